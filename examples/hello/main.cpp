@@ -1,229 +1,404 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <drakon/Game.h>
 #include <drakon/Renderable.h>
 
-namespace {
-std::vector<char> readFile(const std::filesystem::path& path) {
-    std::ifstream file(path, std::ios::ate | std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open shader file: " << path << std::endl;
-        return {};
-    }
+struct TriangleShaders {
+    std::vector<uint32_t> vertexSpirv;
+    std::vector<uint32_t> fragmentSpirv;
+};
 
-    const std::streamsize fileSize = file.tellg();
-    if (fileSize <= 0) {
-        std::cerr << "Shader file is empty: " << path << std::endl;
-        return {};
-    }
+// Matches the push constant block in triangle.vert
+struct TrianglePushConstants {
+    float depth = 0.0f;
+    float scale = 1.0f;
+    // Non-zero places each triangle at gridCenter of its instance index
+    uint32_t gridColumns = 0;
+};
 
-    std::vector<char> buffer(static_cast<size_t>(fileSize));
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-    return buffer;
+// triangle.vert repeats this, so a culled grid draws each triangle where its bounding sphere was tested
+std::array<float, 2> gridCenter(uint32_t index, uint32_t columns) {
+    return {-2.0f + 4.0f * static_cast<float>(index % columns) / static_cast<float>(columns),
+            -0.9f + 1.8f * static_cast<float>(index / columns) / static_cast<float>(columns)};
 }
 
-VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code) {
-    if (code.empty()) {
-        return VK_NULL_HANDLE;
-    }
+void describeTrianglePipeline(const TriangleShaders& shaders, drakon::GraphicsPipelineDescription& description) {
+    description.stages.resize(2);
+    description.stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    description.stages[0].spirv = shaders.vertexSpirv;
+    description.stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    description.stages[1].spirv = shaders.fragmentSpirv;
 
-    VkShaderModuleCreateInfo createInfo = {};
-    createInfo.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize                 = code.size();
-    createInfo.pCode                    = reinterpret_cast<const uint32_t*>(code.data());
+    description.depthTest          = description.depthWrite = true;
+    description.pushConstantRanges = {{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(TrianglePushConstants)}};
+}
+
+// Draws the triangle at the same depth its sort key was built from, so front-to-back order pays off in the depth test
+void setTriangleDepth(drakon::DrawPacket& packet, float depth) {
+    const TrianglePushConstants pushConstants = {depth, 1.0f, 0};
+    packet.pushConstantStages                 = VK_SHADER_STAGE_VERTEX_BIT;
+    packet.pushConstantSize                   = sizeof(pushConstants);
+    std::memcpy(packet.pushConstants.data(), &pushConstants, sizeof(pushConstants));
+}
 
-    VkShaderModule shaderModule = VK_NULL_HANDLE;
-    if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-        std::cerr << "Failed to create Vulkan shader module." << std::endl;
-        return VK_NULL_HANDLE;
+bool parsePresentMode(const std::string& name, VkPresentModeKHR& mode) {
+    if (name == "immediate") {
+        mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    } else if (name == "mailbox") {
+        mode = VK_PRESENT_MODE_MAILBOX_KHR;
+    } else if (name == "fifo") {
+        mode = VK_PRESENT_MODE_FIFO_KHR;
+    } else if (name == "fifo-relaxed") {
+        mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    } else {
+        return false;
     }
+    return true;
+}
 
-    return shaderModule;
+// Drives a triangle entity's place in the sort order, standing in for per-entity simulation state
+struct TriangleMotion {
+    float phase = 0.0f;
+    float speed = 1.0f;
+};
+
+void updateTriangles(drakon::Delta                 delta,
+                     size_t                        count,
+                     TriangleMotion*               motions,
+                     drakon::DrawPacket*           packets,
+                     const drakon::PipelineHandle* pipelines) {
+    for (size_t i = 0; i < count; ++i) {
+        motions[i].phase     = std::fmod(motions[i].phase + motions[i].speed * delta, 1.0f);
+        const uint32_t depth = drakon::RenderQueue::quantizeDepth(motions[i].phase);
+        packets[i].sortKey   = drakon::RenderQueue::makeOpaqueSortKey(pipelines[i]->id, 0, depth);
+        setTriangleDepth(packets[i], motions[i].phase);
+    }
 }
-} // namespace
 
-struct TriangleRenderable : public drakon::Renderable {
-    explicit TriangleRenderable(std::filesystem::path shaderDirectory) : shaderDirectory(std::move(shaderDirectory)) {}
+// The same triangle repeated over a grid twice the width of the screen, culled on the GPU and drawn indirectly
+struct CulledTrianglesRenderable : public drakon::Renderable {
+    CulledTrianglesRenderable(drakon::Renderer&                      renderer,
+                              std::shared_ptr<const TriangleShaders> shaders,
+                              uint32_t                               count)
+        : renderer(renderer), shaders(std::move(shaders)), count(count) {}
 
-    void draw(VkCommandBuffer commandBuffer, VkDevice device, VkRenderPass renderPass, VkExtent2D extent) override {
-        if (!this->ensurePipeline(device, renderPass, extent)) {
+    void prepare(VkCommandBuffer commandBuffer, const drakon::RenderContext& context) override {
+        if (!this->initialized && !this->initialize()) {
             return;
         }
-
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->graphicsPipeline);
-        vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+        this->culling.recordCull(commandBuffer, context.frameIndex);
     }
 
-  private:
-    std::filesystem::path shaderDirectory;
+    bool submit(drakon::RenderQueue&, const drakon::RenderContext&) override { return false; }
 
-    bool ensurePipeline(VkDevice device, VkRenderPass renderPass, VkExtent2D extent) {
-        if (this->graphicsPipeline != VK_NULL_HANDLE) {
-            return true;
+    void draw(VkCommandBuffer commandBuffer, const drakon::RenderContext& context) override {
+        if (this->indexBuffer == nullptr || !this->ensurePipeline(context)) {
+            return;
         }
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline->handle);
+        // Places each draw by its first instance, which is only its object index with drawIndirectFirstInstance
+        const TrianglePushConstants pushConstants = {OBJECT_DEPTH, OBJECT_SCALE, this->columns};
+        vkCmdPushConstants(commandBuffer,
+                           this->pipeline->layout->handle,
+                           VK_SHADER_STAGE_VERTEX_BIT,
+                           0,
+                           sizeof(pushConstants),
+                           &pushConstants);
+        vkCmdBindIndexBuffer(commandBuffer, this->indexBuffer->handle, 0, VK_INDEX_TYPE_UINT16);
+        this->culling.recordDraws(commandBuffer, context.frameIndex);
+    }
 
-        auto vertCode = readFile(this->shaderDirectory / "triangle.vert.spv");
-        auto fragCode = readFile(this->shaderDirectory / "triangle.frag.spv");
-        if (vertCode.empty() || fragCode.empty()) {
-            return false;
-        }
+    uint32_t getVisibleCount() const { return this->culling.getVisibleCount(); }
 
-        VkShaderModule vertShaderModule = createShaderModule(device, vertCode);
-        VkShaderModule fragShaderModule = createShaderModule(device, fragCode);
-        if (vertShaderModule == VK_NULL_HANDLE || fragShaderModule == VK_NULL_HANDLE) {
-            if (vertShaderModule != VK_NULL_HANDLE) {
-                vkDestroyShaderModule(device, vertShaderModule, nullptr);
-            }
-            if (fragShaderModule != VK_NULL_HANDLE) {
-                vkDestroyShaderModule(device, fragShaderModule, nullptr);
-            }
-            return false;
-        }
+    void cleanup() {
+        this->culling.cleanup();
+        this->indexBuffer.reset();
+    }
+
+  protected:
+    bool describePipeline(const drakon::RenderContext&,
+                          drakon::GraphicsPipelineDescription& description) const override {
+        describeTrianglePipeline(*this->shaders, description);
+        return true;
+    }
 
-        VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-        vertShaderStageInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        vertShaderStageInfo.stage                           = VK_SHADER_STAGE_VERTEX_BIT;
-        vertShaderStageInfo.module                          = vertShaderModule;
-        vertShaderStageInfo.pName                           = "main";
-
-        VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-        fragShaderStageInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        fragShaderStageInfo.stage                           = VK_SHADER_STAGE_FRAGMENT_BIT;
-        fragShaderStageInfo.module                          = fragShaderModule;
-        fragShaderStageInfo.pName                           = "main";
-
-        VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-
-        VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-        vertexInputInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount   = 0;
-        vertexInputInfo.pVertexBindingDescriptions      = nullptr;
-        vertexInputInfo.vertexAttributeDescriptionCount = 0;
-        vertexInputInfo.pVertexAttributeDescriptions    = nullptr;
-
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-        inputAssembly.sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssembly.topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-        VkViewport viewport = {};
-        viewport.x          = 0.0f;
-        viewport.y          = 0.0f;
-        viewport.width      = static_cast<float>(extent.width);
-        viewport.height     = static_cast<float>(extent.height);
-        viewport.minDepth   = 0.0f;
-        viewport.maxDepth   = 1.0f;
-
-        VkRect2D scissor = {};
-        scissor.offset   = {0, 0};
-        scissor.extent   = extent;
-
-        VkPipelineViewportStateCreateInfo viewportState = {};
-        viewportState.sType                             = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount                     = 1;
-        viewportState.pViewports                        = &viewport;
-        viewportState.scissorCount                      = 1;
-        viewportState.pScissors                         = &scissor;
-
-        VkPipelineRasterizationStateCreateInfo rasterizer = {};
-        rasterizer.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rasterizer.depthClampEnable                       = VK_FALSE;
-        rasterizer.rasterizerDiscardEnable                = VK_FALSE;
-        rasterizer.polygonMode                            = VK_POLYGON_MODE_FILL;
-        rasterizer.lineWidth                              = 1.0f;
-        rasterizer.cullMode                               = VK_CULL_MODE_BACK_BIT;
-        rasterizer.frontFace                              = VK_FRONT_FACE_CLOCKWISE;
-        rasterizer.depthBiasEnable                        = VK_FALSE;
-
-        VkPipelineMultisampleStateCreateInfo multisampling = {};
-        multisampling.sType                                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        multisampling.sampleShadingEnable                  = VK_FALSE;
-        multisampling.rasterizationSamples                 = VK_SAMPLE_COUNT_1_BIT;
-
-        VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-        colorBlendAttachment.colorWriteMask =
-            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        colorBlendAttachment.blendEnable = VK_FALSE;
-
-        VkPipelineColorBlendStateCreateInfo colorBlending = {};
-        colorBlending.sType                               = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        colorBlending.logicOpEnable                       = VK_FALSE;
-        colorBlending.logicOp                             = VK_LOGIC_OP_COPY;
-        colorBlending.attachmentCount                     = 1;
-        colorBlending.pAttachments                        = &colorBlendAttachment;
-
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-        pipelineLayoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-        if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
-            std::cerr << "Failed to create Vulkan pipeline layout." << std::endl;
-            vkDestroyShaderModule(device, vertShaderModule, nullptr);
-            vkDestroyShaderModule(device, fragShaderModule, nullptr);
+  private:
+    static constexpr float OBJECT_DEPTH  = 0.5f;
+    static constexpr float OBJECT_RADIUS = 0.01f;
+    // The triangle's corners sit within 0.71 of its origin, so this keeps it inside the tested sphere
+    static constexpr float OBJECT_SCALE = OBJECT_RADIUS * 1.4f;
+
+    bool initialize() {
+        this->initialized = true;
+        if (!this->culling.init(this->renderer, this->count)) {
             return false;
         }
 
-        VkGraphicsPipelineCreateInfo pipelineInfo = {};
-        pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount                   = 2;
-        pipelineInfo.pStages                      = shaderStages;
-        pipelineInfo.pVertexInputState            = &vertexInputInfo;
-        pipelineInfo.pInputAssemblyState          = &inputAssembly;
-        pipelineInfo.pViewportState               = &viewportState;
-        pipelineInfo.pRasterizationState          = &rasterizer;
-        pipelineInfo.pMultisampleState            = &multisampling;
-        pipelineInfo.pColorBlendState             = &colorBlending;
-        pipelineInfo.layout                       = this->pipelineLayout;
-        pipelineInfo.renderPass                   = renderPass;
-        pipelineInfo.subpass                      = 0;
-        pipelineInfo.basePipelineHandle           = VK_NULL_HANDLE;
-
-        const VkResult createPipelineResult =
-            vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &this->graphicsPipeline);
-
-        vkDestroyShaderModule(device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(device, fragShaderModule, nullptr);
-
-        if (createPipelineResult != VK_SUCCESS) {
-            std::cerr << "Failed to create Vulkan graphics pipeline." << std::endl;
-            if (this->pipelineLayout != VK_NULL_HANDLE) {
-                vkDestroyPipelineLayout(device, this->pipelineLayout, nullptr);
-                this->pipelineLayout = VK_NULL_HANDLE;
-            }
+        const uint16_t indices[] = {0, 1, 2};
+        this->indexBuffer        = this->renderer.getGpuAllocator().createBuffer(
+            sizeof(indices),
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (this->indexBuffer == nullptr) {
             return false;
         }
-
+        std::memcpy(this->indexBuffer->allocation.mapped, indices, sizeof(indices));
+
+        // Clip space spans [-1, 1], so only the middle half of each row survives
+        this->columns = std::max<uint32_t>(1, static_cast<uint32_t>(std::sqrt(static_cast<float>(this->count))));
+
+        std::vector<drakon::GpuCullingObject> objects(this->count);
+        for (uint32_t i = 0; i < this->count; ++i) {
+            const std::array<float, 2> center = gridCenter(i, this->columns);
+            objects[i].center[0]              = center[0];
+            objects[i].center[1]              = center[1];
+            objects[i].center[2]              = OBJECT_DEPTH;
+            objects[i].radius                 = OBJECT_RADIUS;
+            objects[i].indexCount             = 3;
+        }
+        this->culling.setObjects(objects);
         return true;
     }
+
+    drakon::Renderer&                      renderer;
+    std::shared_ptr<const TriangleShaders> shaders;
+    drakon::GpuCulling                     culling;
+    drakon::BufferHandle                   indexBuffer;
+    uint32_t                               count       = 0;
+    uint32_t                               columns     = 1;
+    bool                                   initialized = false;
 };
 
 struct Game : public drakon::Game {
     using drakon::Game::Game;
 
     std::array<float, 4> clearColorDirection = {0.1f, 0.2f, 0.3f, 0.0f};
+    uint64_t             frameLimit          = 1000;
+    uint64_t             frameCount          = 0;
+    bool                 fixedTimestep       = false;
+    double               targetFrameRate     = 0.0;
+    uint32_t             recordingThreads    = 0;
+    bool                 gpuProfiling        = false;
+    uint32_t             triangleCount       = 1;
+    uint32_t             culledTriangleCount = 0;
+    uint32_t             framesInFlight      = 2;
+    VkPresentModeKHR     presentMode         = VK_PRESENT_MODE_MAILBOX_KHR;
+    bool                 lowLatency          = false;
+    // Enables dynamic resolution when positive
+    double gpuBudget = 0.0;
+
+    std::array<drakon::AssetHandle, 2>         shaderSources;
+    std::array<drakon::ShaderCompileResult, 2> compiledShaders;
+    drakon::JobCounter                         shadersCompiled;
+    bool                                       compilingShaders = false;
+    std::shared_ptr<const TriangleShaders>     triangleShaders;
+    bool                                       trianglesSpawned = false;
+    CulledTrianglesRenderable*                 culledTriangles  = nullptr;
+    std::filesystem::path                      traceOutput;
+    std::filesystem::path                      texturePath;
+    drakon::TextureHandle                      texture;
+    std::chrono::steady_clock::time_point      startTime;
 
     void init() override {
         std::cout << "Initializing Vulkan game" << std::endl;
+        this->useFixedTimestep = this->fixedTimestep;
+        this->frameLimiter.setTargetFrameRate(this->targetFrameRate);
+        this->renderer.setRecordingThreadCount(this->recordingThreads);
+        this->renderer.getGpuProfiler().setEnabled(this->gpuProfiling);
+        this->renderer.setFramesInFlight(this->framesInFlight);
+        this->renderer.setPresentMode(this->presentMode);
+        this->renderer.setLowLatencyMode(this->lowLatency);
+        if (this->gpuBudget > 0.0) {
+            this->renderer.getDynamicResolution().setBudget(this->gpuBudget);
+            this->renderer.setDynamicResolution(true);
+        }
+        this->tracePath = this->traceOutput;
         const std::filesystem::path shaderDirectory = std::filesystem::path(__FILE__).parent_path() / "shaders";
+        // Read in the background; tick compiles them once both have arrived
+        this->shaderSources[0] = this->assets.load(shaderDirectory / "triangle.vert", drakon::AssetPriority::Visible);
+        this->shaderSources[1] = this->assets.load(shaderDirectory / "triangle.frag", drakon::AssetPriority::Visible);
+        if (!this->texturePath.empty()) {
+            this->texture = this->renderer.getTextureCache().load(this->texturePath);
+        }
+        this->startTime = std::chrono::steady_clock::now();
+    }
 
-        if (!this->renderer.compileGlslShader((shaderDirectory / "triangle.vert").string())) {
-            std::cerr << "Failed to compile vertex shader." << std::endl;
+    void tick(const drakon::Delta delta) override {
+        // Pipelines need the renderer's render pass, which only exists once the loop starts
+        if (!this->trianglesSpawned && this->areShadersCompiled()) {
+            this->trianglesSpawned = true;
+            if (this->takeCompiledShaders()) {
+                this->spawnTriangles();
+            }
+        }
+        // Chunks are disjoint, so each updates as its own job while the world's structure stays fixed
+        drakon::JobCounter updated;
+        this->world.eachChunk<TriangleMotion, drakon::DrawPacket, const drakon::PipelineHandle>(
+            [this, delta, &updated](size_t                        count,
+                                    const drakon::Entity*,
+                                    TriangleMotion*               motions,
+                                    drakon::DrawPacket*           packets,
+                                    const drakon::PipelineHandle* pipelines) {
+                this->jobs.run([=]() { updateTriangles(delta, count, motions, packets, pipelines); }, &updated);
+            });
+        this->jobs.wait(updated);
+        this->updateClearColor(delta);
+        // Headless runs have no window to close, so they stop after a fixed number of frames
+        if (this->headless && ++this->frameCount >= this->frameLimit) {
+            this->isRunning = false;
+        }
+    }
+
+    void done() override {
+        const drakon::PipelineCacheStats cacheStats = this->renderer.getPipelineCache().getStats();
+        std::cout << "Pipelines: " << cacheStats.cacheHits << " cache hits, " << cacheStats.compiled << " compiled"
+                  << (cacheStats.feedbackAvailable ? "" : " (creation feedback unavailable)") << std::endl;
+        const drakon::PipelineRegistryStats registryStats = this->renderer.getPipelineRegistry().getStats();
+        std::cout << "Pipeline registry: " << registryStats.pipelines << " pipelines shared by "
+                  << registryStats.pipelineHits + registryStats.pipelines << " requests" << std::endl;
+        const drakon::RenderQueueStats queueStats = this->renderer.getRenderQueue().getStats();
+        std::cout << "Render queue: " << queueStats.packets << " packets, " << queueStats.pipelineBinds
+                  << " pipeline binds, " << queueStats.pipelineBindsSkipped << " skipped" << std::endl;
+        const drakon::GpuAllocatorStats memoryStats = this->renderer.getGpuAllocator().getStats();
+        std::cout << "GPU memory: " << memoryStats.bytesUsed << " of " << memoryStats.bytesReserved
+                  << " bytes used by " << memoryStats.allocations << " allocations in " << memoryStats.blocks
+                  << " blocks (" << memoryStats.dedicated << " dedicated, " << memoryStats.fragmentation * 100.0f
+                  << "% fragmented)" << std::endl;
+        this->printGpuTimings();
+        const drakon::LatencyStats latency = this->renderer.getLatencyStats();
+        std::cout << "Input to GPU completion: " << latency.averageMilliseconds << " ms average, "
+                  << latency.maxMilliseconds << " ms max over " << latency.frames << " frames ("
+                  << this->renderer.getFramesInFlight() << " in flight"
+                  << (this->renderer.isLowLatencyMode() ? ", low latency" : "") << ")" << std::endl;
+        if (this->texture != nullptr) {
+            const drakon::TextureCacheStats textureStats = this->renderer.getTextureCache().getStats();
+            std::cout << "Texture " << this->texture->getPath()
+                      << (this->texture->isReady() ? " uploaded" : " not ready") << ": " << textureStats.bytesUploaded
+                      << " bytes uploaded for " << textureStats.uncompressedBytes << " uncompressed, "
+                      << textureStats.decoded << " decoded, " << textureStats.mipsGenerated << " with generated mips, "
+                      << textureStats.transferBatches << " of " << textureStats.uploadBatches
+                      << " batches on the transfer queue" << std::endl;
+        }
+        if (this->culledTriangles != nullptr) {
+            std::cout << "GPU culling: " << this->culledTriangles->getVisibleCount() << " of "
+                      << this->culledTriangleCount << " triangles visible" << std::endl;
+            this->culledTriangles->cleanup();
+        }
+
+        if (!this->headless) {
             return;
         }
-        if (!this->renderer.compileGlslShader((shaderDirectory / "triangle.frag").string())) {
-            std::cerr << "Failed to compile fragment shader." << std::endl;
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - this->startTime;
+        std::cout << "Rendered " << this->frameCount << " headless frames in " << elapsed.count() << "s ("
+                  << static_cast<double>(this->frameCount) / elapsed.count() << " fps)" << std::endl;
+    }
+
+  private:
+    // Polls the shader sources and compiles them as jobs once both are read, so no frame waits on the disk or compiler
+    bool areShadersCompiled() {
+        if (!this->compilingShaders) {
+            for (const auto& source : this->shaderSources) {
+                if (!source->isReady()) {
+                    return false;
+                }
+            }
+            this->compilingShaders = true;
+            for (size_t i = 0; i < this->shaderSources.size(); ++i) {
+                this->jobs.run([this, i]() { this->compileShader(i); }, &this->shadersCompiled);
+            }
+        }
+        return this->shadersCompiled.isDone();
+    }
+
+    void compileShader(size_t index) {
+        const drakon::AssetHandle& source = this->shaderSources[index];
+        if (source->getState() != drakon::AssetState::Loaded) {
+            this->compiledShaders[index].log = source->getError();
             return;
         }
+        this->compiledShaders[index] = this->renderer.getShaderCompiler().compileSource(std::string(source->text()),
+                                                                                        source->getPath().string());
+    }
 
-        this->renderables.push_back(new TriangleRenderable(shaderDirectory));
+    bool takeCompiledShaders() {
+        for (size_t i = 0; i < this->compiledShaders.size(); ++i) {
+            if (!this->compiledShaders[i].success) {
+                std::cerr << "Failed to compile " << this->shaderSources[i]->getPath() << std::endl
+                          << this->compiledShaders[i].log << std::endl;
+                return false;
+            }
+        }
+        std::cout << "Compiled shaders " << (drakon::ShaderCompiler::isInProcess() ? "in process" : "with glslc")
+                  << (this->compiledShaders[0].fromCache && this->compiledShaders[1].fromCache ? " (cached)" : "")
+                  << std::endl;
+
+        auto triangleShaders           = std::make_shared<TriangleShaders>();
+        triangleShaders->vertexSpirv   = std::move(this->compiledShaders[0].spirv);
+        triangleShaders->fragmentSpirv = std::move(this->compiledShaders[1].spirv);
+        this->triangleShaders          = triangleShaders;
+        if (this->culledTriangleCount > 0) {
+            this->culledTriangles = this->addRenderable<CulledTrianglesRenderable>(
+                this->renderer, triangleShaders, this->culledTriangleCount);
+        }
+        return true;
     }
 
-    void tick(const drakon::Delta delta) override { this->updateClearColor(delta); }
+    // Every triangle is an entity carrying its draw packet, so the renderer copies them out chunk by chunk
+    void spawnTriangles() {
+        if (this->triangleShaders == nullptr || this->triangleCount == 0) {
+            return;
+        }
+
+        drakon::GraphicsPipelineDescription description;
+        describeTrianglePipeline(*this->triangleShaders, description);
+        // Every entity shares the one pipeline the registry builds
+        const drakon::PipelineHandle pipeline =
+            this->renderer.getPipelineRegistry().getGraphicsPipeline(description, this->renderer.getRenderPass());
+        if (pipeline == nullptr) {
+            return;
+        }
+
+        drakon::DrawPacket packet;
+        packet.pipeline       = pipeline->handle;
+        packet.pipelineLayout = pipeline->layout->handle;
+        packet.count          = 3;
+        for (uint32_t i = 0; i < this->triangleCount; ++i) {
+            const TriangleMotion motion = {static_cast<float>(i) / static_cast<float>(this->triangleCount), 0.25f};
+            packet.sortKey              = drakon::RenderQueue::makeOpaqueSortKey(
+                pipeline->id, 0, drakon::RenderQueue::quantizeDepth(motion.phase));
+            setTriangleDepth(packet, motion.phase);
+            // The handle component keeps the pipeline alive for as long as any entity draws with it
+            this->world.create(packet, pipeline, motion);
+        }
+    }
+
+    void printGpuTimings() {
+        const drakon::GpuProfiler& profiler = this->renderer.getGpuProfiler();
+        if (profiler.getHistorySize() == 0) {
+            return;
+        }
+
+        double frameMilliseconds = 0.0;
+        for (size_t age = 0; age < profiler.getHistorySize(); ++age) {
+            frameMilliseconds += profiler.getFrame(age).milliseconds;
+        }
+        frameMilliseconds /= static_cast<double>(profiler.getHistorySize());
+
+        const drakon::GpuScopeStats queue = profiler.getScopeStats("RenderQueue");
+        std::cout << "GPU frame: " << frameMilliseconds << " ms average over " << profiler.getHistorySize()
+                  << " frames; RenderQueue: " << queue.averageMilliseconds << " ms average, "
+                  << queue.maxMilliseconds << " ms max" << std::endl;
+    }
 
-  private:
     void updateClearColor(const drakon::Delta delta) {
         auto& clearColor = this->renderer.getClearColor();
         for (size_t i = 0; i < clearColor.size(); ++i) {
@@ -239,8 +414,79 @@ struct Game : public drakon::Game {
     }
 };
 
-int main() {
-    Game game("Hello Vulkan", drakon::RendererBackend::Vulkan);
+int main(int argc, char** argv) {
+    bool                  headless         = false;
+    bool                  useFixedTimestep = false;
+    uint64_t              frameLimit       = 1000;
+    double                targetFrameRate  = 0.0;
+    uint32_t              recordingThreads = 0;
+    bool                  gpuProfiling     = false;
+    uint32_t              triangleCount    = 1;
+    uint32_t              culledTriangles  = 0;
+    uint32_t              jobWorkers       = drakon::JobSystem::getDefaultWorkerCount();
+    bool                  pinWorkers       = false;
+    uint32_t              framesInFlight   = 2;
+    VkPresentModeKHR      presentMode      = VK_PRESENT_MODE_MAILBOX_KHR;
+    bool                  lowLatency       = false;
+    double                gpuBudget        = 0.0;
+    std::filesystem::path traceOutput;
+    std::filesystem::path texturePath;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--fixed-timestep") {
+            useFixedTimestep = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frameLimit = std::stoull(argv[++i]);
+        } else if (arg == "--fps" && i + 1 < argc) {
+            targetFrameRate = std::stod(argv[++i]);
+        } else if (arg == "--gpu-profile") {
+            gpuProfiling = true;
+        } else if (arg == "--triangles" && i + 1 < argc) {
+            triangleCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--gpu-culling" && i + 1 < argc) {
+            culledTriangles = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--trace" && i + 1 < argc) {
+            traceOutput = argv[++i];
+        } else if (arg == "--recording-threads" && i + 1 < argc) {
+            recordingThreads = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--job-workers" && i + 1 < argc) {
+            jobWorkers = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--pin-workers") {
+            pinWorkers = true;
+        } else if (arg == "--frames-in-flight" && i + 1 < argc) {
+            framesInFlight = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--present-mode" && i + 1 < argc) {
+            if (!parsePresentMode(argv[++i], presentMode)) {
+                std::cerr << "Unknown present mode " << argv[i]
+                          << "; expected immediate, mailbox, fifo or fifo-relaxed" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--low-latency") {
+            lowLatency = true;
+        } else if (arg == "--gpu-budget" && i + 1 < argc) {
+            gpuBudget = std::stod(argv[++i]);
+        } else if (arg == "--texture" && i + 1 < argc) {
+            texturePath = argv[++i];
+        }
+    }
+
+    Game game("Hello Vulkan", drakon::RendererBackend::Vulkan, headless);
+    game.frameLimit          = frameLimit;
+    game.fixedTimestep       = useFixedTimestep;
+    game.targetFrameRate     = targetFrameRate;
+    game.recordingThreads    = recordingThreads;
+    game.gpuProfiling        = gpuProfiling;
+    game.traceOutput         = traceOutput;
+    game.triangleCount       = triangleCount;
+    game.culledTriangleCount = culledTriangles;
+    game.framesInFlight      = framesInFlight;
+    game.presentMode         = presentMode;
+    game.lowLatency          = lowLatency;
+    game.gpuBudget           = gpuBudget;
+    game.texturePath         = texturePath;
+    game.setJobWorkerCount(jobWorkers, pinWorkers);
     game.run();
     return 0;
 }
@@ -1,5 +1,11 @@
 #version 450
 
+layout(push_constant) uniform PushConstants {
+    float depth;
+    float scale;
+    uint  gridColumns;
+} pushConstants;
+
 layout(location = 0) out vec3 outColor;
 
 const vec2 positions[3] = vec2[](
@@ -14,7 +20,17 @@ const vec3 colors[3] = vec3[](
     vec3(0.0, 0.0, 1.0)
 );
 
+// Matches gridCenter in main.cpp
+vec2 gridCenter(uint index, uint columns) {
+    return vec2(-2.0 + 4.0 * float(index % columns) / float(columns),
+                -0.9 + 1.8 * float(index / columns) / float(columns));
+}
+
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    vec2 position = positions[gl_VertexIndex] * pushConstants.scale;
+    if (pushConstants.gridColumns != 0u) {
+        position += gridCenter(uint(gl_InstanceIndex), pushConstants.gridColumns);
+    }
+    gl_Position = vec4(position, pushConstants.depth, 1.0);
     outColor = colors[gl_VertexIndex];
 }
@@ -0,0 +1,109 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <drakon/JobSystem.h>
+
+namespace {
+// Heavy enough that the compiler cannot drop the job, light enough that scheduling dominates
+void work(std::atomic<uint64_t>& sink) { sink.fetch_add(1, std::memory_order_relaxed); }
+
+double nanosecondsPerJob(std::chrono::steady_clock::duration elapsed, size_t jobs) {
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(jobs);
+}
+
+void benchmarkJobSystem(drakon::JobSystem& jobs, size_t count) {
+    std::atomic<uint64_t> sink = 0;
+    drakon::JobCounter    counter;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        jobs.run([&sink]() { work(sink); }, &counter);
+    }
+    jobs.wait(counter);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "JobSystem::run:  " << nanosecondsPerJob(elapsed, count) << " ns per job" << std::endl;
+}
+
+void benchmarkNestedJobs(drakon::JobSystem& jobs, size_t count) {
+    std::atomic<uint64_t> sink = 0;
+    drakon::JobCounter    counter;
+    // Jobs queued from workers land in their own deques, which is the path work stealing is built for
+    const size_t parents  = 64;
+    const size_t children = count / parents;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < parents; ++i) {
+        jobs.run(
+            [&jobs, &sink, children]() {
+                drakon::JobCounter inner;
+                for (size_t j = 0; j < children; ++j) {
+                    jobs.run([&sink]() { work(sink); }, &inner);
+                }
+                jobs.wait(inner);
+            },
+            &counter);
+    }
+    jobs.wait(counter);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Nested run:      " << nanosecondsPerJob(elapsed, parents * children) << " ns per job" << std::endl;
+}
+
+void benchmarkParallelFor(drakon::JobSystem& jobs, size_t count) {
+    std::atomic<uint64_t> sink = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    jobs.parallelFor(count, 1, [&sink](size_t, size_t) { work(sink); });
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "parallelFor:     " << nanosecondsPerJob(elapsed, count) << " ns per job" << std::endl;
+}
+
+void benchmarkAsync(size_t count) {
+    std::atomic<uint64_t>          sink = 0;
+    std::vector<std::future<void>> futures;
+    futures.reserve(count);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        futures.push_back(std::async(std::launch::async, [&sink]() { work(sink); }));
+    }
+    for (auto& future : futures) {
+        future.wait();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "std::async:      " << nanosecondsPerJob(elapsed, count) << " ns per job" << std::endl;
+}
+} // namespace
+
+// Measures the cost of scheduling a near-empty job through the job system against std::async
+int main(int argc, char** argv) {
+    uint32_t workers    = drakon::JobSystem::getDefaultWorkerCount();
+    size_t   jobCount   = 1000000;
+    size_t   asyncCount = 20000;
+    bool     pinWorkers = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--workers" && i + 1 < argc) {
+            workers = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobCount = std::stoull(argv[++i]);
+        } else if (arg == "--async-jobs" && i + 1 < argc) {
+            asyncCount = std::stoull(argv[++i]);
+        } else if (arg == "--pin-workers") {
+            pinWorkers = true;
+        }
+    }
+
+    drakon::JobSystem jobs;
+    jobs.start(workers, pinWorkers);
+    std::cout << "Scheduling " << jobCount << " jobs on " << jobs.getWorkerCount() << " workers" << std::endl;
+    benchmarkJobSystem(jobs, jobCount);
+    benchmarkNestedJobs(jobs, jobCount);
+    benchmarkParallelFor(jobs, jobCount);
+    // A thread per call is far slower, so fewer calls keep the run short
+    benchmarkAsync(asyncCount);
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <drakon/Game.h>
+#include <drakon/SpriteBatch.h>
+
+namespace {
+constexpr uint32_t LAYER_SIZE  = 64;
+constexpr uint32_t LAYER_COUNT = 4;
+
+std::vector<drakon::Sprite> makeSprites(size_t count, uint32_t width, uint32_t height) {
+    std::mt19937                          random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<drakon::Sprite> sprites(count);
+    for (drakon::Sprite& sprite : sprites) {
+        sprite.position[0] = unit(random) * static_cast<float>(width);
+        sprite.position[1] = unit(random) * static_cast<float>(height);
+        sprite.size[0]     = 4.0f + unit(random) * 12.0f;
+        sprite.size[1]     = sprite.size[0];
+        sprite.origin[0]   = 0.5f;
+        sprite.origin[1]   = 0.5f;
+        sprite.rotation    = unit(random) < 0.5f ? 0.0f : unit(random) * 6.28f;
+        sprite.color       = 0xFF000000 | static_cast<uint32_t>(random() & 0xFFFFFF);
+        sprite.layer       = static_cast<uint32_t>(random() % LAYER_COUNT);
+    }
+    return sprites;
+}
+
+// Times SpriteBatch::expandQuads alone, with no renderer involved
+void benchmarkExpansion(size_t count) {
+    const std::vector<drakon::Sprite> sprites = makeSprites(count, 1280, 720);
+    std::vector<drakon::SpriteVertex> vertices(count * 4);
+
+    // Enough repetitions for a stable figure without making the million sprite run slow
+    const size_t iterations = std::max<size_t>(3, 20000000 / count);
+    drakon::SpriteBatch::expandQuads(sprites.data(), count, vertices.data());
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        drakon::SpriteBatch::expandQuads(sprites.data(), count, vertices.data());
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    const double milliseconds = elapsed.count() / static_cast<double>(iterations);
+    std::cout << "Expand " << count << " sprites: " << milliseconds << " ms, "
+              << static_cast<double>(count) / milliseconds << " sprites/ms" << std::endl;
+}
+} // namespace
+
+struct Game : public drakon::Game {
+    using drakon::Game::Game;
+
+    uint64_t frameLimit  = 300;
+    uint64_t frameCount  = 0;
+    size_t   spriteCount = 100000;
+
+    drakon::SpriteBatch                   batch;
+    bool                                  batchReady         = false;
+    double                                expandMilliseconds = 0.0;
+    uint32_t                              drawCalls          = 0;
+    std::chrono::steady_clock::time_point startTime;
+
+    void init() override {
+        this->renderables.push_back(&this->batch);
+        this->startTime = std::chrono::steady_clock::now();
+    }
+
+    void tick(const drakon::Delta) override {
+        // The renderer is only initialized once the loop starts, so the batch is set up on the first tick
+        if (!this->batchReady) {
+            this->batchReady = true;
+            if (!this->batch.init(this->renderer, LAYER_SIZE, LAYER_SIZE, LAYER_COUNT)) {
+                this->isRunning = false;
+                return;
+            }
+            this->uploadCheckerboards();
+            const std::vector<drakon::Sprite> sprites =
+                makeSprites(this->spriteCount, this->windowWidth, this->windowHeight);
+            this->batch.add(sprites.data(), sprites.size());
+        } else {
+            // Stats describe the frame rendered after the previous tick
+            this->expandMilliseconds += this->batch.getStats().expandMilliseconds;
+            this->drawCalls = this->batch.getStats().drawCalls;
+        }
+
+        ++this->frameCount;
+        if (this->headless && this->frameCount >= this->frameLimit) {
+            this->isRunning = false;
+        }
+    }
+
+    void done() override {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - this->startTime;
+
+        const double frames             = static_cast<double>(std::max<uint64_t>(this->frameCount, 2) - 1);
+        const double expandMilliseconds = this->expandMilliseconds / frames;
+        std::cout << "Render " << this->spriteCount << " sprites: " << this->drawCalls << " draw calls, "
+                  << expandMilliseconds << " ms expanding, "
+                  << static_cast<double>(this->spriteCount) / expandMilliseconds << " sprites/ms, "
+                  << static_cast<double>(this->frameCount) / elapsed.count() << " fps" << std::endl;
+        this->batch.cleanup();
+    }
+
+  private:
+    void uploadCheckerboards() {
+        std::vector<uint8_t> pixels(LAYER_SIZE * LAYER_SIZE * 4);
+        for (uint32_t layer = 0; layer < LAYER_COUNT; ++layer) {
+            const uint32_t cell = 4u << layer;
+            for (uint32_t y = 0; y < LAYER_SIZE; ++y) {
+                for (uint32_t x = 0; x < LAYER_SIZE; ++x) {
+                    const uint8_t value = ((x / cell) + (y / cell)) % 2 == 0 ? 255 : 96;
+                    uint8_t*      texel = &pixels[(y * LAYER_SIZE + x) * 4];
+                    texel[0]            = value;
+                    texel[1]            = value;
+                    texel[2]            = value;
+                    texel[3]            = 255;
+                }
+            }
+            this->batch.setLayerPixels(layer, pixels.data());
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    bool     headless    = false;
+    bool     benchmark   = false;
+    uint64_t frameLimit  = 300;
+    size_t   spriteCount = 100000;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--benchmark") {
+            benchmark = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frameLimit = std::stoull(argv[++i]);
+        } else if (arg == "--sprites" && i + 1 < argc) {
+            spriteCount = std::stoull(argv[++i]);
+        }
+    }
+
+    if (!benchmark) {
+        Game game("Sprites", drakon::RendererBackend::Vulkan, headless);
+        game.frameLimit  = frameLimit;
+        game.spriteCount = spriteCount;
+        game.run();
+        return 0;
+    }
+
+    // Expansion alone, then whole headless frames, at each size
+    const std::array<size_t, 3> counts = {10000, 100000, 1000000};
+    for (size_t count : counts) {
+        benchmarkExpansion(count);
+    }
+    for (size_t count : counts) {
+        Game game("Sprites", drakon::RendererBackend::Vulkan, true);
+        game.frameLimit  = frameLimit;
+        game.spriteCount = count;
+        game.run();
+    }
+    return 0;
+}
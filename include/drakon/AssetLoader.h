@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drakon {
+// Lower values load first, so whatever is on screen should be Visible
+enum class AssetPriority : uint8_t {
+    Visible,
+    Nearby,
+    Background,
+};
+
+enum class AssetState : uint8_t {
+    Loading,
+    Loaded,
+    Failed,
+};
+
+// A file's contents, shared by every handle to the same path. Contents are only valid once the state is Loaded
+struct Asset {
+    explicit Asset(std::filesystem::path path) : path(std::move(path)) {}
+    Asset(const Asset&)            = delete;
+    Asset& operator=(const Asset&) = delete;
+    ~Asset();
+
+    const std::filesystem::path& getPath() const;
+    AssetState                   getState() const;
+    // Loaded or failed. Never blocks, so this is what the frame path should poll
+    bool                         isReady() const;
+    // Blocks until the load finishes; meant for loading screens and tools, never the frame path
+    AssetState                   wait() const;
+
+    const std::byte*   data() const;
+    size_t             size() const;
+    std::string_view   text() const;
+    // Large files are mapped rather than copied into the heap
+    bool               isMapped() const;
+    const std::string& getError() const;
+
+  protected:
+    std::filesystem::path   path;
+    std::atomic<AssetState> state = AssetState::Loading;
+    std::vector<std::byte>  bytes;
+    void*                   mapping     = nullptr;
+    size_t                  mappingSize = 0;
+    std::string             error;
+};
+
+typedef std::shared_ptr<const Asset> AssetHandle;
+
+enum class AssetBackend : uint8_t {
+    None,
+    IoUring,
+    ThreadPool,
+};
+
+struct AssetLoaderStats {
+    uint64_t requests = 0;
+    // Requests answered with an asset that was already loading or loaded
+    uint64_t deduplicated = 0;
+    uint64_t loaded       = 0;
+    uint64_t failed       = 0;
+    uint64_t mapped       = 0;
+    // Queued loads dropped because every handle to them was released first
+    uint64_t abandoned = 0;
+    uint64_t bytesRead = 0;
+};
+
+// Reads whole files off the calling thread. On Linux reads go through io_uring from a single I/O thread, falling back
+// to a pool of blocking reader threads when the kernel or a sandbox refuses it. Requests wait in a priority queue, and
+// a path that is still loading or held by someone is never read twice
+struct AssetLoader {
+    static constexpr size_t   DEFAULT_MAP_THRESHOLD = 1 << 20;
+    static constexpr uint32_t IO_URING_QUEUE_DEPTH  = 64;
+
+    AssetLoader();
+    AssetLoader(const AssetLoader&)            = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+    ~AssetLoader();
+
+    // threadCount only applies to the thread pool. With preferIoUring false the thread pool is used regardless
+    bool         start(uint32_t threadCount = 2, bool preferIoUring = true);
+    // Reads in flight finish; loads still queued fail
+    void         stop();
+    AssetBackend getBackend() const;
+
+    // Never touches the disk. Requesting a path again at a higher priority moves it up the queue if it has not started
+    AssetHandle load(const std::filesystem::path& path, AssetPriority priority = AssetPriority::Background);
+
+    // Files at least this large are mapped, and their pages faulted in on the I/O thread
+    void             setMapThreshold(size_t bytes);
+    size_t           getMapThreshold() const;
+    AssetLoaderStats getStats() const;
+
+  protected:
+    struct Request;
+    struct IoRing;
+
+    struct Queued {
+        AssetPriority            priority = AssetPriority::Background;
+        uint64_t                 sequence = 0;
+        std::shared_ptr<Request> request;
+
+        // std::priority_queue pops the largest, which here is the most urgent and then the oldest
+        bool operator<(const Queued& other) const {
+            return this->priority != other.priority ? this->priority > other.priority
+                                                    : this->sequence > other.sequence;
+        }
+    };
+
+    mutable std::mutex                                      mutex;
+    std::condition_variable                                 wake;
+    std::priority_queue<Queued>                             queue;
+    std::unordered_map<std::string, std::weak_ptr<Request>> requests;
+    size_t                                                  pruneAt      = 64;
+    uint64_t                                                nextSequence = 0;
+    AssetLoaderStats                                        stats;
+    std::vector<std::thread>                                threads;
+    std::unique_ptr<IoRing>                                 ring;
+    AssetBackend                                            backend      = AssetBackend::None;
+    bool                                                    stopping     = false;
+    std::atomic<size_t>                                     mapThreshold = DEFAULT_MAP_THRESHOLD;
+
+    // Pops the most urgent request still wanted, or null once stopping. Called with mutex held
+    std::shared_ptr<Request> takeLocked();
+    void                     finish(Request& request);
+    void                     threadPoolLoop();
+    void                     ioRingLoop();
+};
+} // namespace drakon
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace drakon {
+// Picks the scene's render scale from how long finished frames took on the GPU, keeping them within a budget. The
+// scale applies to both axes, so GPU time is taken to grow with its square. Going over budget drops the scale at
+// once, while recovery is gradual so it does not overshoot into the next spike
+struct DynamicResolution {
+    void   setBudget(double milliseconds);
+    double getBudget() const;
+    // Both are clamped to [0.1, 1]; a scale of 1 renders at the swapchain's full size
+    void   setScaleLimits(float minimum, float maximum);
+    float  getMinimumScale() const;
+    float  getMaximumScale() const;
+    float  getScale() const;
+
+    // Feeds one finished frame's GPU time along with the scale it was rendered at, which lags the current scale by
+    // the frames in flight. Returns the scale for the next frame
+    float update(double gpuMilliseconds, float renderedScale);
+    // Forgets every frame seen so far and returns to the maximum scale
+    void  reset();
+
+  protected:
+    double budget       = 1000.0 / 60.0;
+    float  minimumScale = 0.5f;
+    float  maximumScale = 1.0f;
+    float  scale        = 1.0f;
+    // Smoothed estimate of what a frame would take at full scale; zero until the first frame
+    double fullScaleMilliseconds = 0.0;
+};
+} // namespace drakon
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace drakon {
+// Accumulates real frame time and hands it out as whole simulation steps of a fixed size
+struct FixedTimestep {
+    FixedTimestep() = default;
+    FixedTimestep(double step, uint32_t maxStepsPerFrame);
+
+    // Returns how many steps to simulate for a frame that took frameTime seconds
+    uint32_t advance(double frameTime);
+    void     reset();
+
+    double   getStep() const;
+    uint32_t getMaxStepsPerFrame() const;
+    // Fraction of a step left in the accumulator, for blending the last two simulated states
+    float    getAlpha() const;
+    // Steps discarded because the simulation could not keep up
+    uint64_t getDroppedSteps() const;
+
+  protected:
+    // Kept in integer nanoseconds so long sessions don't drift
+    std::chrono::nanoseconds step             = std::chrono::nanoseconds(16666667);
+    uint32_t                 maxStepsPerFrame = 5;
+    std::chrono::nanoseconds accumulator      = std::chrono::nanoseconds::zero();
+    uint64_t                 droppedSteps     = 0;
+};
+} // namespace drakon
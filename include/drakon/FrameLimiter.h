@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+
+namespace drakon {
+// Paces frames to a target rate by sleeping for most of the remaining time and spinning for the rest
+struct FrameLimiter {
+    // A rate of 0 disables limiting
+    void   setTargetFrameRate(double framesPerSecond);
+    double getTargetFrameRate() const;
+    // How long before the deadline to stop sleeping; covers the OS scheduler's wake-up jitter
+    void   setSpinThreshold(std::chrono::nanoseconds threshold);
+
+    // Blocks until the next frame is due
+    void wait();
+
+  protected:
+    double                                targetFrameRate = 0.0;
+    std::chrono::steady_clock::duration   framePeriod     = {};
+    std::chrono::nanoseconds              spinThreshold   = std::chrono::microseconds(1500);
+    std::chrono::steady_clock::time_point nextDeadline    = {};
+};
+} // namespace drakon
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <drakon/AssetLoader.h>
+#include <drakon/FixedTimestep.h>
+#include <drakon/FrameLimiter.h>
+#include <drakon/JobSystem.h>
 #include <drakon/Renderer.h>
 #include <drakon/Renderable.h>
+#include <drakon/World.h>
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace drakon {
 typedef float Delta;
@@ -12,25 +20,61 @@ struct Game {
     Game() = default;
     Game(std::string title) : title(std::move(title)) {}
     Game(std::string title, RendererBackend backend) : title(std::move(title)), renderer(backend) {}
+    Game(std::string title, RendererBackend backend, bool headless)
+        : title(std::move(title)), renderer(backend), headless(headless) {}
 
     void run();
     void cleanup();
+    // Applied when run starts, before init, so init can already queue jobs
+    void setJobWorkerCount(uint32_t workerCount, bool pinToCores = false);
 
   protected:
-    bool                     isRunning = true;
-    std::string              title     = "Drakon Game";
-    drakon::Renderer         renderer;
+    bool             isRunning = true;
+    std::string      title     = "Drakon Game";
+    drakon::Renderer renderer;
+    // Entities with a DrawPacket component are drawn every frame; cleared before the renderer shuts down
+    World world;
+    // Shared by tick, parallel command recording and loading; started by run
+    JobSystem jobs;
+    // Reads files without blocking init or tick; started by run and stopped by cleanup
+    AssetLoader assets;
+    // Drawn after being asked to submit packets; the game keeps them alive, or hands ownership to addRenderable
     std::vector<Renderable*> renderables;
     void*                    windowHandle = nullptr;
     uint32_t                 windowWidth  = 1280;
     uint32_t                 windowHeight = 720;
+    // Renders offscreen without a window; the game ends the loop itself by clearing isRunning
+    bool headless = false;
+    // When set, tick runs at fixedTimestep's rate and rendering receives the interpolation alpha;
+    // otherwise tick runs once per rendered frame with the measured delta
+    bool          useFixedTimestep = false;
+    FixedTimestep fixedTimestep    = FixedTimestep(1.0 / 60.0, 5);
+    FrameLimiter  frameLimiter;
+    // When set, CPU tracing runs for the whole game and is written here as Chrome trace JSON on exit
+    std::filesystem::path tracePath;
 
-    // OS and render engine specific window creation logic
+    // OS and render engine specific window creation logic, or renderer-only setup when headless
     int  makeWindow();
     void processEvents();
+    // Constructs a renderable owned by the game until cleanup and appends it to renderables
+    template <class T, class... Args>
+    T* addRenderable(Args&&... args);
     // Abstract methods to be implemented by consuming party
     virtual void init() {}
     virtual void tick(const Delta delta) = 0;
     virtual void done() {}
+
+  private:
+    std::vector<std::unique_ptr<Renderable>> ownedRenderables;
+    uint32_t                                 jobWorkerCount = JobSystem::getDefaultWorkerCount();
+    bool                                     pinJobWorkers  = false;
 };
-} // namespace drakon
\ No newline at end of file
+} // namespace drakon
+
+template <class T, class... Args>
+T* drakon::Game::addRenderable(Args&&... args) {
+    T* renderable = new T(std::forward<Args>(args)...);
+    this->ownedRenderables.emplace_back(renderable);
+    this->renderables.push_back(renderable);
+    return renderable;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+struct GpuAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize   offset = 0;
+    VkDeviceSize   size   = 0;
+    // Points at offset for host-visible memory, which stays persistently mapped; null otherwise
+    void*    mapped     = nullptr;
+    uint32_t memoryType = 0;
+    bool     dedicated  = false;
+    uint32_t block      = UINT32_MAX;
+};
+
+struct Buffer {
+    VkBuffer      handle = VK_NULL_HANDLE;
+    VkDeviceSize  size   = 0;
+    GpuAllocation allocation;
+};
+
+struct Image {
+    VkImage       handle    = VK_NULL_HANDLE;
+    VkImageView   view      = VK_NULL_HANDLE;
+    VkFormat      format    = VK_FORMAT_UNDEFINED;
+    VkExtent3D    extent    = {};
+    uint32_t      mipLevels = 1;
+    GpuAllocation allocation;
+};
+
+// Like pipeline handles, dropping the last copy retires the object and its memory through the renderer's deferred
+// destruction, so frames still in flight can keep using it
+typedef std::shared_ptr<const Buffer> BufferHandle;
+typedef std::shared_ptr<const Image>  ImageHandle;
+
+struct GpuAllocatorStats {
+    VkDeviceSize bytesUsed     = 0;
+    VkDeviceSize bytesReserved = 0;
+    uint64_t     allocations   = 0;
+    uint64_t     blocks        = 0;
+    uint64_t     dedicated     = 0;
+    float        fragmentation = 0.0f;
+};
+
+// Sub-allocates buffers and images from large per-memory-type blocks. Safe to use from recording threads
+struct GpuAllocator {
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = VkDeviceSize(64) << 20;
+
+    GpuAllocator() = default;
+    GpuAllocator(const GpuAllocator&)            = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    bool init(VkPhysicalDevice                           physicalDevice,
+              VkDevice                                   device,
+              std::function<void(std::function<void()>)> deferDestroy,
+              VkDeviceSize                               blockSize = DEFAULT_BLOCK_SIZE);
+    // Frees every block and destroys every buffer and image still alive; the device must be idle
+    void cleanup();
+
+    // Linear resources are kept in separate blocks from optimal images so bufferImageGranularity never applies
+    bool allocate(const VkMemoryRequirements& requirements,
+                  VkMemoryPropertyFlags       required,
+                  VkMemoryPropertyFlags       preferred,
+                  bool                        linear,
+                  GpuAllocation&              allocation);
+    // Releases immediately; the caller is responsible for the GPU being done with the memory
+    void free(const GpuAllocation& allocation);
+    bool flush(const GpuAllocation& allocation) const;
+
+    BufferHandle createBuffer(VkDeviceSize          size,
+                              VkBufferUsageFlags    usage,
+                              VkMemoryPropertyFlags required,
+                              VkMemoryPropertyFlags preferred = 0);
+    // A non-zero viewAspect also creates a view over the whole image
+    ImageHandle createImage(const VkImageCreateInfo& imageInfo,
+                            VkImageAspectFlags       viewAspect = 0,
+                            VkMemoryPropertyFlags    required   = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                            VkImageViewType          viewType   = VK_IMAGE_VIEW_TYPE_MAX_ENUM);
+
+    GpuAllocatorStats getStats() const;
+
+  protected:
+    struct State;
+    std::shared_ptr<State> state;
+};
+} // namespace drakon
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <drakon/GpuAllocator.h>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+struct Renderer;
+
+// What the device offers for GPU-driven draws; every field may be missing, and GpuCulling falls back accordingly
+struct IndirectDrawSupport {
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount  = nullptr;
+    bool                                 multiDrawIndirect         = false;
+    bool                                 drawIndirectFirstInstance = false;
+    // Draws one indirect call may issue, which is 1 without multiDrawIndirect
+    uint32_t maxDrawIndirectCount = 1;
+};
+
+// Laid out like the std430 struct the culling shader reads
+struct GpuCullingObject {
+    float    center[3]    = {};
+    float    radius       = 0.0f;
+    uint32_t indexCount   = 0;
+    uint32_t firstIndex   = 0;
+    int32_t  vertexOffset = 0;
+    uint32_t reserved     = 0;
+};
+
+// Planes as (normal, distance), with normals pointing into the frustum
+typedef std::array<std::array<float, 4>, 6> FrustumPlanes;
+
+// Frustum-culls bounding spheres in a compute pass and draws the survivors indirectly. Without
+// VK_KHR_draw_indirect_count, culled draws keep their slot with an instance count of zero
+struct GpuCulling {
+    GpuCulling() = default;
+    GpuCulling(const GpuCulling&)            = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+
+    bool init(Renderer& renderer, uint32_t maxObjects);
+    // Retires every Vulkan object through the renderer's deferred destruction
+    void cleanup();
+
+    // Copied into each frame's object buffer as that frame is next recorded; objects past maxObjects are dropped
+    void setObjects(const std::vector<GpuCullingObject>& objects);
+    void setFrustum(const FrustumPlanes& planes);
+
+    // viewProjection is column-major and maps depth to Vulkan's [0, 1] clip range
+    static FrustumPlanes extractFrustumPlanes(const std::array<float, 16>& viewProjection);
+    static bool isSphereVisible(const FrustumPlanes& planes, const float center[3], float radius);
+
+    // Records the culling dispatch; must be outside a render pass, as from Renderable::prepare
+    void recordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    // Records the indirect draws with the caller's pipeline, vertex and index buffers bound. When the device supports
+    // drawIndirectFirstInstance, gl_InstanceIndex is the object's index
+    void recordDraws(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+    uint32_t getObjectCount() const;
+    // Survivors the last time this frame slot was culled, so it lags the current frame by the frames in flight
+    uint32_t getVisibleCount() const;
+
+  protected:
+    struct Frame {
+        BufferHandle    objects;
+        BufferHandle    draws;
+        BufferHandle    count;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        bool            objectsStale  = true;
+    };
+
+    Renderer*                     renderer            = nullptr;
+    VkDevice                      device              = VK_NULL_HANDLE;
+    IndirectDrawSupport           support;
+    VkDescriptorSetLayout         descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool              descriptorPool      = VK_NULL_HANDLE;
+    VkPipelineLayout              pipelineLayout      = VK_NULL_HANDLE;
+    VkPipeline                    pipeline            = VK_NULL_HANDLE;
+    std::vector<Frame>            frames;
+    std::vector<GpuCullingObject> objects;
+    FrustumPlanes                 planes              = {};
+    uint32_t                      maxObjects          = 0;
+    uint32_t                      visibleCount        = 0;
+};
+} // namespace drakon
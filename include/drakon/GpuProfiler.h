@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Builds configured with EXOKOMODO_DRAKON_GPU_PROFILER=OFF skip every profiler call at compile time
+#ifndef DRAKON_GPU_PROFILER
+#define DRAKON_GPU_PROFILER 1
+#endif
+
+namespace drakon {
+struct GpuScopeTiming {
+    std::string name;
+    double      milliseconds = 0.0;
+};
+
+struct GpuFrameTimings {
+    uint64_t                    frameNumber  = 0;
+    double                      milliseconds = 0.0;
+    std::vector<GpuScopeTiming> scopes;
+    // Scopes past the per-frame query budget are not timed
+    uint32_t droppedScopes = 0;
+};
+
+struct GpuScopeStats {
+    uint32_t samples             = 0;
+    double   averageMilliseconds = 0.0;
+    double   maxMilliseconds     = 0.0;
+};
+
+// Brackets GPU work with timestamp queries, one query pool per frame in flight, and keeps a ring of finished frames
+struct GpuProfiler {
+    static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+    GpuProfiler() = default;
+    GpuProfiler(const GpuProfiler&)            = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    bool init(VkPhysicalDevice physicalDevice,
+              VkDevice         device,
+              uint32_t         queueFamilyIndex,
+              uint32_t         framesInFlight,
+              uint32_t         maxScopesPerFrame);
+    void cleanup();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+    // False when the queue cannot write timestamps; the profiler then stays inactive even if enabled
+    bool isSupported() const;
+    bool isActive() const;
+    void setHistoryLength(size_t frames);
+
+    // Resets the frame's queries and opens the whole-frame scope; both must be recorded outside a render pass
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber);
+    void endFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    // Safe to call from several recording threads at once. name must outlive the frame, e.g. a string literal
+    uint32_t beginScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, const char* name);
+    void     endScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scope);
+    // Reads back the frame slot's results; call once its last frame has finished so this never blocks
+    void collect(uint32_t frameIndex);
+
+    size_t                 getHistorySize() const;
+    // An age of 0 is the most recently collected frame; age must be below getHistorySize()
+    const GpuFrameTimings& getFrame(size_t age) const;
+    // Aggregates every scope with the given name across the history, summing repeats within a frame
+    GpuScopeStats getScopeStats(const std::string& name) const;
+
+  protected:
+    struct FrameQueries {
+        VkQueryPool              queryPool = VK_NULL_HANDLE;
+        std::atomic<uint32_t>    nextScope = 0;
+        std::vector<const char*> names;
+        uint64_t                 frameNumber = 0;
+        bool                     pending     = false;
+    };
+
+    VkDevice                                   vkDevice          = VK_NULL_HANDLE;
+    bool                                       enabled           = false;
+    bool                                       supported         = false;
+    double                                     timestampPeriod   = 1.0;
+    uint64_t                                   timestampMask     = UINT64_MAX;
+    uint32_t                                   maxScopesPerFrame = 0;
+    std::vector<std::unique_ptr<FrameQueries>> frames;
+    std::vector<uint64_t>                      queryResults;
+
+    std::vector<GpuFrameTimings> history;
+    size_t                       historyLength = 120;
+    size_t                       historyNext   = 0;
+    size_t                       historyCount  = 0;
+};
+} // namespace drakon
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace drakon {
+constexpr uint64_t HASH_SEED = 0xcbf29ce484222325ull;
+
+// FNV-1a; cheap and stable across runs, so it can key on-disk caches. Not collision resistant
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = HASH_SEED) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline uint64_t hashString(std::string_view text, uint64_t hash = HASH_SEED) {
+    // Hash the length too so adjacent fields cannot run together
+    const uint64_t size = text.size();
+    return hashBytes(text.data(), text.size(), hashBytes(&size, sizeof(size), hash));
+}
+
+template <typename T>
+uint64_t hashValue(const T& value, uint64_t hash = HASH_SEED) {
+    return hashBytes(&value, sizeof(value), hash);
+}
+} // namespace drakon
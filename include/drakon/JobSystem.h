@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace drakon {
+// Chase-Lev deque: the owning thread pushes and pops at the bottom, any thread steals from the top. Grows as needed
+template <class T>
+struct WorkStealingDeque {
+    explicit WorkStealingDeque(size_t capacity = 256);
+    WorkStealingDeque(const WorkStealingDeque&)            = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only
+    void push(T* item);
+    // Owner only; null when empty
+    T* pop();
+    // Any thread; null when empty or when another thread won the race for the last item
+    T* steal();
+
+  protected:
+    struct Buffer {
+        int64_t                            capacity = 0;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+
+        std::atomic<T*>& at(int64_t index) const { return this->slots[index & (this->capacity - 1)]; }
+        T*               get(int64_t index) const { return this->at(index).load(std::memory_order_relaxed); }
+        void             put(int64_t index, T* item) { this->at(index).store(item, std::memory_order_relaxed); }
+    };
+
+    // Separate cache lines, since thieves hammer top while the owner works at bottom
+    alignas(64) std::atomic<int64_t> top    = 0;
+    alignas(64) std::atomic<int64_t> bottom = 0;
+    std::atomic<Buffer*>             buffer;
+    // Outgrown buffers stay allocated until the deque is destroyed, since a thief may still be reading one
+    std::vector<std::unique_ptr<Buffer>> buffers;
+
+    Buffer* allocateBuffer(int64_t capacity);
+};
+
+// Jobs outstanding against a wait; incremented when a job is queued and decremented once it has run
+struct JobCounter {
+    std::atomic<uint32_t> pending = 0;
+
+    bool isDone() const { return this->pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct JobSystem;
+
+// Jobs with ordering constraints between them, launched together. Must be acyclic, and must outlive its run
+struct JobGraph {
+    uint32_t add(std::function<void()> job);
+    // after does not start until before has finished
+    void     precede(uint32_t before, uint32_t after);
+    size_t   size() const;
+    void     clear();
+
+    // Queues every job without predecessors; the rest are queued by the last predecessor to finish
+    void run(JobSystem& jobs, JobCounter& counter);
+
+  protected:
+    struct Node {
+        std::function<void()> job;
+        std::vector<uint32_t> successors;
+        uint32_t              predecessorCount = 0;
+    };
+
+    std::vector<Node>                        nodes;
+    std::unique_ptr<std::atomic<uint32_t>[]> remaining;
+
+    void runNode(JobSystem& jobs, JobCounter& counter, uint32_t node);
+};
+
+// Worker threads that each own a work-stealing deque. Jobs queued from a worker go to its own deque and idle workers
+// steal from the others; jobs queued from any other thread go through a shared queue. Threads waiting on a counter
+// run queued jobs instead of blocking, so jobs may wait on jobs they queued
+struct JobSystem {
+    JobSystem() = default;
+    JobSystem(const JobSystem&)            = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    ~JobSystem();
+
+    // One fewer than the hardware threads, leaving a core for the thread that drives the frame
+    static uint32_t getDefaultWorkerCount();
+
+    // With pinToCores, worker i only runs on core i + 1, leaving core 0 to the calling thread. Linux only
+    void     start(uint32_t workerCount, bool pinToCores = false);
+    // Jobs still queued run on the calling thread before it returns
+    void     stop();
+    uint32_t getWorkerCount() const;
+
+    // Without workers the job runs immediately on the calling thread
+    void run(std::function<void()> job, JobCounter* counter = nullptr);
+    // Runs queued jobs on the calling thread until counter reaches zero
+    void wait(const JobCounter& counter);
+    // Calls body(begin, end) over [0, count) in ranges of at most grainSize, returning once every range has run. The
+    // calling thread takes the first range itself
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+  protected:
+    struct Job {
+        std::function<void()> function;
+        JobCounter*           counter = nullptr;
+    };
+
+    struct Worker {
+        WorkStealingDeque<Job> deque;
+        std::thread            thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex                           injectedMutex;
+    std::deque<Job*>                     injected;
+    std::mutex                           sleepMutex;
+    std::condition_variable              wake;
+    // Briefly negative when a thief takes a job before its push is counted
+    std::atomic<int32_t>                 queuedJobs      = 0;
+    std::atomic<uint32_t>                sleepingWorkers = 0;
+    std::atomic<bool>                    stopping        = false;
+
+    void push(Job* job);
+    // Own deque first, then the shared queue, then the other workers' deques
+    Job* take(uint32_t workerIndex);
+    void execute(Job* job);
+    void workerLoop(uint32_t workerIndex);
+};
+} // namespace drakon
+
+template <class T>
+drakon::WorkStealingDeque<T>::WorkStealingDeque(size_t capacity) {
+    this->buffer.store(this->allocateBuffer(static_cast<int64_t>(std::bit_ceil(std::max<size_t>(capacity, 2)))),
+                       std::memory_order_relaxed);
+}
+
+template <class T>
+void drakon::WorkStealingDeque<T>::push(T* item) {
+    const int64_t bottom = this->bottom.load(std::memory_order_relaxed);
+    const int64_t top    = this->top.load(std::memory_order_acquire);
+    Buffer*       buffer = this->buffer.load(std::memory_order_relaxed);
+    if (bottom - top > buffer->capacity - 1) {
+        Buffer* grown = this->allocateBuffer(buffer->capacity * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            grown->put(i, buffer->get(i));
+        }
+        this->buffer.store(grown, std::memory_order_release);
+        buffer = grown;
+    }
+    buffer->put(bottom, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+template <class T>
+T* drakon::WorkStealingDeque<T>::pop() {
+    const int64_t bottom = this->bottom.load(std::memory_order_relaxed) - 1;
+    Buffer*       buffer = this->buffer.load(std::memory_order_relaxed);
+    this->bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = this->top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        this->bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    T* item = buffer->get(bottom);
+    if (top == bottom) {
+        // The last item, which a thief may be taking at the same time
+        if (!this->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        this->bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+template <class T>
+T* drakon::WorkStealingDeque<T>::steal() {
+    int64_t top = this->top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = this->bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+
+    T* item = this->buffer.load(std::memory_order_acquire)->get(top);
+    if (!this->top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return item;
+}
+
+template <class T>
+typename drakon::WorkStealingDeque<T>::Buffer* drakon::WorkStealingDeque<T>::allocateBuffer(int64_t capacity) {
+    auto buffer      = std::make_unique<Buffer>();
+    buffer->capacity = capacity;
+    buffer->slots    = std::make_unique<std::atomic<T*>[]>(static_cast<size_t>(capacity));
+    this->buffers.push_back(std::move(buffer));
+    return this->buffers.back().get();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+struct PipelineCacheStats {
+    uint64_t cacheHits = 0;
+    uint64_t compiled  = 0;
+    // Without VK_EXT_pipeline_creation_feedback every creation is counted as compiled
+    bool feedbackAvailable = false;
+};
+
+// Owns the VkPipelineCache shared by every renderable and persists it between runs
+struct PipelineCache {
+    PipelineCache() = default;
+    PipelineCache(const PipelineCache&)            = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    bool init(VkPhysicalDevice             physicalDevice,
+              VkDevice                     device,
+              const std::filesystem::path& path,
+              bool                         creationFeedbackEnabled);
+    bool save() const;
+    bool cleanup();
+
+    VkPipelineCache    getHandle() const;
+    PipelineCacheStats getStats() const;
+
+    VkResult createGraphicsPipelines(uint32_t                            createInfoCount,
+                                     const VkGraphicsPipelineCreateInfo* createInfos,
+                                     VkPipeline*                         pipelines);
+
+  protected:
+    VkDevice                   vkDevice                = VK_NULL_HANDLE;
+    VkPipelineCache            vkPipelineCache         = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties deviceProperties        = {};
+    std::filesystem::path      path;
+    bool                       creationFeedbackEnabled = false;
+    std::atomic<uint64_t>      cacheHits               = 0;
+    std::atomic<uint64_t>      compiled                = 0;
+
+    void recordFeedback(const VkPipelineCreationFeedback& feedback);
+};
+} // namespace drakon
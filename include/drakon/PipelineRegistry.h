@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+struct PipelineCache;
+
+struct ShaderStageDescription {
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+    std::vector<uint32_t> spirv;
+    std::string           entryPoint = "main";
+};
+
+// Everything that determines a graphics pipeline. Two equal descriptions always share one VkPipeline
+struct GraphicsPipelineDescription {
+    std::vector<ShaderStageDescription>            stages;
+    std::vector<VkVertexInputBindingDescription>   vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+
+    VkPrimitiveTopology   topology    = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPolygonMode         polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags       cullMode    = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace           frontFace   = VK_FRONT_FACE_CLOCKWISE;
+    float                 lineWidth   = 1.0f;
+    VkSampleCountFlagBits samples     = VK_SAMPLE_COUNT_1_BIT;
+
+    // Opaque pipelines should enable both, so draws sorted front to back are rejected before they are shaded
+    bool        depthTest      = false;
+    bool        depthWrite     = false;
+    VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    VkPipelineColorBlendAttachmentState colorBlend = {
+        .blendEnable         = VK_FALSE,
+        .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .colorBlendOp        = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+        .alphaBlendOp        = VK_BLEND_OP_ADD,
+        .colorWriteMask =
+            VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+    std::vector<VkPushConstantRange>   pushConstantRanges;
+    // Viewport and scissor are always dynamic and set by the renderer, so they need not be listed
+    std::vector<VkDynamicState> dynamicStates;
+    uint32_t                    subpass = 0;
+
+    uint64_t hash() const;
+    bool     operator==(const GraphicsPipelineDescription& other) const;
+};
+
+struct PipelineLayout {
+    VkPipelineLayout handle = VK_NULL_HANDLE;
+};
+
+struct Pipeline {
+    VkPipeline handle = VK_NULL_HANDLE;
+    // Holding the layout here keeps it registered for as long as any pipeline built on it
+    std::shared_ptr<const PipelineLayout> layout;
+    // Small and unique among live pipelines, so it packs into a render queue sort key
+    uint32_t id = 0;
+};
+
+// Handles are reference counted; once the last copy is dropped the Vulkan object is retired through the renderer's
+// deferred destruction, so frames still in flight can keep using it
+typedef std::shared_ptr<const Pipeline>       PipelineHandle;
+typedef std::shared_ptr<const PipelineLayout> PipelineLayoutHandle;
+
+struct PipelineRegistryStats {
+    uint64_t pipelines = 0;
+    uint64_t layouts   = 0;
+    // Requests answered by an existing object rather than a new one
+    uint64_t pipelineHits = 0;
+    uint64_t layoutHits   = 0;
+};
+
+// Deduplicates pipelines and pipeline layouts across renderables. Safe to use from recording threads
+struct PipelineRegistry {
+    PipelineRegistry() = default;
+    PipelineRegistry(const PipelineRegistry&)            = delete;
+    PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+    bool init(VkDevice device, PipelineCache* pipelineCache, std::function<void(std::function<void()>)> deferDestroy);
+    // Destroys everything still registered; the device must be idle. Outstanding handles become inert
+    void cleanup();
+
+    // Returns null if the pipeline could not be created
+    PipelineHandle       getGraphicsPipeline(const GraphicsPipelineDescription& description, VkRenderPass renderPass);
+    PipelineLayoutHandle getPipelineLayout(const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+                                           const std::vector<VkPushConstantRange>&   pushConstantRanges);
+
+    PipelineRegistryStats getStats() const;
+
+  protected:
+    struct State;
+    std::shared_ptr<State> state;
+};
+} // namespace drakon
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <drakon/GpuAllocator.h>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+// How a pass touches an image, which decides the layout, pipeline stages and access masks it is synchronized with
+enum class RenderGraphAccess : uint8_t {
+    ColorAttachment,
+    DepthAttachment,
+    // Depth testing without depth writes
+    DepthRead,
+    Sampled,
+    StorageRead,
+    StorageWrite,
+    TransferSrc,
+    TransferDst,
+};
+
+// What a write starts from. Only attachments can be cleared; Load makes the write depend on the earlier contents
+enum class RenderGraphLoad : uint8_t {
+    DontCare,
+    Clear,
+    Load,
+};
+
+struct RenderGraphImageDesc {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    // A zero width or height sizes the image to the graph's extent times scale
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    float    scale  = 1.0f;
+};
+
+struct RenderGraphBarrier {
+    uint32_t             resource  = 0;
+    VkImageLayout        oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout        newLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags srcStage  = 0;
+    VkAccessFlags        srcAccess = 0;
+    VkPipelineStageFlags dstStage  = 0;
+    VkAccessFlags        dstAccess = 0;
+};
+
+struct RenderGraphAliasRequest {
+    VkMemoryRequirements requirements = {};
+    // The first and last pass using the image, inclusive
+    uint32_t firstPass = 0;
+    uint32_t lastPass  = 0;
+};
+
+// Packs requests into groups that can share one allocation: the lifetimes within a group never overlap and their
+// memory types agree. Larger requests are placed first. Returns the group of each request
+std::vector<uint32_t> assignRenderGraphAliases(const std::vector<RenderGraphAliasRequest>& requests);
+
+struct RenderGraph;
+
+struct RenderGraphPassContext {
+    VkCommandBuffer    commandBuffer = VK_NULL_HANDLE;
+    // Already begun over the pass's attachments, with the viewport and scissor covering them. Null for passes
+    // without attachments, which record outside a render pass
+    VkRenderPass       renderPass = VK_NULL_HANDLE;
+    VkExtent2D         extent     = {};
+    const RenderGraph* graph      = nullptr;
+};
+
+struct RenderGraphStats {
+    uint32_t     passes          = 0;
+    uint32_t     culledPasses    = 0;
+    uint32_t     barriers        = 0;
+    uint32_t     transientImages = 0;
+    uint32_t     aliasGroups     = 0;
+    VkDeviceSize transientBytes  = 0;
+    // What the transient images would take without aliasing
+    VkDeviceSize unaliasedBytes = 0;
+};
+
+// A frame graph: passes declare the images they read and write, and compiling culls unused passes, places barriers
+// and aliases transient images with disjoint lifetimes. Declarations persist from frame to frame and are recompiled
+// only when they or the extent change. Used from the thread that renders
+struct RenderGraph {
+    static constexpr uint32_t INVALID_RESOURCE = UINT32_MAX;
+    static constexpr uint32_t INVALID_GROUP    = UINT32_MAX;
+
+    typedef std::function<void(const RenderGraphPassContext&)> ExecuteFunction;
+
+    RenderGraph() = default;
+    RenderGraph(const RenderGraph&)            = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // Until init, compile only plans the graph, which is all tests need
+    void init(VkDevice device, GpuAllocator& allocator, std::function<void(std::function<void()>)> deferDestroy);
+    // The caller must have waited for the device to go idle
+    void cleanup();
+
+    void clear();
+    bool isEmpty() const;
+
+    uint32_t createImage(std::string name, const RenderGraphImageDesc& desc);
+    // An image owned elsewhere, such as a swapchain image, bound before each execute. It must be in initialLayout
+    // when the graph runs and is left in finalLayout. A zero extent follows the graph's
+    uint32_t importImage(std::string   name,
+                         VkFormat      format,
+                         VkExtent2D    extent,
+                         VkImageLayout initialLayout,
+                         VkImageLayout finalLayout);
+    // Binding a different view retires the framebuffers made with the previous one
+    void     bindImage(uint32_t resource, VkImage image, VkImageView view);
+    // Keeps a created image, and the passes writing it, for use after the graph has run. Outputs are never aliased
+    void     markOutput(uint32_t resource, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void     setClearValue(uint32_t resource, const VkClearValue& value);
+
+    uint32_t addPass(std::string name, ExecuteFunction execute);
+    // Each image at most once per pass, and at most one depth attachment
+    bool     use(uint32_t          pass,
+                 uint32_t          resource,
+                 RenderGraphAccess access,
+                 RenderGraphLoad   load = RenderGraphLoad::DontCare);
+    // Never culled, for passes with results that leave the graph some other way
+    void     setSideEffects(uint32_t pass);
+
+    bool compile(VkExtent2D extent);
+    // Compiles first when the declarations or extent have changed. Must be recorded outside a render pass
+    bool execute(VkCommandBuffer commandBuffer, VkExtent2D extent);
+
+    // Valid once compiled
+    bool                                   isPassCulled(uint32_t pass) const;
+    const std::vector<RenderGraphBarrier>& getPassBarriers(uint32_t pass) const;
+    const std::vector<RenderGraphBarrier>& getFinalBarriers() const;
+    // INVALID_GROUP for imported images and images no pass uses
+    uint32_t                               getAliasGroup(uint32_t resource) const;
+    VkImage                                getImage(uint32_t resource) const;
+    VkImageView                            getImageView(uint32_t resource) const;
+    VkExtent2D                             getExtent(uint32_t resource) const;
+    RenderGraphStats                       getStats() const;
+
+  protected:
+    struct Resource {
+        std::string   name;
+        VkFormat      format        = VK_FORMAT_UNDEFINED;
+        VkExtent2D    size          = {};
+        float         scale         = 1.0f;
+        bool          imported      = false;
+        bool          output        = false;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout finalLayout   = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkClearValue  clearValue    = {};
+
+        VkExtent2D        extent    = {};
+        VkImageUsageFlags usage     = 0;
+        uint32_t          firstPass = UINT32_MAX;
+        uint32_t          lastPass  = 0;
+        uint32_t          group     = INVALID_GROUP;
+        VkImage           image     = VK_NULL_HANDLE;
+        VkImageView       view      = VK_NULL_HANDLE;
+
+        bool isUsed() const { return this->firstPass != UINT32_MAX; }
+    };
+
+    struct PassUse {
+        uint32_t          resource = 0;
+        RenderGraphAccess access   = RenderGraphAccess::Sampled;
+        RenderGraphLoad   load     = RenderGraphLoad::DontCare;
+    };
+
+    struct Pass {
+        std::string                     name;
+        ExecuteFunction                 execute;
+        std::vector<PassUse>            uses;
+        bool                            sideEffects = false;
+        bool                            culled      = false;
+        std::vector<RenderGraphBarrier> barriers;
+        // Indices into uses: color attachments in declaration order, then the depth attachment
+        std::vector<uint32_t>           attachments;
+        VkExtent2D                      extent     = {};
+        VkRenderPass                    renderPass = VK_NULL_HANDLE;
+        // Keyed by the attachments' views, which change with the images bound to imports
+        std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+    };
+
+    struct AliasGroup {
+        VkMemoryRequirements  requirements = {};
+        std::vector<uint32_t> resources;
+        GpuAllocation         allocation;
+    };
+
+    VkDevice                                   device    = VK_NULL_HANDLE;
+    GpuAllocator*                              allocator = nullptr;
+    std::function<void(std::function<void()>)> deferDestroy;
+    std::vector<Resource>                      resources;
+    std::vector<Pass>                          passes;
+    std::vector<AliasGroup>                    groups;
+    std::vector<RenderGraphBarrier>            finalBarriers;
+    VkExtent2D                                 compiledExtent = {};
+    bool                                       compiled       = false;
+    RenderGraphStats                           stats;
+    std::vector<VkImageMemoryBarrier>          imageBarriers;
+    std::vector<VkClearValue>                  clearValues;
+
+    void                 invalidate();
+    void                 cull();
+    bool                 computeLifetimes(VkExtent2D extent);
+    bool                 assignMemory();
+    VkMemoryRequirements getMemoryRequirements(Resource& resource);
+    void                 buildBarriers();
+    bool                 createVulkanObjects();
+    bool                 createRenderPass(uint32_t passIndex);
+    VkFramebuffer        getFramebuffer(Pass& pass);
+    void                 releaseFramebuffers(VkImageView view);
+    // Deferred past the frames in flight unless immediately is set
+    void                 releaseVulkanObjects(bool immediately);
+    void                 recordBarriers(VkCommandBuffer                        commandBuffer,
+                                        const std::vector<RenderGraphBarrier>& barriers);
+};
+} // namespace drakon
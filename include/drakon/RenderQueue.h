@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+// Everything needed to replay one draw, so the queue can reorder draws without calling back into renderables
+struct DrawPacket {
+    uint64_t sortKey = 0;
+
+    VkPipeline       pipeline       = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    // Bound at set 0; with a dynamic uniform or storage buffer, dynamicOffset is applied as its single offset
+    VkDescriptorSet descriptorSet      = VK_NULL_HANDLE;
+    uint32_t        dynamicOffsetCount = 0;
+    uint32_t        dynamicOffset      = 0;
+    // Pushed at offset 0 before every draw when pushConstantSize, at most 16 bytes, is non-zero
+    VkShaderStageFlags      pushConstantStages = 0;
+    uint32_t                pushConstantSize   = 0;
+    std::array<uint32_t, 4> pushConstants      = {};
+
+    VkBuffer     vertexBuffer       = VK_NULL_HANDLE;
+    VkDeviceSize vertexBufferOffset = 0;
+    // A null index buffer draws non-indexed
+    VkBuffer     indexBuffer       = VK_NULL_HANDLE;
+    VkDeviceSize indexBufferOffset = 0;
+    VkIndexType  indexType         = VK_INDEX_TYPE_UINT16;
+
+    // Vertices, or indices when indexed
+    uint32_t count         = 0;
+    uint32_t instanceCount = 1;
+    uint32_t first         = 0;
+    int32_t  vertexOffset  = 0;
+    uint32_t firstInstance = 0;
+};
+
+struct RenderQueueStats {
+    uint64_t packets                = 0;
+    uint64_t pipelineBinds          = 0;
+    uint64_t pipelineBindsSkipped   = 0;
+    uint64_t descriptorBinds        = 0;
+    uint64_t descriptorBindsSkipped = 0;
+    uint64_t bufferBinds            = 0;
+    uint64_t bufferBindsSkipped     = 0;
+};
+
+// Collects draw packets for a frame, sorts them by key and replays them with redundant binds skipped
+struct RenderQueue {
+    static constexpr uint32_t PASS_BITS     = 8;
+    static constexpr uint32_t PIPELINE_BITS = 16;
+    static constexpr uint32_t MATERIAL_BITS = 16;
+    static constexpr uint32_t DEPTH_BITS    = 24;
+    // Opaque keys lead with this many of the depth's top bits
+    static constexpr uint32_t DEPTH_BAND_BITS = 4;
+
+    // The scene's buckets: opaque draws first, then blended draws over them
+    static constexpr uint32_t OPAQUE_PASS      = 0;
+    static constexpr uint32_t TRANSPARENT_PASS = 1;
+
+    // Most significant first, so packets group by pass, then pipeline, then material, then depth. Wider values are
+    // truncated, which only costs grouping, never correctness
+    static uint64_t makeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth);
+    // In OPAQUE_PASS, ordered by depth band, then pipeline, then material, then the rest of the depth. Nearer draws
+    // come roughly first, so they fill the depth buffer and early-Z rejects what they cover, while draws within a
+    // band still share state
+    static uint64_t makeOpaqueSortKey(uint32_t pipeline, uint32_t material, uint32_t depth);
+    // In TRANSPARENT_PASS, strictly back to front so blending composites correctly; state only breaks ties
+    static uint64_t makeTransparentSortKey(uint32_t pipeline, uint32_t material, uint32_t depth);
+    // Maps a depth in [0, 1] onto the key's depth field; pass 1 - depth for back-to-front ordering
+    static uint32_t quantizeDepth(float depth);
+
+    void clear();
+    void submit(const DrawPacket& packet);
+    void submit(const DrawPacket* packets, size_t count);
+    // Stable, so packets with equal keys replay in submission order
+    void sort();
+
+    size_t size() const;
+    bool   empty() const;
+    // Indexed in sorted order once sort has run
+    const DrawPacket& getPacket(size_t index) const;
+
+    // Records sorted packets [begin, end). Disjoint ranges may be recorded concurrently into different command buffers
+    void record(VkCommandBuffer commandBuffer, size_t begin, size_t end);
+
+    // Accumulated over every record call since the last reset
+    RenderQueueStats getStats() const;
+    void             resetStats();
+
+  protected:
+    struct SortEntry {
+        uint64_t key   = 0;
+        uint32_t index = 0;
+    };
+
+    std::vector<DrawPacket> packets;
+    std::vector<SortEntry>  order;
+    std::vector<SortEntry>  scratch;
+
+    std::atomic<uint64_t> recordedPackets        = 0;
+    std::atomic<uint64_t> pipelineBinds          = 0;
+    std::atomic<uint64_t> pipelineBindsSkipped   = 0;
+    std::atomic<uint64_t> descriptorBinds        = 0;
+    std::atomic<uint64_t> descriptorBindsSkipped = 0;
+    std::atomic<uint64_t> bufferBinds            = 0;
+    std::atomic<uint64_t> bufferBindsSkipped     = 0;
+};
+} // namespace drakon
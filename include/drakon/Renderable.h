@@ -1,17 +1,54 @@
 #pragma once
 
+#include <drakon/PipelineRegistry.h>
+#include <drakon/RenderQueue.h>
+#include <drakon/UploadRing.h>
+
 #include <vulkan/vulkan.h>
 
 namespace drakon {
+struct PipelineCache;
+
+// Renderer state handed to each renderable while its commands are recorded
+struct RenderContext {
+    VkDevice     device     = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    // Size of the viewport the renderer has already set; pipelines take it as dynamic state and never bake it
+    VkExtent2D     extent        = {};
+    PipelineCache* pipelineCache = nullptr;
+    // Shared pipelines; renderables should request theirs here rather than create their own
+    PipelineRegistry* pipelineRegistry = nullptr;
+    // Per-frame dynamic vertex and uniform data; renderables recording in parallel must use the concurrent calls
+    UploadRing* uploadRing = nullptr;
+    // How far the frame lies between the last two fixed simulation steps, in [0, 1)
+    float interpolationAlpha = 1.0f;
+    // The frame-in-flight slot being recorded; per-frame GPU resources indexed by it are free to overwrite
+    uint32_t frameIndex = 0;
+};
+
 struct Renderable {
-    virtual void draw(VkCommandBuffer commandBuffer, VkDevice device, VkRenderPass renderPass, VkExtent2D extent) = 0;
+    virtual ~Renderable() = default;
+    // Records work that must happen outside the render pass, such as compute dispatches, before any draw this frame
+    virtual void prepare(VkCommandBuffer commandBuffer, const RenderContext& context);
+    // Adds this frame's draw packets to the queue, which sorts them against every other renderable's. Return false to
+    // be drawn through draw instead, for renderables that need commands a packet cannot express
+    virtual bool submit(RenderQueue& queue, const RenderContext& context);
+    // Records commands directly, after every queued packet
+    virtual void draw(VkCommandBuffer commandBuffer, const RenderContext& context);
+    // Opt in to being drawn on a recording worker thread, concurrently with other renderables' draw calls
+    virtual bool canRecordInParallel() const { return false; }
+    // Labels this renderable's GPU profiler scope; must outlive the frame, so a string literal is typical
+    virtual const char* getDebugName() const { return "Renderable"; }
 
   protected:
     bool isInitialized = false;
 
-    VkPipelineLayout pipelineLayout   = VK_NULL_HANDLE;
-    VkPipeline       graphicsPipeline = VK_NULL_HANDLE;
+    // Shared with every renderable whose description matches
+    PipelineHandle pipeline;
 
-    bool ensurePipeline(VkDevice device, VkRenderPass renderPass, VkExtent2D extent);
+    // Fills in the pipeline this renderable draws with; return false if it draws without one
+    virtual bool describePipeline(const RenderContext& context, GraphicsPipelineDescription& description) const;
+    // Fetches the described pipeline from the registry on first use
+    bool ensurePipeline(const RenderContext& context);
 };
 } // namespace drakon
@@ -1,13 +1,31 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <filesystem>
 #include <functional>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include <drakon/DynamicResolution.h>
+#include <drakon/GpuAllocator.h>
+#include <drakon/GpuCulling.h>
+#include <drakon/GpuProfiler.h>
+#include <drakon/JobSystem.h>
+#include <drakon/PipelineCache.h>
+#include <drakon/PipelineRegistry.h>
+#include <drakon/RenderGraph.h>
+#include <drakon/RenderQueue.h>
 #include <drakon/Renderable.h>
+#include <drakon/ShaderCompiler.h>
+#include <drakon/TextureCache.h>
+#include <drakon/TransferQueue.h>
+#include <drakon/UploadRing.h>
+#include <drakon/World.h>
 
 #include <vulkan/vulkan.h>
 
@@ -16,17 +34,108 @@ enum class RendererBackend {
     Vulkan,
 };
 
+// Time from input being sampled to the GPU finishing the frame built from it. Vulkan core cannot observe the display
+// itself, so presentation adds up to one refresh on top. Completion is noticed when the renderer next polls or waits
+// on the frame, making each sample an upper bound that is tightest in low-latency mode
+struct LatencyStats {
+    uint64_t frames              = 0;
+    double   lastMilliseconds    = 0.0;
+    double   averageMilliseconds = 0.0;
+    double   maxMilliseconds     = 0.0;
+};
+
 struct Renderer {
+    // Per-frame resources exist for this many slots, so the count in flight can change without recreating them
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
     Renderer() = default;
     Renderer(RendererBackend backend);
     virtual ~Renderer() = default;
-    bool                  render(std::vector<Renderable*> renderables);
+    // Entities in world with a DrawPacket component are submitted straight into the render queue
+    bool                  render(const std::vector<Renderable*>& renderables, World* world = nullptr);
     bool                  cleanup();
     void                  setClearColor(const std::array<float, 4> clearColor);
     std::array<float, 4>& getClearColor();
     RendererBackend       getBackend() const;
     bool                  compileGlslShader(const std::string& filename) const;
+    ShaderCompiler&       getShaderCompiler();
+    bool                  isHeadless() const;
+    PipelineCache&        getPipelineCache();
+    PipelineRegistry&     getPipelineRegistry();
+    GpuProfiler&          getGpuProfiler();
+    GpuAllocator&         getGpuAllocator();
+    UploadRing&           getUploadRing();
+    TextureCache&         getTextureCache();
+    // Unavailable without a transfer-only queue family and timeline semaphores
+    TransferQueue&        getTransferQueue();
+    // Runs every frame before the scene, which may sample the images it outputs
+    RenderGraph&          getRenderGraph();
+    RenderQueue&          getRenderQueue();
+    VkDevice              getDevice() const;
+    // The scene pass clears a depth attachment each frame; pipelines opt in to testing against it
+    VkRenderPass          getRenderPass() const;
+    // D32 where the device supports it as an attachment, otherwise D24S8
+    VkFormat              getDepthFormat() const;
+    // Frames the CPU may queue ahead of the GPU, from 1 to MAX_FRAMES_IN_FLIGHT; fewer cut latency at the cost of
+    // CPU and GPU overlap. Takes effect at the start of the next frame, once every frame in flight has finished
+    void     setFramesInFlight(uint32_t count);
+    uint32_t getFramesInFlight() const;
+    // Frame slots that per-frame resources must cover; RenderContext::frameIndex is always below this
+    uint32_t getFrameSlotCount() const;
+    // IMMEDIATE, MAILBOX, FIFO or FIFO_RELAXED. Recreates the swapchain at the next frame, falling back to FIFO, which
+    // every device supports, when the surface lacks the mode
+    void             setPresentMode(VkPresentModeKHR mode);
+    // The mode the swapchain was actually created with
+    VkPresentModeKHR getPresentMode() const;
+    // When set, Game waits for the next frame slot before polling input instead of inside render, so the frame is
+    // built from input sampled as late as possible
+    void setLowLatencyMode(bool enabled);
+    bool isLowLatencyMode() const;
+    // Renders the scene into a target the size of the swapchain, over an area scaled each frame to keep GPU frame time
+    // within budget, then blits it up to the swapchain image. Frames are timed with the GPU profiler, which enabling
+    // turns on; without timestamps the scale stays at its maximum. Ignored when swapchain images cannot be blitted to.
+    // Enabling fails when the profiler is compiled out
+    bool setDynamicResolution(bool enabled);
+    bool isDynamicResolution() const;
+    // Holds the budget and scale limits
+    DynamicResolution& getDynamicResolution();
+    // The area of the framebuffer the scene covers this frame, which RenderContext::extent also reports
+    VkExtent2D getRenderExtent() const;
+    // Blocks until the next frame's slot is free, so render can start without waiting
+    void waitForFrameSlot();
+    // Frames are numbered from 1 in submission order. With timeline semaphores each submit signals its number on one
+    // semaphore; otherwise completion is read from the frame slots' fences
+    uint64_t getSubmittedFrame() const;
+    // The newest frame that has finished on the GPU along with every frame before it. Never blocks
+    uint64_t getCompletedFrame();
+    bool     isFrameComplete(uint64_t frame);
+    // False on timeout, or when frame has not been submitted yet
+    bool     waitForFrame(uint64_t frame, uint64_t timeoutNanoseconds = UINT64_MAX);
+    bool     hasFrameTimeline() const;
+    // Timestamps the input the next rendered frame is built from; frames without a mark count from render
+    void         markInputSampled();
+    LatencyStats getLatencyStats() const;
+    void         resetLatencyStats();
+    // Valid once init has created the device
+    const IndirectDrawSupport& getIndirectDrawSupport() const;
+    // Where the pipeline cache is loaded from at init and saved to at cleanup; empty disables persistence
+    void setPipelineCachePath(std::filesystem::path path);
+    // Bytes of dynamic data each frame may stream through the upload ring; applied by init
+    void setUploadRingSize(VkDeviceSize bytesPerFrame);
+    // Marks the swapchain for recreation at the start of the next frame
+    void resize(uint32_t width, uint32_t height);
+    // Runs destroy once the frame being recorded, and every frame before it, has finished on the GPU. Safe to call
+    // from recording threads
+    void deferDestruction(std::function<void()> destroy);
+    void setInterpolationAlpha(float alpha);
+    // Secondary command buffer streams recorded as jobs alongside the calling thread's own; 0 records every
+    // renderable inline on the calling thread
+    void     setRecordingThreadCount(uint32_t threadCount);
+    uint32_t getRecordingThreadCount() const;
+    // Runs parallel recording; without one, the streams are recorded one after another on the calling thread
+    void setJobSystem(JobSystem* jobSystem);
 
+    // A null window handle selects headless mode, rendering into offscreen images instead of a swapchain
     bool init(void* windowHandle, uint32_t width, uint32_t height);
 
   protected:
@@ -35,6 +144,32 @@ struct Renderer {
     void*                nativeWindowHandle = nullptr;
     uint32_t             windowWidth        = 1280;
     uint32_t             windowHeight       = 720;
+    bool                 headless           = false;
+
+    std::filesystem::path pipelineCachePath = "drakon_pipeline_cache.bin";
+    PipelineCache         pipelineCache;
+    PipelineRegistry      pipelineRegistry;
+    bool                  pipelineCreationFeedbackEnabled = false;
+    float                 interpolationAlpha              = 1.0f;
+    uint32_t              recordingThreadCount            = 0;
+    JobSystem*            jobSystem                       = nullptr;
+    GpuProfiler           gpuProfiler;
+    GpuAllocator          gpuAllocator;
+    UploadRing            uploadRing;
+    VkDeviceSize          uploadRingSize                  = VkDeviceSize(4) << 20;
+    TextureCache          textureCache;
+    TransferQueue         transferQueue;
+    RenderGraph           renderGraph;
+    ShaderCompiler        shaderCompiler;
+    RenderQueue           renderQueue;
+    IndirectDrawSupport   indirectDrawSupport;
+    // The features the device was created with
+    VkPhysicalDeviceFeatures enabledFeatures           = {};
+    uint32_t                 instanceApiVersion        = VK_API_VERSION_1_0;
+    bool                     timelineSemaphoresEnabled = false;
+    bool                     transferQueueEnabled      = false;
+    // Renderables that declined to submit packets this frame and are drawn through Renderable::draw
+    std::vector<Renderable*> customRenderables;
 
     VkInstance                   vkInstance     = VK_NULL_HANDLE;
     VkSurfaceKHR                 vkSurface      = VK_NULL_HANDLE;
@@ -45,39 +180,152 @@ struct Renderer {
     VkSwapchainKHR               swapchain      = VK_NULL_HANDLE;
     std::vector<VkImage>         swapchainImages;
     std::vector<VkImageView>     swapchainViews;
+    std::vector<ImageHandle>     offscreenImages;
     VkFormat                     swapchainFormat = VK_FORMAT_UNDEFINED;
     VkExtent2D                   swapchainExtent = {};
-    VkRenderPass                 renderPass      = VK_NULL_HANDLE;
+    VkFormat                     depthFormat     = VK_FORMAT_UNDEFINED;
+    ImageHandle                  depthImage;
+    VkImageView                  depthView  = VK_NULL_HANDLE;
+    VkRenderPass                 renderPass = VK_NULL_HANDLE;
     std::vector<VkFramebuffer>   framebuffers;
     VkCommandPool                commandPool = VK_NULL_HANDLE;
     std::vector<VkCommandBuffer> commandBuffers;
     std::vector<VkSemaphore>     imageAvailableSemaphores;
     std::vector<VkSemaphore>     renderFinishedSemaphores;
     std::vector<VkFence>         inFlightFences;
-    uint32_t                     currentFrame = 0;
+    VkSemaphore                  frameTimeline      = VK_NULL_HANDLE;
+    uint32_t                     currentFrame       = 0;
+    uint64_t                     frameNumber        = 0;
+    uint64_t                     completedFrame     = 0;
+    bool                         swapchainOutOfDate = false;
+    // The frame each slot last submitted
+    std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> slotFrames               = {};
+    PFN_vkGetSemaphoreCounterValueKHR          getSemaphoreCounterValue = nullptr;
+    PFN_vkWaitSemaphoresKHR                    waitSemaphores           = nullptr;
+
+    uint32_t         framesInFlight          = 2;
+    uint32_t         requestedFramesInFlight = 2;
+    VkPresentModeKHR requestedPresentMode    = VK_PRESENT_MODE_MAILBOX_KHR;
+    VkPresentModeKHR presentMode             = VK_PRESENT_MODE_FIFO_KHR;
+    bool             lowLatencyMode          = false;
+
+    DynamicResolution dynamicResolution;
+    bool              dynamicResolutionEnabled = false;
+    // Set when the swapchain images accept blits from a target of their own format
+    bool     upscaleSupported = false;
+    VkFilter upscaleFilter    = VK_FILTER_NEAREST;
+    // The scene's target under dynamic resolution, rendered through a render pass that leaves it ready to blit
+    ImageHandle   sceneImage;
+    VkImageView   sceneView        = VK_NULL_HANDLE;
+    VkFramebuffer sceneFramebuffer = VK_NULL_HANDLE;
+    VkRenderPass  scaledRenderPass = VK_NULL_HANDLE;
+    VkExtent2D    renderExtent     = {};
+    // The scale each recent frame was rendered at, indexed by frame number modulo the slots
+    std::array<float, MAX_FRAMES_IN_FLIGHT> frameScales       = {};
+    uint64_t                                lastMeasuredFrame = UINT64_MAX;
+
+    // When each slot's frame had its input sampled, while the slot's completion has not yet been observed
+    std::array<std::chrono::steady_clock::time_point, MAX_FRAMES_IN_FLIGHT> frameInputTimes = {};
+    std::array<bool, MAX_FRAMES_IN_FLIGHT>                                  latencyPending  = {};
+    std::chrono::steady_clock::time_point                                   inputSampleTime;
+    bool                                                                    inputSampled = false;
+    LatencyStats                                                            latencyStats;
+
+    // Everything sized by the swapchain extent, retired as a unit when the swapchain is recreated
+    struct SwapchainResources {
+        VkSwapchainKHR             swapchain = VK_NULL_HANDLE;
+        std::vector<VkImage>       images;
+        std::vector<ImageHandle>   offscreenImages;
+        std::vector<VkImageView>   views;
+        std::vector<VkFramebuffer> framebuffers;
+        ImageHandle                depthImage;
+        VkImageView                depthView = VK_NULL_HANDLE;
+        ImageHandle                sceneImage;
+        VkImageView                sceneView        = VK_NULL_HANDLE;
+        VkFramebuffer              sceneFramebuffer = VK_NULL_HANDLE;
+    };
+
+    struct DeferredDestruction {
+        uint64_t              frameNumber = 0;
+        std::function<void()> destroy;
+    };
+    std::deque<DeferredDestruction> deferredDestructions;
+    std::mutex                      deferredDestructionsMutex;
+
+    // Command pools are externally synchronized, so each recording thread owns one per frame in flight
+    struct SecondaryCommandPool {
+        VkCommandPool                pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> commandBuffers;
+        size_t                       used = 0;
+    };
+    // Indexed by frame * (recordingThreadCount + 1) + thread, with the calling thread last
+    std::vector<SecondaryCommandPool> secondaryCommandPools;
+
+    // A contiguous run of renderables or queue packets, recorded into one secondary command buffer by one thread
+    struct RecordingSegment {
+        size_t          begin         = 0;
+        size_t          end           = 0;
+        uint32_t        thread        = 0;
+        bool            renderQueue   = false;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    };
+    std::vector<RecordingSegment> recordingSegments;
 
     struct QueueFamilyIndices {
         std::optional<uint32_t> graphicsFamily;
         std::optional<uint32_t> presentFamily;
+        // Only set for a family without graphics or compute
+        std::optional<uint32_t> transferFamily;
 
         bool isComplete() const { return graphicsFamily.has_value() && presentFamily.has_value(); }
     };
 
+    // Waits for the current slot's last frame and applies a pending change to the frames in flight
+    void               waitForCurrentFrame();
+    // Records the latency of every slot whose frame has finished since it was last observed
+    void               observeFrameCompletion();
     bool               createVulkanInstance();
     bool               createVulkanSurface();
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
     bool               pickPhysicalDevice();
     bool               createLogicalDevice();
-    bool               createSwapchain();
+    bool               createSwapchain(VkSwapchainKHR oldSwapchain);
+    bool               createOffscreenTargets();
     bool               createImageViews();
+    bool               createDepthTarget();
     bool               createRenderPass();
     bool               createFramebuffers();
+    bool               createSceneTarget();
     bool               createCommandPool();
     bool               createCommandBuffers();
     bool               createSyncObjects();
+    bool               createSecondaryCommandPools();
+    void               destroySecondaryCommandPools();
     bool               recordCommandBuffer(VkCommandBuffer                 commandBuffer,
                                            uint32_t                        imageIndex,
-                                           const std::vector<Renderable*>& renderables);
-    void               destroySwapchainResources();
+                                           const std::vector<Renderable*>& renderables,
+                                           World*                          world);
+    // Pipelines take both as dynamic state, so they are set at the start of every command buffer in the pass
+    void               setViewportAndScissor(VkCommandBuffer commandBuffer) const;
+    // Feeds the newest timed frame to the controller and sizes this frame's render area
+    void               updateRenderExtent();
+    // Blits the scene target's render area over the whole swapchain image, leaving it ready to present
+    void               recordUpscale(VkCommandBuffer commandBuffer, uint32_t imageIndex) const;
+    void               buildRecordingSegments(const std::vector<Renderable*>& renderables);
+    bool               recordSecondaryCommandBuffers(uint32_t                        imageIndex,
+                                                     const std::vector<Renderable*>& renderables,
+                                                     const RenderContext&            context);
+    void               drawRenderable(VkCommandBuffer      commandBuffer,
+                                      Renderable&          renderable,
+                                      const RenderContext& context);
+    void               drawRenderQueue(VkCommandBuffer commandBuffer, size_t begin, size_t end);
+    bool               recordSegment(RecordingSegment&               segment,
+                                     uint32_t                        imageIndex,
+                                     const std::vector<Renderable*>& renderables,
+                                     const RenderContext&            context);
+    bool               recreateSwapchain();
+    SwapchainResources releaseSwapchainResources();
+    void               destroySwapchainResources(SwapchainResources& resources) const;
+    void               destroyCompletedDeferrals(bool waitedIdle);
 };
 } // namespace drakon
\ No newline at end of file
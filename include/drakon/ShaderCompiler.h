@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace drakon {
+struct JobSystem;
+
+enum class ShaderStage {
+    // Picked from the file extension: .vert, .frag, .comp, .geom, .tesc or .tese
+    Infer,
+    Vertex,
+    Fragment,
+    Compute,
+    Geometry,
+    TessellationControl,
+    TessellationEvaluation,
+};
+
+struct ShaderCompileOptions {
+    ShaderStage                                      stage = ShaderStage::Infer;
+    std::vector<std::pair<std::string, std::string>> defines;
+    bool                                             optimize  = true;
+    bool                                             debugInfo = false;
+};
+
+struct ShaderCompileRequest {
+    std::filesystem::path path;
+    ShaderCompileOptions  options;
+};
+
+struct ShaderCompileResult {
+    bool                  success   = false;
+    bool                  fromCache = false;
+    std::vector<uint32_t> spirv;
+    // Compiler diagnostics, including warnings on success
+    std::string log;
+};
+
+// Compiles GLSL to SPIR-V in memory, through shaderc when the build links it and glslc otherwise.
+// Results are cached on disk under a hash of the source, stage, defines and options, so an unchanged shader costs a
+// hash and a file read. #include directives are not resolved, so shaders must be self-contained
+struct ShaderCompiler {
+    // An empty directory disables the cache
+    void                         setCacheDirectory(std::filesystem::path directory);
+    const std::filesystem::path& getCacheDirectory() const;
+    // True when compiling in process rather than through glslc
+    static bool isInProcess();
+
+    ShaderCompileResult compile(const std::filesystem::path& path, const ShaderCompileOptions& options = {}) const;
+    // name is used for stage inference and diagnostics
+    ShaderCompileResult compileSource(const std::string&          source,
+                                      const std::string&          name,
+                                      const ShaderCompileOptions& options = {}) const;
+    // Compiles every request as a job on jobs, with the calling thread taking a share
+    std::vector<ShaderCompileResult> compileAll(const std::vector<ShaderCompileRequest>& requests,
+                                                JobSystem&                               jobs) const;
+
+  protected:
+    std::filesystem::path cacheDirectory = "drakon_shader_cache";
+};
+} // namespace drakon
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <drakon/GpuAllocator.h>
+#include <drakon/Renderable.h>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+struct Renderer;
+
+// A textured quad in pixels, with the origin at the top left of the screen
+struct Sprite {
+    float position[2] = {};
+    float size[2]     = {1.0f, 1.0f};
+    // The point position refers to and rotation turns about, as a fraction of size
+    float origin[2] = {};
+    // Radians, clockwise on screen
+    float rotation = 0.0f;
+    // u0, v0, u1, v1 within the texture layer
+    float uv[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    // RGBA8 with red in the lowest byte; multiplies the texture
+    uint32_t color = 0xFFFFFFFF;
+    // Texture array layer to sample
+    uint32_t layer = 0;
+};
+
+struct SpriteVertex {
+    float    position[2] = {};
+    float    uv[2]       = {};
+    uint32_t color       = 0;
+    uint32_t layer       = 0;
+};
+
+struct SpriteBatchStats {
+    uint64_t sprites   = 0;
+    uint32_t drawCalls = 0;
+    // CPU time spent expanding sprites into vertices for the last frame
+    double expandMilliseconds = 0.0;
+};
+
+// Draws any number of sprites with one pipeline and one descriptor set. Every texture is a layer of one texture
+// array, so sprites never need to be split by texture; vertices are expanded on the CPU into a per-frame streaming
+// buffer and drawn in chunks of SPRITES_PER_DRAW, sharing one static index buffer
+struct SpriteBatch : public Renderable {
+    static constexpr uint32_t SPRITES_PER_DRAW = 1u << 16;
+
+    SpriteBatch() = default;
+    SpriteBatch(const SpriteBatch&)            = delete;
+    SpriteBatch& operator=(const SpriteBatch&) = delete;
+
+    // Layers start out opaque white, so untextured sprites draw as their color
+    bool init(Renderer& renderer, uint32_t layerWidth, uint32_t layerHeight, uint32_t layerCount);
+    // Retires every Vulkan object through the renderer's deferred destruction
+    void cleanup();
+
+    // Replaces a layer with layerWidth * layerHeight RGBA8 texels, uploaded through the upload ring as frames allow
+    bool setLayerPixels(uint32_t layer, const void* rgba);
+
+    // Sprites persist across frames until cleared, and draw in the order they were added
+    void   clear();
+    void   add(const Sprite& sprite);
+    void   add(const Sprite* sprites, size_t count);
+    size_t size() const;
+    // Packets are submitted in this render queue pass, so sprites can draw before or after other renderables
+    void setPass(uint32_t pass);
+
+    // Writes four vertices per sprite, in the order top left, top right, bottom right, bottom left
+    static void expandQuads(const Sprite* sprites, size_t count, SpriteVertex* vertices);
+
+    void        prepare(VkCommandBuffer commandBuffer, const RenderContext& context) override;
+    bool        submit(RenderQueue& queue, const RenderContext& context) override;
+    const char* getDebugName() const override { return "SpriteBatch"; }
+
+    const SpriteBatchStats& getStats() const;
+
+  protected:
+    struct Frame {
+        BufferHandle vertices;
+        size_t       capacity = 0;
+        // The frame's screen transform in the upload ring, bound as a dynamic uniform buffer offset
+        uint32_t uniformOffset = 0;
+        bool     ready         = false;
+    };
+
+    struct LayerUpload {
+        uint32_t             layer = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    Renderer*                renderer            = nullptr;
+    VkDevice                 device              = VK_NULL_HANDLE;
+    ImageHandle              texture;
+    VkSampler                sampler             = VK_NULL_HANDLE;
+    VkDescriptorSetLayout    descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool         descriptorPool      = VK_NULL_HANDLE;
+    VkDescriptorSet          descriptorSet       = VK_NULL_HANDLE;
+    BufferHandle             indices;
+    std::vector<Frame>       frames;
+    uint32_t                 frameIndex          = 0;
+    std::vector<uint32_t>    vertexSpirv;
+    std::vector<uint32_t>    fragmentSpirv;
+    std::vector<Sprite>      sprites;
+    std::vector<LayerUpload> pendingUploads;
+    bool                     textureInitialized  = false;
+    uint32_t                 layerWidth          = 0;
+    uint32_t                 layerHeight         = 0;
+    uint32_t                 layerCount          = 0;
+    uint32_t                 pass                = 0;
+    SpriteBatchStats         stats;
+
+    bool describePipeline(const RenderContext& context, GraphicsPipelineDescription& description) const override;
+    bool reserveVertices(Frame& frame, size_t spriteCount);
+    void recordLayerUploads(VkCommandBuffer commandBuffer);
+};
+} // namespace drakon
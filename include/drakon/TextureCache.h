@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <drakon/AssetLoader.h>
+#include <drakon/GpuAllocator.h>
+#include <drakon/TransferQueue.h>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+// Texel block dimensions and size; 1x1 blocks for uncompressed formats. blockBytes is 0 for unknown formats
+struct TextureFormatInfo {
+    uint32_t blockWidth  = 1;
+    uint32_t blockHeight = 1;
+    uint32_t blockBytes  = 0;
+
+    bool isCompressed() const { return this->blockWidth > 1 || this->blockHeight > 1; }
+};
+
+TextureFormatInfo getTextureFormatInfo(VkFormat format);
+
+struct Ktx2Level {
+    uint64_t offset = 0;
+    uint64_t size   = 0;
+};
+
+// The parts of a KTX2 header needed to upload it. Levels run from the full size image down
+struct Ktx2Image {
+    VkFormat               format     = VK_FORMAT_UNDEFINED;
+    uint32_t               width      = 0;
+    uint32_t               height     = 1;
+    uint32_t               depth      = 1;
+    uint32_t               layerCount = 1;
+    uint32_t               faceCount  = 1;
+    // The file asked for a full mip chain but only stores the top level
+    bool                   generateMips = false;
+    std::vector<Ktx2Level> levels;
+};
+
+// Validates the header and level index against size. Supercompressed files are rejected
+bool parseKtx2(const std::byte* data, size_t size, Ktx2Image& image, std::string& error);
+
+// The uncompressed format decodeBlockCompressed produces for format, or VK_FORMAT_UNDEFINED when it has no decoder
+VkFormat getDecodedFormat(VkFormat format);
+// Expands one width x height slice of BC1 to BC5 blocks into tightly packed RGBA8
+bool     decodeBlockCompressed(
+        VkFormat format, uint32_t width, uint32_t height, const std::byte* blocks, uint8_t* rgba);
+
+enum class TextureState : uint8_t {
+    Loading,
+    Ready,
+    Failed,
+};
+
+struct Texture {
+    explicit Texture(std::filesystem::path path) : path(std::move(path)) {}
+    Texture(const Texture&)            = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    const std::filesystem::path& getPath() const;
+    TextureState                 getState() const;
+    bool                         isReady() const;
+    // Null until ready. Sampling it in the frame that made it ready is safe, since uploads are recorded first
+    const ImageHandle&           getImage() const;
+
+  protected:
+    std::filesystem::path path;
+    TextureState          state = TextureState::Loading;
+    ImageHandle           image;
+};
+
+typedef std::shared_ptr<const Texture> TextureHandle;
+
+struct TextureCacheStats {
+    uint64_t     textures          = 0;
+    uint64_t     failed            = 0;
+    uint64_t     decoded           = 0;
+    uint64_t     mipsGenerated     = 0;
+    uint64_t     uploadBatches     = 0;
+    uint64_t     transferBatches   = 0;
+    VkDeviceSize bytesUploaded     = 0;
+    VkDeviceSize uncompressedBytes = 0;
+};
+
+// KTX2 textures keyed by path, so every request for a file shares one image for as long as anyone holds it. The
+// textures ready in a frame share one staging buffer, copied on the transfer queue when there is one. Used from the
+// thread that renders
+struct TextureCache {
+    static constexpr VkDeviceSize DEFAULT_UPLOAD_BUDGET = VkDeviceSize(64) << 20;
+
+    TextureCache() = default;
+    TextureCache(const TextureCache&)            = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    bool init(VkPhysicalDevice                physicalDevice,
+              VkDevice                        device,
+              GpuAllocator&                   allocator,
+              const VkPhysicalDeviceFeatures& enabledFeatures);
+    // Drops every image; textures still held by the game become failed
+    void cleanup();
+
+    // Loading may start before init; uploads wait for it
+    void          setAssetLoader(AssetLoader* loader);
+    TextureHandle load(const std::filesystem::path& path, AssetPriority priority = AssetPriority::Visible);
+
+    // Staging bytes one frame may upload. A texture larger than the budget still goes, alone
+    void setUploadBudget(VkDeviceSize bytesPerFrame);
+    // Copies are submitted there, and the images acquired by the graphics queue a frame or more later. Null, or an
+    // unavailable queue, records them into the frame instead
+    void setTransferQueue(TransferQueue* queue);
+    // Must be recorded before anything samples the textures, outside a render pass
+    void recordUploads(VkCommandBuffer commandBuffer);
+
+    bool              isFormatSupported(VkFormat format) const;
+    VkSampler         getSampler() const;
+    TextureCacheStats getStats() const;
+
+  protected:
+    struct Entry;
+
+    struct Upload {
+        std::shared_ptr<Entry>         entry;
+        ImageHandle                    image;
+        // One region per level the file stores; any levels past them are generated
+        std::vector<VkBufferImageCopy> regions;
+
+        bool          isGeneratingMips() const { return this->image->mipLevels > this->regions.size(); }
+        VkImageLayout getReleasedLayout() const {
+            return this->isGeneratingMips() ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+                                            : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+    };
+
+    struct Batch {
+        BufferHandle        staging;
+        std::vector<Upload> uploads;
+        // Signals once the transfer queue has copied them; 0 when copied in the frame
+        uint64_t transferValue = 0;
+    };
+
+    VkPhysicalDevice                                      physicalDevice = VK_NULL_HANDLE;
+    VkDevice                                              device         = VK_NULL_HANDLE;
+    GpuAllocator*                                         allocator      = nullptr;
+    AssetLoader*                                          assetLoader    = nullptr;
+    TransferQueue*                                        transferQueue  = nullptr;
+    VkPhysicalDeviceFeatures                              features       = {};
+    VkSampler                                             sampler        = VK_NULL_HANDLE;
+    VkDeviceSize                                          uploadBudget   = DEFAULT_UPLOAD_BUDGET;
+    std::unordered_map<std::string, std::weak_ptr<Entry>> entries;
+    std::vector<std::shared_ptr<Entry>>                   pending;
+    std::deque<Batch>                                     transfers;
+    TextureCacheStats                                     stats;
+
+    bool prepare(Entry& entry);
+    void fail(Entry& entry, const std::string& message);
+    bool stage(Batch& batch);
+    // Release hands the images from the transfer queue to the graphics queue afterwards
+    void recordCopies(VkCommandBuffer commandBuffer, const Batch& batch, bool release);
+    // Acquire takes the images from the transfer queue first. Generates mips and marks the textures ready
+    void finishUploads(VkCommandBuffer commandBuffer, Batch& batch, bool acquire);
+};
+} // namespace drakon
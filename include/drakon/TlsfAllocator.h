@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace drakon {
+// Two-level segregated fit allocator over an abstract range of offsets, so it can sub-allocate GPU memory
+struct TlsfAllocator {
+    TlsfAllocator() = default;
+    explicit TlsfAllocator(uint64_t size);
+
+    // alignment must be a power of two
+    std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment);
+    bool                    free(uint64_t offset);
+
+    uint64_t getSize() const;
+    uint64_t getUsedBytes() const;
+    uint64_t getAllocationCount() const;
+    uint64_t getLargestFreeBlock() const;
+    bool     isEmpty() const;
+
+  protected:
+    static constexpr uint32_t SL_LOG2  = 4;
+    static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+    static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+    static constexpr uint32_t NONE     = UINT32_MAX;
+
+    struct Block {
+        uint64_t offset       = 0;
+        uint64_t size         = 0;
+        uint32_t previousPhys = NONE;
+        uint32_t nextPhys     = NONE;
+        uint32_t previousFree = NONE;
+        uint32_t nextFree     = NONE;
+        bool     free         = false;
+    };
+
+    uint64_t                                             size            = 0;
+    uint64_t                                             usedBytes       = 0;
+    uint64_t                                             allocationCount = 0;
+    std::vector<Block>                                   blocks;
+    std::vector<uint32_t>                                unusedBlocks;
+    std::unordered_map<uint64_t, uint32_t>               allocatedBlocks;
+    uint64_t                                             flBitmap        = 0;
+    std::array<uint32_t, FL_COUNT>                       slBitmaps       = {};
+    std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> freeLists       = {};
+
+    static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+    uint32_t    findFreeBlock(uint64_t size) const;
+    uint32_t    createBlock(uint64_t offset, uint64_t size);
+    void        releaseBlock(uint32_t index);
+    void        insertFreeBlock(uint32_t index);
+    void        removeFreeBlock(uint32_t index);
+    uint32_t    splitBlock(uint32_t index, uint64_t size);
+};
+} // namespace drakon
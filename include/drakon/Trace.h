@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+#define DRAKON_TRACE_CONCAT_INNER(a, b) a##b
+#define DRAKON_TRACE_CONCAT(a, b)       DRAKON_TRACE_CONCAT_INNER(a, b)
+// Times the enclosing scope on the calling thread; name must outlive the trace, e.g. a string literal
+#define DRAKON_TRACE_SCOPE(name)        ::drakon::TraceScope DRAKON_TRACE_CONCAT(drakonTraceScope, __LINE__)(name)
+
+namespace drakon {
+// Nanoseconds since the trace epoch
+struct TraceEvent {
+    const char* name     = nullptr;
+    int64_t     start    = 0;
+    int64_t     duration = 0;
+};
+
+// Process-wide CPU trace. Each thread appends to its own fixed-size ring, so recording never takes a lock;
+// once a ring wraps, its oldest events are overwritten
+struct Trace {
+    static void enable();
+    static void disable();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Labels the calling thread's track in exported traces
+    static void    setThreadName(const char* name);
+    static int64_t now();
+    static void    record(const char* name, int64_t start, int64_t end);
+
+    // Chrome trace event JSON, which chrome://tracing and the Perfetto UI both open directly
+    static bool writeChromeJson(const std::filesystem::path& path);
+
+  protected:
+    inline static std::atomic<bool> enabled = false;
+};
+
+struct TraceScope {
+    explicit TraceScope(const char* name)
+        : name(Trace::isEnabled() ? name : nullptr), start(this->name != nullptr ? Trace::now() : 0) {}
+    TraceScope(const TraceScope&)            = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+    ~TraceScope() {
+        if (this->name != nullptr) {
+            Trace::record(this->name, this->start, Trace::now());
+        }
+    }
+
+  protected:
+    const char* name;
+    int64_t     start;
+};
+} // namespace drakon
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+struct TransferQueueStats {
+    uint64_t submits = 0;
+    // Command buffers ever allocated; stays small while completed ones are recycled
+    uint64_t commandBuffers = 0;
+};
+
+// A queue from a transfer-only family, so streaming copies run beside rendering instead of inside its command
+// buffers. Every submit signals the next value of one timeline semaphore, which the render thread polls to learn
+// which copies have landed. Resources written here belong to the transfer family: record a release barrier before
+// submitting, then the matching acquire on the graphics queue once isComplete reports the submit's value, and pass
+// that value to addGraphicsWait so the frame's submit waits on the timeline too
+struct TransferQueue {
+    TransferQueue() = default;
+    TransferQueue(const TransferQueue&)            = delete;
+    TransferQueue& operator=(const TransferQueue&) = delete;
+
+    // The device must have been created with the family's queue and VK_KHR_timeline_semaphore enabled
+    bool init(VkDevice device, uint32_t family, uint32_t graphicsFamily);
+    // The caller must have waited for the device to go idle
+    void cleanup();
+
+    bool     isAvailable() const;
+    uint32_t getFamily() const;
+    uint32_t getGraphicsFamily() const;
+
+    // A command buffer in the recording state, recycled from a completed submit where possible
+    VkCommandBuffer begin();
+    // Ends and submits commandBuffer, returning the timeline value that signals once it has executed; 0 on failure
+    uint64_t        submit(VkCommandBuffer commandBuffer);
+
+    // Never blocks
+    bool               isComplete(uint64_t value);
+    bool               wait(uint64_t value, uint64_t timeoutNanoseconds = UINT64_MAX);
+    TransferQueueStats getStats() const;
+
+    // A host poll does not order the GPU work, so the next graphics submit has to wait on the timeline for value
+    void        addGraphicsWait(uint64_t value);
+    // The value the next graphics submit waits on, or 0 when nothing was acquired since the last one
+    uint64_t    takeGraphicsWait();
+    VkSemaphore getTimeline() const;
+
+  protected:
+    struct Submitted {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        uint64_t        value         = 0;
+    };
+
+    VkDevice                          device          = VK_NULL_HANDLE;
+    VkQueue                           queue           = VK_NULL_HANDLE;
+    uint32_t                          family          = 0;
+    uint32_t                          graphicsFamily  = 0;
+    VkCommandPool                     commandPool     = VK_NULL_HANDLE;
+    VkSemaphore                       timeline        = VK_NULL_HANDLE;
+    uint64_t                          nextValue       = 1;
+    uint64_t                          completedValue  = 0;
+    uint64_t                          graphicsWait    = 0;
+    std::deque<Submitted>             submitted;
+    PFN_vkGetSemaphoreCounterValueKHR getCounterValue = nullptr;
+    PFN_vkWaitSemaphoresKHR           waitSemaphores  = nullptr;
+    TransferQueueStats                stats;
+};
+} // namespace drakon
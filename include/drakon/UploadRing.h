@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <drakon/GpuAllocator.h>
+
+#include <vulkan/vulkan.h>
+
+namespace drakon {
+// A slice of the ring for this frame only; write through data, then bind buffer at offset
+struct UploadAllocation {
+    VkBuffer     buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size   = 0;
+    void*        data   = nullptr;
+
+    bool isValid() const { return this->data != nullptr; }
+};
+
+struct UploadRingStats {
+    VkDeviceSize capacityPerFrame = 0;
+    VkDeviceSize bytesLastFrame   = 0;
+    VkDeviceSize peakBytes        = 0;
+    // Requests that did not fit in the frame's region; raise the ring size if this is ever non-zero
+    uint64_t failedAllocations = 0;
+};
+
+// One persistently mapped buffer split into a region per frame in flight. Each frame bump-allocates from its own
+// region, which is only rewound once that frame has finished, so streaming dynamic vertex and uniform data never
+// allocates Vulkan memory
+struct UploadRing {
+    UploadRing() = default;
+    UploadRing(const UploadRing&)            = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+
+    bool init(VkPhysicalDevice physicalDevice, GpuAllocator& allocator, VkDeviceSize regionSize, uint32_t regionCount);
+    void cleanup();
+
+    // Rewinds the frame's region; the caller must have waited for that frame to finish
+    void beginFrame(uint32_t frameIndex);
+    // Flushes what the frame wrote, for memory that is not host coherent
+    bool endFrame();
+
+    // Not thread safe; for use while only one thread is allocating from the ring
+    UploadAllocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+    // Safe to call from several recording threads at once
+    UploadAllocation allocateConcurrent(VkDeviceSize size, VkDeviceSize alignment);
+    // Copies size bytes into a fresh allocation, using the uniform buffer offset alignment
+    UploadAllocation upload(const void* data, VkDeviceSize size, bool concurrent = false);
+
+    template <typename T>
+    UploadAllocation push(const T& value, bool concurrent = false) {
+        return this->upload(&value, sizeof(T), concurrent);
+    }
+
+    VkBuffer        getBuffer() const;
+    VkDeviceSize    getUniformAlignment() const;
+    VkDeviceSize    getStorageAlignment() const;
+    UploadRingStats getStats() const;
+
+  protected:
+    GpuAllocator*             allocator         = nullptr;
+    BufferHandle              buffer;
+    VkDeviceSize              regionSize        = 0;
+    uint32_t                  regionCount       = 0;
+    uint32_t                  frameIndex        = 0;
+    VkDeviceSize              uniformAlignment  = 1;
+    VkDeviceSize              storageAlignment  = 1;
+    std::atomic<VkDeviceSize> head              = 0;
+    std::atomic<uint64_t>     failedAllocations = 0;
+    VkDeviceSize              bytesLastFrame    = 0;
+    VkDeviceSize              peakBytes         = 0;
+
+    UploadAllocation makeAllocation(VkDeviceSize offset, VkDeviceSize size) const;
+};
+} // namespace drakon
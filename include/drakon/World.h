@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace drakon {
+// A handle that goes stale once its entity is destroyed, even if the index is reused
+struct Entity {
+    uint32_t index      = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity& other) const = default;
+};
+
+constexpr size_t MAX_COMPONENT_TYPES     = 256;
+constexpr size_t MAX_COMPONENT_ALIGNMENT = 64;
+typedef uint32_t                         ComponentId;
+typedef std::bitset<MAX_COMPONENT_TYPES> ComponentMask;
+
+// How a World stores one component type without knowing it
+struct ComponentType {
+    ComponentId id        = 0;
+    size_t      size      = 0;
+    size_t      alignment = 0;
+    // Move-constructs destination from source, then destroys source
+    void (*relocate)(void* destination, void* source) = nullptr;
+    void (*destroy)(void* value)                       = nullptr;
+};
+
+// Hands out ids in first-use order; registering more than MAX_COMPONENT_TYPES types is a fatal error
+ComponentId registerComponentType();
+
+template <class T>
+const ComponentType& componentTypeOf() {
+    static_assert(std::is_same_v<T, std::remove_cvref_t<T>>, "Components are registered by their plain type");
+    static_assert(std::is_nothrow_move_constructible_v<T>, "Components must be nothrow move constructible");
+    static_assert(alignof(T) <= MAX_COMPONENT_ALIGNMENT, "Chunks are not aligned for this component");
+    static const ComponentType type = {
+        registerComponentType(),
+        sizeof(T),
+        alignof(T),
+        [](void* destination, void* source) {
+            T* value = static_cast<T*>(source);
+            new (destination) T(std::move(*value));
+            value->~T();
+        },
+        [](void* value) { static_cast<T*>(value)->~T(); },
+    };
+    return type;
+}
+
+// Entities and their components. Entities with the same set of component types share an archetype, which stores
+// each component type as its own contiguous array within fixed-size chunks, so queries stream through memory.
+// Creating and destroying entities is O(1); destroying moves the archetype's last entity into the gap, so entity order
+// within an archetype is not stable. Not thread safe, and no entity may be created, destroyed, or gain or lose a
+// component while a query is running
+struct World {
+    // Chunks are sized to stay comfortably inside L2 while holding a useful number of entities
+    static constexpr size_t CHUNK_BYTES = 16 * 1024;
+
+    World()                        = default;
+    World(const World&)            = delete;
+    World& operator=(const World&) = delete;
+    ~World();
+
+    // Component types must be distinct
+    template <class... Ts>
+    Entity create(Ts&&... components);
+    // False if the entity was already destroyed
+    bool   destroy(Entity entity);
+    bool   isAlive(Entity entity) const;
+    size_t size() const;
+    // Destroys every entity
+    void clear();
+
+    // Null if the entity is dead or lacks the component. Valid until the next structural change
+    template <class T>
+    T* get(Entity entity);
+    template <class T>
+    bool has(Entity entity) const;
+    // Assigns over an existing component, or moves the entity to the archetype that adds T
+    template <class T>
+    T* add(Entity entity, T value);
+    // False if the entity is dead or has no T
+    template <class T>
+    bool remove(Entity entity);
+
+    // Calls function(Ts&...) or function(Entity, Ts&...) for every entity with at least the components Ts
+    template <class... Ts, class F>
+    void each(F&& function);
+    // Calls function(count, entities, Ts*...) once per chunk, with one array of count elements per component
+    template <class... Ts, class F>
+    void eachChunk(F&& function);
+
+  protected:
+    struct ChunkDeleter {
+        void operator()(std::byte* chunk) const;
+    };
+    typedef std::unique_ptr<std::byte[], ChunkDeleter> Chunk;
+
+    struct Archetype {
+        ComponentMask                     mask;
+        std::vector<const ComponentType*> types;
+        // Byte offset of each type's array within a chunk; the chunk's Entity array sits at offset 0
+        std::vector<size_t>                         offsets;
+        std::array<int16_t, MAX_COMPONENT_TYPES>    columns       = {};
+        uint32_t                                    chunkCapacity = 0;
+        size_t                                      chunkBytes    = 0;
+        std::vector<Chunk>                          chunks;
+        uint32_t                                    count         = 0;
+        std::unordered_map<ComponentId, Archetype*> addEdges;
+        std::unordered_map<ComponentId, Archetype*> removeEdges;
+
+        Entity* entities(size_t chunk) const;
+        void*   component(size_t column, uint32_t row) const;
+    };
+
+    struct EntityRecord {
+        Archetype* archetype  = nullptr;
+        uint32_t   row        = 0;
+        uint32_t   generation = 0;
+    };
+
+    std::vector<std::unique_ptr<Archetype>>       archetypes;
+    std::unordered_map<ComponentMask, Archetype*> archetypesByMask;
+    std::vector<EntityRecord>                     records;
+    std::vector<uint32_t>                         freeIndices;
+    size_t                                        entityCount = 0;
+
+    Archetype&          findArchetype(const ComponentType* const* types, size_t count);
+    Archetype&          archetypeWith(Archetype& source, const ComponentType& type);
+    Archetype&          archetypeWithout(Archetype& source, ComponentId id);
+    Entity              allocateEntity(Archetype& archetype);
+    uint32_t            allocateRow(Archetype& archetype);
+    // Fills the row with the archetype's last entity; the row's own components must already be destroyed or moved
+    void                removeRow(Archetype& archetype, uint32_t row);
+    // Moves an entity's components to destination, destroying those destination lacks. New columns are left
+    // unconstructed for the caller
+    void                moveEntity(uint32_t index, Archetype& destination);
+    const EntityRecord* findRecord(Entity entity) const;
+};
+} // namespace drakon
+
+template <class... Ts>
+drakon::Entity drakon::World::create(Ts&&... components) {
+    const std::array<const ComponentType*, sizeof...(Ts)> types = {&componentTypeOf<std::remove_cvref_t<Ts>>()...};
+
+    Archetype&     archetype = this->findArchetype(types.data(), types.size());
+    const Entity   entity    = this->allocateEntity(archetype);
+    const uint32_t row       = this->records[entity.index].row;
+    (new (archetype.component(archetype.columns[componentTypeOf<std::remove_cvref_t<Ts>>().id], row))
+         std::remove_cvref_t<Ts>(std::forward<Ts>(components)),
+     ...);
+    return entity;
+}
+
+template <class T>
+T* drakon::World::get(Entity entity) {
+    const EntityRecord* record = this->findRecord(entity);
+    if (record == nullptr) {
+        return nullptr;
+    }
+    const int16_t column = record->archetype->columns[componentTypeOf<std::remove_cv_t<T>>().id];
+    return column < 0 ? nullptr : static_cast<T*>(record->archetype->component(column, record->row));
+}
+
+template <class T>
+bool drakon::World::has(Entity entity) const {
+    const EntityRecord* record = this->findRecord(entity);
+    return record != nullptr && record->archetype->columns[componentTypeOf<std::remove_cv_t<T>>().id] >= 0;
+}
+
+template <class T>
+T* drakon::World::add(Entity entity, T value) {
+    if (T* existing = this->get<T>(entity)) {
+        *existing = std::move(value);
+        return existing;
+    }
+    const EntityRecord* record = this->findRecord(entity);
+    if (record == nullptr) {
+        return nullptr;
+    }
+
+    const ComponentType& type        = componentTypeOf<T>();
+    Archetype&           destination = this->archetypeWith(*record->archetype, type);
+    this->moveEntity(entity.index, destination);
+    void* slot = destination.component(destination.columns[type.id], this->records[entity.index].row);
+    return new (slot) T(std::move(value));
+}
+
+template <class T>
+bool drakon::World::remove(Entity entity) {
+    if (!this->has<T>(entity)) {
+        return false;
+    }
+    Archetype& destination = this->archetypeWithout(*this->records[entity.index].archetype, componentTypeOf<T>().id);
+    this->moveEntity(entity.index, destination);
+    return true;
+}
+
+template <class... Ts, class F>
+void drakon::World::each(F&& function) {
+    this->eachChunk<Ts...>([&function](size_t count, const Entity* entities, Ts*... arrays) {
+        for (size_t i = 0; i < count; ++i) {
+            if constexpr (std::is_invocable_v<F&, Entity, Ts&...>) {
+                function(entities[i], arrays[i]...);
+            } else {
+                function(arrays[i]...);
+            }
+        }
+    });
+}
+
+template <class... Ts, class F>
+void drakon::World::eachChunk(F&& function) {
+    ComponentMask required;
+    (required.set(componentTypeOf<std::remove_cv_t<Ts>>().id), ...);
+
+    for (const auto& archetype : this->archetypes) {
+        if (archetype->count == 0 || (archetype->mask & required) != required) {
+            continue;
+        }
+        const std::array<int16_t, sizeof...(Ts)> columns = {
+            archetype->columns[componentTypeOf<std::remove_cv_t<Ts>>().id]...};
+
+        for (size_t chunk = 0; chunk * archetype->chunkCapacity < archetype->count; ++chunk) {
+            const size_t first = chunk * archetype->chunkCapacity;
+            const size_t count = std::min<size_t>(archetype->chunkCapacity, archetype->count - first);
+            std::byte*   base  = archetype->chunks[chunk].get();
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                function(count,
+                         const_cast<const Entity*>(archetype->entities(chunk)),
+                         reinterpret_cast<Ts*>(base + archetype->offsets[columns[I]])...);
+            }(std::index_sequence_for<Ts...>{});
+        }
+    }
+}
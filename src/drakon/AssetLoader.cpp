@@ -0,0 +1,582 @@
+#include <drakon/AssetLoader.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DRAKON_HAS_POSIX_IO 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#define DRAKON_HAS_POSIX_IO 0
+#include <fstream>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define DRAKON_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#else
+#define DRAKON_HAS_IO_URING 0
+#endif
+
+namespace {
+std::string describeErrno(int error) { return std::strerror(error); }
+} // namespace
+
+// The loader's view of an asset, with the bookkeeping needed while it is read
+struct drakon::AssetLoader::Request : drakon::Asset {
+    Request(std::filesystem::path path, AssetPriority priority) : Asset(std::move(path)), priority(priority) {}
+    ~Request() { this->closeFile(); }
+
+    // Guarded by the loader's mutex
+    AssetPriority priority = AssetPriority::Background;
+    bool          started  = false;
+
+    int    file   = -1;
+    size_t offset = 0;
+#if DRAKON_HAS_POSIX_IO
+    iovec vector = {};
+#endif
+
+    bool               succeeded() const { return this->error.empty(); }
+    const std::string& failure() const { return this->error; }
+    bool               isContentMapped() const { return this->mapping != nullptr; }
+    size_t             contentSize() const {
+        return this->isContentMapped() ? this->mappingSize : this->bytes.size();
+    }
+
+    void fail(std::string message) {
+        if (this->error.empty()) {
+            this->error = std::move(message);
+        }
+    }
+
+    // Opens the file and maps it when it is at least mapThreshold bytes. True when its contents still need reading
+    bool open(size_t mapThreshold) {
+#if DRAKON_HAS_POSIX_IO
+        this->file = ::open(this->path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (this->file < 0) {
+            this->fail("Failed to open " + this->path.string() + ": " + describeErrno(errno));
+            return false;
+        }
+        struct stat info = {};
+        if (fstat(this->file, &info) != 0) {
+            this->fail("Failed to stat " + this->path.string() + ": " + describeErrno(errno));
+            return false;
+        }
+
+        const auto fileSize = static_cast<size_t>(info.st_size);
+        if (fileSize > 0 && fileSize >= mapThreshold) {
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            // Faulting every page in here keeps the first touch on the frame path from stalling on the disk
+            flags |= MAP_POPULATE;
+#endif
+            void* mapped = mmap(nullptr, fileSize, PROT_READ, flags, this->file, 0);
+            if (mapped != MAP_FAILED) {
+                this->mapping     = mapped;
+                this->mappingSize = fileSize;
+                return false;
+            }
+            // Some files cannot be mapped but can still be read
+        }
+        this->bytes.resize(fileSize);
+        return fileSize > 0;
+#else
+        (void)mapThreshold;
+        std::ifstream stream(this->path, std::ios::binary | std::ios::ate);
+        if (!stream) {
+            this->fail("Failed to open " + this->path.string());
+            return false;
+        }
+        this->bytes.resize(static_cast<size_t>(stream.tellg()));
+        stream.seekg(0);
+        const auto size = static_cast<std::streamsize>(this->bytes.size());
+        if (!stream.read(reinterpret_cast<char*>(this->bytes.data()), size)) {
+            this->fail("Failed to read " + this->path.string());
+        }
+        return false;
+#endif
+    }
+
+    // Accounts for a read that returned result bytes or a negative errno. True when more remains to be read
+    bool advance(int64_t result) {
+        if (result == -EINTR || result == -EAGAIN) {
+            return true;
+        }
+        if (result < 0) {
+            this->fail("Failed to read " + this->path.string() + ": " + describeErrno(static_cast<int>(-result)));
+            return false;
+        }
+        if (result == 0) {
+            // The file shrank since it was opened
+            this->bytes.resize(this->offset);
+            return false;
+        }
+        this->offset += static_cast<size_t>(result);
+        return this->offset < this->bytes.size();
+    }
+
+#if DRAKON_HAS_POSIX_IO
+    // Points vector at whatever is left to read
+    iovec* prepareRead() {
+        this->vector = {this->bytes.data() + this->offset, this->bytes.size() - this->offset};
+        return &this->vector;
+    }
+#endif
+
+    // Blocking reads of whatever open left, for the thread pool
+    void readRemaining() {
+#if DRAKON_HAS_POSIX_IO
+        bool more = true;
+        while (more) {
+            const ssize_t result = pread(this->file,
+                                         this->bytes.data() + this->offset,
+                                         this->bytes.size() - this->offset,
+                                         static_cast<off_t>(this->offset));
+            more                 = this->advance(result < 0 ? -errno : result);
+        }
+#endif
+    }
+
+    // Makes the contents visible to every handle and wakes anyone waiting
+    void publish() {
+        this->closeFile();
+        this->state.store(this->succeeded() ? AssetState::Loaded : AssetState::Failed, std::memory_order_release);
+        this->state.notify_all();
+    }
+
+  private:
+    void closeFile() {
+#if DRAKON_HAS_POSIX_IO
+        if (this->file >= 0) {
+            close(this->file);
+            this->file = -1;
+        }
+#endif
+    }
+};
+
+#if DRAKON_HAS_IO_URING
+// A bare io_uring instance driven through the raw system calls, so the build needs no liburing. Only the I/O thread
+// touches it
+struct drakon::AssetLoader::IoRing {
+    IoRing() = default;
+    IoRing(const IoRing&)            = delete;
+    IoRing& operator=(const IoRing&) = delete;
+    ~IoRing() {
+        if (this->entries != MAP_FAILED) {
+            munmap(this->entries, this->entriesSize);
+        }
+        if (this->completionRing != MAP_FAILED && this->completionRing != this->submissionRing) {
+            munmap(this->completionRing, this->completionRingSize);
+        }
+        if (this->submissionRing != MAP_FAILED) {
+            munmap(this->submissionRing, this->submissionRingSize);
+        }
+        if (this->ring >= 0) {
+            close(this->ring);
+        }
+    }
+
+    bool init(uint32_t depth) {
+        io_uring_params params = {};
+        this->ring             = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+        if (this->ring < 0) {
+            return false;
+        }
+
+        this->submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        this->completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMapping) {
+            this->submissionRingSize = std::max(this->submissionRingSize, this->completionRingSize);
+        }
+        this->submissionRing = this->map(this->submissionRingSize, IORING_OFF_SQ_RING);
+        this->completionRing =
+            singleMapping ? this->submissionRing : this->map(this->completionRingSize, IORING_OFF_CQ_RING);
+        this->entriesSize = params.sq_entries * sizeof(io_uring_sqe);
+        this->entries     = this->map(this->entriesSize, IORING_OFF_SQES);
+        if (this->submissionRing == MAP_FAILED || this->completionRing == MAP_FAILED || this->entries == MAP_FAILED) {
+            return false;
+        }
+
+        auto* submission      = static_cast<char*>(this->submissionRing);
+        this->submissionTail  = reinterpret_cast<uint32_t*>(submission + params.sq_off.tail);
+        this->submissionMask  = *reinterpret_cast<uint32_t*>(submission + params.sq_off.ring_mask);
+        this->submissionArray = reinterpret_cast<uint32_t*>(submission + params.sq_off.array);
+
+        auto* completion     = static_cast<char*>(this->completionRing);
+        this->completionHead = reinterpret_cast<uint32_t*>(completion + params.cq_off.head);
+        this->completionTail = reinterpret_cast<uint32_t*>(completion + params.cq_off.tail);
+        this->completionMask = *reinterpret_cast<uint32_t*>(completion + params.cq_off.ring_mask);
+        this->completions    = reinterpret_cast<io_uring_cqe*>(completion + params.cq_off.cqes);
+        return true;
+    }
+
+    // The caller keeps at most the ring's depth in flight, so there is always a free entry
+    void queueRead(int file, iovec* vector, size_t offset, uint64_t userData) {
+        const uint32_t tail  = *this->submissionTail;
+        const uint32_t index = tail & this->submissionMask;
+        io_uring_sqe&  entry = static_cast<io_uring_sqe*>(this->entries)[index];
+        // READV rather than READ, since it is supported by every kernel that has io_uring
+        entry                        = {};
+        entry.opcode                 = IORING_OP_READV;
+        entry.fd                     = file;
+        entry.addr                   = reinterpret_cast<uint64_t>(vector);
+        entry.len                    = 1;
+        entry.off                    = offset;
+        entry.user_data              = userData;
+        this->submissionArray[index] = index;
+        std::atomic_ref<uint32_t>(*this->submissionTail).store(tail + 1, std::memory_order_release);
+        ++this->unsubmitted;
+    }
+
+    // Submits every queued read and waits for at least one completion. False when the ring stops working
+    bool submitAndWait() {
+        for (;;) {
+            const long result =
+                syscall(__NR_io_uring_enter, this->ring, this->unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result >= 0) {
+                this->unsubmitted -= static_cast<uint32_t>(result);
+                return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                return false;
+            }
+        }
+    }
+
+    bool popCompletion(uint64_t& userData, int32_t& result) {
+        const uint32_t head = *this->completionHead;
+        if (head == std::atomic_ref<uint32_t>(*this->completionTail).load(std::memory_order_acquire)) {
+            return false;
+        }
+        const io_uring_cqe& completion = this->completions[head & this->completionMask];
+        userData                       = completion.user_data;
+        result                         = completion.res;
+        std::atomic_ref<uint32_t>(*this->completionHead).store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+  private:
+    int           ring               = -1;
+    void*         submissionRing     = MAP_FAILED;
+    void*         completionRing     = MAP_FAILED;
+    void*         entries            = MAP_FAILED;
+    size_t        submissionRingSize = 0;
+    size_t        completionRingSize = 0;
+    size_t        entriesSize        = 0;
+    uint32_t*     submissionTail     = nullptr;
+    uint32_t      submissionMask     = 0;
+    uint32_t*     submissionArray    = nullptr;
+    uint32_t*     completionHead     = nullptr;
+    uint32_t*     completionTail     = nullptr;
+    uint32_t      completionMask     = 0;
+    io_uring_cqe* completions        = nullptr;
+    uint32_t      unsubmitted        = 0;
+
+    void* map(size_t size, uint64_t offset) const {
+        return mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->ring, offset);
+    }
+};
+#else
+struct drakon::AssetLoader::IoRing {};
+#endif
+
+drakon::Asset::~Asset() {
+#if DRAKON_HAS_POSIX_IO
+    if (this->mapping != nullptr) {
+        munmap(this->mapping, this->mappingSize);
+    }
+#endif
+}
+
+const std::filesystem::path& drakon::Asset::getPath() const { return this->path; }
+
+drakon::AssetState drakon::Asset::getState() const { return this->state.load(std::memory_order_acquire); }
+
+bool drakon::Asset::isReady() const { return this->getState() != AssetState::Loading; }
+
+drakon::AssetState drakon::Asset::wait() const {
+    AssetState current = this->getState();
+    while (current == AssetState::Loading) {
+        this->state.wait(current, std::memory_order_acquire);
+        current = this->getState();
+    }
+    return current;
+}
+
+const std::byte* drakon::Asset::data() const {
+    // The I/O thread may still be writing until the state says otherwise
+    if (this->getState() != AssetState::Loaded) {
+        return nullptr;
+    }
+    return this->mapping != nullptr ? static_cast<const std::byte*>(this->mapping) : this->bytes.data();
+}
+
+size_t drakon::Asset::size() const {
+    if (this->getState() != AssetState::Loaded) {
+        return 0;
+    }
+    return this->mapping != nullptr ? this->mappingSize : this->bytes.size();
+}
+
+std::string_view drakon::Asset::text() const {
+    return std::string_view(reinterpret_cast<const char*>(this->data()), this->size());
+}
+
+bool drakon::Asset::isMapped() const { return this->getState() == AssetState::Loaded && this->mapping != nullptr; }
+
+const std::string& drakon::Asset::getError() const {
+    static const std::string none;
+    return this->getState() == AssetState::Failed ? this->error : none;
+}
+
+// Out of line, since IoRing is only complete here
+drakon::AssetLoader::AssetLoader() = default;
+
+drakon::AssetLoader::~AssetLoader() { this->stop(); }
+
+bool drakon::AssetLoader::start(uint32_t threadCount, bool preferIoUring) {
+    // Loads queued before the first start are kept for it
+    if (!this->threads.empty()) {
+        this->stop();
+    }
+
+#if DRAKON_HAS_IO_URING
+    if (preferIoUring) {
+        auto ring = std::make_unique<IoRing>();
+        if (ring->init(IO_URING_QUEUE_DEPTH)) {
+            this->ring    = std::move(ring);
+            this->backend = AssetBackend::IoUring;
+            this->threads.emplace_back(&AssetLoader::ioRingLoop, this);
+            return true;
+        }
+        // Containers commonly filter io_uring out, so this is not worth an error
+    }
+#else
+    (void)preferIoUring;
+#endif
+
+    this->backend = AssetBackend::ThreadPool;
+    for (uint32_t i = 0; i < std::max(threadCount, 1u); ++i) {
+        this->threads.emplace_back(&AssetLoader::threadPoolLoop, this);
+    }
+    return true;
+}
+
+void drakon::AssetLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (auto& thread : this->threads) {
+        thread.join();
+    }
+    this->threads.clear();
+    this->ring.reset();
+
+    std::vector<std::shared_ptr<Request>> leftovers;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = false;
+        this->backend  = AssetBackend::None;
+        while (!this->queue.empty()) {
+            std::shared_ptr<Request> request = this->queue.top().request;
+            this->queue.pop();
+            if (!request->started) {
+                request->started = true;
+                leftovers.push_back(std::move(request));
+            }
+        }
+    }
+    for (auto& request : leftovers) {
+        request->fail("Asset loader stopped before " + request->getPath().string() + " was read");
+        this->finish(*request);
+    }
+}
+
+drakon::AssetBackend drakon::AssetLoader::getBackend() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->backend;
+}
+
+drakon::AssetHandle drakon::AssetLoader::load(const std::filesystem::path& path, AssetPriority priority) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    ++this->stats.requests;
+
+    std::weak_ptr<Request>&  entry   = this->requests[path.lexically_normal().string()];
+    std::shared_ptr<Request> request = entry.lock();
+    // A failed load is retried rather than shared
+    if (request != nullptr && request->getState() != AssetState::Failed) {
+        ++this->stats.deduplicated;
+        if (!request->started && priority < request->priority) {
+            // The older, lower priority entry is skipped when it reaches the top
+            request->priority = priority;
+            this->queue.push(Queued{priority, this->nextSequence++, request});
+            this->wake.notify_one();
+        }
+        return request;
+    }
+
+    request = std::make_shared<Request>(path, priority);
+    entry   = request;
+    this->queue.push(Queued{priority, this->nextSequence++, request});
+    this->wake.notify_one();
+
+    // Released assets leave expired entries behind, swept whenever the map doubles
+    if (this->requests.size() >= this->pruneAt) {
+        std::erase_if(this->requests, [](const auto& pair) { return pair.second.expired(); });
+        this->pruneAt = std::max<size_t>(64, this->requests.size() * 2);
+    }
+    return request;
+}
+
+void drakon::AssetLoader::setMapThreshold(size_t bytes) { this->mapThreshold.store(bytes, std::memory_order_relaxed); }
+
+size_t drakon::AssetLoader::getMapThreshold() const { return this->mapThreshold.load(std::memory_order_relaxed); }
+
+drakon::AssetLoaderStats drakon::AssetLoader::getStats() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->stats;
+}
+
+std::shared_ptr<drakon::AssetLoader::Request> drakon::AssetLoader::takeLocked() {
+    while (!this->stopping && !this->queue.empty()) {
+        std::shared_ptr<Request> request = this->queue.top().request;
+        this->queue.pop();
+        if (request->started) {
+            continue;
+        }
+        if (request.use_count() == 1) {
+            // Only the queue still wanted it. Handles are only made under the mutex, so none can appear now
+            ++this->stats.abandoned;
+            continue;
+        }
+        request->started = true;
+        return request;
+    }
+    return nullptr;
+}
+
+void drakon::AssetLoader::finish(Request& request) {
+    {
+        // Counted before publishing, so anyone woken by the load already sees it in the stats
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (request.succeeded()) {
+            ++this->stats.loaded;
+            this->stats.bytesRead += request.contentSize();
+            this->stats.mapped += request.isContentMapped() ? 1 : 0;
+        } else {
+            ++this->stats.failed;
+        }
+    }
+    if (!request.succeeded()) {
+        std::cerr << request.failure() << std::endl;
+    }
+    request.publish();
+}
+
+void drakon::AssetLoader::threadPoolLoop() {
+    for (;;) {
+        std::shared_ptr<Request> request;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+            if (this->stopping) {
+                return;
+            }
+            request = this->takeLocked();
+        }
+        if (request == nullptr) {
+            continue;
+        }
+        if (request->open(this->getMapThreshold())) {
+            request->readRemaining();
+        }
+        this->finish(*request);
+    }
+}
+
+void drakon::AssetLoader::ioRingLoop() {
+#if DRAKON_HAS_IO_URING
+    std::vector<std::shared_ptr<Request>> inFlight;
+    std::vector<std::shared_ptr<Request>> starting;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            if (inFlight.empty()) {
+                this->wake.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+            }
+            while (inFlight.size() + starting.size() < IO_URING_QUEUE_DEPTH) {
+                std::shared_ptr<Request> request = this->takeLocked();
+                if (request == nullptr) {
+                    break;
+                }
+                starting.push_back(std::move(request));
+            }
+            if (this->stopping && inFlight.empty() && starting.empty()) {
+                return;
+            }
+        }
+
+        // Opening and mapping block, but only this thread
+        for (auto& request : starting) {
+            if (!request->open(this->getMapThreshold())) {
+                this->finish(*request);
+                continue;
+            }
+            this->ring->queueRead(request->file, request->prepareRead(), 0, reinterpret_cast<uint64_t>(request.get()));
+            inFlight.push_back(std::move(request));
+        }
+        starting.clear();
+        if (inFlight.empty()) {
+            continue;
+        }
+
+        if (!this->ring->submitAndWait()) {
+            const int error = errno;
+            // Closing the ring cancels its reads before the requests are failed and closed. They stay referenced
+            // until this thread exits in case the kernel was already writing into one
+            this->ring.reset();
+            for (auto& request : inFlight) {
+                request->fail("Failed to read " + request->getPath().string() + ": " + describeErrno(error));
+                this->finish(*request);
+            }
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->backend = AssetBackend::ThreadPool;
+            }
+            this->threadPoolLoop();
+            return;
+        }
+        uint64_t userData = 0;
+        int32_t  result   = 0;
+        while (this->ring->popCompletion(userData, result)) {
+            auto found = std::find_if(inFlight.begin(), inFlight.end(), [userData](const auto& request) {
+                return reinterpret_cast<uint64_t>(request.get()) == userData;
+            });
+            if (found == inFlight.end()) {
+                continue;
+            }
+            Request& request = **found;
+            if (request.advance(result)) {
+                // A short read, so the rest goes back on the ring
+                this->ring->queueRead(request.file, request.prepareRead(), request.offset, userData);
+                continue;
+            }
+            this->finish(request);
+            std::swap(*found, inFlight.back());
+            inFlight.pop_back();
+        }
+    }
+#endif
+}
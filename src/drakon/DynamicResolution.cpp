@@ -0,0 +1,58 @@
+#include <drakon/DynamicResolution.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr float LOWEST_SCALE = 0.1f;
+// Aims under the budget so ordinary frame-to-frame noise does not push frames over it
+constexpr double HEADROOM = 0.9;
+// Weight of each new frame in the smoothed cost
+constexpr double SMOOTHING = 0.25;
+// How far the scale may rise in one frame; drops are never limited
+constexpr float MAX_SCALE_INCREASE = 0.02f;
+} // namespace
+
+void drakon::DynamicResolution::setBudget(double milliseconds) { this->budget = std::max(milliseconds, 0.0); }
+
+double drakon::DynamicResolution::getBudget() const { return this->budget; }
+
+void drakon::DynamicResolution::setScaleLimits(float minimum, float maximum) {
+    this->maximumScale = std::clamp(maximum, LOWEST_SCALE, 1.0f);
+    this->minimumScale = std::clamp(minimum, LOWEST_SCALE, this->maximumScale);
+    this->scale        = std::clamp(this->scale, this->minimumScale, this->maximumScale);
+}
+
+float drakon::DynamicResolution::getMinimumScale() const { return this->minimumScale; }
+
+float drakon::DynamicResolution::getMaximumScale() const { return this->maximumScale; }
+
+float drakon::DynamicResolution::getScale() const { return this->scale; }
+
+float drakon::DynamicResolution::update(double gpuMilliseconds, float renderedScale) {
+    if (gpuMilliseconds <= 0.0 || renderedScale <= 0.0f || this->budget <= 0.0) {
+        return this->scale;
+    }
+
+    // Counting fixed costs as resolution-bound overestimates small scales, which only errs toward a lower scale
+    const double squaredScale = static_cast<double>(renderedScale) * static_cast<double>(renderedScale);
+    const double cost         = gpuMilliseconds / squaredScale;
+    if (this->fullScaleMilliseconds <= 0.0) {
+        this->fullScaleMilliseconds = cost;
+    } else {
+        this->fullScaleMilliseconds += (cost - this->fullScaleMilliseconds) * SMOOTHING;
+    }
+
+    // A frame over budget is acted on in full rather than through the smoothing
+    const double estimate = gpuMilliseconds > this->budget ? std::max(cost, this->fullScaleMilliseconds)
+                                                           : this->fullScaleMilliseconds;
+    const float  target   = static_cast<float>(std::sqrt(this->budget * HEADROOM / estimate));
+    this->scale           = target < this->scale ? target : std::min(target, this->scale + MAX_SCALE_INCREASE);
+    this->scale           = std::clamp(this->scale, this->minimumScale, this->maximumScale);
+    return this->scale;
+}
+
+void drakon::DynamicResolution::reset() {
+    this->scale                 = this->maximumScale;
+    this->fullScaleMilliseconds = 0.0;
+}
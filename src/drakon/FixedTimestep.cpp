@@ -0,0 +1,40 @@
+#include <drakon/FixedTimestep.h>
+
+#include <algorithm>
+
+namespace {
+std::chrono::nanoseconds toNanoseconds(double seconds) {
+    return std::chrono::round<std::chrono::nanoseconds>(std::chrono::duration<double>(seconds));
+}
+} // namespace
+
+drakon::FixedTimestep::FixedTimestep(double step, uint32_t maxStepsPerFrame)
+    : step(std::max(toNanoseconds(step), std::chrono::nanoseconds(1))),
+      maxStepsPerFrame(std::max<uint32_t>(maxStepsPerFrame, 1)) {}
+
+uint32_t drakon::FixedTimestep::advance(double frameTime) {
+    this->accumulator += std::max(toNanoseconds(frameTime), std::chrono::nanoseconds::zero());
+
+    const int64_t pendingSteps = this->accumulator / this->step;
+    if (pendingSteps <= static_cast<int64_t>(this->maxStepsPerFrame)) {
+        this->accumulator -= pendingSteps * this->step;
+        return static_cast<uint32_t>(pendingSteps);
+    }
+
+    // Running every pending step would make the next frame slower still; drop the backlog instead
+    this->droppedSteps += static_cast<uint64_t>(pendingSteps) - this->maxStepsPerFrame;
+    this->accumulator %= this->step;
+    return this->maxStepsPerFrame;
+}
+
+void drakon::FixedTimestep::reset() { this->accumulator = std::chrono::nanoseconds::zero(); }
+
+double drakon::FixedTimestep::getStep() const { return std::chrono::duration<double>(this->step).count(); }
+
+uint32_t drakon::FixedTimestep::getMaxStepsPerFrame() const { return this->maxStepsPerFrame; }
+
+float drakon::FixedTimestep::getAlpha() const {
+    return static_cast<float>(static_cast<double>(this->accumulator.count()) / static_cast<double>(this->step.count()));
+}
+
+uint64_t drakon::FixedTimestep::getDroppedSteps() const { return this->droppedSteps; }
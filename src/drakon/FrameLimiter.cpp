@@ -0,0 +1,41 @@
+#include <drakon/FrameLimiter.h>
+
+#include <thread>
+
+void drakon::FrameLimiter::setTargetFrameRate(double framesPerSecond) {
+    this->targetFrameRate = framesPerSecond > 0.0 ? framesPerSecond : 0.0;
+    this->framePeriod     = std::chrono::steady_clock::duration::zero();
+    this->nextDeadline    = {};
+
+    if (this->targetFrameRate > 0.0) {
+        const std::chrono::duration<double> period(1.0 / this->targetFrameRate);
+        this->framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+    }
+}
+
+double drakon::FrameLimiter::getTargetFrameRate() const { return this->targetFrameRate; }
+
+void drakon::FrameLimiter::setSpinThreshold(std::chrono::nanoseconds threshold) { this->spinThreshold = threshold; }
+
+void drakon::FrameLimiter::wait() {
+    if (this->targetFrameRate <= 0.0) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (this->nextDeadline.time_since_epoch().count() == 0 || now - this->nextDeadline > this->framePeriod) {
+        // First frame, or more than a frame behind: restart the cadence rather than rushing to catch up
+        this->nextDeadline = now + this->framePeriod;
+        return;
+    }
+
+    const auto sleepUntil = this->nextDeadline - this->spinThreshold;
+    if (now < sleepUntil) {
+        std::this_thread::sleep_until(sleepUntil);
+    }
+    while (std::chrono::steady_clock::now() < this->nextDeadline) {
+        std::this_thread::yield();
+    }
+
+    this->nextDeadline += this->framePeriod;
+}
@@ -1,4 +1,5 @@
 #include <drakon/Game.h>
+#include <drakon/Trace.h>
 
 #include <iostream>
 
@@ -8,9 +9,19 @@
 #include <chrono>
 
 void drakon::Game::run() {
+    this->jobs.start(this->jobWorkerCount, this->pinJobWorkers);
+    this->renderer.setJobSystem(&this->jobs);
+    this->assets.start();
+    this->renderer.getTextureCache().setAssetLoader(&this->assets);
+
     // Init before tracking time
     this->init();
 
+    if (!this->tracePath.empty()) {
+        drakon::Trace::setThreadName("main");
+        drakon::Trace::enable();
+    }
+
     if (this->makeWindow() != 0) {
         this->cleanup();
         return;
@@ -23,16 +34,54 @@ void drakon::Game::run() {
         std::chrono::duration<drakon::Delta> duration    = currentTime - startTime;
         delta                                            = duration.count();
         startTime                                        = currentTime;
-        this->processEvents();
-        // First frame will always have a near-0 value
-        this->tick(delta);
-        this->renderer.render(this->renderables);
+        DRAKON_TRACE_SCOPE("Game::frame");
+        if (this->renderer.isLowLatencyMode()) {
+            // Waiting here rather than inside render keeps the wait from aging the input this frame is built from
+            DRAKON_TRACE_SCOPE("Renderer::waitForFrameSlot");
+            this->renderer.waitForFrameSlot();
+        }
+        {
+            DRAKON_TRACE_SCOPE("Game::processEvents");
+            this->renderer.markInputSampled();
+            this->processEvents();
+        }
+        if (this->useFixedTimestep) {
+            const uint32_t steps = this->fixedTimestep.advance(std::chrono::duration<double>(duration).count());
+            const auto     step  = static_cast<drakon::Delta>(this->fixedTimestep.getStep());
+            for (uint32_t i = 0; i < steps && this->isRunning; ++i) {
+                DRAKON_TRACE_SCOPE("Game::tick");
+                this->tick(step);
+            }
+            this->renderer.setInterpolationAlpha(this->fixedTimestep.getAlpha());
+        } else {
+            DRAKON_TRACE_SCOPE("Game::tick");
+            // First frame will always have a near-0 value
+            this->tick(delta);
+        }
+        this->renderer.render(this->renderables, &this->world);
+        {
+            DRAKON_TRACE_SCOPE("FrameLimiter::wait");
+            this->frameLimiter.wait();
+        }
     }
     this->done();
     this->cleanup();
 }
 
+void drakon::Game::setJobWorkerCount(uint32_t workerCount, bool pinToCores) {
+    this->jobWorkerCount = workerCount;
+    this->pinJobWorkers  = pinToCores;
+}
+
 int drakon::Game::makeWindow() {
+    if (this->headless) {
+        if (!this->renderer.init(nullptr, this->windowWidth, this->windowHeight)) {
+            std::cerr << "Failed to initialize headless renderer." << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW." << std::endl;
         return 1;
@@ -53,6 +102,12 @@ int drakon::Game::makeWindow() {
 
     this->windowHandle = window;
 
+    glfwSetWindowUserPointer(window, this);
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* resizedWindow, int width, int height) {
+        auto* game = static_cast<drakon::Game*>(glfwGetWindowUserPointer(resizedWindow));
+        game->renderer.resize(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    });
+
     if (!this->renderer.init(this->windowHandle, this->windowWidth, this->windowHeight)) {
         std::cerr << "Failed to initialize renderer." << std::endl;
         glfwDestroyWindow(window);
@@ -65,6 +120,10 @@ int drakon::Game::makeWindow() {
 }
 
 void drakon::Game::processEvents() {
+    if (this->headless) {
+        return;
+    }
+
     glfwPollEvents();
     if (this->windowHandle != nullptr) {
         auto* window = reinterpret_cast<GLFWwindow*>(this->windowHandle);
@@ -75,11 +134,26 @@ void drakon::Game::processEvents() {
 }
 
 void drakon::Game::cleanup() {
+    // Components may hold GPU resources, which the renderer destroys on cleanup
+    this->world.clear();
+    this->renderables.clear();
+    this->ownedRenderables.clear();
     this->renderer.cleanup();
+    this->assets.stop();
+    this->jobs.stop();
+
+    if (!this->tracePath.empty()) {
+        drakon::Trace::disable();
+        if (drakon::Trace::writeChromeJson(this->tracePath)) {
+            std::cout << "Wrote CPU trace to " << this->tracePath << std::endl;
+        }
+    }
 
     if (this->windowHandle != nullptr) {
         glfwDestroyWindow(reinterpret_cast<GLFWwindow*>(this->windowHandle));
         this->windowHandle = nullptr;
     }
-    glfwTerminate();
+    if (!this->headless) {
+        glfwTerminate();
+    }
 }
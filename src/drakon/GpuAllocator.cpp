@@ -0,0 +1,475 @@
+#include <drakon/GpuAllocator.h>
+#include <drakon/TlsfAllocator.h>
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkImageViewType viewTypeFor(const VkImageCreateInfo& imageInfo) {
+    switch (imageInfo.imageType) {
+    case VK_IMAGE_TYPE_1D:
+        return imageInfo.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+    case VK_IMAGE_TYPE_3D:
+        return VK_IMAGE_VIEW_TYPE_3D;
+    default:
+        if ((imageInfo.flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT) != 0 && imageInfo.arrayLayers == 6) {
+            return VK_IMAGE_VIEW_TYPE_CUBE;
+        }
+        return imageInfo.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    }
+}
+} // namespace
+
+struct drakon::GpuAllocator::State {
+    struct MemoryBlock {
+        VkDeviceMemory memory     = VK_NULL_HANDLE;
+        void*          mapped     = nullptr;
+        uint32_t       memoryType = 0;
+        bool           linear     = false;
+        TlsfAllocator  allocator;
+    };
+
+    mutable std::mutex                         mutex;
+    VkDevice                                   device              = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties           memoryProperties    = {};
+    VkDeviceSize                               nonCoherentAtomSize = 1;
+    VkDeviceSize                               blockSize           = 0;
+    std::function<void(std::function<void()>)> deferDestroy;
+    // Indexed by GpuAllocation::block; freed blocks leave a null slot for reuse
+    std::vector<std::unique_ptr<MemoryBlock>>        blocks;
+    std::unordered_map<VkDeviceMemory, VkDeviceSize> dedicatedAllocations;
+    std::unordered_set<VkBuffer>                     buffers;
+    std::unordered_map<VkImage, VkImageView>         images;
+    bool                                             shutDown = false;
+
+    bool isHostVisible(uint32_t memoryType) const {
+        const VkMemoryPropertyFlags flags = this->memoryProperties.memoryTypes[memoryType].propertyFlags;
+        return (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+    }
+
+    bool isHostCoherent(uint32_t memoryType) const {
+        const VkMemoryPropertyFlags flags = this->memoryProperties.memoryTypes[memoryType].propertyFlags;
+        return (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+    }
+
+    bool allocateMemory(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory& memory, void*& mapped) {
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize       = size;
+        allocInfo.memoryTypeIndex      = memoryType;
+
+        if (vkAllocateMemory(this->device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+            return false;
+        }
+        mapped = nullptr;
+        if (this->isHostVisible(memoryType) && vkMapMemory(this->device, memory, 0, size, 0, &mapped) != VK_SUCCESS) {
+            vkFreeMemory(this->device, memory, nullptr);
+            memory = VK_NULL_HANDLE;
+            return false;
+        }
+        return true;
+    }
+
+    // Called with the mutex held
+    bool allocateFromType(uint32_t                    memoryType,
+                          const VkMemoryRequirements& requirements,
+                          bool                        linear,
+                          GpuAllocation&              allocation) {
+        VkDeviceSize size      = requirements.size;
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+        // Keep non-coherent allocations on atom boundaries so flushing one never touches a neighbour
+        if (this->isHostVisible(memoryType) && !this->isHostCoherent(memoryType)) {
+            size      = alignUp(size, this->nonCoherentAtomSize);
+            alignment = std::max(alignment, this->nonCoherentAtomSize);
+        }
+
+        const uint32_t     heap      = this->memoryProperties.memoryTypes[memoryType].heapIndex;
+        const VkDeviceSize heapSize  = this->memoryProperties.memoryHeaps[heap].size;
+        const VkDeviceSize blockSize = std::min(this->blockSize, std::max<VkDeviceSize>(heapSize / 8, 1));
+
+        allocation            = {};
+        allocation.size       = size;
+        allocation.memoryType = memoryType;
+
+        if (size > blockSize / 2) {
+            void* mapped = nullptr;
+            if (!this->allocateMemory(memoryType, size, allocation.memory, mapped)) {
+                return false;
+            }
+            allocation.mapped    = mapped;
+            allocation.dedicated = true;
+            this->dedicatedAllocations.emplace(allocation.memory, size);
+            return true;
+        }
+
+        const auto place = [&](uint32_t index) {
+            MemoryBlock&                  block  = *this->blocks[index];
+            const std::optional<uint64_t> offset = block.allocator.allocate(size, alignment);
+            if (!offset.has_value()) {
+                return false;
+            }
+            allocation.memory = block.memory;
+            allocation.offset = *offset;
+            allocation.mapped = block.mapped != nullptr ? static_cast<uint8_t*>(block.mapped) + *offset : nullptr;
+            allocation.block  = index;
+            return true;
+        };
+
+        for (uint32_t i = 0; i < this->blocks.size(); ++i) {
+            const auto& block = this->blocks[i];
+            if (block != nullptr && block->memoryType == memoryType && block->linear == linear && place(i)) {
+                return true;
+            }
+        }
+
+        auto block        = std::make_unique<MemoryBlock>();
+        block->memoryType = memoryType;
+        block->linear     = linear;
+        block->allocator  = TlsfAllocator(blockSize);
+        if (!this->allocateMemory(memoryType, blockSize, block->memory, block->mapped)) {
+            return false;
+        }
+
+        const auto slot  = std::find(this->blocks.begin(), this->blocks.end(), nullptr);
+        const auto index = static_cast<uint32_t>(slot - this->blocks.begin());
+        if (slot == this->blocks.end()) {
+            this->blocks.push_back(std::move(block));
+        } else {
+            *slot = std::move(block);
+        }
+        return place(index);
+    }
+
+    // Called with the mutex held
+    void freeAllocation(const GpuAllocation& allocation) {
+        if (allocation.dedicated) {
+            if (this->dedicatedAllocations.erase(allocation.memory) > 0) {
+                vkFreeMemory(this->device, allocation.memory, nullptr);
+            }
+            return;
+        }
+        if (allocation.block >= this->blocks.size() || this->blocks[allocation.block] == nullptr) {
+            return;
+        }
+
+        MemoryBlock& block = *this->blocks[allocation.block];
+        block.allocator.free(allocation.offset);
+        if (!block.allocator.isEmpty()) {
+            return;
+        }
+
+        // Keep one empty block per pool so a resource recreated every frame does not churn device allocations
+        const bool hasSibling = std::any_of(this->blocks.begin(), this->blocks.end(), [&](const auto& other) {
+            return other != nullptr && other.get() != &block && other->memoryType == block.memoryType &&
+                   other->linear == block.linear;
+        });
+        if (hasSibling) {
+            vkFreeMemory(this->device, block.memory, nullptr);
+            this->blocks[allocation.block].reset();
+        }
+    }
+
+    void destroyBuffer(VkBuffer handle, const GpuAllocation& allocation) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->shutDown || this->buffers.erase(handle) == 0) {
+            return;
+        }
+        vkDestroyBuffer(this->device, handle, nullptr);
+        this->freeAllocation(allocation);
+    }
+
+    void destroyImage(VkImage handle, const GpuAllocation& allocation) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        const auto                  found = this->images.find(handle);
+        if (this->shutDown || found == this->images.end()) {
+            return;
+        }
+        if (found->second != VK_NULL_HANDLE) {
+            vkDestroyImageView(this->device, found->second, nullptr);
+        }
+        vkDestroyImage(this->device, handle, nullptr);
+        this->images.erase(found);
+        this->freeAllocation(allocation);
+    }
+};
+
+bool drakon::GpuAllocator::init(VkPhysicalDevice                           physicalDevice,
+                                VkDevice                                   device,
+                                std::function<void(std::function<void()>)> deferDestroy,
+                                VkDeviceSize                               blockSize) {
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    this->state                      = std::make_shared<State>();
+    this->state->device              = device;
+    this->state->nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+    this->state->blockSize           = blockSize;
+    this->state->deferDestroy        = std::move(deferDestroy);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &this->state->memoryProperties);
+    return true;
+}
+
+void drakon::GpuAllocator::cleanup() {
+    if (this->state == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->state->mutex);
+        const VkDevice              device = this->state->device;
+        for (const auto& [image, view] : this->state->images) {
+            if (view != VK_NULL_HANDLE) {
+                vkDestroyImageView(device, view, nullptr);
+            }
+            vkDestroyImage(device, image, nullptr);
+        }
+        for (VkBuffer buffer : this->state->buffers) {
+            vkDestroyBuffer(device, buffer, nullptr);
+        }
+        for (const auto& block : this->state->blocks) {
+            if (block != nullptr) {
+                vkFreeMemory(device, block->memory, nullptr);
+            }
+        }
+        for (const auto& [memory, size] : this->state->dedicatedAllocations) {
+            vkFreeMemory(device, memory, nullptr);
+        }
+        this->state->images.clear();
+        this->state->buffers.clear();
+        this->state->blocks.clear();
+        this->state->dedicatedAllocations.clear();
+        this->state->shutDown = true;
+    }
+    this->state.reset();
+}
+
+bool drakon::GpuAllocator::allocate(const VkMemoryRequirements& requirements,
+                                    VkMemoryPropertyFlags       required,
+                                    VkMemoryPropertyFlags       preferred,
+                                    bool                        linear,
+                                    GpuAllocation&              allocation) {
+    const std::shared_ptr<State> state = this->state;
+    if (state == nullptr) {
+        return false;
+    }
+
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < state->memoryProperties.memoryTypeCount; ++i) {
+        const VkMemoryPropertyFlags flags = state->memoryProperties.memoryTypes[i].propertyFlags;
+        if ((requirements.memoryTypeBits & (1u << i)) != 0 && (flags & required) == required) {
+            candidates.push_back(i);
+        }
+    }
+    if (candidates.empty()) {
+        std::cerr << "No suitable Vulkan memory type for allocation." << std::endl;
+        return false;
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+        const VkMemoryPropertyFlags flagsA = state->memoryProperties.memoryTypes[a].propertyFlags;
+        const VkMemoryPropertyFlags flagsB = state->memoryProperties.memoryTypes[b].propertyFlags;
+        return std::popcount(flagsA & preferred) > std::popcount(flagsB & preferred);
+    });
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    for (uint32_t memoryType : candidates) {
+        if (state->allocateFromType(memoryType, requirements, linear, allocation)) {
+            return true;
+        }
+    }
+
+    std::cerr << "Failed to allocate Vulkan device memory." << std::endl;
+    return false;
+}
+
+void drakon::GpuAllocator::free(const GpuAllocation& allocation) {
+    if (this->state == nullptr || allocation.memory == VK_NULL_HANDLE) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(this->state->mutex);
+    this->state->freeAllocation(allocation);
+}
+
+bool drakon::GpuAllocator::flush(const GpuAllocation& allocation) const {
+    if (this->state == nullptr || allocation.mapped == nullptr || this->state->isHostCoherent(allocation.memoryType)) {
+        return true;
+    }
+
+    VkMappedMemoryRange range = {};
+    range.sType               = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory              = allocation.memory;
+    range.offset              = allocation.offset;
+    range.size                = allocation.size;
+    if (vkFlushMappedMemoryRanges(this->state->device, 1, &range) != VK_SUCCESS) {
+        std::cerr << "Failed to flush Vulkan mapped memory." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+drakon::BufferHandle drakon::GpuAllocator::createBuffer(VkDeviceSize          size,
+                                                        VkBufferUsageFlags    usage,
+                                                        VkMemoryPropertyFlags required,
+                                                        VkMemoryPropertyFlags preferred) {
+    const std::shared_ptr<State> state = this->state;
+    if (state == nullptr) {
+        return nullptr;
+    }
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size               = size;
+    bufferInfo.usage              = usage;
+    bufferInfo.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer handle = VK_NULL_HANDLE;
+    if (vkCreateBuffer(state->device, &bufferInfo, nullptr, &handle) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan buffer." << std::endl;
+        return nullptr;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(state->device, handle, &requirements);
+
+    GpuAllocation allocation;
+    if (!this->allocate(requirements, required, preferred, true, allocation)) {
+        vkDestroyBuffer(state->device, handle, nullptr);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (vkBindBufferMemory(state->device, handle, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        std::cerr << "Failed to bind Vulkan buffer memory." << std::endl;
+        vkDestroyBuffer(state->device, handle, nullptr);
+        state->freeAllocation(allocation);
+        return nullptr;
+    }
+    state->buffers.insert(handle);
+
+    const std::weak_ptr<State> weakState = state;
+    return BufferHandle(new Buffer{handle, size, allocation}, [weakState](const Buffer* released) {
+        if (std::shared_ptr<State> state = weakState.lock()) {
+            state->deferDestroy([weakState, handle = released->handle, allocation = released->allocation]() {
+                if (std::shared_ptr<State> state = weakState.lock()) {
+                    state->destroyBuffer(handle, allocation);
+                }
+            });
+        }
+        delete released;
+    });
+}
+
+drakon::ImageHandle drakon::GpuAllocator::createImage(const VkImageCreateInfo& imageInfo,
+                                                      VkImageAspectFlags       viewAspect,
+                                                      VkMemoryPropertyFlags    required,
+                                                      VkImageViewType          viewType) {
+    const std::shared_ptr<State> state = this->state;
+    if (state == nullptr) {
+        return nullptr;
+    }
+
+    VkImage handle = VK_NULL_HANDLE;
+    if (vkCreateImage(state->device, &imageInfo, nullptr, &handle) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan image." << std::endl;
+        return nullptr;
+    }
+
+    VkMemoryRequirements requirements = {};
+    vkGetImageMemoryRequirements(state->device, handle, &requirements);
+
+    const bool    linear = imageInfo.tiling == VK_IMAGE_TILING_LINEAR;
+    GpuAllocation allocation;
+    if (!this->allocate(requirements, required, 0, linear, allocation)) {
+        vkDestroyImage(state->device, handle, nullptr);
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (vkBindImageMemory(state->device, handle, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        std::cerr << "Failed to bind Vulkan image memory." << std::endl;
+        vkDestroyImage(state->device, handle, nullptr);
+        state->freeAllocation(allocation);
+        return nullptr;
+    }
+
+    VkImageView view = VK_NULL_HANDLE;
+    if (viewAspect != 0) {
+        if (viewType == VK_IMAGE_VIEW_TYPE_MAX_ENUM) {
+            viewType = viewTypeFor(imageInfo);
+        }
+
+        VkImageViewCreateInfo viewInfo           = {};
+        viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image                           = handle;
+        viewInfo.viewType                        = viewType;
+        viewInfo.format                          = imageInfo.format;
+        viewInfo.subresourceRange.aspectMask     = viewAspect;
+        viewInfo.subresourceRange.baseMipLevel   = 0;
+        viewInfo.subresourceRange.levelCount     = imageInfo.mipLevels;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount     = imageInfo.arrayLayers;
+
+        if (vkCreateImageView(state->device, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+            std::cerr << "Failed to create Vulkan image view." << std::endl;
+            vkDestroyImage(state->device, handle, nullptr);
+            state->freeAllocation(allocation);
+            return nullptr;
+        }
+    }
+    state->images.emplace(handle, view);
+
+    const std::weak_ptr<State> weakState = state;
+    Image* image = new Image{handle, view, imageInfo.format, imageInfo.extent, imageInfo.mipLevels, allocation};
+    return ImageHandle(image, [weakState](const Image* released) {
+        if (std::shared_ptr<State> state = weakState.lock()) {
+            state->deferDestroy([weakState, handle = released->handle, allocation = released->allocation]() {
+                if (std::shared_ptr<State> state = weakState.lock()) {
+                    state->destroyImage(handle, allocation);
+                }
+            });
+        }
+        delete released;
+    });
+}
+
+drakon::GpuAllocatorStats drakon::GpuAllocator::getStats() const {
+    GpuAllocatorStats stats;
+    if (this->state == nullptr) {
+        return stats;
+    }
+
+    std::lock_guard<std::mutex> lock(this->state->mutex);
+    VkDeviceSize                freeBytes   = 0;
+    VkDeviceSize                largestFree = 0;
+    for (const auto& block : this->state->blocks) {
+        if (block == nullptr) {
+            continue;
+        }
+        stats.bytesReserved += block->allocator.getSize();
+        stats.bytesUsed += block->allocator.getUsedBytes();
+        stats.allocations += block->allocator.getAllocationCount();
+        ++stats.blocks;
+        freeBytes += block->allocator.getSize() - block->allocator.getUsedBytes();
+        largestFree = std::max(largestFree, block->allocator.getLargestFreeBlock());
+    }
+    for (const auto& [memory, size] : this->state->dedicatedAllocations) {
+        stats.bytesReserved += size;
+        stats.bytesUsed += size;
+        ++stats.allocations;
+        ++stats.dedicated;
+    }
+
+    if (freeBytes > 0) {
+        stats.fragmentation = 1.0f - static_cast<float>(largestFree) / static_cast<float>(freeBytes);
+    }
+    return stats;
+}
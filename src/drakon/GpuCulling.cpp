@@ -0,0 +1,421 @@
+#include <drakon/GpuCulling.h>
+#include <drakon/Renderer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+constexpr uint32_t CULLING_WORKGROUP_SIZE = 64;
+constexpr uint32_t CULLING_FLAG_COMPACT   = 1;
+constexpr uint32_t CULLING_FLAG_INSTANCE  = 2;
+
+// Matches the push constant block of the culling shader
+struct CullingPushConstants {
+    float    planes[6][4] = {};
+    uint32_t objectCount  = 0;
+    uint32_t flags        = 0;
+};
+
+const char* const CULLING_SHADER_SOURCE = R"(#version 450
+layout(local_size_x = CULLING_WORKGROUP_SIZE) in;
+
+struct Object {
+    vec4 sphere;
+    uint indexCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint reserved;
+};
+
+struct DrawCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint firstInstance;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects { Object objects[]; };
+layout(std430, set = 0, binding = 1) writeonly buffer Draws { DrawCommand draws[]; };
+layout(std430, set = 0, binding = 2) buffer Count { uint drawCount; };
+
+layout(push_constant) uniform Culling {
+    vec4 planes[6];
+    uint objectCount;
+    uint flags;
+};
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= objectCount) {
+        return;
+    }
+
+    Object object = objects[index];
+    bool visible = true;
+    for (int i = 0; i < 6; ++i) {
+        visible = visible && dot(planes[i].xyz, object.sphere.xyz) + planes[i].w >= -object.sphere.w;
+    }
+
+    uint firstInstance = (flags & CULLING_FLAG_INSTANCE) != 0u ? index : 0u;
+    DrawCommand draw = DrawCommand(object.indexCount, visible ? 1u : 0u, object.firstIndex, object.vertexOffset,
+                                   firstInstance);
+    if ((flags & CULLING_FLAG_COMPACT) != 0u) {
+        if (visible) {
+            draws[atomicAdd(drawCount, 1u)] = draw;
+        }
+    } else {
+        draws[index] = draw;
+        if (visible) {
+            atomicAdd(drawCount, 1u);
+        }
+    }
+}
+)";
+
+void normalizePlane(std::array<float, 4>& plane) {
+    const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+    if (length > 0.0f) {
+        for (float& component : plane) {
+            component /= length;
+        }
+    }
+}
+} // namespace
+
+bool drakon::GpuCulling::init(Renderer& renderer, uint32_t maxObjects) {
+    this->renderer   = &renderer;
+    this->device     = renderer.getDevice();
+    this->support    = renderer.getIndirectDrawSupport();
+    this->maxObjects = std::max<uint32_t>(maxObjects, 1);
+    this->planes     = extractFrustumPlanes({1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1});
+    // A count draw cannot be split, so it is only used when one call can cover every object
+    if (this->maxObjects > this->support.maxDrawIndirectCount) {
+        this->support.drawIndexedIndirectCount = nullptr;
+    }
+
+    // The shader takes its constants from here so the two sides cannot drift apart
+    ShaderCompileOptions options;
+    options.stage   = ShaderStage::Compute;
+    options.defines = {
+        {"CULLING_WORKGROUP_SIZE", std::to_string(CULLING_WORKGROUP_SIZE)},
+        {"CULLING_FLAG_COMPACT", std::to_string(CULLING_FLAG_COMPACT) + "u"},
+        {"CULLING_FLAG_INSTANCE", std::to_string(CULLING_FLAG_INSTANCE) + "u"},
+    };
+
+    const ShaderCompileResult shader =
+        renderer.getShaderCompiler().compileSource(CULLING_SHADER_SOURCE, "gpu_culling.comp", options);
+    if (!shader.success) {
+        std::cerr << "Failed to compile GPU culling shader:" << std::endl << shader.log << std::endl;
+        return false;
+    }
+
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+    for (uint32_t i = 0; i < bindings.size(); ++i) {
+        bindings[i].binding         = i;
+        bindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount                    = static_cast<uint32_t>(bindings.size());
+    setLayoutInfo.pBindings                       = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(this->device, &setLayoutInfo, nullptr, &this->descriptorSetLayout) !=
+        VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan descriptor set layout." << std::endl;
+        return false;
+    }
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags          = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset              = 0;
+    pushConstantRange.size                = sizeof(CullingPushConstants);
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount             = 1;
+    layoutInfo.pSetLayouts                = &this->descriptorSetLayout;
+    layoutInfo.pushConstantRangeCount     = 1;
+    layoutInfo.pPushConstantRanges        = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(this->device, &layoutInfo, nullptr, &this->pipelineLayout) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan pipeline layout." << std::endl;
+        return false;
+    }
+
+    VkShaderModuleCreateInfo moduleInfo = {};
+    moduleInfo.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize                 = shader.spirv.size() * sizeof(uint32_t);
+    moduleInfo.pCode                    = shader.spirv.data();
+
+    VkShaderModule shaderModule = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(this->device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan shader module." << std::endl;
+        return false;
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType                 = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage                 = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module                = shaderModule;
+    pipelineInfo.stage.pName                 = "main";
+    pipelineInfo.layout                      = this->pipelineLayout;
+
+    const VkPipelineCache pipelineCache = renderer.getPipelineCache().getHandle();
+    const VkResult        result =
+        vkCreateComputePipelines(this->device, pipelineCache, 1, &pipelineInfo, nullptr, &this->pipeline);
+    vkDestroyShaderModule(this->device, shaderModule, nullptr);
+    if (result != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan compute pipeline." << std::endl;
+        return false;
+    }
+
+    const uint32_t       frameCount = renderer.getFrameSlotCount();
+    VkDescriptorPoolSize poolSize   = {};
+    poolSize.type                   = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount        = frameCount * static_cast<uint32_t>(bindings.size());
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets                    = frameCount;
+    poolInfo.poolSizeCount              = 1;
+    poolInfo.pPoolSizes                 = &poolSize;
+
+    if (vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &this->descriptorPool) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan descriptor pool." << std::endl;
+        return false;
+    }
+
+    // Each frame in flight culls into its own buffers, so one frame's draws are never overwritten by the next cull
+    const VkDeviceSize objectBytes = VkDeviceSize(this->maxObjects) * sizeof(GpuCullingObject);
+    const VkDeviceSize drawBytes   = VkDeviceSize(this->maxObjects) * sizeof(VkDrawIndexedIndirectCommand);
+
+    const VkMemoryPropertyFlags hostMemory =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkBufferUsageFlags    drawUsage  = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+    GpuAllocator& allocator = renderer.getGpuAllocator();
+    this->frames.resize(frameCount);
+    for (Frame& frame : this->frames) {
+        frame.objects = allocator.createBuffer(objectBytes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+        frame.draws   = allocator.createBuffer(drawBytes, drawUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.count   = allocator.createBuffer(
+            sizeof(uint32_t), drawUsage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, hostMemory);
+        if (frame.objects == nullptr || frame.draws == nullptr || frame.count == nullptr) {
+            std::cerr << "Failed to create GPU culling buffers." << std::endl;
+            return false;
+        }
+        std::memset(frame.count->allocation.mapped, 0, sizeof(uint32_t));
+
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool              = this->descriptorPool;
+        allocInfo.descriptorSetCount          = 1;
+        allocInfo.pSetLayouts                 = &this->descriptorSetLayout;
+
+        if (vkAllocateDescriptorSets(this->device, &allocInfo, &frame.descriptorSet) != VK_SUCCESS) {
+            std::cerr << "Failed to allocate Vulkan descriptor set." << std::endl;
+            return false;
+        }
+
+        const std::array<VkDescriptorBufferInfo, 3> bufferInfos = {{
+            {frame.objects->handle, 0, VK_WHOLE_SIZE},
+            {frame.draws->handle, 0, VK_WHOLE_SIZE},
+            {frame.count->handle, 0, VK_WHOLE_SIZE},
+        }};
+        std::array<VkWriteDescriptorSet, 3> writes = {};
+        for (uint32_t i = 0; i < writes.size(); ++i) {
+            writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet          = frame.descriptorSet;
+            writes[i].dstBinding      = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo     = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    return true;
+}
+
+void drakon::GpuCulling::cleanup() {
+    if (this->renderer == nullptr) {
+        return;
+    }
+
+    this->frames.clear();
+    this->renderer->deferDestruction([device         = this->device,
+                                      pipeline       = this->pipeline,
+                                      pipelineLayout = this->pipelineLayout,
+                                      descriptorPool = this->descriptorPool,
+                                      setLayout      = this->descriptorSetLayout]() {
+        vkDestroyPipeline(device, pipeline, nullptr);
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    });
+
+    this->pipeline            = VK_NULL_HANDLE;
+    this->pipelineLayout      = VK_NULL_HANDLE;
+    this->descriptorPool      = VK_NULL_HANDLE;
+    this->descriptorSetLayout = VK_NULL_HANDLE;
+    this->renderer            = nullptr;
+}
+
+void drakon::GpuCulling::setObjects(const std::vector<GpuCullingObject>& objects) {
+    if (objects.size() > this->maxObjects) {
+        std::cerr << "GPU culling holds " << this->maxObjects << " objects; dropping "
+                  << objects.size() - this->maxObjects << std::endl;
+    }
+    const size_t count = std::min<size_t>(objects.size(), this->maxObjects);
+    this->objects.assign(objects.begin(), objects.begin() + static_cast<std::ptrdiff_t>(count));
+    for (Frame& frame : this->frames) {
+        frame.objectsStale = true;
+    }
+}
+
+void drakon::GpuCulling::setFrustum(const FrustumPlanes& planes) { this->planes = planes; }
+
+drakon::FrustumPlanes drakon::GpuCulling::extractFrustumPlanes(const std::array<float, 16>& viewProjection) {
+    std::array<std::array<float, 4>, 4> rows = {};
+    for (size_t row = 0; row < 4; ++row) {
+        for (size_t column = 0; column < 4; ++column) {
+            rows[row][column] = viewProjection[column * 4 + row];
+        }
+    }
+
+    FrustumPlanes planes = {};
+    for (size_t i = 0; i < 4; ++i) {
+        planes[0][i] = rows[3][i] + rows[0][i];
+        planes[1][i] = rows[3][i] - rows[0][i];
+        planes[2][i] = rows[3][i] + rows[1][i];
+        planes[3][i] = rows[3][i] - rows[1][i];
+        // Vulkan clips depth to [0, w] rather than [-w, w]
+        planes[4][i] = rows[2][i];
+        planes[5][i] = rows[3][i] - rows[2][i];
+    }
+    for (auto& plane : planes) {
+        normalizePlane(plane);
+    }
+    return planes;
+}
+
+bool drakon::GpuCulling::isSphereVisible(const FrustumPlanes& planes, const float center[3], float radius) {
+    for (const auto& plane : planes) {
+        const float distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+        if (distance < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void drakon::GpuCulling::recordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+    if (this->frames.empty()) {
+        return;
+    }
+    Frame& frame = this->frames[frameIndex % this->frames.size()];
+
+    // The slot's last frame has finished, so its buffers are free and its last count is final
+    this->visibleCount = *static_cast<const uint32_t*>(frame.count->allocation.mapped);
+    if (frame.objectsStale) {
+        const size_t bytes = this->objects.size() * sizeof(GpuCullingObject);
+        std::memcpy(frame.objects->allocation.mapped, this->objects.data(), bytes);
+        frame.objectsStale = false;
+    }
+
+    vkCmdFillBuffer(commandBuffer, frame.count->handle, 0, sizeof(uint32_t), 0);
+
+    VkMemoryBarrier clearBarrier = {};
+    clearBarrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clearBarrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clearBarrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         1,
+                         &clearBarrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+
+    const auto objectCount = static_cast<uint32_t>(this->objects.size());
+    if (objectCount > 0) {
+        CullingPushConstants pushConstants;
+        std::memcpy(pushConstants.planes, this->planes.data(), sizeof(pushConstants.planes));
+        pushConstants.objectCount = objectCount;
+        if (this->support.drawIndexedIndirectCount != nullptr) {
+            pushConstants.flags |= CULLING_FLAG_COMPACT;
+        }
+        if (this->support.drawIndirectFirstInstance) {
+            pushConstants.flags |= CULLING_FLAG_INSTANCE;
+        }
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline);
+        vkCmdBindDescriptorSets(commandBuffer,
+                                VK_PIPELINE_BIND_POINT_COMPUTE,
+                                this->pipelineLayout,
+                                0,
+                                1,
+                                &frame.descriptorSet,
+                                0,
+                                nullptr);
+        vkCmdPushConstants(commandBuffer,
+                           this->pipelineLayout,
+                           VK_SHADER_STAGE_COMPUTE_BIT,
+                           0,
+                           sizeof(pushConstants),
+                           &pushConstants);
+        vkCmdDispatch(commandBuffer, (objectCount + CULLING_WORKGROUP_SIZE - 1) / CULLING_WORKGROUP_SIZE, 1, 1);
+    }
+
+    // The count is also read back on the host once the frame finishes
+    VkMemoryBarrier drawBarrier = {};
+    drawBarrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    drawBarrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+    drawBarrier.dstAccessMask   = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         0,
+                         1,
+                         &drawBarrier,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr);
+}
+
+void drakon::GpuCulling::recordDraws(VkCommandBuffer commandBuffer, uint32_t frameIndex) const {
+    if (this->frames.empty() || this->objects.empty()) {
+        return;
+    }
+    const Frame&   frame       = this->frames[frameIndex % this->frames.size()];
+    const auto     objectCount = static_cast<uint32_t>(this->objects.size());
+    const uint32_t stride      = sizeof(VkDrawIndexedIndirectCommand);
+
+    if (this->support.drawIndexedIndirectCount != nullptr) {
+        this->support.drawIndexedIndirectCount(
+            commandBuffer, frame.draws->handle, 0, frame.count->handle, 0, objectCount, stride);
+    } else {
+        const uint32_t chunk = std::max(this->support.maxDrawIndirectCount, 1u);
+        for (uint32_t first = 0; first < objectCount;) {
+            const uint32_t count = std::min(chunk, objectCount - first);
+            vkCmdDrawIndexedIndirect(commandBuffer, frame.draws->handle, VkDeviceSize(first) * stride, count, stride);
+            first += count;
+        }
+    }
+}
+
+uint32_t drakon::GpuCulling::getObjectCount() const { return static_cast<uint32_t>(this->objects.size()); }
+
+uint32_t drakon::GpuCulling::getVisibleCount() const { return this->visibleCount; }
@@ -0,0 +1,203 @@
+#include <drakon/GpuProfiler.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+constexpr uint32_t FRAME_SCOPE = 0;
+
+uint32_t beginQuery(uint32_t scope) { return scope * 2; }
+uint32_t endQuery(uint32_t scope) { return scope * 2 + 1; }
+} // namespace
+
+bool drakon::GpuProfiler::init(VkPhysicalDevice physicalDevice,
+                               VkDevice         device,
+                               uint32_t         queueFamilyIndex,
+                               uint32_t         framesInFlight,
+                               uint32_t         maxScopesPerFrame) {
+    this->vkDevice          = device;
+    this->maxScopesPerFrame = std::max<uint32_t>(maxScopesPerFrame, 1);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    uint32_t validBits = 0;
+    if (queueFamilyIndex < queueFamilyCount) {
+        validBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+    }
+    this->supported = validBits > 0;
+    if (!this->supported) {
+        std::cerr << "Vulkan queue does not support timestamps; GPU profiling is unavailable." << std::endl;
+        return true;
+    }
+    this->timestampPeriod = properties.limits.timestampPeriod;
+    this->timestampMask   = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount            = this->maxScopesPerFrame * 2;
+
+    for (uint32_t i = 0; i < framesInFlight; ++i) {
+        auto frame = std::make_unique<FrameQueries>();
+        if (vkCreateQueryPool(this->vkDevice, &queryPoolInfo, nullptr, &frame->queryPool) != VK_SUCCESS) {
+            std::cerr << "Failed to create Vulkan timestamp query pool." << std::endl;
+            return false;
+        }
+        frame->names.resize(this->maxScopesPerFrame, nullptr);
+        this->frames.push_back(std::move(frame));
+    }
+
+    return true;
+}
+
+void drakon::GpuProfiler::cleanup() {
+    for (auto& frame : this->frames) {
+        vkDestroyQueryPool(this->vkDevice, frame->queryPool, nullptr);
+    }
+    this->frames.clear();
+    this->supported = false;
+}
+
+void drakon::GpuProfiler::setEnabled(bool enabled) { this->enabled = enabled; }
+
+bool drakon::GpuProfiler::isEnabled() const { return this->enabled; }
+
+bool drakon::GpuProfiler::isSupported() const { return this->supported; }
+
+bool drakon::GpuProfiler::isActive() const { return DRAKON_GPU_PROFILER && this->enabled && this->supported; }
+
+void drakon::GpuProfiler::setHistoryLength(size_t frames) {
+    this->historyLength = std::max<size_t>(frames, 1);
+    this->history.clear();
+    this->historyNext  = 0;
+    this->historyCount = 0;
+}
+
+void drakon::GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber) {
+    FrameQueries& frame = *this->frames[frameIndex];
+    frame.frameNumber   = frameNumber;
+    frame.nextScope.store(FRAME_SCOPE + 1, std::memory_order_relaxed);
+    frame.names[FRAME_SCOPE] = "frame";
+
+    vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0, this->maxScopesPerFrame * 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, beginQuery(FRAME_SCOPE));
+}
+
+void drakon::GpuProfiler::endFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+    FrameQueries& frame = *this->frames[frameIndex];
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, endQuery(FRAME_SCOPE));
+    frame.pending = true;
+}
+
+uint32_t drakon::GpuProfiler::beginScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, const char* name) {
+    FrameQueries&  frame = *this->frames[frameIndex];
+    const uint32_t scope = frame.nextScope.fetch_add(1, std::memory_order_relaxed);
+    if (scope >= this->maxScopesPerFrame) {
+        return INVALID_SCOPE;
+    }
+
+    frame.names[scope] = name;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, beginQuery(scope));
+    return scope;
+}
+
+void drakon::GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scope) {
+    if (scope == INVALID_SCOPE) {
+        return;
+    }
+    FrameQueries& frame = *this->frames[frameIndex];
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, endQuery(scope));
+}
+
+void drakon::GpuProfiler::collect(uint32_t frameIndex) {
+    if (frameIndex >= this->frames.size()) {
+        return;
+    }
+    FrameQueries& frame = *this->frames[frameIndex];
+    if (!frame.pending) {
+        return;
+    }
+    frame.pending = false;
+
+    const uint32_t requestedScopes = frame.nextScope.load(std::memory_order_relaxed);
+    const uint32_t scopeCount      = std::min(requestedScopes, this->maxScopesPerFrame);
+    this->queryResults.resize(static_cast<size_t>(scopeCount) * 2);
+
+    // No WAIT flag: the frame has finished, so anything not yet available means a scope was never closed
+    const VkResult result = vkGetQueryPoolResults(this->vkDevice,
+                                                  frame.queryPool,
+                                                  0,
+                                                  scopeCount * 2,
+                                                  this->queryResults.size() * sizeof(uint64_t),
+                                                  this->queryResults.data(),
+                                                  sizeof(uint64_t),
+                                                  VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return;
+    }
+
+    const auto toMilliseconds = [this](uint32_t scope) {
+        const uint64_t ticks = (this->queryResults[endQuery(scope)] - this->queryResults[beginQuery(scope)]) &
+                               this->timestampMask;
+        return static_cast<double>(ticks) * this->timestampPeriod / 1e6;
+    };
+
+    if (this->history.size() < this->historyLength) {
+        this->history.resize(this->historyLength);
+    }
+    GpuFrameTimings& timings = this->history[this->historyNext];
+    timings.frameNumber      = frame.frameNumber;
+    timings.milliseconds     = toMilliseconds(FRAME_SCOPE);
+    timings.droppedScopes    = requestedScopes - scopeCount;
+    timings.scopes.resize(scopeCount - 1);
+    for (uint32_t scope = FRAME_SCOPE + 1; scope < scopeCount; ++scope) {
+        GpuScopeTiming& timing = timings.scopes[scope - 1];
+        timing.name            = frame.names[scope] != nullptr ? frame.names[scope] : "";
+        timing.milliseconds    = toMilliseconds(scope);
+    }
+
+    this->historyNext  = (this->historyNext + 1) % this->historyLength;
+    this->historyCount = std::min(this->historyCount + 1, this->historyLength);
+}
+
+size_t drakon::GpuProfiler::getHistorySize() const { return this->historyCount; }
+
+const drakon::GpuFrameTimings& drakon::GpuProfiler::getFrame(size_t age) const {
+    const size_t offset = age % this->historyLength;
+    return this->history[(this->historyNext + this->historyLength - 1 - offset) % this->historyLength];
+}
+
+drakon::GpuScopeStats drakon::GpuProfiler::getScopeStats(const std::string& name) const {
+    GpuScopeStats stats;
+    double        total = 0.0;
+    for (size_t age = 0; age < this->historyCount; ++age) {
+        const GpuFrameTimings& timings = this->getFrame(age);
+
+        bool   found        = false;
+        double milliseconds = 0.0;
+        for (const auto& scope : timings.scopes) {
+            if (scope.name == name) {
+                found = true;
+                milliseconds += scope.milliseconds;
+            }
+        }
+        if (!found) {
+            continue;
+        }
+
+        ++stats.samples;
+        total += milliseconds;
+        stats.maxMilliseconds = std::max(stats.maxMilliseconds, milliseconds);
+    }
+
+    if (stats.samples > 0) {
+        stats.averageMilliseconds = total / stats.samples;
+    }
+    return stats;
+}
@@ -0,0 +1,267 @@
+#include <drakon/JobSystem.h>
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+constexpr uint32_t NO_WORKER = UINT32_MAX;
+// Failed attempts to find a job before an idle worker goes to sleep
+constexpr uint32_t IDLE_SPINS = 64;
+
+thread_local const drakon::JobSystem* currentJobSystem = nullptr;
+thread_local uint32_t                 currentWorker    = NO_WORKER;
+thread_local uint32_t                 stealSeed        = 0x9E3779B9u;
+
+uint32_t nextRandom() {
+    // xorshift32, only needed to spread thieves over victims
+    stealSeed ^= stealSeed << 13;
+    stealSeed ^= stealSeed >> 17;
+    stealSeed ^= stealSeed << 5;
+    return stealSeed;
+}
+
+void pinToCore(std::thread& thread, uint32_t core) {
+#ifdef __linux__
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core % CPU_SETSIZE, &cores);
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(cores), &cores) != 0) {
+        std::cerr << "Failed to pin job worker to core " << core << "." << std::endl;
+    }
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+} // namespace
+
+uint32_t drakon::JobGraph::add(std::function<void()> job) {
+    Node node;
+    node.job = std::move(job);
+    this->nodes.push_back(std::move(node));
+    return static_cast<uint32_t>(this->nodes.size() - 1);
+}
+
+void drakon::JobGraph::precede(uint32_t before, uint32_t after) {
+    this->nodes[before].successors.push_back(after);
+    ++this->nodes[after].predecessorCount;
+}
+
+size_t drakon::JobGraph::size() const { return this->nodes.size(); }
+
+void drakon::JobGraph::clear() {
+    this->nodes.clear();
+    this->remaining.reset();
+}
+
+void drakon::JobGraph::run(JobSystem& jobs, JobCounter& counter) {
+    // Counted up front, so the counter cannot reach zero between one job finishing and its successors being queued
+    counter.pending.fetch_add(static_cast<uint32_t>(this->nodes.size()), std::memory_order_relaxed);
+
+    this->remaining = std::make_unique<std::atomic<uint32_t>[]>(this->nodes.size());
+    for (size_t i = 0; i < this->nodes.size(); ++i) {
+        this->remaining[i].store(this->nodes[i].predecessorCount, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < this->nodes.size(); ++i) {
+        if (this->nodes[i].predecessorCount == 0) {
+            this->runNode(jobs, counter, i);
+        }
+    }
+}
+
+void drakon::JobGraph::runNode(JobSystem& jobs, JobCounter& counter, uint32_t node) {
+    jobs.run([this, &jobs, &counter, node]() {
+        this->nodes[node].job();
+        for (uint32_t successor : this->nodes[node].successors) {
+            if (this->remaining[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                this->runNode(jobs, counter, successor);
+            }
+        }
+        counter.pending.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+drakon::JobSystem::~JobSystem() { this->stop(); }
+
+uint32_t drakon::JobSystem::getDefaultWorkerCount() {
+    const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void drakon::JobSystem::start(uint32_t workerCount, bool pinToCores) {
+    this->stop();
+
+    this->stopping.store(false, std::memory_order_relaxed);
+    // Every deque exists before any thread starts, since each worker steals from all of them
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        this->workers.push_back(std::make_unique<Worker>());
+    }
+    const uint32_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        this->workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+        if (pinToCores) {
+            pinToCore(this->workers[i]->thread, (i + 1) % cores);
+        }
+    }
+}
+
+void drakon::JobSystem::stop() {
+    if (this->workers.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->stopping.store(true, std::memory_order_relaxed);
+    }
+    this->wake.notify_all();
+    for (auto& worker : this->workers) {
+        worker->thread.join();
+    }
+
+    // Workers only exit once they find nothing to take, but jobs queued after that are still owed a run
+    std::vector<Job*> leftovers;
+    for (auto& worker : this->workers) {
+        while (Job* job = worker->deque.steal()) {
+            leftovers.push_back(job);
+        }
+    }
+    leftovers.insert(leftovers.end(), this->injected.begin(), this->injected.end());
+    this->injected.clear();
+    this->workers.clear();
+    this->queuedJobs.store(0, std::memory_order_relaxed);
+    for (Job* job : leftovers) {
+        this->execute(job);
+    }
+}
+
+uint32_t drakon::JobSystem::getWorkerCount() const { return static_cast<uint32_t>(this->workers.size()); }
+
+void drakon::JobSystem::run(std::function<void()> job, JobCounter* counter) {
+    if (counter != nullptr) {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (this->workers.empty()) {
+        this->execute(new Job{std::move(job), counter});
+        return;
+    }
+    this->push(new Job{std::move(job), counter});
+}
+
+void drakon::JobSystem::wait(const JobCounter& counter) {
+    const uint32_t workerIndex = currentJobSystem == this ? currentWorker : NO_WORKER;
+    while (!counter.isDone()) {
+        if (Job* job = this->take(workerIndex)) {
+            this->execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void drakon::JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    grainSize = std::max<size_t>(grainSize, 1);
+    if (this->workers.empty() || count <= grainSize) {
+        for (size_t begin = 0; begin < count; begin += grainSize) {
+            body(begin, std::min(begin + grainSize, count));
+        }
+        return;
+    }
+
+    JobCounter counter;
+    for (size_t begin = grainSize; begin < count; begin += grainSize) {
+        const size_t end = std::min(begin + grainSize, count);
+        this->run([&body, begin, end]() { body(begin, end); }, &counter);
+    }
+    body(0, grainSize);
+    this->wait(counter);
+}
+
+void drakon::JobSystem::push(Job* job) {
+    if (currentJobSystem == this) {
+        this->workers[currentWorker]->deque.push(job);
+    } else {
+        std::lock_guard<std::mutex> lock(this->injectedMutex);
+        this->injected.push_back(job);
+    }
+
+    // Pairs with the sleeper registering before it checks queuedJobs, so one of the two always sees the other
+    this->queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+    if (this->sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->wake.notify_one();
+    }
+}
+
+drakon::JobSystem::Job* drakon::JobSystem::take(uint32_t workerIndex) {
+    Job* job = nullptr;
+    if (workerIndex != NO_WORKER) {
+        job = this->workers[workerIndex]->deque.pop();
+    }
+    if (job == nullptr && this->queuedJobs.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(this->injectedMutex);
+        if (!this->injected.empty()) {
+            job = this->injected.front();
+            this->injected.pop_front();
+        }
+    }
+    if (job == nullptr && !this->workers.empty()) {
+        const size_t workerCount = this->workers.size();
+        const size_t first       = nextRandom() % workerCount;
+        for (size_t i = 0; i < workerCount && job == nullptr; ++i) {
+            const size_t victim = (first + i) % workerCount;
+            if (victim != workerIndex) {
+                job = this->workers[victim]->deque.steal();
+            }
+        }
+    }
+
+    if (job != nullptr) {
+        this->queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+void drakon::JobSystem::execute(Job* job) {
+    job->function();
+    if (job->counter != nullptr) {
+        job->counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+    delete job;
+}
+
+void drakon::JobSystem::workerLoop(uint32_t workerIndex) {
+    currentJobSystem = this;
+    currentWorker    = workerIndex;
+    stealSeed        = 0x9E3779B9u * (workerIndex + 1);
+
+    uint32_t idleSpins = 0;
+    for (;;) {
+        if (Job* job = this->take(workerIndex)) {
+            this->execute(job);
+            idleSpins = 0;
+            continue;
+        }
+        if (++idleSpins < IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        idleSpins = 0;
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        this->wake.wait(lock, [this] {
+            return this->stopping.load(std::memory_order_relaxed) ||
+                   this->queuedJobs.load(std::memory_order_seq_cst) > 0;
+        });
+        this->sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        if (this->stopping.load(std::memory_order_relaxed) && this->queuedJobs.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+    }
+}
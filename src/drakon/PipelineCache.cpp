@@ -0,0 +1,222 @@
+#include <drakon/Hash.h>
+#include <drakon/PipelineCache.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+namespace {
+constexpr uint32_t PIPELINE_CACHE_MAGIC   = 0x43504B44; // "DKPC"
+constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+// Prefixed to the driver's blob so stale caches are rejected before Vulkan ever sees them
+struct PipelineCacheFileHeader {
+    uint32_t magic                           = PIPELINE_CACHE_MAGIC;
+    uint32_t version                         = PIPELINE_CACHE_VERSION;
+    uint32_t vendorID                        = 0;
+    uint32_t deviceID                        = 0;
+    uint32_t driverVersion                   = 0;
+    uint8_t  pipelineCacheUUID[VK_UUID_SIZE] = {};
+    // Fills the padding before dataSize, so no uninitialized bytes reach the file
+    uint32_t reserved = 0;
+    uint64_t dataSize = 0;
+    uint64_t dataHash = 0;
+};
+static_assert(sizeof(PipelineCacheFileHeader) == 56);
+
+std::vector<uint8_t> readCacheFile(const std::filesystem::path& path, const VkPhysicalDeviceProperties& properties) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return {};
+    }
+
+    PipelineCacheFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return {};
+    }
+
+    if (header.magic != PIPELINE_CACHE_MAGIC || header.version != PIPELINE_CACHE_VERSION ||
+        header.vendorID != properties.vendorID || header.deviceID != properties.deviceID ||
+        header.driverVersion != properties.driverVersion ||
+        std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        std::cerr << "Discarding pipeline cache built for a different device or driver: " << path << std::endl;
+        return {};
+    }
+
+    std::error_code error;
+    const uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (error || header.dataSize > fileSize - sizeof(header)) {
+        std::cerr << "Discarding truncated pipeline cache: " << path << std::endl;
+        return {};
+    }
+
+    std::vector<uint8_t> data(static_cast<size_t>(header.dataSize));
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())) ||
+        drakon::hashBytes(data.data(), data.size()) != header.dataHash) {
+        std::cerr << "Discarding corrupted pipeline cache: " << path << std::endl;
+        return {};
+    }
+
+    return data;
+}
+} // namespace
+
+bool drakon::PipelineCache::init(VkPhysicalDevice             physicalDevice,
+                                 VkDevice                     device,
+                                 const std::filesystem::path& path,
+                                 bool                         creationFeedbackEnabled) {
+    this->vkDevice                = device;
+    this->path                    = path;
+    this->creationFeedbackEnabled = creationFeedbackEnabled;
+    vkGetPhysicalDeviceProperties(physicalDevice, &this->deviceProperties);
+
+    std::vector<uint8_t> initialData;
+    if (!this->path.empty()) {
+        initialData = readCacheFile(this->path, this->deviceProperties);
+    }
+
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize           = initialData.size();
+    createInfo.pInitialData              = initialData.empty() ? nullptr : initialData.data();
+
+    if (vkCreatePipelineCache(this->vkDevice, &createInfo, nullptr, &this->vkPipelineCache) == VK_SUCCESS) {
+        return true;
+    }
+
+    // The driver may still reject data that passed our header checks; fall back to an empty cache
+    createInfo.initialDataSize = 0;
+    createInfo.pInitialData    = nullptr;
+    if (vkCreatePipelineCache(this->vkDevice, &createInfo, nullptr, &this->vkPipelineCache) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan pipeline cache." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool drakon::PipelineCache::save() const {
+    if (this->vkPipelineCache == VK_NULL_HANDLE || this->path.empty()) {
+        return false;
+    }
+
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(this->vkDevice, this->vkPipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+        std::cerr << "Failed to query Vulkan pipeline cache size." << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> data(dataSize);
+    if (vkGetPipelineCacheData(this->vkDevice, this->vkPipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+        std::cerr << "Failed to read Vulkan pipeline cache data." << std::endl;
+        return false;
+    }
+    data.resize(dataSize);
+
+    PipelineCacheFileHeader header;
+    header.vendorID      = this->deviceProperties.vendorID;
+    header.deviceID      = this->deviceProperties.deviceID;
+    header.driverVersion = this->deviceProperties.driverVersion;
+    header.dataSize      = data.size();
+    header.dataHash      = drakon::hashBytes(data.data(), data.size());
+    std::memcpy(header.pipelineCacheUUID, this->deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::error_code error;
+    if (this->path.has_parent_path()) {
+        std::filesystem::create_directories(this->path.parent_path(), error);
+    }
+
+    // Write beside the destination and rename over it so a crash never leaves a half-written cache
+    std::filesystem::path temporaryPath = this->path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open pipeline cache for writing: " << temporaryPath << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file.flush()) {
+            std::cerr << "Failed to write pipeline cache: " << temporaryPath << std::endl;
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, this->path, error);
+    if (error) {
+        std::cerr << "Failed to replace pipeline cache " << this->path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+bool drakon::PipelineCache::cleanup() {
+    if (this->vkPipelineCache == VK_NULL_HANDLE) {
+        return true;
+    }
+
+    const bool saved = this->path.empty() || this->save();
+
+    vkDestroyPipelineCache(this->vkDevice, this->vkPipelineCache, nullptr);
+    this->vkPipelineCache = VK_NULL_HANDLE;
+
+    return saved;
+}
+
+VkPipelineCache drakon::PipelineCache::getHandle() const { return this->vkPipelineCache; }
+
+drakon::PipelineCacheStats drakon::PipelineCache::getStats() const {
+    PipelineCacheStats stats;
+    stats.cacheHits         = this->cacheHits.load(std::memory_order_relaxed);
+    stats.compiled          = this->compiled.load(std::memory_order_relaxed);
+    stats.feedbackAvailable = this->creationFeedbackEnabled;
+    return stats;
+}
+
+VkResult drakon::PipelineCache::createGraphicsPipelines(uint32_t                            createInfoCount,
+                                                        const VkGraphicsPipelineCreateInfo* createInfos,
+                                                        VkPipeline*                         pipelines) {
+    if (!this->creationFeedbackEnabled) {
+        const VkResult result = vkCreateGraphicsPipelines(
+            this->vkDevice, this->vkPipelineCache, createInfoCount, createInfos, nullptr, pipelines);
+        if (result == VK_SUCCESS) {
+            this->compiled.fetch_add(createInfoCount, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    // Chain creation feedback onto a copy of each create info so callers' structures are left untouched
+    std::vector<VkGraphicsPipelineCreateInfo>         feedbackCreateInfos(createInfos, createInfos + createInfoCount);
+    std::vector<VkPipelineCreationFeedback>           feedbacks(createInfoCount);
+    std::vector<VkPipelineCreationFeedbackCreateInfo> feedbackInfos(createInfoCount);
+    for (uint32_t i = 0; i < createInfoCount; ++i) {
+        feedbackInfos[i]                           = {};
+        feedbackInfos[i].sType                     = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+        feedbackInfos[i].pNext                     = feedbackCreateInfos[i].pNext;
+        feedbackInfos[i].pPipelineCreationFeedback = &feedbacks[i];
+        feedbackCreateInfos[i].pNext               = &feedbackInfos[i];
+    }
+
+    const VkResult result = vkCreateGraphicsPipelines(
+        this->vkDevice, this->vkPipelineCache, createInfoCount, feedbackCreateInfos.data(), nullptr, pipelines);
+    if (result == VK_SUCCESS) {
+        for (const auto& feedback : feedbacks) {
+            this->recordFeedback(feedback);
+        }
+    }
+    return result;
+}
+
+void drakon::PipelineCache::recordFeedback(const VkPipelineCreationFeedback& feedback) {
+    if ((feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0 &&
+        (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0) {
+        this->cacheHits.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        this->compiled.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,436 @@
+#include <drakon/Hash.h>
+#include <drakon/PipelineCache.h>
+#include <drakon/PipelineRegistry.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+template <typename T>
+uint64_t hashVector(const std::vector<T>& values, uint64_t hash) {
+    hash = drakon::hashValue(static_cast<uint64_t>(values.size()), hash);
+    return drakon::hashBytes(values.data(), values.size() * sizeof(T), hash);
+}
+
+// Only used with Vulkan structs built from 32-bit fields and handles, which carry no padding
+template <typename T>
+bool sameBytes(const T& a, const T& b) {
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+template <typename T>
+bool sameBytes(const std::vector<T>& a, const std::vector<T>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+uint64_t layoutKey(const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+                   const std::vector<VkPushConstantRange>&   pushConstantRanges) {
+    return hashVector(pushConstantRanges, hashVector(descriptorSetLayouts, drakon::HASH_SEED));
+}
+
+// Pipelines never bake the viewport, so a resize or a render-scale change never recompiles them
+std::vector<VkDynamicState> withViewportAndScissor(const std::vector<VkDynamicState>& dynamicStates) {
+    std::vector<VkDynamicState> states = dynamicStates;
+    for (VkDynamicState state : {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR}) {
+        if (std::find(states.begin(), states.end(), state) == states.end()) {
+            states.push_back(state);
+        }
+    }
+    return states;
+}
+} // namespace
+
+uint64_t drakon::GraphicsPipelineDescription::hash() const {
+    uint64_t hash = hashValue(static_cast<uint64_t>(this->stages.size()));
+    for (const auto& stage : this->stages) {
+        hash = hashValue(stage.stage, hash);
+        hash = hashVector(stage.spirv, hash);
+        hash = hashString(stage.entryPoint, hash);
+    }
+    hash = hashVector(this->vertexBindings, hash);
+    hash = hashVector(this->vertexAttributes, hash);
+    hash = hashValue(this->topology, hash);
+    hash = hashValue(this->polygonMode, hash);
+    hash = hashValue(this->cullMode, hash);
+    hash = hashValue(this->frontFace, hash);
+    hash = hashValue(this->lineWidth, hash);
+    hash = hashValue(this->samples, hash);
+    hash = hashValue(this->depthTest, hash);
+    hash = hashValue(this->depthWrite, hash);
+    hash = hashValue(this->depthCompareOp, hash);
+    hash = hashValue(this->colorBlend, hash);
+    hash = hashVector(this->descriptorSetLayouts, hash);
+    hash = hashVector(this->pushConstantRanges, hash);
+    hash = hashVector(this->dynamicStates, hash);
+    return hashValue(this->subpass, hash);
+}
+
+bool drakon::GraphicsPipelineDescription::operator==(const GraphicsPipelineDescription& other) const {
+    if (this->stages.size() != other.stages.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < this->stages.size(); ++i) {
+        if (this->stages[i].stage != other.stages[i].stage || this->stages[i].spirv != other.stages[i].spirv ||
+            this->stages[i].entryPoint != other.stages[i].entryPoint) {
+            return false;
+        }
+    }
+
+    const bool sameVertexInput = sameBytes(this->vertexBindings, other.vertexBindings) &&
+                                 sameBytes(this->vertexAttributes, other.vertexAttributes);
+    const bool sameRasterState = this->topology == other.topology && this->polygonMode == other.polygonMode &&
+                                 this->cullMode == other.cullMode && this->frontFace == other.frontFace &&
+                                 this->lineWidth == other.lineWidth && this->samples == other.samples;
+    const bool sameOutputState = this->depthTest == other.depthTest && this->depthWrite == other.depthWrite &&
+                                 this->depthCompareOp == other.depthCompareOp &&
+                                 sameBytes(this->colorBlend, other.colorBlend);
+    const bool sameLayout      = this->descriptorSetLayouts == other.descriptorSetLayouts &&
+                                 sameBytes(this->pushConstantRanges, other.pushConstantRanges);
+    return sameVertexInput && sameRasterState && sameOutputState && sameLayout &&
+           this->dynamicStates == other.dynamicStates && this->subpass == other.subpass;
+}
+
+struct drakon::PipelineRegistry::State {
+    struct PipelineSlot {
+        GraphicsPipelineDescription   description;
+        VkRenderPass                  renderPass = VK_NULL_HANDLE;
+        std::weak_ptr<const Pipeline> pipeline;
+        VkPipeline                    handle = VK_NULL_HANDLE;
+    };
+    struct LayoutSlot {
+        std::vector<VkDescriptorSetLayout>  descriptorSetLayouts;
+        std::vector<VkPushConstantRange>    pushConstantRanges;
+        std::weak_ptr<const PipelineLayout> layout;
+        VkPipelineLayout                    handle = VK_NULL_HANDLE;
+    };
+
+    std::mutex                                      mutex;
+    VkDevice                                        device        = VK_NULL_HANDLE;
+    PipelineCache*                                  pipelineCache = nullptr;
+    std::function<void(std::function<void()>)>      deferDestroy;
+    std::unordered_multimap<uint64_t, PipelineSlot> pipelines;
+    std::unordered_multimap<uint64_t, LayoutSlot>   layouts;
+    std::vector<uint32_t>                           freePipelineIds;
+    uint32_t                                        nextPipelineId = 0;
+    uint64_t                                        pipelineHits   = 0;
+    uint64_t                                        layoutHits     = 0;
+    bool                                            shutDown       = false;
+};
+
+bool drakon::PipelineRegistry::init(VkDevice                                   device,
+                                    PipelineCache*                             pipelineCache,
+                                    std::function<void(std::function<void()>)> deferDestroy) {
+    this->state                = std::make_shared<State>();
+    this->state->device        = device;
+    this->state->pipelineCache = pipelineCache;
+    this->state->deferDestroy  = std::move(deferDestroy);
+    return true;
+}
+
+void drakon::PipelineRegistry::cleanup() {
+    if (this->state == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->state->mutex);
+        for (const auto& [key, slot] : this->state->pipelines) {
+            vkDestroyPipeline(this->state->device, slot.handle, nullptr);
+        }
+        for (const auto& [key, slot] : this->state->layouts) {
+            vkDestroyPipelineLayout(this->state->device, slot.handle, nullptr);
+        }
+        this->state->pipelines.clear();
+        this->state->layouts.clear();
+        this->state->shutDown = true;
+    }
+    this->state.reset();
+}
+
+drakon::PipelineLayoutHandle drakon::PipelineRegistry::getPipelineLayout(
+    const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts,
+    const std::vector<VkPushConstantRange>&   pushConstantRanges) {
+    const std::shared_ptr<State> state = this->state;
+    if (state == nullptr) {
+        return nullptr;
+    }
+
+    const uint64_t key        = layoutKey(descriptorSetLayouts, pushConstantRanges);
+    const auto     findLayout = [&]() -> PipelineLayoutHandle {
+        auto [begin, end] = state->layouts.equal_range(key);
+        for (auto it = begin; it != end; ++it) {
+            if (it->second.descriptorSetLayouts == descriptorSetLayouts &&
+                sameBytes(it->second.pushConstantRanges, pushConstantRanges)) {
+                // A slot whose last handle is being released right now reads as expired; it is about to be erased
+                if (PipelineLayoutHandle existing = it->second.layout.lock()) {
+                    ++state->layoutHits;
+                    return existing;
+                }
+            }
+        }
+        return nullptr;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (PipelineLayoutHandle existing = findLayout()) {
+            return existing;
+        }
+    }
+
+    VkPipelineLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount             = static_cast<uint32_t>(descriptorSetLayouts.size());
+    layoutInfo.pSetLayouts                = descriptorSetLayouts.data();
+    layoutInfo.pushConstantRangeCount     = static_cast<uint32_t>(pushConstantRanges.size());
+    layoutInfo.pPushConstantRanges        = pushConstantRanges.data();
+
+    VkPipelineLayout handle = VK_NULL_HANDLE;
+    if (vkCreatePipelineLayout(state->device, &layoutInfo, nullptr, &handle) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan pipeline layout." << std::endl;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    // Another thread may have created the same layout while this one was being built
+    if (PipelineLayoutHandle existing = findLayout()) {
+        vkDestroyPipelineLayout(state->device, handle, nullptr);
+        return existing;
+    }
+
+    const std::weak_ptr<State> weakState = state;
+    PipelineLayoutHandle       layout(new PipelineLayout{handle}, [weakState, key](const PipelineLayout* released) {
+        if (std::shared_ptr<State> state = weakState.lock()) {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if (!state->shutDown) {
+                auto [begin, end] = state->layouts.equal_range(key);
+                for (auto it = begin; it != end; ++it) {
+                    if (it->second.handle == released->handle) {
+                        state->layouts.erase(it);
+                        break;
+                    }
+                }
+                lock.unlock();
+                state->deferDestroy([device = state->device, handle = released->handle]() {
+                    vkDestroyPipelineLayout(device, handle, nullptr);
+                });
+            }
+        }
+        delete released;
+    });
+
+    State::LayoutSlot slot;
+    slot.descriptorSetLayouts = descriptorSetLayouts;
+    slot.pushConstantRanges   = pushConstantRanges;
+    slot.layout               = layout;
+    slot.handle               = handle;
+    state->layouts.emplace(key, std::move(slot));
+    return layout;
+}
+
+drakon::PipelineHandle drakon::PipelineRegistry::getGraphicsPipeline(const GraphicsPipelineDescription& description,
+                                                                     VkRenderPass                       renderPass) {
+    const std::shared_ptr<State> state = this->state;
+    if (state == nullptr) {
+        return nullptr;
+    }
+
+    const uint64_t key          = hashValue(renderPass, description.hash());
+    const auto     findPipeline = [&]() -> PipelineHandle {
+        auto [begin, end] = state->pipelines.equal_range(key);
+        for (auto it = begin; it != end; ++it) {
+            if (it->second.renderPass == renderPass && it->second.description == description) {
+                if (PipelineHandle existing = it->second.pipeline.lock()) {
+                    ++state->pipelineHits;
+                    return existing;
+                }
+            }
+        }
+        return nullptr;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (PipelineHandle existing = findPipeline()) {
+            return existing;
+        }
+    }
+
+    PipelineLayoutHandle layout =
+        this->getPipelineLayout(description.descriptorSetLayouts, description.pushConstantRanges);
+    if (layout == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<VkShaderModule>                  shaderModules;
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+    const auto                                   destroyShaderModules = [&]() {
+        for (VkShaderModule shaderModule : shaderModules) {
+            vkDestroyShaderModule(state->device, shaderModule, nullptr);
+        }
+    };
+    for (const auto& stage : description.stages) {
+        VkShaderModuleCreateInfo moduleInfo = {};
+        moduleInfo.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize                 = stage.spirv.size() * sizeof(uint32_t);
+        moduleInfo.pCode                    = stage.spirv.data();
+
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(state->device, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            std::cerr << "Failed to create Vulkan shader module." << std::endl;
+            destroyShaderModules();
+            return nullptr;
+        }
+        shaderModules.push_back(shaderModule);
+
+        VkPipelineShaderStageCreateInfo stageInfo = {};
+        stageInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        stageInfo.stage                           = stage.stage;
+        stageInfo.module                          = shaderModule;
+        stageInfo.pName                           = stage.entryPoint.c_str();
+        shaderStages.push_back(stageInfo);
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+    vertexInputInfo.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount   = static_cast<uint32_t>(description.vertexBindings.size());
+    vertexInputInfo.pVertexBindingDescriptions      = description.vertexBindings.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.vertexAttributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions    = description.vertexAttributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology                               = description.topology;
+    inputAssembly.primitiveRestartEnable                 = VK_FALSE;
+
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType                             = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount                     = 1;
+    viewportState.scissorCount                      = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer = {};
+    rasterizer.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable                       = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable                = VK_FALSE;
+    rasterizer.polygonMode                            = description.polygonMode;
+    rasterizer.lineWidth                              = description.lineWidth;
+    rasterizer.cullMode                               = description.cullMode;
+    rasterizer.frontFace                              = description.frontFace;
+    rasterizer.depthBiasEnable                        = VK_FALSE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling = {};
+    multisampling.sType                                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable                  = VK_FALSE;
+    multisampling.rasterizationSamples                 = description.samples;
+
+    // Always given, since render passes with a depth attachment require it even when depth is unused
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+    depthStencil.sType                                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable                       = description.depthTest ? VK_TRUE : VK_FALSE;
+    depthStencil.depthWriteEnable                      = description.depthWrite ? VK_TRUE : VK_FALSE;
+    depthStencil.depthCompareOp                        = description.depthCompareOp;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending = {};
+    colorBlending.sType                               = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable                       = VK_FALSE;
+    colorBlending.logicOp                             = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount                     = 1;
+    colorBlending.pAttachments                        = &description.colorBlend;
+
+    const std::vector<VkDynamicState> dynamicStates = withViewportAndScissor(description.dynamicStates);
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType                            = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount                = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates                   = dynamicStates.data();
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount                   = static_cast<uint32_t>(shaderStages.size());
+    pipelineInfo.pStages                      = shaderStages.data();
+    pipelineInfo.pVertexInputState            = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState          = &inputAssembly;
+    pipelineInfo.pViewportState               = &viewportState;
+    pipelineInfo.pRasterizationState          = &rasterizer;
+    pipelineInfo.pMultisampleState            = &multisampling;
+    pipelineInfo.pDepthStencilState           = &depthStencil;
+    pipelineInfo.pColorBlendState             = &colorBlending;
+    pipelineInfo.pDynamicState                = &dynamicState;
+    pipelineInfo.layout                       = layout->handle;
+    pipelineInfo.renderPass                   = renderPass;
+    pipelineInfo.subpass                      = description.subpass;
+    pipelineInfo.basePipelineHandle           = VK_NULL_HANDLE;
+
+    VkPipeline     handle = VK_NULL_HANDLE;
+    const VkResult result =
+        state->pipelineCache != nullptr
+            ? state->pipelineCache->createGraphicsPipelines(1, &pipelineInfo, &handle)
+            : vkCreateGraphicsPipelines(state->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &handle);
+    destroyShaderModules();
+    if (result != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan graphics pipeline." << std::endl;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (PipelineHandle existing = findPipeline()) {
+        vkDestroyPipeline(state->device, handle, nullptr);
+        return existing;
+    }
+
+    uint32_t id = state->nextPipelineId;
+    if (!state->freePipelineIds.empty()) {
+        id = state->freePipelineIds.back();
+        state->freePipelineIds.pop_back();
+    } else {
+        ++state->nextPipelineId;
+    }
+
+    const std::weak_ptr<State> weakState = state;
+    PipelineHandle pipeline(new Pipeline{handle, std::move(layout), id}, [weakState, key](const Pipeline* released) {
+        if (std::shared_ptr<State> state = weakState.lock()) {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if (!state->shutDown) {
+                auto [begin, end] = state->pipelines.equal_range(key);
+                for (auto it = begin; it != end; ++it) {
+                    if (it->second.handle == released->handle) {
+                        state->pipelines.erase(it);
+                        break;
+                    }
+                }
+                state->freePipelineIds.push_back(released->id);
+                lock.unlock();
+                state->deferDestroy([device = state->device, handle = released->handle]() {
+                    vkDestroyPipeline(device, handle, nullptr);
+                });
+            }
+        }
+        // Drops this pipeline's reference to its layout, which may retire the layout as well
+        delete released;
+    });
+
+    State::PipelineSlot slot;
+    slot.description = description;
+    slot.renderPass  = renderPass;
+    slot.pipeline    = pipeline;
+    slot.handle      = handle;
+    state->pipelines.emplace(key, std::move(slot));
+    return pipeline;
+}
+
+drakon::PipelineRegistryStats drakon::PipelineRegistry::getStats() const {
+    PipelineRegistryStats stats;
+    if (this->state == nullptr) {
+        return stats;
+    }
+
+    std::lock_guard<std::mutex> lock(this->state->mutex);
+    stats.pipelines    = this->state->pipelines.size();
+    stats.layouts      = this->state->layouts.size();
+    stats.pipelineHits = this->state->pipelineHits;
+    stats.layoutHits   = this->state->layoutHits;
+    return stats;
+}
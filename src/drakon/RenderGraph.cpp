@@ -0,0 +1,971 @@
+#include <drakon/RenderGraph.h>
+#include <drakon/Trace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+namespace {
+constexpr VkAccessFlags WRITE_ACCESS = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                       VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                                       VK_ACCESS_TRANSFER_WRITE_BIT;
+constexpr VkPipelineStageFlags DEPTH_STAGES =
+    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+constexpr VkPipelineStageFlags SHADER_STAGES =
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+struct AccessInfo {
+    VkImageLayout        layout     = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags stage      = 0;
+    VkAccessFlags        access     = 0;
+    VkImageUsageFlags    usage      = 0;
+    bool                 writes     = false;
+    bool                 reads      = false;
+    bool                 attachment = false;
+};
+
+AccessInfo getAccessInfo(drakon::RenderGraphAccess access, drakon::RenderGraphLoad load) {
+    const bool loads = load == drakon::RenderGraphLoad::Load;
+
+    AccessInfo info;
+    switch (access) {
+    case drakon::RenderGraphAccess::ColorAttachment:
+        info.layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        info.stage      = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        info.access     = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (loads ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0);
+        info.usage      = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        info.writes     = true;
+        info.attachment = true;
+        break;
+    case drakon::RenderGraphAccess::DepthAttachment:
+        info.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        info.stage      = DEPTH_STAGES;
+        info.access     = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        info.usage      = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        info.writes     = true;
+        info.attachment = true;
+        break;
+    case drakon::RenderGraphAccess::DepthRead:
+        info.layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        info.stage      = DEPTH_STAGES;
+        info.access     = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+        info.usage      = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        info.reads      = true;
+        info.attachment = true;
+        break;
+    case drakon::RenderGraphAccess::Sampled:
+        info.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        info.stage  = SHADER_STAGES;
+        info.access = VK_ACCESS_SHADER_READ_BIT;
+        info.usage  = VK_IMAGE_USAGE_SAMPLED_BIT;
+        info.reads  = true;
+        break;
+    case drakon::RenderGraphAccess::StorageRead:
+        info.layout = VK_IMAGE_LAYOUT_GENERAL;
+        info.stage  = SHADER_STAGES;
+        info.access = VK_ACCESS_SHADER_READ_BIT;
+        info.usage  = VK_IMAGE_USAGE_STORAGE_BIT;
+        info.reads  = true;
+        break;
+    case drakon::RenderGraphAccess::StorageWrite:
+        info.layout = VK_IMAGE_LAYOUT_GENERAL;
+        info.stage  = SHADER_STAGES;
+        info.access = VK_ACCESS_SHADER_WRITE_BIT | (loads ? VK_ACCESS_SHADER_READ_BIT : 0);
+        info.usage  = VK_IMAGE_USAGE_STORAGE_BIT;
+        info.writes = true;
+        break;
+    case drakon::RenderGraphAccess::TransferSrc:
+        info.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        info.stage  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        info.access = VK_ACCESS_TRANSFER_READ_BIT;
+        info.usage  = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        info.reads  = true;
+        break;
+    case drakon::RenderGraphAccess::TransferDst:
+        info.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        info.stage  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        info.access = VK_ACCESS_TRANSFER_WRITE_BIT;
+        info.usage  = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        info.writes = true;
+        break;
+    }
+    // A write that keeps the earlier contents depends on them like a read
+    info.reads = info.reads || (info.writes && loads);
+    return info;
+}
+
+bool isDepthAccess(drakon::RenderGraphAccess access) {
+    return access == drakon::RenderGraphAccess::DepthAttachment || access == drakon::RenderGraphAccess::DepthRead;
+}
+
+VkImageAspectFlags getAspectMask(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+VkAttachmentLoadOp getLoadOp(drakon::RenderGraphLoad load) {
+    switch (load) {
+    case drakon::RenderGraphLoad::Clear:
+        return VK_ATTACHMENT_LOAD_OP_CLEAR;
+    case drakon::RenderGraphLoad::Load:
+        return VK_ATTACHMENT_LOAD_OP_LOAD;
+    default:
+        return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    }
+}
+
+bool overlaps(const drakon::RenderGraphAliasRequest& first, const drakon::RenderGraphAliasRequest& second) {
+    return first.firstPass <= second.lastPass && second.firstPass <= first.lastPass;
+}
+
+// Where an image stands after the last access recorded for it
+struct ImageState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    // The last write or layout transition
+    VkPipelineStageFlags writeStage  = 0;
+    VkAccessFlags        writeAccess = 0;
+    // Reads since then that a barrier has already made the write visible to
+    VkPipelineStageFlags readStages = 0;
+    VkAccessFlags        readAccess = 0;
+    // Pass and barrier index of the image's first barrier in the frame
+    uint32_t firstPass    = UINT32_MAX;
+    size_t   firstBarrier = 0;
+};
+} // namespace
+
+std::vector<uint32_t> drakon::assignRenderGraphAliases(const std::vector<RenderGraphAliasRequest>& requests) {
+    std::vector<uint32_t> order(requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    // The largest image in each group sets its size, so the smaller ones fit in around it
+    std::stable_sort(order.begin(), order.end(), [&requests](uint32_t first, uint32_t second) {
+        return requests[first].requirements.size > requests[second].requirements.size;
+    });
+
+    struct Group {
+        uint32_t              memoryTypeBits = 0;
+        std::vector<uint32_t> members;
+    };
+    std::vector<Group>    placed;
+    std::vector<uint32_t> groups(requests.size(), 0);
+    for (uint32_t index : order) {
+        const RenderGraphAliasRequest& request = requests[index];
+
+        uint32_t group = 0;
+        for (; group < placed.size(); ++group) {
+            const bool compatible = (placed[group].memoryTypeBits & request.requirements.memoryTypeBits) != 0;
+            if (compatible && std::none_of(placed[group].members.begin(),
+                                           placed[group].members.end(),
+                                           [&](uint32_t member) { return overlaps(requests[member], request); })) {
+                break;
+            }
+        }
+        if (group == placed.size()) {
+            placed.push_back({request.requirements.memoryTypeBits, {}});
+        }
+        placed[group].memoryTypeBits &= request.requirements.memoryTypeBits;
+        placed[group].members.push_back(index);
+        groups[index] = group;
+    }
+    return groups;
+}
+
+void drakon::RenderGraph::init(VkDevice                                   device,
+                               GpuAllocator&                              allocator,
+                               std::function<void(std::function<void()>)> deferDestroy) {
+    this->device       = device;
+    this->allocator    = &allocator;
+    this->deferDestroy = std::move(deferDestroy);
+    this->invalidate();
+}
+
+void drakon::RenderGraph::cleanup() {
+    this->releaseVulkanObjects(true);
+    this->compiled     = false;
+    this->device       = VK_NULL_HANDLE;
+    this->allocator    = nullptr;
+    this->deferDestroy = nullptr;
+}
+
+void drakon::RenderGraph::clear() {
+    this->releaseVulkanObjects(false);
+    this->resources.clear();
+    this->passes.clear();
+    this->finalBarriers.clear();
+    this->stats    = {};
+    this->compiled = false;
+}
+
+bool drakon::RenderGraph::isEmpty() const { return this->passes.empty(); }
+
+uint32_t drakon::RenderGraph::createImage(std::string name, const RenderGraphImageDesc& desc) {
+    Resource resource;
+    resource.name   = std::move(name);
+    resource.format = desc.format;
+    resource.size   = {desc.width, desc.height};
+    resource.scale  = desc.scale;
+    if (getAspectMask(desc.format) != VK_IMAGE_ASPECT_COLOR_BIT) {
+        resource.clearValue.depthStencil = {1.0f, 0};
+    }
+    this->resources.push_back(std::move(resource));
+    this->invalidate();
+    return static_cast<uint32_t>(this->resources.size() - 1);
+}
+
+uint32_t drakon::RenderGraph::importImage(std::string   name,
+                                          VkFormat      format,
+                                          VkExtent2D    extent,
+                                          VkImageLayout initialLayout,
+                                          VkImageLayout finalLayout) {
+    const uint32_t resource = this->createImage(std::move(name), {format, extent.width, extent.height});
+
+    Resource& image     = this->resources[resource];
+    image.imported      = true;
+    image.initialLayout = initialLayout;
+    image.finalLayout   = finalLayout;
+    return resource;
+}
+
+void drakon::RenderGraph::bindImage(uint32_t resource, VkImage image, VkImageView view) {
+    if (resource >= this->resources.size() || !this->resources[resource].imported) {
+        std::cerr << "Failed to bind render graph image: only imported images can be bound." << std::endl;
+        return;
+    }
+    Resource& bound = this->resources[resource];
+    if (bound.view != VK_NULL_HANDLE && bound.view != view) {
+        this->releaseFramebuffers(bound.view);
+    }
+    bound.image = image;
+    bound.view  = view;
+}
+
+void drakon::RenderGraph::markOutput(uint32_t resource, VkImageLayout finalLayout) {
+    if (resource >= this->resources.size() || this->resources[resource].imported) {
+        std::cerr << "Failed to mark render graph output: only created images can be outputs." << std::endl;
+        return;
+    }
+    this->resources[resource].output      = true;
+    this->resources[resource].finalLayout = finalLayout;
+    this->invalidate();
+}
+
+void drakon::RenderGraph::setClearValue(uint32_t resource, const VkClearValue& value) {
+    if (resource < this->resources.size()) {
+        this->resources[resource].clearValue = value;
+    }
+}
+
+uint32_t drakon::RenderGraph::addPass(std::string name, ExecuteFunction execute) {
+    Pass pass;
+    pass.name    = std::move(name);
+    pass.execute = std::move(execute);
+    this->passes.push_back(std::move(pass));
+    this->invalidate();
+    return static_cast<uint32_t>(this->passes.size() - 1);
+}
+
+bool drakon::RenderGraph::use(uint32_t pass, uint32_t resource, RenderGraphAccess access, RenderGraphLoad load) {
+    if (pass >= this->passes.size() || resource >= this->resources.size()) {
+        std::cerr << "Failed to use render graph image: unknown pass or image." << std::endl;
+        return false;
+    }
+    Pass&           target = this->passes[pass];
+    const Resource& image  = this->resources[resource];
+
+    const AccessInfo info = getAccessInfo(access, load);
+    if (load == RenderGraphLoad::Clear && !info.attachment) {
+        std::cerr << "Failed to use " << image.name << " in " << target.name << ": only attachments can be cleared."
+                  << std::endl;
+        return false;
+    }
+    const bool depthFormat = (getAspectMask(image.format) & VK_IMAGE_ASPECT_COLOR_BIT) == 0;
+    if (info.attachment && isDepthAccess(access) != depthFormat) {
+        std::cerr << "Failed to use " << image.name << " in " << target.name
+                  << ": the attachment does not match the image's format." << std::endl;
+        return false;
+    }
+    for (const PassUse& existing : target.uses) {
+        if (existing.resource == resource) {
+            std::cerr << "Failed to use " << image.name << " in " << target.name << ": it is already used there."
+                      << std::endl;
+            return false;
+        }
+        if (isDepthAccess(access) && isDepthAccess(existing.access)) {
+            std::cerr << "Failed to use " << image.name << " in " << target.name
+                      << ": the pass already has a depth attachment." << std::endl;
+            return false;
+        }
+    }
+
+    target.uses.push_back({resource, access, load});
+    this->invalidate();
+    return true;
+}
+
+void drakon::RenderGraph::setSideEffects(uint32_t pass) {
+    if (pass < this->passes.size()) {
+        this->passes[pass].sideEffects = true;
+        this->invalidate();
+    }
+}
+
+bool drakon::RenderGraph::compile(VkExtent2D extent) {
+    DRAKON_TRACE_SCOPE("RenderGraph::compile");
+    this->releaseVulkanObjects(false);
+    this->compiled       = false;
+    this->compiledExtent = extent;
+    this->stats          = {};
+
+    this->cull();
+    if (!this->computeLifetimes(extent) || !this->assignMemory()) {
+        this->releaseVulkanObjects(true);
+        return false;
+    }
+    this->buildBarriers();
+    if (this->device != VK_NULL_HANDLE && !this->createVulkanObjects()) {
+        // Nothing has been recorded with them yet
+        this->releaseVulkanObjects(true);
+        return false;
+    }
+
+    this->compiled = true;
+    return true;
+}
+
+bool drakon::RenderGraph::execute(VkCommandBuffer commandBuffer, VkExtent2D extent) {
+    if (!this->compiled || extent.width != this->compiledExtent.width ||
+        extent.height != this->compiledExtent.height) {
+        if (!this->compile(extent)) {
+            return false;
+        }
+    }
+    if (this->device == VK_NULL_HANDLE) {
+        std::cerr << "Failed to execute render graph: it has not been initialized." << std::endl;
+        return false;
+    }
+    for (const Resource& resource : this->resources) {
+        if (resource.imported && resource.isUsed() && resource.image == VK_NULL_HANDLE) {
+            std::cerr << "Failed to execute render graph: no image is bound to " << resource.name << "." << std::endl;
+            return false;
+        }
+    }
+    DRAKON_TRACE_SCOPE("RenderGraph::execute");
+
+    for (Pass& pass : this->passes) {
+        if (pass.culled) {
+            continue;
+        }
+        this->recordBarriers(commandBuffer, pass.barriers);
+
+        RenderGraphPassContext context = {};
+        context.commandBuffer          = commandBuffer;
+        context.renderPass             = pass.renderPass;
+        context.extent                 = pass.extent;
+        context.graph                  = this;
+        if (pass.renderPass == VK_NULL_HANDLE) {
+            if (pass.execute) {
+                pass.execute(context);
+            }
+            continue;
+        }
+
+        const VkFramebuffer framebuffer = this->getFramebuffer(pass);
+        if (framebuffer == VK_NULL_HANDLE) {
+            return false;
+        }
+        this->clearValues.clear();
+        for (uint32_t use : pass.attachments) {
+            this->clearValues.push_back(this->resources[pass.uses[use].resource].clearValue);
+        }
+
+        VkRenderPassBeginInfo renderPassInfo = {};
+        renderPassInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass            = pass.renderPass;
+        renderPassInfo.framebuffer           = framebuffer;
+        renderPassInfo.renderArea.extent     = pass.extent;
+        renderPassInfo.clearValueCount       = static_cast<uint32_t>(this->clearValues.size());
+        renderPassInfo.pClearValues          = this->clearValues.data();
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport = {};
+        viewport.width      = static_cast<float>(pass.extent.width);
+        viewport.height     = static_cast<float>(pass.extent.height);
+        viewport.maxDepth   = 1.0f;
+
+        VkRect2D scissor = {};
+        scissor.extent   = pass.extent;
+
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        if (pass.execute) {
+            pass.execute(context);
+        }
+        vkCmdEndRenderPass(commandBuffer);
+    }
+    this->recordBarriers(commandBuffer, this->finalBarriers);
+    return true;
+}
+
+bool drakon::RenderGraph::isPassCulled(uint32_t pass) const { return this->passes[pass].culled; }
+
+const std::vector<drakon::RenderGraphBarrier>& drakon::RenderGraph::getPassBarriers(uint32_t pass) const {
+    return this->passes[pass].barriers;
+}
+
+const std::vector<drakon::RenderGraphBarrier>& drakon::RenderGraph::getFinalBarriers() const {
+    return this->finalBarriers;
+}
+
+uint32_t drakon::RenderGraph::getAliasGroup(uint32_t resource) const { return this->resources[resource].group; }
+
+VkImage drakon::RenderGraph::getImage(uint32_t resource) const { return this->resources[resource].image; }
+
+VkImageView drakon::RenderGraph::getImageView(uint32_t resource) const { return this->resources[resource].view; }
+
+VkExtent2D drakon::RenderGraph::getExtent(uint32_t resource) const { return this->resources[resource].extent; }
+
+drakon::RenderGraphStats drakon::RenderGraph::getStats() const { return this->stats; }
+
+void drakon::RenderGraph::invalidate() { this->compiled = false; }
+
+void drakon::RenderGraph::cull() {
+    // Walking backwards, a pass is kept when it writes something a kept pass after it reads, or that outlives the
+    // graph. A write that replaces the whole image hides every earlier write from the passes after it
+    std::vector<bool> needed(this->resources.size(), false);
+    for (size_t i = 0; i < this->resources.size(); ++i) {
+        needed[i] = this->resources[i].imported || this->resources[i].output;
+    }
+
+    for (size_t i = this->passes.size(); i-- > 0;) {
+        Pass& pass  = this->passes[i];
+        pass.culled = !pass.sideEffects && std::none_of(pass.uses.begin(), pass.uses.end(), [&](const PassUse& use) {
+            return getAccessInfo(use.access, use.load).writes && needed[use.resource];
+        });
+        if (pass.culled) {
+            ++this->stats.culledPasses;
+            continue;
+        }
+        for (const PassUse& use : pass.uses) {
+            const AccessInfo info = getAccessInfo(use.access, use.load);
+            if (info.writes && !info.reads) {
+                needed[use.resource] = false;
+            }
+        }
+        for (const PassUse& use : pass.uses) {
+            if (getAccessInfo(use.access, use.load).reads) {
+                needed[use.resource] = true;
+            }
+        }
+    }
+    this->stats.passes = static_cast<uint32_t>(this->passes.size()) - this->stats.culledPasses;
+}
+
+bool drakon::RenderGraph::computeLifetimes(VkExtent2D extent) {
+    for (Resource& resource : this->resources) {
+        if (resource.size.width != 0 && resource.size.height != 0) {
+            resource.extent = resource.size;
+        } else {
+            resource.extent.width  = std::max(1u, static_cast<uint32_t>(std::ceil(extent.width * resource.scale)));
+            resource.extent.height = std::max(1u, static_cast<uint32_t>(std::ceil(extent.height * resource.scale)));
+        }
+        resource.usage     = 0;
+        resource.firstPass = UINT32_MAX;
+        resource.lastPass  = 0;
+        resource.group     = INVALID_GROUP;
+    }
+
+    for (uint32_t i = 0; i < this->passes.size(); ++i) {
+        Pass& pass = this->passes[i];
+        pass.attachments.clear();
+        pass.extent = {};
+        if (pass.culled) {
+            continue;
+        }
+
+        uint32_t depthAttachment = UINT32_MAX;
+        for (uint32_t u = 0; u < pass.uses.size(); ++u) {
+            const PassUse&   use      = pass.uses[u];
+            Resource&        resource = this->resources[use.resource];
+            const AccessInfo info     = getAccessInfo(use.access, use.load);
+            if (!resource.isUsed()) {
+                if (!resource.imported && info.reads) {
+                    std::cerr << "Failed to compile render graph: " << pass.name << " reads " << resource.name
+                              << " before any pass writes it." << std::endl;
+                    return false;
+                }
+                resource.firstPass = i;
+            }
+            resource.lastPass = i;
+            resource.usage |= info.usage;
+
+            if (!info.attachment) {
+                continue;
+            }
+            if (pass.extent.width == 0) {
+                pass.extent = resource.extent;
+            } else if (pass.extent.width != resource.extent.width || pass.extent.height != resource.extent.height) {
+                std::cerr << "Failed to compile render graph: the attachments of " << pass.name
+                          << " differ in size." << std::endl;
+                return false;
+            }
+            if (isDepthAccess(use.access)) {
+                depthAttachment = u;
+            } else {
+                pass.attachments.push_back(u);
+            }
+        }
+        if (depthAttachment != UINT32_MAX) {
+            pass.attachments.push_back(depthAttachment);
+        }
+    }
+    return true;
+}
+
+bool drakon::RenderGraph::assignMemory() {
+    std::vector<uint32_t>                transients;
+    std::vector<RenderGraphAliasRequest> requests;
+    for (uint32_t i = 0; i < this->resources.size(); ++i) {
+        Resource& resource = this->resources[i];
+        if (resource.imported || !resource.isUsed()) {
+            continue;
+        }
+        RenderGraphAliasRequest request;
+        request.requirements = this->getMemoryRequirements(resource);
+        if (request.requirements.size == 0) {
+            return false;
+        }
+        // Outputs live for the whole frame and beyond, so nothing can share their memory
+        request.firstPass = resource.output ? 0 : resource.firstPass;
+        request.lastPass  = resource.output ? UINT32_MAX : resource.lastPass;
+        transients.push_back(i);
+        requests.push_back(request);
+        this->stats.unaliasedBytes += request.requirements.size;
+    }
+
+    const std::vector<uint32_t> assigned = assignRenderGraphAliases(requests);
+    this->groups.clear();
+    for (size_t i = 0; i < transients.size(); ++i) {
+        if (assigned[i] >= this->groups.size()) {
+            this->groups.resize(assigned[i] + 1);
+            this->groups[assigned[i]].requirements.memoryTypeBits = UINT32_MAX;
+        }
+        AliasGroup&                 group        = this->groups[assigned[i]];
+        const VkMemoryRequirements& requirements = requests[i].requirements;
+
+        group.requirements.size      = std::max(group.requirements.size, requirements.size);
+        group.requirements.alignment = std::max(group.requirements.alignment, requirements.alignment);
+        group.requirements.memoryTypeBits &= requirements.memoryTypeBits;
+        group.resources.push_back(transients[i]);
+        this->resources[transients[i]].group = assigned[i];
+    }
+    for (AliasGroup& group : this->groups) {
+        std::sort(group.resources.begin(), group.resources.end(), [this](uint32_t first, uint32_t second) {
+            return this->resources[first].firstPass < this->resources[second].firstPass;
+        });
+        this->stats.transientBytes += group.requirements.size;
+    }
+    this->stats.transientImages = static_cast<uint32_t>(transients.size());
+    this->stats.aliasGroups     = static_cast<uint32_t>(this->groups.size());
+    return true;
+}
+
+VkMemoryRequirements drakon::RenderGraph::getMemoryRequirements(Resource& resource) {
+    VkMemoryRequirements requirements = {};
+    if (this->device == VK_NULL_HANDLE) {
+        // Four bytes a texel is enough to plan aliasing without a device
+        requirements.size           = VkDeviceSize(resource.extent.width) * resource.extent.height * 4;
+        requirements.alignment      = 256;
+        requirements.memoryTypeBits = UINT32_MAX;
+        return requirements;
+    }
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageInfo.format            = resource.format;
+    imageInfo.extent            = {resource.extent.width, resource.extent.height, 1};
+    imageInfo.mipLevels         = 1;
+    imageInfo.arrayLayers       = 1;
+    imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage             = resource.usage;
+    imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(this->device, &imageInfo, nullptr, &resource.image) != VK_SUCCESS) {
+        std::cerr << "Failed to create render graph image " << resource.name << "." << std::endl;
+        resource.image = VK_NULL_HANDLE;
+        return requirements;
+    }
+    vkGetImageMemoryRequirements(this->device, resource.image, &requirements);
+    return requirements;
+}
+
+void drakon::RenderGraph::buildBarriers() {
+    std::vector<ImageState> states(this->resources.size());
+    for (uint32_t i = 0; i < this->passes.size(); ++i) {
+        Pass& pass = this->passes[i];
+        pass.barriers.clear();
+        if (pass.culled) {
+            continue;
+        }
+
+        for (const PassUse& use : pass.uses) {
+            const Resource&  resource = this->resources[use.resource];
+            const AccessInfo info     = getAccessInfo(use.access, use.load);
+            ImageState&      state    = states[use.resource];
+
+            RenderGraphBarrier barrier;
+            barrier.resource  = use.resource;
+            barrier.newLayout = info.layout;
+            barrier.dstStage  = info.stage;
+            barrier.dstAccess = info.access;
+            if (state.firstPass == UINT32_MAX) {
+                // Images shared with the world outside the graph are synchronized with everything. Transient ones
+                // wait for whatever used their memory last, which is filled in once every image has been walked
+                if (resource.imported) {
+                    barrier.oldLayout = resource.initialLayout;
+                }
+                if (resource.imported || resource.output) {
+                    barrier.srcStage  = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                    barrier.srcAccess = VK_ACCESS_MEMORY_WRITE_BIT;
+                }
+                state.firstPass    = i;
+                state.firstBarrier = pass.barriers.size();
+            } else if (info.writes || state.layout != info.layout) {
+                barrier.oldLayout = state.layout;
+                barrier.srcStage  = state.writeStage | state.readStages;
+                barrier.srcAccess = state.writeAccess;
+            } else if ((info.stage & ~state.readStages) != 0 || (info.access & ~state.readAccess) != 0) {
+                // A read in the same layout only needs the last write made visible to it
+                barrier.oldLayout = state.layout;
+                barrier.srcStage  = state.writeStage;
+                barrier.srcAccess = state.writeAccess;
+                pass.barriers.push_back(barrier);
+                state.readStages |= info.stage;
+                state.readAccess |= info.access;
+                continue;
+            } else {
+                continue;
+            }
+            pass.barriers.push_back(barrier);
+
+            state.layout      = info.layout;
+            state.writeStage  = info.stage;
+            state.writeAccess = info.access & WRITE_ACCESS;
+            state.readStages  = info.writes ? 0 : info.stage;
+            state.readAccess  = info.writes ? 0 : info.access;
+        }
+        this->stats.barriers += static_cast<uint32_t>(pass.barriers.size());
+    }
+
+    // Each transient image waits for the one before it in its memory, and the first for the last, which the previous
+    // frame left there
+    for (const AliasGroup& group : this->groups) {
+        const size_t count = group.resources.size();
+        for (size_t i = 0; i < count; ++i) {
+            if (this->resources[group.resources[i]].output) {
+                continue;
+            }
+            const ImageState&   previous = states[group.resources[(i + count - 1) % count]];
+            const ImageState&   state    = states[group.resources[i]];
+            RenderGraphBarrier& barrier  = this->passes[state.firstPass].barriers[state.firstBarrier];
+            barrier.srcStage             = previous.writeStage | previous.readStages;
+            barrier.srcAccess            = previous.writeAccess;
+        }
+    }
+
+    this->finalBarriers.clear();
+    for (uint32_t i = 0; i < this->resources.size(); ++i) {
+        const Resource&   resource = this->resources[i];
+        const ImageState& state    = states[i];
+        if (!(resource.imported || resource.output) || !resource.isUsed() ||
+            (state.layout == resource.finalLayout && state.writeAccess == 0)) {
+            continue;
+        }
+        RenderGraphBarrier barrier;
+        barrier.resource  = i;
+        barrier.oldLayout = state.layout;
+        barrier.newLayout = resource.finalLayout;
+        barrier.srcStage  = state.writeStage | state.readStages;
+        barrier.srcAccess = state.writeAccess;
+        barrier.dstStage  = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        barrier.dstAccess = VK_ACCESS_MEMORY_READ_BIT;
+        this->finalBarriers.push_back(barrier);
+    }
+    this->stats.barriers += static_cast<uint32_t>(this->finalBarriers.size());
+}
+
+bool drakon::RenderGraph::createVulkanObjects() {
+    for (AliasGroup& group : this->groups) {
+        if (!this->allocator->allocate(
+                group.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, false, group.allocation)) {
+            std::cerr << "Failed to allocate render graph memory." << std::endl;
+            return false;
+        }
+        for (uint32_t index : group.resources) {
+            Resource& resource = this->resources[index];
+            if (vkBindImageMemory(this->device, resource.image, group.allocation.memory, group.allocation.offset) !=
+                VK_SUCCESS) {
+                std::cerr << "Failed to bind memory to render graph image " << resource.name << "." << std::endl;
+                return false;
+            }
+
+            VkImageViewCreateInfo viewInfo       = {};
+            viewInfo.sType                       = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image                       = resource.image;
+            viewInfo.viewType                    = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format                      = resource.format;
+            viewInfo.subresourceRange.aspectMask = getAspectMask(resource.format);
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.layerCount = 1;
+            if (vkCreateImageView(this->device, &viewInfo, nullptr, &resource.view) != VK_SUCCESS) {
+                std::cerr << "Failed to create render graph image view " << resource.name << "." << std::endl;
+                resource.view = VK_NULL_HANDLE;
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < this->passes.size(); ++i) {
+        if (!this->passes[i].culled && !this->passes[i].attachments.empty() && !this->createRenderPass(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool drakon::RenderGraph::createRenderPass(uint32_t passIndex) {
+    Pass& pass = this->passes[passIndex];
+
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<VkAttachmentReference>   colorReferences;
+    VkAttachmentReference                depthReference = {};
+    bool                                 hasDepth       = false;
+    for (uint32_t use : pass.attachments) {
+        const PassUse&   passUse  = pass.uses[use];
+        const Resource&  resource = this->resources[passUse.resource];
+        const AccessInfo info     = getAccessInfo(passUse.access, passUse.load);
+        // Nothing reads a transient image after its last pass, so its contents need not be written back
+        const bool discard = !resource.imported && !resource.output && resource.lastPass == passIndex;
+        const bool stencil = (getAspectMask(resource.format) & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+        // A read-only depth attachment has to keep what an earlier pass wrote
+        const RenderGraphLoad load = passUse.access == RenderGraphAccess::DepthRead ? RenderGraphLoad::Load
+                                                                                    : passUse.load;
+
+        // Barriers move the image in and out of the attachment layout, so the render pass never transitions it
+        VkAttachmentDescription attachment = {};
+        attachment.format                  = resource.format;
+        attachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+        attachment.loadOp                  = getLoadOp(load);
+        attachment.storeOp        = discard ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp  = stencil ? attachment.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp = stencil ? attachment.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachment.initialLayout  = info.layout;
+        attachment.finalLayout    = info.layout;
+
+        const VkAttachmentReference reference = {static_cast<uint32_t>(attachments.size()), info.layout};
+        attachments.push_back(attachment);
+        if (isDepthAccess(passUse.access)) {
+            depthReference = reference;
+            hasDepth       = true;
+        } else {
+            colorReferences.push_back(reference);
+        }
+    }
+
+    VkSubpassDescription subpass    = {};
+    subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount    = static_cast<uint32_t>(colorReferences.size());
+    subpass.pColorAttachments       = colorReferences.data();
+    subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount        = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments           = attachments.data();
+    renderPassInfo.subpassCount           = 1;
+    renderPassInfo.pSubpasses             = &subpass;
+    if (vkCreateRenderPass(this->device, &renderPassInfo, nullptr, &pass.renderPass) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan render pass for " << pass.name << "." << std::endl;
+        pass.renderPass = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+VkFramebuffer drakon::RenderGraph::getFramebuffer(Pass& pass) {
+    std::vector<VkImageView> views;
+    views.reserve(pass.attachments.size());
+    for (uint32_t use : pass.attachments) {
+        views.push_back(this->resources[pass.uses[use].resource].view);
+    }
+
+    auto it = pass.framebuffers.find(views);
+    if (it != pass.framebuffers.end()) {
+        return it->second;
+    }
+
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass              = pass.renderPass;
+    framebufferInfo.attachmentCount         = static_cast<uint32_t>(views.size());
+    framebufferInfo.pAttachments            = views.data();
+    framebufferInfo.width                   = pass.extent.width;
+    framebufferInfo.height                  = pass.extent.height;
+    framebufferInfo.layers                  = 1;
+
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    if (vkCreateFramebuffer(this->device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan framebuffer for " << pass.name << "." << std::endl;
+        return VK_NULL_HANDLE;
+    }
+    pass.framebuffers.emplace(std::move(views), framebuffer);
+    return framebuffer;
+}
+
+void drakon::RenderGraph::releaseFramebuffers(VkImageView view) {
+    std::vector<VkFramebuffer> framebuffers;
+    for (Pass& pass : this->passes) {
+        std::erase_if(pass.framebuffers, [&framebuffers, view](const auto& entry) {
+            if (std::find(entry.first.begin(), entry.first.end(), view) == entry.first.end()) {
+                return false;
+            }
+            framebuffers.push_back(entry.second);
+            return true;
+        });
+    }
+    if (framebuffers.empty() || this->device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    auto destroy = [device = this->device, framebuffers]() {
+        for (VkFramebuffer framebuffer : framebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+    };
+    if (!this->deferDestroy) {
+        destroy();
+    } else {
+        this->deferDestroy(std::move(destroy));
+    }
+}
+
+void drakon::RenderGraph::releaseVulkanObjects(bool immediately) {
+    std::vector<VkImage>       images;
+    std::vector<VkImageView>   views;
+    std::vector<VkRenderPass>  renderPasses;
+    std::vector<VkFramebuffer> framebuffers;
+    std::vector<GpuAllocation> allocations;
+    for (Resource& resource : this->resources) {
+        if (resource.imported) {
+            continue;
+        }
+        if (resource.image != VK_NULL_HANDLE) {
+            images.push_back(resource.image);
+        }
+        if (resource.view != VK_NULL_HANDLE) {
+            views.push_back(resource.view);
+        }
+        resource.image = VK_NULL_HANDLE;
+        resource.view  = VK_NULL_HANDLE;
+    }
+    for (Pass& pass : this->passes) {
+        if (pass.renderPass != VK_NULL_HANDLE) {
+            renderPasses.push_back(pass.renderPass);
+        }
+        for (const auto& [key, framebuffer] : pass.framebuffers) {
+            framebuffers.push_back(framebuffer);
+        }
+        pass.renderPass = VK_NULL_HANDLE;
+        pass.framebuffers.clear();
+    }
+    for (const AliasGroup& group : this->groups) {
+        if (group.allocation.memory != VK_NULL_HANDLE) {
+            allocations.push_back(group.allocation);
+        }
+    }
+    this->groups.clear();
+
+    if (this->device == VK_NULL_HANDLE) {
+        return;
+    }
+    auto destroy = [device = this->device, allocator = this->allocator, images, views, renderPasses, framebuffers,
+                    allocations]() {
+        for (VkFramebuffer framebuffer : framebuffers) {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+        for (VkRenderPass renderPass : renderPasses) {
+            vkDestroyRenderPass(device, renderPass, nullptr);
+        }
+        for (VkImageView view : views) {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        for (VkImage image : images) {
+            vkDestroyImage(device, image, nullptr);
+        }
+        for (const GpuAllocation& allocation : allocations) {
+            allocator->free(allocation);
+        }
+    };
+    if (immediately || !this->deferDestroy) {
+        destroy();
+    } else {
+        this->deferDestroy(std::move(destroy));
+    }
+}
+
+void drakon::RenderGraph::recordBarriers(VkCommandBuffer                        commandBuffer,
+                                         const std::vector<RenderGraphBarrier>& barriers) {
+    if (barriers.empty()) {
+        return;
+    }
+
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    this->imageBarriers.clear();
+    for (const RenderGraphBarrier& barrier : barriers) {
+        const Resource&       resource     = this->resources[barrier.resource];
+        VkImageMemoryBarrier& imageBarrier = this->imageBarriers.emplace_back();
+
+        imageBarrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask               = barrier.srcAccess;
+        imageBarrier.dstAccessMask               = barrier.dstAccess;
+        imageBarrier.oldLayout                   = barrier.oldLayout;
+        imageBarrier.newLayout                   = barrier.newLayout;
+        imageBarrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image                       = resource.image;
+        imageBarrier.subresourceRange.aspectMask = getAspectMask(resource.format);
+        imageBarrier.subresourceRange.levelCount = 1;
+        imageBarrier.subresourceRange.layerCount = 1;
+        srcStages |= barrier.srcStage;
+        dstStages |= barrier.dstStage;
+    }
+    // Zero source stages are invalid, and only happen when nothing came before
+    if (srcStages == 0) {
+        srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    }
+    vkCmdPipelineBarrier(commandBuffer,
+                         srcStages,
+                         dstStages,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         static_cast<uint32_t>(this->imageBarriers.size()),
+                         this->imageBarriers.data());
+}
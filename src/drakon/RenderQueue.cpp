@@ -0,0 +1,221 @@
+#include <drakon/RenderQueue.h>
+
+#include <algorithm>
+#include <array>
+
+namespace {
+constexpr uint32_t RADIX_BITS    = 8;
+constexpr uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+constexpr uint32_t RADIX_PASSES  = 64 / RADIX_BITS;
+
+uint64_t fieldMask(uint32_t bits) { return (uint64_t(1) << bits) - 1; }
+} // namespace
+
+uint64_t drakon::RenderQueue::makeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth) {
+    uint64_t key = pass & fieldMask(PASS_BITS);
+    key          = (key << PIPELINE_BITS) | (pipeline & fieldMask(PIPELINE_BITS));
+    key          = (key << MATERIAL_BITS) | (material & fieldMask(MATERIAL_BITS));
+    return (key << DEPTH_BITS) | (depth & fieldMask(DEPTH_BITS));
+}
+
+uint64_t drakon::RenderQueue::makeOpaqueSortKey(uint32_t pipeline, uint32_t material, uint32_t depth) {
+    constexpr uint32_t fineBits = DEPTH_BITS - DEPTH_BAND_BITS;
+    const uint64_t     clamped  = depth & fieldMask(DEPTH_BITS);
+
+    uint64_t key = (uint64_t(OPAQUE_PASS) << DEPTH_BAND_BITS) | (clamped >> fineBits);
+    key          = (key << PIPELINE_BITS) | (pipeline & fieldMask(PIPELINE_BITS));
+    key          = (key << MATERIAL_BITS) | (material & fieldMask(MATERIAL_BITS));
+    return (key << fineBits) | (clamped & fieldMask(fineBits));
+}
+
+uint64_t drakon::RenderQueue::makeTransparentSortKey(uint32_t pipeline, uint32_t material, uint32_t depth) {
+    // Farther draws have larger depths and must come first
+    const uint64_t inverted = fieldMask(DEPTH_BITS) - (depth & fieldMask(DEPTH_BITS));
+
+    uint64_t key = (uint64_t(TRANSPARENT_PASS) << DEPTH_BITS) | inverted;
+    key          = (key << PIPELINE_BITS) | (pipeline & fieldMask(PIPELINE_BITS));
+    return (key << MATERIAL_BITS) | (material & fieldMask(MATERIAL_BITS));
+}
+
+uint32_t drakon::RenderQueue::quantizeDepth(float depth) {
+    const float clamped = std::clamp(depth, 0.0f, 1.0f);
+    return static_cast<uint32_t>(clamped * static_cast<float>(fieldMask(DEPTH_BITS)));
+}
+
+void drakon::RenderQueue::clear() {
+    this->packets.clear();
+    this->order.clear();
+}
+
+void drakon::RenderQueue::submit(const DrawPacket& packet) {
+    this->packets.push_back(packet);
+    // Any earlier sort no longer covers every packet
+    this->order.clear();
+}
+
+void drakon::RenderQueue::submit(const DrawPacket* packets, size_t count) {
+    this->packets.insert(this->packets.end(), packets, packets + count);
+    this->order.clear();
+}
+
+void drakon::RenderQueue::sort() {
+    const size_t count = this->packets.size();
+    this->order.resize(count);
+    this->scratch.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        this->order[i].key   = this->packets[i].sortKey;
+        this->order[i].index = static_cast<uint32_t>(i);
+    }
+
+    // Least significant digit first; each pass is a stable counting sort, and digits every key shares are skipped
+    for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass) {
+        const uint32_t                    shift     = pass * RADIX_BITS;
+        std::array<size_t, RADIX_BUCKETS> histogram = {};
+        for (const SortEntry& entry : this->order) {
+            ++histogram[(entry.key >> shift) & (RADIX_BUCKETS - 1)];
+        }
+        if (count == 0 || histogram[(this->order[0].key >> shift) & (RADIX_BUCKETS - 1)] == count) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t& bucket : histogram) {
+            const size_t bucketCount = bucket;
+            bucket                   = offset;
+            offset += bucketCount;
+        }
+        for (const SortEntry& entry : this->order) {
+            this->scratch[histogram[(entry.key >> shift) & (RADIX_BUCKETS - 1)]++] = entry;
+        }
+        this->order.swap(this->scratch);
+    }
+}
+
+size_t drakon::RenderQueue::size() const { return this->packets.size(); }
+
+bool drakon::RenderQueue::empty() const { return this->packets.empty(); }
+
+const drakon::DrawPacket& drakon::RenderQueue::getPacket(size_t index) const {
+    return this->packets[this->order.empty() ? index : this->order[index].index];
+}
+
+void drakon::RenderQueue::record(VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+    // Every command buffer starts with no bound state, so each range tracks its own
+    RenderQueueStats stats;
+    VkPipeline       boundPipeline      = VK_NULL_HANDLE;
+    VkPipelineLayout boundLayout        = VK_NULL_HANDLE;
+    VkDescriptorSet  boundDescriptorSet = VK_NULL_HANDLE;
+    uint32_t         boundDynamicOffset = 0;
+    VkBuffer         boundVertexBuffer  = VK_NULL_HANDLE;
+    VkDeviceSize     boundVertexOffset  = 0;
+    VkBuffer         boundIndexBuffer   = VK_NULL_HANDLE;
+    VkDeviceSize     boundIndexOffset   = 0;
+    VkIndexType      boundIndexType     = VK_INDEX_TYPE_UINT16;
+
+    for (size_t i = begin; i < end; ++i) {
+        const DrawPacket& packet = this->getPacket(i);
+        ++stats.packets;
+
+        if (packet.pipeline != boundPipeline) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipeline);
+            boundPipeline = packet.pipeline;
+            ++stats.pipelineBinds;
+        } else {
+            ++stats.pipelineBindsSkipped;
+        }
+
+        if (packet.descriptorSet != VK_NULL_HANDLE) {
+            // Sets stay bound across pipelines only while the layout matches, so a layout change forces a rebind
+            const bool sameSet = packet.descriptorSet == boundDescriptorSet && packet.pipelineLayout == boundLayout &&
+                                 (packet.dynamicOffsetCount == 0 || packet.dynamicOffset == boundDynamicOffset);
+            if (!sameSet) {
+                vkCmdBindDescriptorSets(commandBuffer,
+                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                        packet.pipelineLayout,
+                                        0,
+                                        1,
+                                        &packet.descriptorSet,
+                                        packet.dynamicOffsetCount > 0 ? 1 : 0,
+                                        &packet.dynamicOffset);
+                boundDescriptorSet = packet.descriptorSet;
+                boundLayout        = packet.pipelineLayout;
+                boundDynamicOffset = packet.dynamicOffset;
+                ++stats.descriptorBinds;
+            } else {
+                ++stats.descriptorBindsSkipped;
+            }
+        }
+
+        if (packet.pushConstantSize > 0) {
+            vkCmdPushConstants(commandBuffer,
+                               packet.pipelineLayout,
+                               packet.pushConstantStages,
+                               0,
+                               packet.pushConstantSize,
+                               packet.pushConstants.data());
+        }
+
+        if (packet.vertexBuffer != VK_NULL_HANDLE) {
+            if (packet.vertexBuffer != boundVertexBuffer || packet.vertexBufferOffset != boundVertexOffset) {
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &packet.vertexBuffer, &packet.vertexBufferOffset);
+                boundVertexBuffer = packet.vertexBuffer;
+                boundVertexOffset = packet.vertexBufferOffset;
+                ++stats.bufferBinds;
+            } else {
+                ++stats.bufferBindsSkipped;
+            }
+        }
+
+        if (packet.indexBuffer == VK_NULL_HANDLE) {
+            vkCmdDraw(commandBuffer, packet.count, packet.instanceCount, packet.first, packet.firstInstance);
+            continue;
+        }
+
+        if (packet.indexBuffer != boundIndexBuffer || packet.indexBufferOffset != boundIndexOffset ||
+            packet.indexType != boundIndexType) {
+            vkCmdBindIndexBuffer(commandBuffer, packet.indexBuffer, packet.indexBufferOffset, packet.indexType);
+            boundIndexBuffer = packet.indexBuffer;
+            boundIndexOffset = packet.indexBufferOffset;
+            boundIndexType   = packet.indexType;
+            ++stats.bufferBinds;
+        } else {
+            ++stats.bufferBindsSkipped;
+        }
+        vkCmdDrawIndexed(commandBuffer,
+                         packet.count,
+                         packet.instanceCount,
+                         packet.first,
+                         packet.vertexOffset,
+                         packet.firstInstance);
+    }
+
+    this->recordedPackets.fetch_add(stats.packets, std::memory_order_relaxed);
+    this->pipelineBinds.fetch_add(stats.pipelineBinds, std::memory_order_relaxed);
+    this->pipelineBindsSkipped.fetch_add(stats.pipelineBindsSkipped, std::memory_order_relaxed);
+    this->descriptorBinds.fetch_add(stats.descriptorBinds, std::memory_order_relaxed);
+    this->descriptorBindsSkipped.fetch_add(stats.descriptorBindsSkipped, std::memory_order_relaxed);
+    this->bufferBinds.fetch_add(stats.bufferBinds, std::memory_order_relaxed);
+    this->bufferBindsSkipped.fetch_add(stats.bufferBindsSkipped, std::memory_order_relaxed);
+}
+
+drakon::RenderQueueStats drakon::RenderQueue::getStats() const {
+    RenderQueueStats stats;
+    stats.packets                = this->recordedPackets.load(std::memory_order_relaxed);
+    stats.pipelineBinds          = this->pipelineBinds.load(std::memory_order_relaxed);
+    stats.pipelineBindsSkipped   = this->pipelineBindsSkipped.load(std::memory_order_relaxed);
+    stats.descriptorBinds        = this->descriptorBinds.load(std::memory_order_relaxed);
+    stats.descriptorBindsSkipped = this->descriptorBindsSkipped.load(std::memory_order_relaxed);
+    stats.bufferBinds            = this->bufferBinds.load(std::memory_order_relaxed);
+    stats.bufferBindsSkipped     = this->bufferBindsSkipped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void drakon::RenderQueue::resetStats() {
+    this->recordedPackets.store(0, std::memory_order_relaxed);
+    this->pipelineBinds.store(0, std::memory_order_relaxed);
+    this->pipelineBindsSkipped.store(0, std::memory_order_relaxed);
+    this->descriptorBinds.store(0, std::memory_order_relaxed);
+    this->descriptorBindsSkipped.store(0, std::memory_order_relaxed);
+    this->bufferBinds.store(0, std::memory_order_relaxed);
+    this->bufferBindsSkipped.store(0, std::memory_order_relaxed);
+}
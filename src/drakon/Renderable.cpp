@@ -0,0 +1,26 @@
+#include <drakon/Renderable.h>
+
+void drakon::Renderable::prepare(VkCommandBuffer, const RenderContext&) {}
+
+bool drakon::Renderable::submit(RenderQueue&, const RenderContext&) { return false; }
+
+void drakon::Renderable::draw(VkCommandBuffer, const RenderContext&) {}
+
+bool drakon::Renderable::describePipeline(const RenderContext&, GraphicsPipelineDescription&) const { return false; }
+
+bool drakon::Renderable::ensurePipeline(const RenderContext& context) {
+    if (this->pipeline != nullptr) {
+        return true;
+    }
+    if (context.pipelineRegistry == nullptr) {
+        return false;
+    }
+
+    GraphicsPipelineDescription description;
+    if (!this->describePipeline(context, description)) {
+        return false;
+    }
+
+    this->pipeline = context.pipelineRegistry->getGraphicsPipeline(description, context.renderPass);
+    return this->pipeline != nullptr;
+}
@@ -1,27 +1,40 @@
 #include <drakon/Renderer.h>
+#include <drakon/Trace.h>
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <optional>
 #include <set>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
 
 namespace {
-constexpr uint32_t                   MAX_FRAMES_IN_FLIGHT = 2;
-constexpr std::array<const char*, 1> DEVICE_EXTENSIONS    = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
-constexpr std::array<const char*, 1> VALIDATION_LAYERS    = {"VK_LAYER_KHRONOS_validation"};
+constexpr std::array<const char*, 1> DEVICE_EXTENSIONS = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+constexpr std::array<const char*, 1> VALIDATION_LAYERS = {"VK_LAYER_KHRONOS_validation"};
+// Shorter runs are not worth handing to a worker and are recorded on the calling thread instead
+constexpr size_t MIN_RENDERABLES_PER_RECORDING_SEGMENT = 64;
+// Replaying a packet is far cheaper than a virtual draw, so the queue only spreads out in larger pieces
+constexpr size_t MIN_PACKETS_PER_RECORDING_SEGMENT = 512;
 #if defined(NDEBUG)
 constexpr bool ENABLE_VALIDATION = false;
 #else
 constexpr bool ENABLE_VALIDATION = true;
 #endif
+constexpr bool ENABLE_GPU_PROFILER = DRAKON_GPU_PROFILER != 0;
+// Timestamp pairs per frame: the whole frame plus one per renderable, after which renderables go untimed
+constexpr uint32_t MAX_GPU_PROFILER_SCOPES = 1024;
 
 struct SwapchainSupportDetails {
     VkSurfaceCapabilitiesKHR        capabilities = {};
@@ -60,9 +73,10 @@ VkSurfaceFormatKHR chooseSwapchainSurfaceFormat(const std::vector<VkSurfaceForma
     return availableFormats[0];
 }
 
-VkPresentModeKHR chooseSwapchainPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
+VkPresentModeKHR chooseSwapchainPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes,
+                                            VkPresentModeKHR                     requestedPresentMode) {
     for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+        if (availablePresentMode == requestedPresentMode) {
             return availablePresentMode;
         }
     }
@@ -83,6 +97,32 @@ chooseSwapchainExtent(const VkSurfaceCapabilitiesKHR& capabilities, uint32_t win
     return actualExtent;
 }
 
+// D32 keeps the most precision; D24S8 covers devices that cannot use it as an attachment
+VkFormat chooseDepthFormat(VkPhysicalDevice device) {
+    for (VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT}) {
+        VkFormatProperties properties = {};
+        vkGetPhysicalDeviceFormatProperties(device, format, &properties);
+        if ((properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0) {
+            return format;
+        }
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+// Blitting between images of one format needs it as both a source and a destination; linear filtering is optional
+bool chooseUpscaleFilter(VkPhysicalDevice device, VkFormat format, VkFilter& filter) {
+    VkFormatProperties properties = {};
+    vkGetPhysicalDeviceFormatProperties(device, format, &properties);
+
+    const VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+    if ((properties.optimalTilingFeatures & blit) != blit) {
+        return false;
+    }
+    const bool linear = (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+    filter            = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+    return true;
+}
+
 bool checkValidationLayerSupport() {
     uint32_t layerCount = 0;
     vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
@@ -120,6 +160,32 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
 
     return requiredExtensions.empty();
 }
+
+bool hasDeviceExtension(VkPhysicalDevice device, const char* extensionName) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& extension : availableExtensions) {
+        if (std::strcmp(extension.extensionName, extensionName) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Vulkan 1.1 satisfies what the timeline semaphore extension depends on. 1.0 loaders lack the version query entirely
+uint32_t chooseInstanceApiVersion() {
+    auto enumerateVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+        vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion"));
+    uint32_t version = VK_API_VERSION_1_0;
+    if (enumerateVersion == nullptr || enumerateVersion(&version) != VK_SUCCESS) {
+        return VK_API_VERSION_1_0;
+    }
+    return version >= VK_API_VERSION_1_1 ? VK_API_VERSION_1_1 : VK_API_VERSION_1_0;
+}
 } // namespace
 
 drakon::Renderer::Renderer(RendererBackend backend) : backend(backend) {}
@@ -135,6 +201,203 @@ std::array<float, 4>& drakon::Renderer::getClearColor() { return this->clearColo
 
 drakon::RendererBackend drakon::Renderer::getBackend() const { return this->backend; }
 
+bool drakon::Renderer::isHeadless() const { return this->headless; }
+
+drakon::PipelineCache& drakon::Renderer::getPipelineCache() { return this->pipelineCache; }
+
+void drakon::Renderer::setInterpolationAlpha(float alpha) { this->interpolationAlpha = alpha; }
+
+drakon::PipelineRegistry& drakon::Renderer::getPipelineRegistry() { return this->pipelineRegistry; }
+
+drakon::GpuProfiler& drakon::Renderer::getGpuProfiler() { return this->gpuProfiler; }
+
+drakon::GpuAllocator& drakon::Renderer::getGpuAllocator() { return this->gpuAllocator; }
+
+drakon::UploadRing& drakon::Renderer::getUploadRing() { return this->uploadRing; }
+
+drakon::TextureCache& drakon::Renderer::getTextureCache() { return this->textureCache; }
+
+drakon::TransferQueue& drakon::Renderer::getTransferQueue() { return this->transferQueue; }
+
+drakon::RenderGraph& drakon::Renderer::getRenderGraph() { return this->renderGraph; }
+
+drakon::RenderQueue& drakon::Renderer::getRenderQueue() { return this->renderQueue; }
+
+VkDevice drakon::Renderer::getDevice() const { return this->vkDevice; }
+
+VkRenderPass drakon::Renderer::getRenderPass() const { return this->renderPass; }
+
+VkFormat drakon::Renderer::getDepthFormat() const { return this->depthFormat; }
+
+void drakon::Renderer::setFramesInFlight(uint32_t count) {
+    this->requestedFramesInFlight = std::clamp<uint32_t>(count, 1, MAX_FRAMES_IN_FLIGHT);
+}
+
+uint32_t drakon::Renderer::getFramesInFlight() const { return this->framesInFlight; }
+
+uint32_t drakon::Renderer::getFrameSlotCount() const { return MAX_FRAMES_IN_FLIGHT; }
+
+void drakon::Renderer::setPresentMode(VkPresentModeKHR mode) {
+    if (mode == this->requestedPresentMode) {
+        return;
+    }
+    this->requestedPresentMode = mode;
+    if (this->swapchain != VK_NULL_HANDLE) {
+        this->swapchainOutOfDate = true;
+    }
+}
+
+VkPresentModeKHR drakon::Renderer::getPresentMode() const { return this->presentMode; }
+
+void drakon::Renderer::setLowLatencyMode(bool enabled) { this->lowLatencyMode = enabled; }
+
+bool drakon::Renderer::isLowLatencyMode() const { return this->lowLatencyMode; }
+
+bool drakon::Renderer::setDynamicResolution(bool enabled) {
+    if (enabled == this->dynamicResolutionEnabled) {
+        return true;
+    }
+    if (enabled && !ENABLE_GPU_PROFILER) {
+        std::cerr << "Failed to enable dynamic resolution: the GPU profiler is compiled out" << std::endl;
+        return false;
+    }
+    this->dynamicResolutionEnabled = enabled;
+    if (enabled) {
+        this->gpuProfiler.setEnabled(true);
+        this->dynamicResolution.reset();
+        this->frameScales = {};
+    }
+    // The scene target is created and retired with the other swapchain-sized resources
+    if (this->vkDevice != VK_NULL_HANDLE) {
+        this->swapchainOutOfDate = true;
+    }
+    return true;
+}
+
+bool drakon::Renderer::isDynamicResolution() const { return this->dynamicResolutionEnabled; }
+
+drakon::DynamicResolution& drakon::Renderer::getDynamicResolution() { return this->dynamicResolution; }
+
+VkExtent2D drakon::Renderer::getRenderExtent() const { return this->renderExtent; }
+
+void drakon::Renderer::waitForFrameSlot() {
+    if (this->vkDevice == VK_NULL_HANDLE) {
+        return;
+    }
+    this->waitForCurrentFrame();
+}
+
+uint64_t drakon::Renderer::getSubmittedFrame() const { return this->frameNumber; }
+
+uint64_t drakon::Renderer::getCompletedFrame() {
+    if (this->vkDevice == VK_NULL_HANDLE || this->completedFrame == this->frameNumber) {
+        return this->completedFrame;
+    }
+
+    if (this->frameTimeline != VK_NULL_HANDLE) {
+        uint64_t counter = 0;
+        if (this->getSemaphoreCounterValue(this->vkDevice, this->frameTimeline, &counter) == VK_SUCCESS) {
+            this->completedFrame = std::max(this->completedFrame, counter);
+        }
+        return this->completedFrame;
+    }
+
+    // Fences carry no ordering between submits, so the oldest pending frame bounds what is known to be done. Every
+    // frame not yet collected is still the last one in its slot, since a slot is only reused once its frame finished
+    uint64_t completed = this->frameNumber;
+    for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; ++slot) {
+        const uint64_t frame = this->slotFrames[slot];
+        if (frame > this->completedFrame &&
+            vkGetFenceStatus(this->vkDevice, this->inFlightFences[slot]) != VK_SUCCESS) {
+            completed = std::min(completed, frame - 1);
+        }
+    }
+    this->completedFrame = std::max(this->completedFrame, completed);
+    return this->completedFrame;
+}
+
+bool drakon::Renderer::isFrameComplete(uint64_t frame) {
+    return frame <= this->completedFrame || frame <= this->getCompletedFrame();
+}
+
+bool drakon::Renderer::waitForFrame(uint64_t frame, uint64_t timeoutNanoseconds) {
+    if (this->isFrameComplete(frame)) {
+        return true;
+    }
+    if (frame > this->frameNumber) {
+        return false;
+    }
+
+    if (this->frameTimeline != VK_NULL_HANDLE) {
+        VkSemaphoreWaitInfo waitInfo = {};
+        waitInfo.sType               = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount      = 1;
+        waitInfo.pSemaphores         = &this->frameTimeline;
+        waitInfo.pValues             = &frame;
+        if (this->waitSemaphores(this->vkDevice, &waitInfo, timeoutNanoseconds) != VK_SUCCESS) {
+            return false;
+        }
+    } else {
+        std::array<VkFence, MAX_FRAMES_IN_FLIGHT> fences     = {};
+        uint32_t                                  fenceCount = 0;
+        for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; ++slot) {
+            if (this->slotFrames[slot] > this->completedFrame && this->slotFrames[slot] <= frame) {
+                fences[fenceCount++] = this->inFlightFences[slot];
+            }
+        }
+        if (fenceCount > 0 &&
+            vkWaitForFences(this->vkDevice, fenceCount, fences.data(), VK_TRUE, timeoutNanoseconds) != VK_SUCCESS) {
+            return false;
+        }
+    }
+    this->completedFrame = frame;
+    return true;
+}
+
+bool drakon::Renderer::hasFrameTimeline() const { return this->frameTimeline != VK_NULL_HANDLE; }
+
+void drakon::Renderer::markInputSampled() {
+    this->inputSampleTime = std::chrono::steady_clock::now();
+    this->inputSampled    = true;
+}
+
+drakon::LatencyStats drakon::Renderer::getLatencyStats() const { return this->latencyStats; }
+
+void drakon::Renderer::resetLatencyStats() { this->latencyStats = LatencyStats(); }
+
+const drakon::IndirectDrawSupport& drakon::Renderer::getIndirectDrawSupport() const {
+    return this->indirectDrawSupport;
+}
+
+void drakon::Renderer::setUploadRingSize(VkDeviceSize bytesPerFrame) { this->uploadRingSize = bytesPerFrame; }
+
+void drakon::Renderer::setRecordingThreadCount(uint32_t threadCount) {
+    if (threadCount == this->recordingThreadCount) {
+        return;
+    }
+    this->recordingThreadCount = threadCount;
+    if (this->vkDevice == VK_NULL_HANDLE) {
+        // Applied by init
+        return;
+    }
+
+    // Frames still in flight may reference secondary command buffers from the old pools
+    this->deferDestruction([device = this->vkDevice, pools = std::move(this->secondaryCommandPools)]() {
+        for (const auto& pool : pools) {
+            vkDestroyCommandPool(device, pool.pool, nullptr);
+        }
+    });
+    this->secondaryCommandPools.clear();
+
+    this->createSecondaryCommandPools();
+}
+
+uint32_t drakon::Renderer::getRecordingThreadCount() const { return this->recordingThreadCount; }
+
+void drakon::Renderer::setJobSystem(JobSystem* jobSystem) { this->jobSystem = jobSystem; }
+
+void drakon::Renderer::setPipelineCachePath(std::filesystem::path path) { this->pipelineCachePath = std::move(path); }
+
 bool drakon::Renderer::createVulkanInstance() {
     if (ENABLE_VALIDATION && !checkValidationLayerSupport()) {
         std::cerr << "Requested Vulkan validation layers are not available." << std::endl;
@@ -147,17 +410,20 @@ bool drakon::Renderer::createVulkanInstance() {
     appInfo.applicationVersion = VK_MAKE_VERSION(0, 1, 0);
     appInfo.pEngineName        = "drakon";
     appInfo.engineVersion      = VK_MAKE_VERSION(0, 1, 0);
-    appInfo.apiVersion         = VK_API_VERSION_1_0;
-
-    uint32_t     extensionCount = 0;
-    const char** extensions     = glfwGetRequiredInstanceExtensions(&extensionCount);
-    if (extensions == nullptr) {
-        std::cerr << "Failed to query GLFW Vulkan instance extensions." << std::endl;
-        return false;
+    appInfo.apiVersion         = chooseInstanceApiVersion();
+
+    // Headless rendering needs no surface, so GLFW's WSI extensions are only requested for a window
+    std::vector<const char*> enabledExtensions;
+    if (!this->headless) {
+        uint32_t     extensionCount = 0;
+        const char** extensions     = glfwGetRequiredInstanceExtensions(&extensionCount);
+        if (extensions == nullptr) {
+            std::cerr << "Failed to query GLFW Vulkan instance extensions." << std::endl;
+            return false;
+        }
+        enabledExtensions.assign(extensions, extensions + extensionCount);
     }
 
-    std::vector<const char*> enabledExtensions(extensions, extensions + extensionCount);
-
     VkInstanceCreateInfo createInfo    = {};
     createInfo.sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo        = &appInfo;
@@ -173,6 +439,7 @@ bool drakon::Renderer::createVulkanInstance() {
         std::cerr << "Failed to create Vulkan instance." << std::endl;
         return false;
     }
+    this->instanceApiVersion = appInfo.apiVersion;
 
     return true;
 }
@@ -196,14 +463,21 @@ drakon::Renderer::QueueFamilyIndices drakon::Renderer::findQueueFamilies(VkPhysi
 
     uint32_t index = 0;
     for (const auto& queueFamily : queueFamilies) {
-        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+        // Compute work such as GPU culling is recorded into the same command buffers as the frame's draws
+        const VkQueueFlags graphicsAndCompute = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+        if ((queueFamily.queueFlags & graphicsAndCompute) == graphicsAndCompute) {
             indices.graphicsFamily = index;
         }
 
-        VkBool32 presentSupport = VK_FALSE;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, index, this->vkSurface, &presentSupport);
-        if (presentSupport == VK_TRUE) {
-            indices.presentFamily = index;
+        if (this->headless) {
+            // Nothing is presented, so the graphics family stands in for the present family
+            indices.presentFamily = indices.graphicsFamily;
+        } else {
+            VkBool32 presentSupport = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, index, this->vkSurface, &presentSupport);
+            if (presentSupport == VK_TRUE) {
+                indices.presentFamily = index;
+            }
         }
 
         if (indices.isComplete()) {
@@ -212,6 +486,15 @@ drakon::Renderer::QueueFamilyIndices drakon::Renderer::findQueueFamilies(VkPhysi
         ++index;
     }
 
+    // A family that can only copy is usually backed by its own DMA engine, so its work overlaps rendering
+    for (uint32_t family = 0; family < queueFamilyCount; ++family) {
+        const VkQueueFlags flags = queueFamilies[family].queueFlags;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) != 0 && (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0) {
+            indices.transferFamily = family;
+            break;
+        }
+    }
+
     return indices;
 }
 
@@ -228,7 +511,16 @@ bool drakon::Renderer::pickPhysicalDevice() {
 
     for (const auto& candidate : devices) {
         QueueFamilyIndices indices = this->findQueueFamilies(candidate);
-        if (!indices.isComplete() || !checkDeviceExtensionSupport(candidate)) {
+        if (!indices.isComplete()) {
+            continue;
+        }
+
+        if (this->headless) {
+            this->physicalDevice = candidate;
+            return true;
+        }
+
+        if (!checkDeviceExtensionSupport(candidate)) {
             continue;
         }
 
@@ -249,6 +541,17 @@ bool drakon::Renderer::createLogicalDevice() {
     QueueFamilyIndices indices             = this->findQueueFamilies(this->physicalDevice);
     std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(this->physicalDevice, &properties);
+    this->timelineSemaphoresEnabled =
+        this->instanceApiVersion >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1 &&
+        hasDeviceExtension(this->physicalDevice, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    // The transfer queue reports completion through a timeline semaphore, so it is only created alongside one
+    this->transferQueueEnabled = this->timelineSemaphoresEnabled && indices.transferFamily.has_value();
+    if (this->transferQueueEnabled) {
+        uniqueQueueFamilies.insert(indices.transferFamily.value());
+    }
+
     float                                queuePriority = 1.0f;
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     queueCreateInfos.reserve(uniqueQueueFamilies.size());
@@ -262,15 +565,50 @@ bool drakon::Renderer::createLogicalDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
-    VkPhysicalDeviceFeatures deviceFeatures = {};
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures(this->physicalDevice, &supportedFeatures);
+
+    // Only the indirect draw and texture compression features are enabled; GpuCulling falls back when the former are
+    // missing, and TextureCache decodes or rejects formats the latter would have covered
+    VkPhysicalDeviceFeatures deviceFeatures   = {};
+    deviceFeatures.multiDrawIndirect          = supportedFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance  = supportedFeatures.drawIndirectFirstInstance;
+    deviceFeatures.textureCompressionBC       = supportedFeatures.textureCompressionBC;
+    deviceFeatures.textureCompressionETC2     = supportedFeatures.textureCompressionETC2;
+    deviceFeatures.textureCompressionASTC_LDR = supportedFeatures.textureCompressionASTC_LDR;
+
+    std::vector<const char*> enabledExtensions;
+    if (!this->headless) {
+        enabledExtensions.assign(DEVICE_EXTENSIONS.begin(), DEVICE_EXTENSIONS.end());
+    }
+
+    const bool drawIndirectCount = hasDeviceExtension(this->physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    if (drawIndirectCount) {
+        enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    this->pipelineCreationFeedbackEnabled =
+        hasDeviceExtension(this->physicalDevice, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+    if (this->pipelineCreationFeedbackEnabled) {
+        enabledExtensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+    // Devices exposing the extension must support the feature, so it is enabled without querying for it
+    timelineFeatures.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+    if (this->timelineSemaphoresEnabled) {
+        enabledExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
 
     VkDeviceCreateInfo createInfo      = {};
     createInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pQueueCreateInfos       = queueCreateInfos.data();
     createInfo.queueCreateInfoCount    = static_cast<uint32_t>(queueCreateInfos.size());
+    createInfo.pNext                   = this->timelineSemaphoresEnabled ? &timelineFeatures : nullptr;
     createInfo.pEnabledFeatures        = &deviceFeatures;
-    createInfo.enabledExtensionCount   = static_cast<uint32_t>(DEVICE_EXTENSIONS.size());
-    createInfo.ppEnabledExtensionNames = DEVICE_EXTENSIONS.data();
+    createInfo.enabledExtensionCount   = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     if (ENABLE_VALIDATION) {
         createInfo.enabledLayerCount   = static_cast<uint32_t>(VALIDATION_LAYERS.size());
@@ -285,14 +623,25 @@ bool drakon::Renderer::createLogicalDevice() {
     vkGetDeviceQueue(this->vkDevice, indices.graphicsFamily.value(), 0, &this->graphicsQueue);
     vkGetDeviceQueue(this->vkDevice, indices.presentFamily.value(), 0, &this->presentQueue);
 
+    this->enabledFeatures                               = deviceFeatures;
+    this->indirectDrawSupport                           = {};
+    this->indirectDrawSupport.multiDrawIndirect         = deviceFeatures.multiDrawIndirect == VK_TRUE;
+    this->indirectDrawSupport.drawIndirectFirstInstance = deviceFeatures.drawIndirectFirstInstance == VK_TRUE;
+    if (drawIndirectCount) {
+        this->indirectDrawSupport.drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            vkGetDeviceProcAddr(this->vkDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+    this->indirectDrawSupport.maxDrawIndirectCount =
+        deviceFeatures.multiDrawIndirect == VK_TRUE ? properties.limits.maxDrawIndirectCount : 1;
+
     return true;
 }
 
-bool drakon::Renderer::createSwapchain() {
+bool drakon::Renderer::createSwapchain(VkSwapchainKHR oldSwapchain) {
     SwapchainSupportDetails supportDetails = querySwapchainSupport(this->physicalDevice, this->vkSurface);
 
     VkSurfaceFormatKHR surfaceFormat = chooseSwapchainSurfaceFormat(supportDetails.formats);
-    VkPresentModeKHR   presentMode   = chooseSwapchainPresentMode(supportDetails.presentModes);
+    VkPresentModeKHR presentMode = chooseSwapchainPresentMode(supportDetails.presentModes, this->requestedPresentMode);
     VkExtent2D extent = chooseSwapchainExtent(supportDetails.capabilities, this->windowWidth, this->windowHeight);
 
     uint32_t imageCount = supportDetails.capabilities.minImageCount + 1;
@@ -310,6 +659,12 @@ bool drakon::Renderer::createSwapchain() {
     createInfo.imageArrayLayers         = 1;
     createInfo.imageUsage               = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+    // Lets dynamic resolution blit the scene into the image
+    const bool blitTarget = (supportDetails.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+    if (blitTarget) {
+        createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+
     QueueFamilyIndices indices              = this->findQueueFamilies(this->physicalDevice);
     uint32_t           queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
@@ -327,7 +682,7 @@ bool drakon::Renderer::createSwapchain() {
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode    = presentMode;
     createInfo.clipped        = VK_TRUE;
-    createInfo.oldSwapchain   = VK_NULL_HANDLE;
+    createInfo.oldSwapchain   = oldSwapchain;
 
     if (vkCreateSwapchainKHR(this->vkDevice, &createInfo, nullptr, &this->swapchain) != VK_SUCCESS) {
         std::cerr << "Failed to create Vulkan swapchain." << std::endl;
@@ -340,6 +695,44 @@ bool drakon::Renderer::createSwapchain() {
 
     this->swapchainFormat = surfaceFormat.format;
     this->swapchainExtent = extent;
+    this->presentMode     = presentMode;
+
+    this->upscaleSupported =
+        blitTarget && chooseUpscaleFilter(this->physicalDevice, this->swapchainFormat, this->upscaleFilter);
+
+    return true;
+}
+
+bool drakon::Renderer::createOffscreenTargets() {
+    // One target per frame in flight so consecutive frames never wait on each other's attachment
+    this->swapchainFormat = VK_FORMAT_B8G8R8A8_UNORM;
+    this->swapchainExtent = {this->windowWidth, this->windowHeight};
+    this->swapchainImages.resize(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+    this->offscreenImages.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+        imageInfo.format            = this->swapchainFormat;
+        imageInfo.extent            = {this->swapchainExtent.width, this->swapchainExtent.height, 1};
+        imageInfo.mipLevels         = 1;
+        imageInfo.arrayLayers       = 1;
+        imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                                      VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        this->offscreenImages[i] = this->gpuAllocator.createImage(imageInfo);
+        if (this->offscreenImages[i] == nullptr) {
+            std::cerr << "Failed to create Vulkan offscreen image." << std::endl;
+            return false;
+        }
+        this->swapchainImages[i] = this->offscreenImages[i]->handle;
+    }
+    this->upscaleSupported = chooseUpscaleFilter(this->physicalDevice, this->swapchainFormat, this->upscaleFilter);
 
     return true;
 }
@@ -372,7 +765,54 @@ bool drakon::Renderer::createImageViews() {
     return true;
 }
 
+bool drakon::Renderer::createDepthTarget() {
+    // Cleared at the start of every frame and never read back, so one image serves every frame in flight
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageInfo.format            = this->depthFormat;
+    imageInfo.extent            = {this->swapchainExtent.width, this->swapchainExtent.height, 1};
+    imageInfo.mipLevels         = 1;
+    imageInfo.arrayLayers       = 1;
+    imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage             = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    this->depthImage = this->gpuAllocator.createImage(imageInfo);
+    if (this->depthImage == nullptr) {
+        std::cerr << "Failed to create Vulkan depth image." << std::endl;
+        return false;
+    }
+
+    VkImageViewCreateInfo viewInfo           = {};
+    viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                           = this->depthImage->handle;
+    viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                          = this->depthFormat;
+    viewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_DEPTH_BIT;
+    viewInfo.subresourceRange.baseMipLevel   = 0;
+    viewInfo.subresourceRange.levelCount     = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount     = 1;
+    if (this->depthFormat == VK_FORMAT_D24_UNORM_S8_UINT) {
+        viewInfo.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    if (vkCreateImageView(this->vkDevice, &viewInfo, nullptr, &this->depthView) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan depth image view." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
 bool drakon::Renderer::createRenderPass() {
+    // Offscreen targets are left ready for readback rather than presentation
+    const VkImageLayout finalLayout =
+        this->headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
     VkAttachmentDescription colorAttachment = {};
     colorAttachment.format                  = this->swapchainFormat;
     colorAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
@@ -381,16 +821,32 @@ bool drakon::Renderer::createRenderPass() {
     colorAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout             = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout             = finalLayout;
+
+    // Only needed while the frame is drawn, so its contents are never stored
+    VkAttachmentDescription depthAttachment = {};
+    depthAttachment.format                  = this->depthFormat;
+    depthAttachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout             = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkAttachmentReference colorAttachmentRef = {};
     colorAttachmentRef.attachment            = 0;
     colorAttachmentRef.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments    = &colorAttachmentRef;
+    VkAttachmentReference depthAttachmentRef = {};
+    depthAttachmentRef.attachment            = 1;
+    depthAttachmentRef.layout                = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass    = {};
+    subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount    = 1;
+    subpass.pColorAttachments       = &colorAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
     VkSubpassDependency dependency = {};
     dependency.srcSubpass          = VK_SUBPASS_EXTERNAL;
@@ -399,11 +855,18 @@ bool drakon::Renderer::createRenderPass() {
     dependency.srcAccessMask       = 0;
     dependency.dstStageMask        = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependency.dstAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    // Frames in flight share the depth image, so clearing it waits for the previous frame's depth tests
+    dependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    VkAttachmentDescription attachments[] = {colorAttachment, depthAttachment};
 
     VkRenderPassCreateInfo renderPassInfo = {};
     renderPassInfo.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount        = 1;
-    renderPassInfo.pAttachments           = &colorAttachment;
+    renderPassInfo.attachmentCount        = 2;
+    renderPassInfo.pAttachments           = attachments;
     renderPassInfo.subpassCount           = 1;
     renderPassInfo.pSubpasses             = &subpass;
     renderPassInfo.dependencyCount        = 1;
@@ -414,6 +877,89 @@ bool drakon::Renderer::createRenderPass() {
         return false;
     }
 
+    // Dynamic resolution renders into the scene target instead and leaves it for the upscaling blit. The attachments
+    // match, so pipelines built for either render pass work with both
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    // Frames in flight share the target too, so clearing it waits for the previous frame's blit to read it
+    VkSubpassDependency scaledDependencies[2] = {dependency, dependency};
+    scaledDependencies[0].srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    scaledDependencies[0].srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    scaledDependencies[1].srcSubpass    = 0;
+    scaledDependencies[1].dstSubpass    = VK_SUBPASS_EXTERNAL;
+    scaledDependencies[1].srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    scaledDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    scaledDependencies[1].dstStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    scaledDependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    renderPassInfo.dependencyCount = 2;
+    renderPassInfo.pDependencies   = scaledDependencies;
+
+    if (vkCreateRenderPass(this->vkDevice, &renderPassInfo, nullptr, &this->scaledRenderPass) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan render pass." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool drakon::Renderer::createSceneTarget() {
+    if (!this->dynamicResolutionEnabled || !this->upscaleSupported) {
+        return true;
+    }
+
+    // Allocated at the largest scale, so changing the scale only ever changes the render area
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageInfo.format            = this->swapchainFormat;
+    imageInfo.extent            = {this->swapchainExtent.width, this->swapchainExtent.height, 1};
+    imageInfo.mipLevels         = 1;
+    imageInfo.arrayLayers       = 1;
+    imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    this->sceneImage = this->gpuAllocator.createImage(imageInfo);
+    if (this->sceneImage == nullptr) {
+        std::cerr << "Failed to create Vulkan scene image." << std::endl;
+        return false;
+    }
+
+    VkImageViewCreateInfo viewInfo           = {};
+    viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                           = this->sceneImage->handle;
+    viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                          = this->swapchainFormat;
+    viewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel   = 0;
+    viewInfo.subresourceRange.levelCount     = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount     = 1;
+
+    if (vkCreateImageView(this->vkDevice, &viewInfo, nullptr, &this->sceneView) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan scene image view." << std::endl;
+        return false;
+    }
+
+    VkImageView attachments[] = {this->sceneView, this->depthView};
+
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass              = this->scaledRenderPass;
+    framebufferInfo.attachmentCount         = 2;
+    framebufferInfo.pAttachments            = attachments;
+    framebufferInfo.width                   = this->swapchainExtent.width;
+    framebufferInfo.height                  = this->swapchainExtent.height;
+    framebufferInfo.layers                  = 1;
+
+    if (vkCreateFramebuffer(this->vkDevice, &framebufferInfo, nullptr, &this->sceneFramebuffer) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan framebuffer." << std::endl;
+        return false;
+    }
+
     return true;
 }
 
@@ -421,12 +967,12 @@ bool drakon::Renderer::createFramebuffers() {
     this->framebuffers.resize(this->swapchainViews.size());
 
     for (size_t i = 0; i < this->swapchainViews.size(); ++i) {
-        VkImageView attachments[] = {this->swapchainViews[i]};
+        VkImageView attachments[] = {this->swapchainViews[i], this->depthView};
 
         VkFramebufferCreateInfo framebufferInfo = {};
         framebufferInfo.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebufferInfo.renderPass              = this->renderPass;
-        framebufferInfo.attachmentCount         = 1;
+        framebufferInfo.attachmentCount         = 2;
         framebufferInfo.pAttachments            = attachments;
         framebufferInfo.width                   = this->swapchainExtent.width;
         framebufferInfo.height                  = this->swapchainExtent.height;
@@ -497,12 +1043,72 @@ bool drakon::Renderer::createSyncObjects() {
         }
     }
 
+    if (!this->timelineSemaphoresEnabled) {
+        return true;
+    }
+
+    // Without the timeline the fences above track frames instead
+    this->getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+        vkGetDeviceProcAddr(this->vkDevice, "vkGetSemaphoreCounterValueKHR"));
+    this->waitSemaphores =
+        reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(this->vkDevice, "vkWaitSemaphoresKHR"));
+    if (this->getSemaphoreCounterValue == nullptr || this->waitSemaphores == nullptr) {
+        return true;
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo = {};
+    typeInfo.sType                     = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue              = this->frameNumber;
+
+    VkSemaphoreCreateInfo timelineInfo = {};
+    timelineInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    timelineInfo.pNext                 = &typeInfo;
+    if (vkCreateSemaphore(this->vkDevice, &timelineInfo, nullptr, &this->frameTimeline) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan frame timeline semaphore." << std::endl;
+        return false;
+    }
+
     return true;
 }
 
+bool drakon::Renderer::createSecondaryCommandPools() {
+    if (this->recordingThreadCount == 0) {
+        return true;
+    }
+
+    QueueFamilyIndices queueFamilyIndices = this->findQueueFamilies(this->physicalDevice);
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex        = queueFamilyIndices.graphicsFamily.value();
+
+    this->secondaryCommandPools.resize(MAX_FRAMES_IN_FLIGHT * (this->recordingThreadCount + 1));
+    for (auto& pool : this->secondaryCommandPools) {
+        if (vkCreateCommandPool(this->vkDevice, &poolInfo, nullptr, &pool.pool) != VK_SUCCESS) {
+            std::cerr << "Failed to create Vulkan secondary command pool." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void drakon::Renderer::destroySecondaryCommandPools() {
+    for (const auto& pool : this->secondaryCommandPools) {
+        if (pool.pool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(this->vkDevice, pool.pool, nullptr);
+        }
+    }
+    this->secondaryCommandPools.clear();
+}
+
 bool drakon::Renderer::recordCommandBuffer(VkCommandBuffer                 commandBuffer,
                                            uint32_t                        imageIndex,
-                                           const std::vector<Renderable*>& renderables) {
+                                           const std::vector<Renderable*>& renderables,
+                                           World*                          world) {
+    DRAKON_TRACE_SCOPE("Renderer::recordCommandBuffer");
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
@@ -511,29 +1117,119 @@ bool drakon::Renderer::recordCommandBuffer(VkCommandBuffer                 comma
         return false;
     }
 
-    VkClearValue clearValue     = {};
-    clearValue.color.float32[0] = this->clearColor[0];
-    clearValue.color.float32[1] = this->clearColor[1];
-    clearValue.color.float32[2] = this->clearColor[2];
-    clearValue.color.float32[3] = this->clearColor[3];
+    const bool profiling = ENABLE_GPU_PROFILER && this->gpuProfiler.isActive();
+    if (profiling) {
+        this->gpuProfiler.beginFrame(commandBuffer, this->currentFrame, this->frameNumber);
+    }
+
+    // Depth clears to the far plane, so pipelines compare with LESS or LESS_OR_EQUAL
+    VkClearValue clearValues[2]         = {};
+    clearValues[0].color.float32[0]     = this->clearColor[0];
+    clearValues[0].color.float32[1]     = this->clearColor[1];
+    clearValues[0].color.float32[2]     = this->clearColor[2];
+    clearValues[0].color.float32[3]     = this->clearColor[3];
+    clearValues[1].depthStencil.depth   = 1.0f;
+    clearValues[1].depthStencil.stencil = 0;
+
+    // Under dynamic resolution the scene covers the corner of its target given by the render extent
+    const bool upscaling = this->sceneFramebuffer != VK_NULL_HANDLE;
 
     VkRenderPassBeginInfo renderPassInfo = {};
     renderPassInfo.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass            = this->renderPass;
-    renderPassInfo.framebuffer           = this->framebuffers[imageIndex];
+    renderPassInfo.renderPass            = upscaling ? this->scaledRenderPass : this->renderPass;
+    renderPassInfo.framebuffer           = upscaling ? this->sceneFramebuffer : this->framebuffers[imageIndex];
     renderPassInfo.renderArea.offset     = {0, 0};
-    renderPassInfo.renderArea.extent     = this->swapchainExtent;
-    renderPassInfo.clearValueCount       = 1;
-    renderPassInfo.pClearValues          = &clearValue;
+    renderPassInfo.renderArea.extent     = this->renderExtent;
+    renderPassInfo.clearValueCount       = 2;
+    renderPassInfo.pClearValues          = clearValues;
+
+    RenderContext context      = {};
+    context.device             = this->vkDevice;
+    context.renderPass         = this->renderPass;
+    context.extent             = this->renderExtent;
+    context.pipelineCache      = &this->pipelineCache;
+    context.pipelineRegistry   = &this->pipelineRegistry;
+    context.uploadRing         = &this->uploadRing;
+    context.interpolationAlpha = this->interpolationAlpha;
+    context.frameIndex         = this->currentFrame;
+
+    // Textures finish uploading before anything this frame can sample them
+    this->textureCache.recordUploads(commandBuffer);
+
+    {
+        DRAKON_TRACE_SCOPE("Renderer::prepareRenderables");
+        for (auto* renderable : renderables) {
+            if (renderable != nullptr) {
+                renderable->prepare(commandBuffer, context);
+            }
+        }
+    }
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-    for (auto* renderable : renderables) {
-        if (renderable == nullptr) {
-            continue;
+    // Offscreen passes run ahead of the scene so it can sample what they output
+    if (!this->renderGraph.isEmpty() && !this->renderGraph.execute(commandBuffer, this->swapchainExtent)) {
+        return false;
+    }
+
+    {
+        DRAKON_TRACE_SCOPE("Renderer::sortRenderQueue");
+        this->renderQueue.clear();
+        this->customRenderables.clear();
+        for (auto* renderable : renderables) {
+            if (renderable != nullptr && !renderable->submit(this->renderQueue, context)) {
+                this->customRenderables.push_back(renderable);
+            }
+        }
+        if (world != nullptr) {
+            // Packets already sit contiguously in each chunk, so they are copied in bulk with no per-entity calls
+            world->eachChunk<const DrawPacket>([this](size_t count, const Entity*, const DrawPacket* packets) {
+                this->renderQueue.submit(packets, count);
+            });
+        }
+        this->renderQueue.sort();
+    }
+
+    bool useSecondaryCommandBuffers = false;
+    if (this->recordingThreadCount > 0) {
+        this->buildRecordingSegments(this->customRenderables);
+        useSecondaryCommandBuffers =
+            std::any_of(this->recordingSegments.begin(), this->recordingSegments.end(), [this](const auto& segment) {
+                return segment.thread != this->recordingThreadCount;
+            });
+    }
+
+    if (!useSecondaryCommandBuffers) {
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        this->setViewportAndScissor(commandBuffer);
+        this->drawRenderQueue(commandBuffer, 0, this->renderQueue.size());
+        for (auto* renderable : this->customRenderables) {
+            this->drawRenderable(commandBuffer, *renderable, context);
         }
-        renderable->draw(commandBuffer, this->vkDevice, this->renderPass, this->swapchainExtent);
+        vkCmdEndRenderPass(commandBuffer);
+    } else {
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        if (!this->recordSecondaryCommandBuffers(imageIndex, this->customRenderables, context)) {
+            return false;
+        }
+
+        // Segments are ordered like the queue and then the renderables, so execution order matches the inline path
+        std::vector<VkCommandBuffer> secondaryCommandBuffers;
+        secondaryCommandBuffers.reserve(this->recordingSegments.size());
+        for (const auto& segment : this->recordingSegments) {
+            secondaryCommandBuffers.push_back(segment.commandBuffer);
+        }
+        vkCmdExecuteCommands(commandBuffer,
+                             static_cast<uint32_t>(secondaryCommandBuffers.size()),
+                             secondaryCommandBuffers.data());
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    if (upscaling) {
+        this->recordUpscale(commandBuffer, imageIndex);
+    }
+
+    if (profiling) {
+        this->gpuProfiler.endFrame(commandBuffer, this->currentFrame);
     }
-    vkCmdEndRenderPass(commandBuffer);
 
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         std::cerr << "Failed to record Vulkan command buffer." << std::endl;
@@ -543,25 +1239,426 @@ bool drakon::Renderer::recordCommandBuffer(VkCommandBuffer                 comma
     return true;
 }
 
-void drakon::Renderer::destroySwapchainResources() {
-    for (auto framebuffer : this->framebuffers) {
-        vkDestroyFramebuffer(this->vkDevice, framebuffer, nullptr);
+void drakon::Renderer::setViewportAndScissor(VkCommandBuffer commandBuffer) const {
+    VkViewport viewport = {};
+    viewport.x          = 0.0f;
+    viewport.y          = 0.0f;
+    viewport.width      = static_cast<float>(this->renderExtent.width);
+    viewport.height     = static_cast<float>(this->renderExtent.height);
+    viewport.minDepth   = 0.0f;
+    viewport.maxDepth   = 1.0f;
+
+    VkRect2D scissor = {};
+    scissor.offset   = {0, 0};
+    scissor.extent   = this->renderExtent;
+
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+void drakon::Renderer::updateRenderExtent() {
+    if (this->sceneFramebuffer == VK_NULL_HANDLE) {
+        this->renderExtent = this->swapchainExtent;
+        return;
+    }
+
+    // Scales are keyed by the frame number the profiler was given, and each frame is timed before its entry is reused
+    if (this->gpuProfiler.getHistorySize() > 0) {
+        const GpuFrameTimings& frame = this->gpuProfiler.getFrame(0);
+        if (frame.frameNumber != this->lastMeasuredFrame) {
+            this->lastMeasuredFrame = frame.frameNumber;
+            this->dynamicResolution.update(frame.milliseconds,
+                                           this->frameScales[frame.frameNumber % MAX_FRAMES_IN_FLIGHT]);
+        }
+    }
+
+    const float scale  = this->dynamicResolution.getScale();
+    const auto  scaled = [scale](uint32_t size) {
+        return std::clamp<uint32_t>(static_cast<uint32_t>(std::lround(static_cast<float>(size) * scale)), 1, size);
+    };
+    this->renderExtent = {scaled(this->swapchainExtent.width), scaled(this->swapchainExtent.height)};
+    // Kept until the frame recorded next is timed
+    this->frameScales[this->frameNumber % MAX_FRAMES_IN_FLIGHT] = scale;
+}
+
+void drakon::Renderer::recordUpscale(VkCommandBuffer commandBuffer, uint32_t imageIndex) const {
+    const VkImageLayout finalLayout =
+        this->headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    // The scaled render pass has already made the scene visible to transfers. The image's acquire is waited on at
+    // color attachment output, so including that stage chains the blit after it
+    VkImageMemoryBarrier barrier            = {};
+    barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask                   = 0;
+    barrier.dstAccessMask                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout                       = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                           = this->swapchainImages[imageIndex];
+    barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = 1;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier);
+
+    VkImageBlit blit                   = {};
+    blit.srcSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    blit.srcSubresource.mipLevel       = 0;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount     = 1;
+    blit.srcOffsets[1].x               = static_cast<int32_t>(this->renderExtent.width);
+    blit.srcOffsets[1].y               = static_cast<int32_t>(this->renderExtent.height);
+    blit.srcOffsets[1].z               = 1;
+    blit.dstSubresource                = blit.srcSubresource;
+    blit.dstOffsets[1].x               = static_cast<int32_t>(this->swapchainExtent.width);
+    blit.dstOffsets[1].y               = static_cast<int32_t>(this->swapchainExtent.height);
+    blit.dstOffsets[1].z               = 1;
+    vkCmdBlitImage(commandBuffer,
+                   this->sceneImage->handle,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   this->swapchainImages[imageIndex],
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   1,
+                   &blit,
+                   this->upscaleFilter);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout     = finalLayout;
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         1,
+                         &barrier);
+}
+
+void drakon::Renderer::buildRecordingSegments(const std::vector<Renderable*>& renderables) {
+    this->recordingSegments.clear();
+
+    // The calling thread takes a share of the parallel work too, as the last thread index
+    const uint32_t threadCount   = this->recordingThreadCount + 1;
+    const uint32_t callingThread = this->recordingThreadCount;
+    uint32_t       nextThread    = 0;
+
+    const auto addSegment = [this, callingThread](size_t begin, size_t end, uint32_t thread, bool renderQueue) {
+        if (thread == callingThread && !this->recordingSegments.empty()) {
+            RecordingSegment& last = this->recordingSegments.back();
+            if (last.thread == callingThread && last.renderQueue == renderQueue && last.end == begin) {
+                last.end = end;
+                return;
+            }
+        }
+        RecordingSegment segment;
+        segment.begin       = begin;
+        segment.end         = end;
+        segment.thread      = thread;
+        segment.renderQueue = renderQueue;
+        this->recordingSegments.push_back(segment);
+    };
+    const auto addParallelRun = [&](size_t begin, size_t end, size_t minimumSize, bool renderQueue) {
+        const size_t count = end - begin;
+        if (count < minimumSize) {
+            addSegment(begin, end, callingThread, renderQueue);
+            return;
+        }
+        const size_t segmentCount = std::min<size_t>(count / minimumSize, threadCount);
+        const size_t segmentSize  = (count + segmentCount - 1) / segmentCount;
+        for (size_t segmentBegin = begin; segmentBegin < end; segmentBegin += segmentSize) {
+            addSegment(segmentBegin, std::min(segmentBegin + segmentSize, end), nextThread, renderQueue);
+            nextThread = (nextThread + 1) % threadCount;
+        }
+    };
+    const auto canRecordInParallel = [&renderables](size_t index) {
+        return renderables[index] == nullptr || renderables[index]->canRecordInParallel();
+    };
+
+    // Packets never call back into renderables, so any range of the sorted queue can be replayed on any thread
+    if (!this->renderQueue.empty()) {
+        addParallelRun(0, this->renderQueue.size(), MIN_PACKETS_PER_RECORDING_SEGMENT, true);
+    }
+
+    // Split the list into runs that agree on thread safety; only runs of thread-safe renderables are spread out
+    size_t begin = 0;
+    while (begin < renderables.size()) {
+        const bool parallel = canRecordInParallel(begin);
+        size_t     end      = begin + 1;
+        while (end < renderables.size() && canRecordInParallel(end) == parallel) {
+            ++end;
+        }
+
+        if (parallel) {
+            addParallelRun(begin, end, MIN_RENDERABLES_PER_RECORDING_SEGMENT, false);
+        } else {
+            addSegment(begin, end, callingThread, false);
+        }
+        begin = end;
+    }
+}
+
+bool drakon::Renderer::recordSecondaryCommandBuffers(uint32_t                        imageIndex,
+                                                     const std::vector<Renderable*>& renderables,
+                                                     const RenderContext&            context) {
+    // The frame's fence has signaled, so none of its secondary command buffers are still pending
+    const uint32_t threadCount = this->recordingThreadCount + 1;
+    for (uint32_t thread = 0; thread < threadCount; ++thread) {
+        SecondaryCommandPool& pool = this->secondaryCommandPools[this->currentFrame * threadCount + thread];
+        vkResetCommandPool(this->vkDevice, pool.pool, 0);
+        pool.used = 0;
+    }
+
+    std::atomic<bool> succeeded = true;
+    const auto        recordJob = [&](uint32_t thread) {
+        for (auto& segment : this->recordingSegments) {
+            if (segment.thread == thread && !this->recordSegment(segment, imageIndex, renderables, context)) {
+                succeeded.store(false, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    // One job per stream, so no two threads ever share a stream's command pool whichever workers run them
+    const auto recordStreams = [&recordJob](size_t begin, size_t end) {
+        for (size_t thread = begin; thread < end; ++thread) {
+            recordJob(static_cast<uint32_t>(thread));
+        }
+    };
+    if (this->jobSystem != nullptr) {
+        this->jobSystem->parallelFor(threadCount, 1, recordStreams);
+    } else {
+        recordStreams(0, threadCount);
+    }
+
+    return succeeded.load(std::memory_order_relaxed);
+}
+
+void drakon::Renderer::drawRenderable(VkCommandBuffer      commandBuffer,
+                                      Renderable&          renderable,
+                                      const RenderContext& context) {
+    if (!ENABLE_GPU_PROFILER || !this->gpuProfiler.isActive()) {
+        renderable.draw(commandBuffer, context);
+        return;
+    }
+
+    const uint32_t scope = this->gpuProfiler.beginScope(commandBuffer, this->currentFrame, renderable.getDebugName());
+    renderable.draw(commandBuffer, context);
+    this->gpuProfiler.endScope(commandBuffer, this->currentFrame, scope);
+}
+
+void drakon::Renderer::drawRenderQueue(VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+    if (begin == end) {
+        return;
+    }
+    if (!ENABLE_GPU_PROFILER || !this->gpuProfiler.isActive()) {
+        this->renderQueue.record(commandBuffer, begin, end);
+        return;
+    }
+
+    const uint32_t scope = this->gpuProfiler.beginScope(commandBuffer, this->currentFrame, "RenderQueue");
+    this->renderQueue.record(commandBuffer, begin, end);
+    this->gpuProfiler.endScope(commandBuffer, this->currentFrame, scope);
+}
+
+bool drakon::Renderer::recordSegment(RecordingSegment&               segment,
+                                     uint32_t                        imageIndex,
+                                     const std::vector<Renderable*>& renderables,
+                                     const RenderContext&            context) {
+    DRAKON_TRACE_SCOPE("Renderer::recordSegment");
+    const uint32_t        threadCount = this->recordingThreadCount + 1;
+    SecondaryCommandPool& pool        = this->secondaryCommandPools[this->currentFrame * threadCount + segment.thread];
+
+    if (pool.used == pool.commandBuffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool                 = pool.pool;
+        allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount          = 1;
+
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        if (vkAllocateCommandBuffers(this->vkDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            std::cerr << "Failed to allocate Vulkan secondary command buffer." << std::endl;
+            return false;
+        }
+        pool.commandBuffers.push_back(commandBuffer);
+    }
+    segment.commandBuffer = pool.commandBuffers[pool.used++];
+
+    const bool          upscaling   = this->sceneFramebuffer != VK_NULL_HANDLE;
+    const VkFramebuffer framebuffer = upscaling ? this->sceneFramebuffer : this->framebuffers[imageIndex];
+
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType                          = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass                     = upscaling ? this->scaledRenderPass : this->renderPass;
+    inheritanceInfo.subpass                        = 0;
+    inheritanceInfo.framebuffer                    = framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(segment.commandBuffer, &beginInfo) != VK_SUCCESS) {
+        std::cerr << "Failed to begin recording Vulkan secondary command buffer." << std::endl;
+        return false;
     }
+    // Secondary command buffers inherit no dynamic state from the primary
+    this->setViewportAndScissor(segment.commandBuffer);
+
+    if (segment.renderQueue) {
+        this->drawRenderQueue(segment.commandBuffer, segment.begin, segment.end);
+    } else {
+        for (size_t i = segment.begin; i < segment.end; ++i) {
+            if (renderables[i] == nullptr) {
+                continue;
+            }
+            this->drawRenderable(segment.commandBuffer, *renderables[i], context);
+        }
+    }
+
+    if (vkEndCommandBuffer(segment.commandBuffer) != VK_SUCCESS) {
+        std::cerr << "Failed to record Vulkan secondary command buffer." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+drakon::Renderer::SwapchainResources drakon::Renderer::releaseSwapchainResources() {
+    SwapchainResources resources;
+    resources.swapchain        = this->swapchain;
+    resources.images           = std::move(this->swapchainImages);
+    resources.offscreenImages  = std::move(this->offscreenImages);
+    resources.views            = std::move(this->swapchainViews);
+    resources.framebuffers     = std::move(this->framebuffers);
+    resources.depthImage       = std::move(this->depthImage);
+    resources.depthView        = this->depthView;
+    resources.sceneImage       = std::move(this->sceneImage);
+    resources.sceneView        = this->sceneView;
+    resources.sceneFramebuffer = this->sceneFramebuffer;
+
+    this->swapchain = VK_NULL_HANDLE;
+    this->swapchainImages.clear();
+    this->offscreenImages.clear();
+    this->swapchainViews.clear();
     this->framebuffers.clear();
+    this->depthView        = VK_NULL_HANDLE;
+    this->sceneView        = VK_NULL_HANDLE;
+    this->sceneFramebuffer = VK_NULL_HANDLE;
 
-    if (this->renderPass != VK_NULL_HANDLE) {
-        vkDestroyRenderPass(this->vkDevice, this->renderPass, nullptr);
-        this->renderPass = VK_NULL_HANDLE;
+    return resources;
+}
+
+void drakon::Renderer::destroySwapchainResources(SwapchainResources& resources) const {
+    for (auto framebuffer : resources.framebuffers) {
+        vkDestroyFramebuffer(this->vkDevice, framebuffer, nullptr);
+    }
+    resources.framebuffers.clear();
+    if (resources.sceneFramebuffer != VK_NULL_HANDLE) {
+        vkDestroyFramebuffer(this->vkDevice, resources.sceneFramebuffer, nullptr);
+        resources.sceneFramebuffer = VK_NULL_HANDLE;
     }
 
-    for (auto imageView : this->swapchainViews) {
+    for (auto imageView : resources.views) {
         vkDestroyImageView(this->vkDevice, imageView, nullptr);
     }
-    this->swapchainViews.clear();
+    resources.views.clear();
 
-    if (this->swapchain != VK_NULL_HANDLE) {
-        vkDestroySwapchainKHR(this->vkDevice, this->swapchain, nullptr);
-        this->swapchain = VK_NULL_HANDLE;
+    if (resources.depthView != VK_NULL_HANDLE) {
+        vkDestroyImageView(this->vkDevice, resources.depthView, nullptr);
+        resources.depthView = VK_NULL_HANDLE;
+    }
+    resources.depthImage.reset();
+    if (resources.sceneView != VK_NULL_HANDLE) {
+        vkDestroyImageView(this->vkDevice, resources.sceneView, nullptr);
+        resources.sceneView = VK_NULL_HANDLE;
+    }
+    resources.sceneImage.reset();
+
+    // Swapchain images belong to the swapchain; offscreen targets are retired through the allocator
+    resources.offscreenImages.clear();
+    resources.images.clear();
+
+    if (resources.swapchain != VK_NULL_HANDLE) {
+        vkDestroySwapchainKHR(this->vkDevice, resources.swapchain, nullptr);
+        resources.swapchain = VK_NULL_HANDLE;
+    }
+}
+
+bool drakon::Renderer::recreateSwapchain() {
+    if (!this->headless) {
+        VkSurfaceCapabilitiesKHR capabilities = {};
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(this->physicalDevice, this->vkSurface, &capabilities);
+        const VkExtent2D extent = chooseSwapchainExtent(capabilities, this->windowWidth, this->windowHeight);
+        if (extent.width == 0 || extent.height == 0) {
+            // Minimized; stay out of date until the surface has an area again
+            return true;
+        }
+    }
+
+    // The render pass only depends on the formats, so only extent-sized resources are rebuilt. The old ones
+    // may still be referenced by frames in flight and are destroyed once those frames retire.
+    SwapchainResources retired = this->releaseSwapchainResources();
+
+    const bool created = this->headless ? this->createOffscreenTargets() : this->createSwapchain(retired.swapchain);
+    this->deferDestruction([this, retired]() mutable { this->destroySwapchainResources(retired); });
+    if (!created || !this->createImageViews() || !this->createDepthTarget() || !this->createFramebuffers() ||
+        !this->createSceneTarget()) {
+        return false;
+    }
+
+    this->swapchainOutOfDate = false;
+    return true;
+}
+
+void drakon::Renderer::resize(uint32_t width, uint32_t height) {
+    this->windowWidth        = width;
+    this->windowHeight       = height;
+    this->swapchainOutOfDate = true;
+}
+
+void drakon::Renderer::deferDestruction(std::function<void()> destroy) {
+    std::lock_guard<std::mutex> lock(this->deferredDestructionsMutex);
+    DeferredDestruction         deferred;
+    deferred.frameNumber = this->frameNumber;
+    deferred.destroy     = std::move(destroy);
+    this->deferredDestructions.push_back(std::move(deferred));
+}
+
+void drakon::Renderer::destroyCompletedDeferrals(bool waitedIdle) {
+    // Anything deferred while a frame was being recorded may still be used by it, so waits for that frame
+    const uint64_t completed = waitedIdle ? UINT64_MAX : this->getCompletedFrame();
+    for (;;) {
+        std::function<void()> destroy;
+        {
+            std::lock_guard<std::mutex> lock(this->deferredDestructionsMutex);
+            if (this->deferredDestructions.empty()) {
+                break;
+            }
+            DeferredDestruction& deferred = this->deferredDestructions.front();
+            if (deferred.frameNumber >= completed) {
+                break;
+            }
+            destroy = std::move(deferred.destroy);
+            this->deferredDestructions.pop_front();
+        }
+        // Run unlocked, since destroying one object may release others that defer their own destruction
+        destroy();
     }
 }
 
@@ -570,11 +1667,12 @@ bool drakon::Renderer::init(void* windowHandle, uint32_t width, uint32_t height)
     this->nativeWindowHandle = windowHandle;
     this->windowWidth        = width;
     this->windowHeight       = height;
+    this->headless           = windowHandle == nullptr;
 
     if (!this->createVulkanInstance()) {
         return false;
     }
-    if (!this->createVulkanSurface()) {
+    if (!this->headless && !this->createVulkanSurface()) {
         return false;
     }
     if (!this->pickPhysicalDevice()) {
@@ -583,18 +1681,59 @@ bool drakon::Renderer::init(void* windowHandle, uint32_t width, uint32_t height)
     if (!this->createLogicalDevice()) {
         return false;
     }
-    if (!this->createSwapchain()) {
+    if (!this->pipelineCache.init(
+            this->physicalDevice, this->vkDevice, this->pipelineCachePath, this->pipelineCreationFeedbackEnabled)) {
+        return false;
+    }
+    if (!this->pipelineRegistry.init(this->vkDevice, &this->pipelineCache, [this](std::function<void()> destroy) {
+            this->deferDestruction(std::move(destroy));
+        })) {
+        return false;
+    }
+    if (!this->gpuAllocator.init(this->physicalDevice, this->vkDevice, [this](std::function<void()> destroy) {
+            this->deferDestruction(std::move(destroy));
+        })) {
+        return false;
+    }
+    if (!this->uploadRing.init(this->physicalDevice, this->gpuAllocator, this->uploadRingSize, MAX_FRAMES_IN_FLIGHT)) {
+        return false;
+    }
+    if (!this->textureCache.init(this->physicalDevice, this->vkDevice, this->gpuAllocator, this->enabledFeatures)) {
+        return false;
+    }
+    if (this->transferQueueEnabled) {
+        const QueueFamilyIndices indices = this->findQueueFamilies(this->physicalDevice);
+        // Without it uploads are recorded into the frame, which is slower but just as correct
+        if (this->transferQueue.init(this->vkDevice, indices.transferFamily.value(), indices.graphicsFamily.value())) {
+            this->textureCache.setTransferQueue(&this->transferQueue);
+        }
+    }
+    this->renderGraph.init(this->vkDevice, this->gpuAllocator, [this](std::function<void()> destroy) {
+        this->deferDestruction(std::move(destroy));
+    });
+    if (this->headless ? !this->createOffscreenTargets() : !this->createSwapchain(VK_NULL_HANDLE)) {
         return false;
     }
     if (!this->createImageViews()) {
         return false;
     }
+    this->depthFormat = chooseDepthFormat(this->physicalDevice);
+    if (this->depthFormat == VK_FORMAT_UNDEFINED) {
+        std::cerr << "Failed to find a supported Vulkan depth format." << std::endl;
+        return false;
+    }
+    if (!this->createDepthTarget()) {
+        return false;
+    }
     if (!this->createRenderPass()) {
         return false;
     }
     if (!this->createFramebuffers()) {
         return false;
     }
+    if (!this->createSceneTarget()) {
+        return false;
+    }
     if (!this->createCommandPool()) {
         return false;
     }
@@ -604,69 +1743,198 @@ bool drakon::Renderer::init(void* windowHandle, uint32_t width, uint32_t height)
     if (!this->createSyncObjects()) {
         return false;
     }
+    if (!this->createSecondaryCommandPools()) {
+        return false;
+    }
+    if (ENABLE_GPU_PROFILER) {
+        const uint32_t graphicsFamily = this->findQueueFamilies(this->physicalDevice).graphicsFamily.value();
+        if (!this->gpuProfiler.init(
+                this->physicalDevice, this->vkDevice, graphicsFamily, MAX_FRAMES_IN_FLIGHT, MAX_GPU_PROFILER_SCOPES)) {
+            return false;
+        }
+    }
 
     return true;
 }
 
-bool drakon::Renderer::render(std::vector<Renderable*> renderables) {
-    vkWaitForFences(this->vkDevice, 1, &this->inFlightFences[this->currentFrame], VK_TRUE, UINT64_MAX);
+void drakon::Renderer::waitForCurrentFrame() {
+    {
+        DRAKON_TRACE_SCOPE("Renderer::waitForFrame");
+        this->waitForFrame(this->slotFrames[this->currentFrame]);
+    }
+
+    if (this->requestedFramesInFlight != this->framesInFlight) {
+        // Slots outside the new rotation would never be collected, so every frame finishes before the switch
+        DRAKON_TRACE_SCOPE("Renderer::setFramesInFlight");
+        this->waitForFrame(this->frameNumber);
+        if (ENABLE_GPU_PROFILER) {
+            for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; ++slot) {
+                this->gpuProfiler.collect(slot);
+            }
+        }
+        this->framesInFlight = this->requestedFramesInFlight;
+        this->currentFrame   = 0;
+    }
+    this->observeFrameCompletion();
+}
 
-    uint32_t imageIndex    = 0;
-    VkResult acquireResult = vkAcquireNextImageKHR(this->vkDevice,
-                                                   this->swapchain,
-                                                   UINT64_MAX,
-                                                   this->imageAvailableSemaphores[this->currentFrame],
-                                                   VK_NULL_HANDLE,
-                                                   &imageIndex);
+void drakon::Renderer::observeFrameCompletion() {
+    const auto     now       = std::chrono::steady_clock::now();
+    const uint64_t completed = this->getCompletedFrame();
+    for (uint32_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; ++slot) {
+        if (!this->latencyPending[slot] || this->slotFrames[slot] > completed) {
+            continue;
+        }
+        this->latencyPending[slot] = false;
+
+        const std::chrono::duration<double, std::milli> latency = now - this->frameInputTimes[slot];
+        const double                                    milliseconds = latency.count();
+        LatencyStats&                                   stats        = this->latencyStats;
+        ++stats.frames;
+        stats.lastMilliseconds = milliseconds;
+        stats.averageMilliseconds += (milliseconds - stats.averageMilliseconds) / static_cast<double>(stats.frames);
+        stats.maxMilliseconds = std::max(stats.maxMilliseconds, milliseconds);
+    }
+}
 
-    if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
-        std::cerr << "Failed to acquire Vulkan swapchain image." << std::endl;
-        return false;
+bool drakon::Renderer::render(const std::vector<Renderable*>& renderables, World* world) {
+    DRAKON_TRACE_SCOPE("Renderer::render");
+    const auto renderStart = std::chrono::steady_clock::now();
+    this->waitForCurrentFrame();
+    this->destroyCompletedDeferrals(false);
+    // The slot's last frame has finished, so the GPU is done reading this frame's region of the ring
+    this->uploadRing.beginFrame(this->currentFrame);
+    if (ENABLE_GPU_PROFILER) {
+        this->gpuProfiler.collect(this->currentFrame);
     }
 
-    vkResetFences(this->vkDevice, 1, &this->inFlightFences[this->currentFrame]);
+    if (this->swapchainOutOfDate) {
+        if (!this->recreateSwapchain()) {
+            return false;
+        }
+        if (this->swapchainOutOfDate) {
+            return true;
+        }
+    }
+    this->updateRenderExtent();
+
+    // Offscreen targets are paired with frames in flight, so waiting for the slot already guards its image
+    uint32_t imageIndex = this->currentFrame;
+    if (!this->headless) {
+        DRAKON_TRACE_SCOPE("vkAcquireNextImageKHR");
+        VkResult acquireResult = vkAcquireNextImageKHR(this->vkDevice,
+                                                       this->swapchain,
+                                                       UINT64_MAX,
+                                                       this->imageAvailableSemaphores[this->currentFrame],
+                                                       VK_NULL_HANDLE,
+                                                       &imageIndex);
+
+        if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+            // Nothing was submitted and the fence is still signaled, so the frame can simply be skipped
+            this->swapchainOutOfDate = true;
+            return true;
+        }
+        if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
+            std::cerr << "Failed to acquire Vulkan swapchain image." << std::endl;
+            return false;
+        }
+    }
+
+    // The timeline replaces the fence, which stays signaled and unused
+    VkFence fence = VK_NULL_HANDLE;
+    if (this->frameTimeline == VK_NULL_HANDLE) {
+        fence = this->inFlightFences[this->currentFrame];
+        vkResetFences(this->vkDevice, 1, &fence);
+    }
     vkResetCommandBuffer(this->commandBuffers[this->currentFrame], 0);
 
-    if (!this->recordCommandBuffer(this->commandBuffers[this->currentFrame], imageIndex, renderables)) {
+    if (!this->recordCommandBuffer(this->commandBuffers[this->currentFrame], imageIndex, renderables, world)) {
+        return false;
+    }
+    if (!this->uploadRing.endFrame()) {
         return false;
     }
 
-    VkSemaphore          waitSemaphores[]   = {this->imageAvailableSemaphores[this->currentFrame]};
-    VkPipelineStageFlags waitStages[]       = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    VkSemaphore          signalSemaphores[] = {this->renderFinishedSemaphores[this->currentFrame]};
+    // Texture uploads acquired this frame must wait for the transfer queue's release, not just the host's poll
+    const uint64_t       transferWait     = this->transferQueue.takeGraphicsWait();
+    VkSemaphore          waitSemaphores[] = {this->imageAvailableSemaphores[this->currentFrame],
+                                             this->transferQueue.getTimeline()};
+    VkPipelineStageFlags waitStages[]     = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                             VK_PIPELINE_STAGE_TRANSFER_BIT};
+    const uint64_t       waitValues[]     = {0, transferWait};
+    const uint32_t       firstWait        = this->headless ? 1 : 0;
+    const uint32_t       waitCount        = (transferWait != 0 ? 2 : 1) - firstWait;
+
+    const uint64_t submittedFrame     = this->frameNumber + 1;
+    VkSemaphore    renderFinished     = this->renderFinishedSemaphores[this->currentFrame];
+    VkSemaphore    signalSemaphores[] = {renderFinished, this->frameTimeline};
+    const uint64_t signalValues[]     = {0, submittedFrame};
+    const uint32_t firstSignal        = this->headless ? 1 : 0;
+    const uint32_t signalCount        = (this->frameTimeline != VK_NULL_HANDLE ? 2 : 1) - firstSignal;
+
+    // The binary semaphores ignore their values, but every waited and signaled semaphore needs one
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount       = waitCount;
+    timelineInfo.pWaitSemaphoreValues          = waitValues + firstWait;
+    timelineInfo.signalSemaphoreValueCount     = signalCount;
+    timelineInfo.pSignalSemaphoreValues        = signalValues + firstSignal;
 
     VkSubmitInfo submitInfo         = {};
     submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount   = 1;
-    submitInfo.pWaitSemaphores      = waitSemaphores;
-    submitInfo.pWaitDstStageMask    = waitStages;
+    submitInfo.pNext                = this->frameTimeline != VK_NULL_HANDLE ? &timelineInfo : nullptr;
+    submitInfo.waitSemaphoreCount   = waitCount;
+    submitInfo.pWaitSemaphores      = waitSemaphores + firstWait;
+    submitInfo.pWaitDstStageMask    = waitStages + firstWait;
     submitInfo.commandBufferCount   = 1;
     submitInfo.pCommandBuffers      = &this->commandBuffers[this->currentFrame];
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores    = signalSemaphores;
+    submitInfo.signalSemaphoreCount = signalCount;
+    submitInfo.pSignalSemaphores    = signalSemaphores + firstSignal;
 
-    if (vkQueueSubmit(this->graphicsQueue, 1, &submitInfo, this->inFlightFences[this->currentFrame]) != VK_SUCCESS) {
+    VkResult submitResult = VK_SUCCESS;
+    {
+        DRAKON_TRACE_SCOPE("vkQueueSubmit");
+        submitResult = vkQueueSubmit(this->graphicsQueue, 1, &submitInfo, fence);
+    }
+    if (submitResult != VK_SUCCESS) {
         std::cerr << "Failed to submit Vulkan draw command buffer." << std::endl;
         return false;
     }
 
+    this->frameInputTimes[this->currentFrame] = this->inputSampled ? this->inputSampleTime : renderStart;
+    this->latencyPending[this->currentFrame]  = true;
+    this->slotFrames[this->currentFrame]      = submittedFrame;
+    this->inputSampled                        = false;
+
+    this->frameNumber = submittedFrame;
+    this->currentFrame = (this->currentFrame + 1) % this->framesInFlight;
+
+    if (this->headless) {
+        return true;
+    }
+
     VkPresentInfoKHR presentInfo   = {};
     presentInfo.sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores    = signalSemaphores;
+    presentInfo.pWaitSemaphores    = &renderFinished;
 
     VkSwapchainKHR swapchains[] = {this->swapchain};
     presentInfo.swapchainCount  = 1;
     presentInfo.pSwapchains     = swapchains;
     presentInfo.pImageIndices   = &imageIndex;
 
-    VkResult presentResult = vkQueuePresentKHR(this->presentQueue, &presentInfo);
-    if (presentResult != VK_SUCCESS && presentResult != VK_SUBOPTIMAL_KHR) {
+    VkResult presentResult = VK_SUCCESS;
+    {
+        DRAKON_TRACE_SCOPE("vkQueuePresentKHR");
+        presentResult = vkQueuePresentKHR(this->presentQueue, &presentInfo);
+    }
+    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
+        this->swapchainOutOfDate = true;
+    } else if (presentResult != VK_SUCCESS) {
         std::cerr << "Failed to present Vulkan swapchain image." << std::endl;
         return false;
     }
 
-    this->currentFrame = (this->currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
     return true;
 }
 
@@ -690,8 +1958,36 @@ bool drakon::Renderer::cleanup() {
     }
     this->inFlightFences.clear();
 
-    this->destroySwapchainResources();
+    if (this->frameTimeline != VK_NULL_HANDLE) {
+        vkDestroySemaphore(this->vkDevice, this->frameTimeline, nullptr);
+        this->frameTimeline = VK_NULL_HANDLE;
+    }
+    this->completedFrame = this->frameNumber;
 
+    this->destroyCompletedDeferrals(true);
+
+    SwapchainResources swapchainResources = this->releaseSwapchainResources();
+    this->destroySwapchainResources(swapchainResources);
+
+    if (this->renderPass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(this->vkDevice, this->renderPass, nullptr);
+        this->renderPass = VK_NULL_HANDLE;
+    }
+    if (this->scaledRenderPass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(this->vkDevice, this->scaledRenderPass, nullptr);
+        this->scaledRenderPass = VK_NULL_HANDLE;
+    }
+
+    this->pipelineRegistry.cleanup();
+    this->pipelineCache.cleanup();
+    this->gpuProfiler.cleanup();
+    this->renderGraph.cleanup();
+    this->textureCache.cleanup();
+    this->transferQueue.cleanup();
+    this->uploadRing.cleanup();
+    this->gpuAllocator.cleanup();
+
+    this->destroySecondaryCommandPools();
     if (this->commandPool != VK_NULL_HANDLE) {
         vkDestroyCommandPool(this->vkDevice, this->commandPool, nullptr);
         this->commandPool = VK_NULL_HANDLE;
@@ -721,14 +2017,22 @@ bool drakon::Renderer::compileGlslShader(const std::string& filename) const {
         return false;
     }
 
-    const std::string outputFilename = filename + ".spv";
-    const std::string command        = "glslc \"" + filename + "\" -o \"" + outputFilename + "\"";
+    const ShaderCompileResult result = this->shaderCompiler.compile(filename);
+    if (!result.success) {
+        std::cerr << "Failed to compile GLSL shader: " << filename << std::endl << result.log << std::endl;
+        return false;
+    }
 
-    const int result = std::system(command.c_str());
-    if (result != 0) {
-        std::cerr << "Failed to compile GLSL shader: " << filename << std::endl;
+    const std::filesystem::path outputPath = filename + ".spv";
+    std::ofstream               file(outputPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(result.spirv.data()),
+               static_cast<std::streamsize>(result.spirv.size() * sizeof(uint32_t)));
+    if (!file.flush()) {
+        std::cerr << "Failed to write compiled shader: " << outputPath << std::endl;
         return false;
     }
 
     return true;
 }
+
+drakon::ShaderCompiler& drakon::Renderer::getShaderCompiler() { return this->shaderCompiler; }
@@ -0,0 +1,320 @@
+#include <drakon/Hash.h>
+#include <drakon/ShaderCompiler.h>
+#include <drakon/Trace.h>
+#include <drakon/JobSystem.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#if DRAKON_HAS_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+namespace {
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+// Bump whenever the key or the cached file layout changes so stale entries are ignored
+constexpr uint32_t SHADER_CACHE_VERSION = 2;
+#if DRAKON_HAS_SHADERC
+constexpr bool IN_PROCESS = true;
+#else
+constexpr bool IN_PROCESS = false;
+#endif
+#ifndef DRAKON_SHADERC_VERSION
+#define DRAKON_SHADERC_VERSION ""
+#endif
+
+drakon::ShaderStage inferStage(const std::filesystem::path& path) {
+    const std::string extension = path.extension().string();
+    if (extension == ".vert") {
+        return drakon::ShaderStage::Vertex;
+    }
+    if (extension == ".frag") {
+        return drakon::ShaderStage::Fragment;
+    }
+    if (extension == ".comp") {
+        return drakon::ShaderStage::Compute;
+    }
+    if (extension == ".geom") {
+        return drakon::ShaderStage::Geometry;
+    }
+    if (extension == ".tesc") {
+        return drakon::ShaderStage::TessellationControl;
+    }
+    if (extension == ".tese") {
+        return drakon::ShaderStage::TessellationEvaluation;
+    }
+    return drakon::ShaderStage::Infer;
+}
+
+std::string toHex(uint64_t value) {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(value));
+    return hex;
+}
+
+std::optional<std::string> readTextFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// A compiler upgrade can change the SPIR-V an unchanged source produces
+const std::string& compilerVersion() {
+#if DRAKON_HAS_SHADERC
+    static const std::string version = DRAKON_SHADERC_VERSION;
+#else
+    static const std::string version = [] {
+        const std::filesystem::path path =
+            std::filesystem::temp_directory_path() /
+            ("drakon_glslc_version_" + toHex(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".txt");
+        const std::string command = "glslc --version > \"" + path.string() + "\" 2>&1";
+        std::string       output  = std::system(command.c_str()) == 0 ? readTextFile(path).value_or("") : "";
+        std::error_code   error;
+        std::filesystem::remove(path, error);
+        return output;
+    }();
+#endif
+    return version;
+}
+
+uint64_t cacheKey(const std::string& source, drakon::ShaderStage stage, const drakon::ShaderCompileOptions& options) {
+    // The two backends do not produce identical SPIR-V, so they never share entries
+    uint64_t hash = drakon::hashValue(SHADER_CACHE_VERSION);
+    hash          = drakon::hashValue(IN_PROCESS, hash);
+    hash          = drakon::hashString(compilerVersion(), hash);
+    hash          = drakon::hashValue(stage, hash);
+    hash          = drakon::hashValue(options.optimize, hash);
+    hash          = drakon::hashValue(options.debugInfo, hash);
+    for (const auto& [name, value] : options.defines) {
+        hash = drakon::hashString(name, hash);
+        hash = drakon::hashString(value, hash);
+    }
+    return drakon::hashString(source, hash);
+}
+
+bool readSpirv(const std::filesystem::path& path, std::vector<uint32_t>& spirv) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const std::streamsize size = file.tellg();
+    if (size < static_cast<std::streamsize>(sizeof(uint32_t)) || size % sizeof(uint32_t) != 0) {
+        return false;
+    }
+
+    spirv.resize(static_cast<size_t>(size) / sizeof(uint32_t));
+    file.seekg(0);
+    return file.read(reinterpret_cast<char*>(spirv.data()), size) && spirv[0] == SPIRV_MAGIC;
+}
+
+bool writeSpirv(const std::filesystem::path& path, const std::vector<uint32_t>& spirv) {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    // Parallel compiles of the same shader race on the same entry; renaming a private file over it keeps that safe
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += "." + toHex(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(spirv.data()),
+                   static_cast<std::streamsize>(spirv.size() * sizeof(uint32_t)));
+        if (!file.flush()) {
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+#if DRAKON_HAS_SHADERC
+shaderc_shader_kind shadercKind(drakon::ShaderStage stage) {
+    switch (stage) {
+    case drakon::ShaderStage::Vertex:
+        return shaderc_vertex_shader;
+    case drakon::ShaderStage::Fragment:
+        return shaderc_fragment_shader;
+    case drakon::ShaderStage::Compute:
+        return shaderc_compute_shader;
+    case drakon::ShaderStage::Geometry:
+        return shaderc_geometry_shader;
+    case drakon::ShaderStage::TessellationControl:
+        return shaderc_tess_control_shader;
+    case drakon::ShaderStage::TessellationEvaluation:
+        return shaderc_tess_evaluation_shader;
+    case drakon::ShaderStage::Infer:
+        break;
+    }
+    return shaderc_glsl_infer_from_source;
+}
+
+bool compileSpirv(const std::string&                  source,
+                  const std::string&                  name,
+                  drakon::ShaderStage                 stage,
+                  const drakon::ShaderCompileOptions& options,
+                  drakon::ShaderCompileResult&        result) {
+    // One compiler per thread so compileAll never shares one between threads
+    thread_local shaderc::Compiler compiler;
+
+    shaderc::CompileOptions compileOptions;
+    compileOptions.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0);
+    compileOptions.SetOptimizationLevel(options.optimize ? shaderc_optimization_level_performance
+                                                         : shaderc_optimization_level_zero);
+    if (options.debugInfo) {
+        compileOptions.SetGenerateDebugInfo();
+    }
+    for (const auto& [defineName, value] : options.defines) {
+        compileOptions.AddMacroDefinition(defineName, value);
+    }
+
+    const shaderc::SpvCompilationResult compiled =
+        compiler.CompileGlslToSpv(source, shadercKind(stage), name.c_str(), compileOptions);
+    result.log = compiled.GetErrorMessage();
+    if (compiled.GetCompilationStatus() != shaderc_compilation_status_success) {
+        return false;
+    }
+
+    result.spirv.assign(compiled.cbegin(), compiled.cend());
+    return true;
+}
+#else
+const char* stageName(drakon::ShaderStage stage) {
+    switch (stage) {
+    case drakon::ShaderStage::Vertex:
+        return "vert";
+    case drakon::ShaderStage::Fragment:
+        return "frag";
+    case drakon::ShaderStage::Compute:
+        return "comp";
+    case drakon::ShaderStage::Geometry:
+        return "geom";
+    case drakon::ShaderStage::TessellationControl:
+        return "tesc";
+    case drakon::ShaderStage::TessellationEvaluation:
+        return "tese";
+    case drakon::ShaderStage::Infer:
+        break;
+    }
+    return "";
+}
+
+bool compileSpirv(const std::string&                  source,
+                  const std::string&                  name,
+                  drakon::ShaderStage                 stage,
+                  const drakon::ShaderCompileOptions& options,
+                  drakon::ShaderCompileResult&        result) {
+    // glslc only reads files, so stage the source in a scratch file unique to this thread and shader
+    const std::string scratchName = "drakon_shader_" + toHex(drakon::hashString(name)) + "_" +
+                                    toHex(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    const std::filesystem::path scratchDirectory = std::filesystem::temp_directory_path();
+    const std::filesystem::path sourcePath       = scratchDirectory / (scratchName + ".glsl");
+    const std::filesystem::path outputPath       = scratchDirectory / (scratchName + ".spv");
+    const std::filesystem::path logPath          = scratchDirectory / (scratchName + ".log");
+    {
+        std::ofstream file(sourcePath, std::ios::binary | std::ios::trunc);
+        file << source;
+        if (!file.flush()) {
+            result.log = "Failed to stage shader source for glslc: " + sourcePath.string();
+            return false;
+        }
+    }
+
+    std::string command = "glslc -fshader-stage=" + std::string(stageName(stage));
+    command += options.optimize ? " -O" : " -O0";
+    if (options.debugInfo) {
+        command += " -g";
+    }
+    for (const auto& [defineName, value] : options.defines) {
+        command += " \"-D" + defineName + (value.empty() ? "" : "=" + value) + "\"";
+    }
+    command += " \"" + sourcePath.string() + "\" -o \"" + outputPath.string() + "\" 2> \"" + logPath.string() + "\"";
+
+    const bool compiled = std::system(command.c_str()) == 0 && readSpirv(outputPath, result.spirv);
+    result.log          = readTextFile(logPath).value_or("");
+
+    std::error_code error;
+    std::filesystem::remove(sourcePath, error);
+    std::filesystem::remove(outputPath, error);
+    std::filesystem::remove(logPath, error);
+    return compiled;
+}
+#endif
+} // namespace
+
+void drakon::ShaderCompiler::setCacheDirectory(std::filesystem::path directory) {
+    this->cacheDirectory = std::move(directory);
+}
+
+const std::filesystem::path& drakon::ShaderCompiler::getCacheDirectory() const { return this->cacheDirectory; }
+
+bool drakon::ShaderCompiler::isInProcess() { return IN_PROCESS; }
+
+drakon::ShaderCompileResult drakon::ShaderCompiler::compile(const std::filesystem::path& path,
+                                                            const ShaderCompileOptions&  options) const {
+    const std::optional<std::string> source = readTextFile(path);
+    if (!source.has_value()) {
+        ShaderCompileResult result;
+        result.log = "Failed to open shader source: " + path.string();
+        return result;
+    }
+    return this->compileSource(*source, path.string(), options);
+}
+
+drakon::ShaderCompileResult drakon::ShaderCompiler::compileSource(const std::string&          source,
+                                                                  const std::string&          name,
+                                                                  const ShaderCompileOptions& options) const {
+    DRAKON_TRACE_SCOPE("ShaderCompiler::compile");
+    ShaderCompileResult result;
+
+    const ShaderStage stage = options.stage == ShaderStage::Infer ? inferStage(name) : options.stage;
+    if (stage == ShaderStage::Infer) {
+        result.log = "Cannot infer the shader stage of " + name + "; set ShaderCompileOptions::stage";
+        return result;
+    }
+
+    std::filesystem::path cachePath;
+    if (!this->cacheDirectory.empty()) {
+        cachePath = this->cacheDirectory / (toHex(cacheKey(source, stage, options)) + ".spv");
+        if (readSpirv(cachePath, result.spirv)) {
+            result.success   = true;
+            result.fromCache = true;
+            return result;
+        }
+    }
+
+    result.success = compileSpirv(source, name, stage, options, result);
+    if (result.success && !cachePath.empty()) {
+        // A cache that cannot be written only costs a recompile next launch
+        writeSpirv(cachePath, result.spirv);
+    }
+    return result;
+}
+
+std::vector<drakon::ShaderCompileResult> drakon::ShaderCompiler::compileAll(
+    const std::vector<ShaderCompileRequest>& requests, JobSystem& jobs) const {
+    std::vector<ShaderCompileResult> results(requests.size());
+    jobs.parallelFor(requests.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = this->compile(requests[i].path, requests[i].options);
+        }
+    });
+    return results;
+}
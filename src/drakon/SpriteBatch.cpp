@@ -0,0 +1,574 @@
+#include <drakon/Renderer.h>
+#include <drakon/SpriteBatch.h>
+#include <drakon/Trace.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DRAKON_SPRITE_SSE 1
+#else
+#define DRAKON_SPRITE_SSE 0
+#endif
+
+namespace {
+// Four floats of position and uv, then color and layer, so the first half of a vertex is one 16 byte store
+static_assert(sizeof(drakon::SpriteVertex) == 24);
+static_assert(offsetof(drakon::SpriteVertex, uv) == 8);
+static_assert(offsetof(drakon::SpriteVertex, color) == 16);
+
+constexpr size_t MIN_VERTEX_CAPACITY = 1024;
+
+const char* const SPRITE_VERTEX_SOURCE = R"(#version 450
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUv;
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in uint inLayer;
+
+layout(set = 0, binding = 1) uniform Screen {
+    vec2 scale;
+    vec2 offset;
+};
+
+layout(location = 0) out vec2 outUv;
+layout(location = 1) out vec4 outColor;
+layout(location = 2) flat out uint outLayer;
+
+void main() {
+    gl_Position = vec4(inPosition * scale + offset, 0.0, 1.0);
+    outUv       = inUv;
+    outColor    = inColor;
+    outLayer    = inLayer;
+}
+)";
+
+const char* const SPRITE_FRAGMENT_SOURCE = R"(#version 450
+layout(set = 0, binding = 0) uniform sampler2DArray spriteTexture;
+
+layout(location = 0) in vec2 inUv;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) flat in uint inLayer;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(spriteTexture, vec3(inUv, float(inLayer))) * inColor;
+}
+)";
+
+void transitionTexture(VkCommandBuffer      commandBuffer,
+                       VkImage              image,
+                       VkImageLayout        oldLayout,
+                       VkImageLayout        newLayout,
+                       VkAccessFlags        srcAccess,
+                       VkAccessFlags        dstAccess,
+                       VkPipelineStageFlags srcStage,
+                       VkPipelineStageFlags dstStage) {
+    VkImageMemoryBarrier barrier        = {};
+    barrier.sType                       = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask               = srcAccess;
+    barrier.dstAccessMask               = dstAccess;
+    barrier.oldLayout                   = oldLayout;
+    barrier.newLayout                   = newLayout;
+    barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                       = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+} // namespace
+
+bool drakon::SpriteBatch::init(Renderer& renderer, uint32_t layerWidth, uint32_t layerHeight, uint32_t layerCount) {
+    this->renderer           = &renderer;
+    this->device             = renderer.getDevice();
+    this->layerWidth         = std::max<uint32_t>(layerWidth, 1);
+    this->layerHeight        = std::max<uint32_t>(layerHeight, 1);
+    this->layerCount         = std::max<uint32_t>(layerCount, 1);
+    this->textureInitialized = false;
+
+    ShaderCompileOptions vertexOptions;
+    vertexOptions.stage = ShaderStage::Vertex;
+    ShaderCompileOptions fragmentOptions;
+    fragmentOptions.stage = ShaderStage::Fragment;
+
+    ShaderCompiler&     compiler = renderer.getShaderCompiler();
+    ShaderCompileResult vertex   = compiler.compileSource(SPRITE_VERTEX_SOURCE, "sprite.vert", vertexOptions);
+    ShaderCompileResult fragment = compiler.compileSource(SPRITE_FRAGMENT_SOURCE, "sprite.frag", fragmentOptions);
+    if (!vertex.success || !fragment.success) {
+        std::cerr << "Failed to compile sprite shaders:" << std::endl << vertex.log << fragment.log << std::endl;
+        return false;
+    }
+    this->vertexSpirv   = std::move(vertex.spirv);
+    this->fragmentSpirv = std::move(fragment.spirv);
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType         = VK_IMAGE_TYPE_2D;
+    imageInfo.format            = VK_FORMAT_R8G8B8A8_SRGB;
+    imageInfo.extent            = {this->layerWidth, this->layerHeight, 1};
+    imageInfo.mipLevels         = 1;
+    imageInfo.arrayLayers       = this->layerCount;
+    imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage             = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    GpuAllocator& allocator = renderer.getGpuAllocator();
+    // Always an array view, even for a single layer, since that is what the shader samples
+    this->texture = allocator.createImage(
+        imageInfo, VK_IMAGE_ASPECT_COLOR_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+    if (this->texture == nullptr) {
+        std::cerr << "Failed to create sprite texture array." << std::endl;
+        return false;
+    }
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType               = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter           = VK_FILTER_LINEAR;
+    samplerInfo.minFilter           = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode          = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    if (vkCreateSampler(this->device, &samplerInfo, nullptr, &this->sampler) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan sampler." << std::endl;
+        return false;
+    }
+
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+    bindings[0].binding                                  = 0;
+    bindings[0].descriptorType                           = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount                          = 1;
+    bindings[0].stageFlags                               = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[1].binding                                  = 1;
+    bindings[1].descriptorType                           = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    bindings[1].descriptorCount                          = 1;
+    bindings[1].stageFlags                               = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount                    = static_cast<uint32_t>(bindings.size());
+    setLayoutInfo.pBindings                       = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(this->device, &setLayoutInfo, nullptr, &this->descriptorSetLayout) !=
+        VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan descriptor set layout." << std::endl;
+        return false;
+    }
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+    poolSizes[0].type                             = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount                  = 1;
+    poolSizes[1].type                             = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSizes[1].descriptorCount                  = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets                    = 1;
+    poolInfo.poolSizeCount              = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes                 = poolSizes.data();
+
+    if (vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &this->descriptorPool) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan descriptor pool." << std::endl;
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool              = this->descriptorPool;
+    allocInfo.descriptorSetCount          = 1;
+    allocInfo.pSetLayouts                 = &this->descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(this->device, &allocInfo, &this->descriptorSet) != VK_SUCCESS) {
+        std::cerr << "Failed to allocate Vulkan descriptor set." << std::endl;
+        return false;
+    }
+
+    // The screen transform is streamed through the upload ring each frame, at a dynamic offset into its one buffer
+    VkDescriptorImageInfo imageDescriptor = {};
+    imageDescriptor.sampler               = this->sampler;
+    imageDescriptor.imageView             = this->texture->view;
+    imageDescriptor.imageLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkDescriptorBufferInfo screenDescriptor = {};
+    screenDescriptor.buffer                 = renderer.getUploadRing().getBuffer();
+    screenDescriptor.offset                 = 0;
+    screenDescriptor.range                  = sizeof(float) * 4;
+
+    std::array<VkWriteDescriptorSet, 2> writes = {};
+    writes[0].sType                            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstSet                           = this->descriptorSet;
+    writes[0].dstBinding                       = 0;
+    writes[0].descriptorCount                  = 1;
+    writes[0].descriptorType                   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].pImageInfo                       = &imageDescriptor;
+    writes[1].sType                            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[1].dstSet                           = this->descriptorSet;
+    writes[1].dstBinding                       = 1;
+    writes[1].descriptorCount                  = 1;
+    writes[1].descriptorType                   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    writes[1].pBufferInfo                      = &screenDescriptor;
+    vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    // Every chunk draws the same quads at a different vertex offset, so one chunk's worth of indices serves them all
+    const VkMemoryPropertyFlags hostMemory =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    this->indices = allocator.createBuffer(
+        VkDeviceSize(SPRITES_PER_DRAW) * 6 * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, hostMemory);
+    if (this->indices == nullptr) {
+        std::cerr << "Failed to create sprite index buffer." << std::endl;
+        return false;
+    }
+    auto* index = static_cast<uint32_t*>(this->indices->allocation.mapped);
+    for (uint32_t quad = 0; quad < SPRITES_PER_DRAW; ++quad) {
+        const uint32_t first = quad * 4;
+        *index++             = first;
+        *index++             = first + 1;
+        *index++             = first + 2;
+        *index++             = first + 2;
+        *index++             = first + 3;
+        *index++             = first;
+    }
+
+    this->frames.assign(renderer.getFrameSlotCount(), Frame());
+    this->frameIndex = 0;
+    return true;
+}
+
+void drakon::SpriteBatch::cleanup() {
+    if (this->renderer == nullptr) {
+        return;
+    }
+
+    this->frames.clear();
+    this->texture.reset();
+    this->indices.reset();
+    this->pipeline.reset();
+    this->pendingUploads.clear();
+    this->renderer->deferDestruction([device         = this->device,
+                                      sampler        = this->sampler,
+                                      descriptorPool = this->descriptorPool,
+                                      setLayout      = this->descriptorSetLayout]() {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+        vkDestroySampler(device, sampler, nullptr);
+    });
+
+    this->sampler             = VK_NULL_HANDLE;
+    this->descriptorPool      = VK_NULL_HANDLE;
+    this->descriptorSetLayout = VK_NULL_HANDLE;
+    this->descriptorSet       = VK_NULL_HANDLE;
+    this->renderer            = nullptr;
+}
+
+bool drakon::SpriteBatch::setLayerPixels(uint32_t layer, const void* rgba) {
+    if (layer >= this->layerCount || rgba == nullptr) {
+        std::cerr << "Sprite texture layer " << layer << " is out of range." << std::endl;
+        return false;
+    }
+    // Waiting would not help a layer that can never fit, and it would hold back every layer queued after it
+    const size_t size = size_t(this->layerWidth) * this->layerHeight * 4;
+    if (size > this->renderer->getUploadRing().getStats().capacityPerFrame) {
+        std::cerr << "Failed to set sprite texture layer " << layer << ": " << size
+                  << " bytes do not fit in the upload ring's per-frame region." << std::endl;
+        return false;
+    }
+
+    LayerUpload upload;
+    upload.layer = layer;
+    upload.pixels.resize(size);
+    std::memcpy(upload.pixels.data(), rgba, upload.pixels.size());
+    // A newer upload of the same layer makes any older one redundant
+    std::erase_if(this->pendingUploads, [layer](const LayerUpload& pending) { return pending.layer == layer; });
+    this->pendingUploads.push_back(std::move(upload));
+    return true;
+}
+
+void drakon::SpriteBatch::clear() { this->sprites.clear(); }
+
+void drakon::SpriteBatch::add(const Sprite& sprite) { this->sprites.push_back(sprite); }
+
+void drakon::SpriteBatch::add(const Sprite* sprites, size_t count) {
+    this->sprites.insert(this->sprites.end(), sprites, sprites + count);
+}
+
+size_t drakon::SpriteBatch::size() const { return this->sprites.size(); }
+
+void drakon::SpriteBatch::setPass(uint32_t pass) { this->pass = pass; }
+
+void drakon::SpriteBatch::expandQuads(const Sprite* sprites, size_t count, SpriteVertex* vertices) {
+#if DRAKON_SPRITE_SSE
+    // One lane per corner, so each sprite's four corners are transformed together and transposed into vertices
+    const __m128 cornerX = _mm_setr_ps(0.0f, 1.0f, 1.0f, 0.0f);
+    const __m128 cornerY = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+    for (size_t i = 0; i < count; ++i) {
+        const Sprite& sprite = sprites[i];
+        float         cosine = 1.0f;
+        float         sine   = 0.0f;
+        if (sprite.rotation != 0.0f) {
+            cosine = std::cos(sprite.rotation);
+            sine   = std::sin(sprite.rotation);
+        }
+
+        const __m128 originX = _mm_sub_ps(cornerX, _mm_set1_ps(sprite.origin[0]));
+        const __m128 originY = _mm_sub_ps(cornerY, _mm_set1_ps(sprite.origin[1]));
+        const __m128 localX  = _mm_mul_ps(originX, _mm_set1_ps(sprite.size[0]));
+        const __m128 localY  = _mm_mul_ps(originY, _mm_set1_ps(sprite.size[1]));
+        const __m128 cosines = _mm_set1_ps(cosine);
+        const __m128 sines   = _mm_set1_ps(sine);
+
+        __m128 x = _mm_sub_ps(_mm_mul_ps(localX, cosines), _mm_mul_ps(localY, sines));
+        __m128 y = _mm_add_ps(_mm_mul_ps(localX, sines), _mm_mul_ps(localY, cosines));
+        x        = _mm_add_ps(x, _mm_set1_ps(sprite.position[0]));
+        y        = _mm_add_ps(y, _mm_set1_ps(sprite.position[1]));
+        __m128 u = _mm_setr_ps(sprite.uv[0], sprite.uv[2], sprite.uv[2], sprite.uv[0]);
+        __m128 v = _mm_setr_ps(sprite.uv[1], sprite.uv[1], sprite.uv[3], sprite.uv[3]);
+        _MM_TRANSPOSE4_PS(x, y, u, v);
+
+        const __m128i colorAndLayer =
+            _mm_set_epi32(0, 0, static_cast<int>(sprite.layer), static_cast<int>(sprite.color));
+        SpriteVertex* quad = vertices + i * 4;
+        _mm_storeu_ps(reinterpret_cast<float*>(&quad[0]), x);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&quad[0].color), colorAndLayer);
+        _mm_storeu_ps(reinterpret_cast<float*>(&quad[1]), y);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&quad[1].color), colorAndLayer);
+        _mm_storeu_ps(reinterpret_cast<float*>(&quad[2]), u);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&quad[2].color), colorAndLayer);
+        _mm_storeu_ps(reinterpret_cast<float*>(&quad[3]), v);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&quad[3].color), colorAndLayer);
+    }
+#else
+    constexpr float CORNER_X[4] = {0.0f, 1.0f, 1.0f, 0.0f};
+    constexpr float CORNER_Y[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    for (size_t i = 0; i < count; ++i) {
+        const Sprite& sprite = sprites[i];
+        float         cosine = 1.0f;
+        float         sine   = 0.0f;
+        if (sprite.rotation != 0.0f) {
+            cosine = std::cos(sprite.rotation);
+            sine   = std::sin(sprite.rotation);
+        }
+
+        for (size_t corner = 0; corner < 4; ++corner) {
+            const float   localX = (CORNER_X[corner] - sprite.origin[0]) * sprite.size[0];
+            const float   localY = (CORNER_Y[corner] - sprite.origin[1]) * sprite.size[1];
+            SpriteVertex& vertex = vertices[i * 4 + corner];
+            vertex.position[0]   = localX * cosine - localY * sine + sprite.position[0];
+            vertex.position[1]   = localX * sine + localY * cosine + sprite.position[1];
+            vertex.uv[0]         = CORNER_X[corner] == 0.0f ? sprite.uv[0] : sprite.uv[2];
+            vertex.uv[1]         = CORNER_Y[corner] == 0.0f ? sprite.uv[1] : sprite.uv[3];
+            vertex.color         = sprite.color;
+            vertex.layer         = sprite.layer;
+        }
+    }
+#endif
+}
+
+void drakon::SpriteBatch::prepare(VkCommandBuffer commandBuffer, const RenderContext& context) {
+    DRAKON_TRACE_SCOPE("SpriteBatch::prepare");
+    this->stats = {};
+    if (this->renderer == nullptr || this->frames.empty()) {
+        return;
+    }
+
+    this->frameIndex = context.frameIndex % static_cast<uint32_t>(this->frames.size());
+    Frame& frame     = this->frames[this->frameIndex];
+    frame.ready      = false;
+    this->recordLayerUploads(commandBuffer);
+    if (this->sprites.empty() || context.uploadRing == nullptr) {
+        return;
+    }
+
+    // Maps pixels onto clip space, with y pointing down as it does on screen
+    const std::array<float, 4> screen = {
+        2.0f / static_cast<float>(std::max<uint32_t>(context.extent.width, 1)),
+        2.0f / static_cast<float>(std::max<uint32_t>(context.extent.height, 1)),
+        -1.0f,
+        -1.0f,
+    };
+    const UploadAllocation screenAllocation = context.uploadRing->upload(screen.data(), sizeof(screen));
+    if (!screenAllocation.isValid() || !this->reserveVertices(frame, this->sprites.size())) {
+        return;
+    }
+    frame.uniformOffset = static_cast<uint32_t>(screenAllocation.offset);
+
+    const auto start = std::chrono::steady_clock::now();
+    expandQuads(this->sprites.data(),
+                this->sprites.size(),
+                static_cast<SpriteVertex*>(frame.vertices->allocation.mapped));
+    this->renderer->getGpuAllocator().flush(frame.vertices->allocation);
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    this->stats.sprites            = this->sprites.size();
+    this->stats.expandMilliseconds = elapsed.count();
+    frame.ready                    = true;
+}
+
+bool drakon::SpriteBatch::submit(RenderQueue& queue, const RenderContext& context) {
+    if (this->frames.empty() || !this->frames[this->frameIndex].ready || !this->ensurePipeline(context)) {
+        return true;
+    }
+    const Frame& frame = this->frames[this->frameIndex];
+
+    DrawPacket packet;
+    packet.sortKey            = RenderQueue::makeSortKey(this->pass, this->pipeline->id, 0, 0);
+    packet.pipeline           = this->pipeline->handle;
+    packet.pipelineLayout     = this->pipeline->layout->handle;
+    packet.descriptorSet      = this->descriptorSet;
+    packet.dynamicOffsetCount = 1;
+    packet.dynamicOffset      = frame.uniformOffset;
+    packet.vertexBuffer       = frame.vertices->handle;
+    packet.indexBuffer        = this->indices->handle;
+    packet.indexType          = VK_INDEX_TYPE_UINT32;
+
+    // Chunks share a key, so the queue's stable sort keeps them, and so every sprite, in the order they were added
+    for (size_t first = 0; first < this->sprites.size(); first += SPRITES_PER_DRAW) {
+        const size_t count  = std::min<size_t>(this->sprites.size() - first, SPRITES_PER_DRAW);
+        packet.count        = static_cast<uint32_t>(count * 6);
+        packet.vertexOffset = static_cast<int32_t>(first * 4);
+        queue.submit(packet);
+        ++this->stats.drawCalls;
+    }
+    return true;
+}
+
+const drakon::SpriteBatchStats& drakon::SpriteBatch::getStats() const { return this->stats; }
+
+bool drakon::SpriteBatch::describePipeline(const RenderContext&, GraphicsPipelineDescription& description) const {
+    if (this->vertexSpirv.empty() || this->fragmentSpirv.empty()) {
+        return false;
+    }
+
+    description.stages.resize(2);
+    description.stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    description.stages[0].spirv = this->vertexSpirv;
+    description.stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    description.stages[1].spirv = this->fragmentSpirv;
+
+    description.vertexBindings   = {{0, sizeof(SpriteVertex), VK_VERTEX_INPUT_RATE_VERTEX}};
+    description.vertexAttributes = {
+        {0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(SpriteVertex, position)},
+        {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(SpriteVertex, uv)},
+        {2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(SpriteVertex, color)},
+        {3, 0, VK_FORMAT_R32_UINT, offsetof(SpriteVertex, layer)},
+    };
+    // Negative sizes mirror a sprite, so neither winding may be culled
+    description.cullMode                       = VK_CULL_MODE_NONE;
+    description.colorBlend.blendEnable         = VK_TRUE;
+    description.colorBlend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    description.colorBlend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    description.colorBlend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    description.descriptorSetLayouts           = {this->descriptorSetLayout};
+    return true;
+}
+
+bool drakon::SpriteBatch::reserveVertices(Frame& frame, size_t spriteCount) {
+    if (frame.vertices != nullptr && frame.capacity >= spriteCount) {
+        return true;
+    }
+
+    // Grows geometrically; the old buffer is retired once the frames using it have finished
+    const size_t capacity = std::max({spriteCount, frame.capacity * 2, MIN_VERTEX_CAPACITY});
+    frame.vertices        = this->renderer->getGpuAllocator().createBuffer(
+        VkDeviceSize(capacity) * 4 * sizeof(SpriteVertex),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (frame.vertices == nullptr || frame.vertices->allocation.mapped == nullptr) {
+        std::cerr << "Failed to create sprite vertex buffer for " << spriteCount << " sprites." << std::endl;
+        frame.vertices.reset();
+        frame.capacity = 0;
+        return false;
+    }
+    frame.capacity = capacity;
+    return true;
+}
+
+void drakon::SpriteBatch::recordLayerUploads(VkCommandBuffer commandBuffer) {
+    if (this->texture == nullptr || (this->textureInitialized && this->pendingUploads.empty())) {
+        return;
+    }
+
+    const VkImage image = this->texture->handle;
+    if (this->textureInitialized) {
+        // Earlier frames may still be sampling the texture; waiting on their reads is enough before writing
+        transitionTexture(commandBuffer,
+                          image,
+                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          0,
+                          VK_ACCESS_TRANSFER_WRITE_BIT,
+                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT);
+    } else {
+        transitionTexture(commandBuffer,
+                          image,
+                          VK_IMAGE_LAYOUT_UNDEFINED,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          0,
+                          VK_ACCESS_TRANSFER_WRITE_BIT,
+                          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        VkClearColorValue white = {};
+        std::fill(std::begin(white.float32), std::end(white.float32), 1.0f);
+        VkImageSubresourceRange range = {};
+        range.aspectMask              = VK_IMAGE_ASPECT_COLOR_BIT;
+        range.levelCount              = VK_REMAINING_MIP_LEVELS;
+        range.layerCount              = VK_REMAINING_ARRAY_LAYERS;
+        vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &white, 1, &range);
+
+        // Layer copies below write over the clear
+        transitionTexture(commandBuffer,
+                          image,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          VK_ACCESS_TRANSFER_WRITE_BIT,
+                          VK_ACCESS_TRANSFER_WRITE_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT);
+        this->textureInitialized = true;
+    }
+
+    // Layers that do not fit in this frame's share of the upload ring wait for the next frame
+    UploadRing& uploadRing = this->renderer->getUploadRing();
+    size_t      uploaded   = 0;
+    for (; uploaded < this->pendingUploads.size(); ++uploaded) {
+        const LayerUpload&     upload     = this->pendingUploads[uploaded];
+        const UploadAllocation allocation = uploadRing.allocate(upload.pixels.size(), 16);
+        if (!allocation.isValid()) {
+            break;
+        }
+        std::memcpy(allocation.data, upload.pixels.data(), upload.pixels.size());
+
+        VkBufferImageCopy region               = {};
+        region.bufferOffset                    = allocation.offset;
+        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.baseArrayLayer = upload.layer;
+        region.imageSubresource.layerCount     = 1;
+        region.imageExtent                     = {this->layerWidth, this->layerHeight, 1};
+        vkCmdCopyBufferToImage(
+            commandBuffer, allocation.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+    this->pendingUploads.erase(this->pendingUploads.begin(),
+                               this->pendingUploads.begin() + static_cast<std::ptrdiff_t>(uploaded));
+
+    transitionTexture(commandBuffer,
+                      image,
+                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                      VK_ACCESS_TRANSFER_WRITE_BIT,
+                      VK_ACCESS_SHADER_READ_BIT,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT,
+                      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
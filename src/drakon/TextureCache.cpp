@@ -0,0 +1,888 @@
+#include <drakon/TextureCache.h>
+#include <drakon/Trace.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr std::array<uint8_t, 12> KTX2_IDENTIFIER = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+// Identifier, nine header fields and the index of the data format, key/value and supercompression sections
+constexpr size_t KTX2_HEADER_SIZE = 80;
+constexpr size_t KTX2_LEVEL_SIZE  = 24;
+// A multiple of every block and texel size in the format table, and of the 4 bytes copies require
+constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+constexpr uint32_t     MAX_EXTENT        = 16384;
+constexpr uint32_t     MAX_LAYERS        = 2048;
+
+// KTX2 is little endian, like every platform the engine runs on
+template <class T>
+T readLittleEndian(const std::byte* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+uint32_t mipExtent(uint32_t extent, uint32_t level) { return std::max<uint32_t>(extent >> level, 1); }
+
+uint32_t blockCount(uint32_t extent, uint32_t blockExtent) {
+    return extent / blockExtent + (extent % blockExtent != 0 ? 1 : 0);
+}
+
+// Saturates instead of wrapping, so an oversized level can never pass for a small one
+VkDeviceSize multiplySize(VkDeviceSize size, VkDeviceSize factor) {
+    return factor != 0 && size > UINT64_MAX / factor ? UINT64_MAX : size * factor;
+}
+
+VkDeviceSize alignStaging(VkDeviceSize size) { return (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1); }
+
+VkDeviceSize levelSize(const drakon::Ktx2Image& image, VkFormat format, uint32_t level) {
+    const drakon::TextureFormatInfo info = drakon::getTextureFormatInfo(format);
+
+    VkDeviceSize size = blockCount(mipExtent(image.width, level), info.blockWidth);
+    size              = multiplySize(size, blockCount(mipExtent(image.height, level), info.blockHeight));
+    size              = multiplySize(size, mipExtent(image.depth, level));
+    size              = multiplySize(size, image.layerCount);
+    size              = multiplySize(size, image.faceCount);
+    return multiplySize(size, info.blockBytes);
+}
+
+void expand565(uint16_t color, uint8_t* rgba) {
+    const uint32_t red   = (color >> 11) & 0x1F;
+    const uint32_t green = (color >> 5) & 0x3F;
+    const uint32_t blue  = color & 0x1F;
+    rgba[0]              = static_cast<uint8_t>((red << 3) | (red >> 2));
+    rgba[1]              = static_cast<uint8_t>((green << 2) | (green >> 4));
+    rgba[2]              = static_cast<uint8_t>((blue << 3) | (blue >> 2));
+    rgba[3]              = 255;
+}
+
+// The BC1 color block, which BC2 and BC3 reuse without its punch-through alpha mode
+void decodeColorBlock(const uint8_t* block, bool punchThrough, uint8_t texels[16][4]) {
+    const auto color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+    const auto color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+    uint8_t palette[4][4];
+    expand565(color0, palette[0]);
+    expand565(color1, palette[1]);
+    for (int channel = 0; channel < 3; ++channel) {
+        const uint32_t first  = palette[0][channel];
+        const uint32_t second = palette[1][channel];
+        if (color0 > color1 || !punchThrough) {
+            palette[2][channel] = static_cast<uint8_t>((2 * first + second) / 3);
+            palette[3][channel] = static_cast<uint8_t>((first + 2 * second) / 3);
+        } else {
+            palette[2][channel] = static_cast<uint8_t>((first + second) / 2);
+            palette[3][channel] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = color0 > color1 || !punchThrough ? 255 : 0;
+
+    const uint32_t indices = readLittleEndian<uint32_t>(reinterpret_cast<const std::byte*>(block + 4));
+    for (int i = 0; i < 16; ++i) {
+        std::memcpy(texels[i], palette[(indices >> (2 * i)) & 3], 4);
+    }
+}
+
+// The interpolated single channel block of BC3's alpha and each of BC4's and BC5's channels
+void decodeChannelBlock(const uint8_t* block, uint8_t* texels, size_t stride) {
+    const uint32_t first  = block[0];
+    const uint32_t second = block[1];
+
+    uint8_t palette[8] = {block[0], block[1]};
+    if (first > second) {
+        for (uint32_t i = 1; i < 7; ++i) {
+            palette[i + 1] = static_cast<uint8_t>(((7 - i) * first + i * second) / 7);
+        }
+    } else {
+        for (uint32_t i = 1; i < 5; ++i) {
+            palette[i + 1] = static_cast<uint8_t>(((5 - i) * first + i * second) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= uint64_t(block[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        texels[i * stride] = palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+void decodeBlock(VkFormat format, const uint8_t* block, uint8_t texels[16][4]) {
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        decodeColorBlock(block, true, texels);
+        // Without alpha, the punch-through texel is plain black
+        for (int i = 0; i < 16; ++i) {
+            texels[i][3] = 255;
+        }
+        break;
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        decodeColorBlock(block, true, texels);
+        break;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+        decodeColorBlock(block + 8, false, texels);
+        for (int i = 0; i < 16; ++i) {
+            texels[i][3] = static_cast<uint8_t>(((block[i / 2] >> (4 * (i % 2))) & 0xF) * 17);
+        }
+        break;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        decodeColorBlock(block + 8, false, texels);
+        decodeChannelBlock(block, &texels[0][3], 4);
+        break;
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        decodeChannelBlock(block, &texels[0][0], 4);
+        for (int i = 0; i < 16; ++i) {
+            texels[i][1] = 0;
+            texels[i][2] = 0;
+            texels[i][3] = 255;
+        }
+        break;
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        decodeChannelBlock(block, &texels[0][0], 4);
+        decodeChannelBlock(block + 8, &texels[0][1], 4);
+        for (int i = 0; i < 16; ++i) {
+            texels[i][2] = 0;
+            texels[i][3] = 255;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+VkImageMemoryBarrier& imageBarrier(std::vector<VkImageMemoryBarrier>& barriers,
+                                   VkImage                            image,
+                                   VkImageLayout                      oldLayout,
+                                   VkImageLayout                      newLayout,
+                                   VkAccessFlags                      srcAccess,
+                                   VkAccessFlags                      dstAccess,
+                                   uint32_t                           baseLevel,
+                                   uint32_t                           levelCount) {
+    VkImageMemoryBarrier barrier          = {};
+    barrier.sType                         = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask                 = srcAccess;
+    barrier.dstAccessMask                 = dstAccess;
+    barrier.oldLayout                     = oldLayout;
+    barrier.newLayout                     = newLayout;
+    barrier.srcQueueFamilyIndex           = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex           = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                         = image;
+    barrier.subresourceRange.aspectMask   = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = baseLevel;
+    barrier.subresourceRange.levelCount   = levelCount;
+    barrier.subresourceRange.layerCount   = VK_REMAINING_ARRAY_LAYERS;
+    return barriers.emplace_back(barrier);
+}
+
+void flushBarriers(VkCommandBuffer                    commandBuffer,
+                   std::vector<VkImageMemoryBarrier>& barriers,
+                   VkPipelineStageFlags               srcStage,
+                   VkPipelineStageFlags               dstStage) {
+    if (barriers.empty()) {
+        return;
+    }
+    vkCmdPipelineBarrier(commandBuffer,
+                         srcStage,
+                         dstStage,
+                         0,
+                         0,
+                         nullptr,
+                         0,
+                         nullptr,
+                         static_cast<uint32_t>(barriers.size()),
+                         barriers.data());
+    barriers.clear();
+}
+} // namespace
+
+struct drakon::TextureCache::Entry : drakon::Texture {
+    explicit Entry(std::filesystem::path path) : Texture(std::move(path)) {}
+
+    AssetHandle source;
+    Ktx2Image   header;
+    bool        prepared = false;
+    // The format the image is created with, which differs from the file's when its blocks were decoded
+    VkFormat               format = VK_FORMAT_UNDEFINED;
+    std::vector<std::byte> decoded;
+    std::vector<size_t>    decodedOffsets;
+    uint32_t               mipLevels   = 1;
+    VkDeviceSize           stagingSize = 0;
+
+    const std::byte* levelData(uint32_t level) const {
+        if (!this->decoded.empty()) {
+            return this->decoded.data() + this->decodedOffsets[level];
+        }
+        return this->source->data() + this->header.levels[level].offset;
+    }
+
+    void finish(ImageHandle image) {
+        this->image = std::move(image);
+        this->state = TextureState::Ready;
+        this->release();
+    }
+
+    void fail() {
+        this->image.reset();
+        this->state = TextureState::Failed;
+        this->release();
+    }
+
+  private:
+    void release() {
+        this->source.reset();
+        this->decoded        = {};
+        this->decodedOffsets = {};
+    }
+};
+
+drakon::TextureFormatInfo drakon::getTextureFormatInfo(VkFormat format) {
+    // ASTC formats come in UNORM and SRGB pairs ordered by block size
+    constexpr std::array<std::array<uint32_t, 2>, 14> ASTC_BLOCKS = {{{4, 4},
+                                                                      {5, 4},
+                                                                      {5, 5},
+                                                                      {6, 5},
+                                                                      {6, 6},
+                                                                      {8, 5},
+                                                                      {8, 6},
+                                                                      {8, 8},
+                                                                      {10, 5},
+                                                                      {10, 6},
+                                                                      {10, 8},
+                                                                      {10, 10},
+                                                                      {12, 10},
+                                                                      {12, 12}}};
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) {
+        const auto& block = ASTC_BLOCKS[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+        return {block[0], block[1], 16};
+    }
+
+    switch (format) {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_SRGB:
+        return {1, 1, 1};
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8_SRGB:
+        return {1, 1, 2};
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+    case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+    case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+        return {1, 1, 4};
+    case VK_FORMAT_R16G16B16A16_UNORM:
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+        return {1, 1, 8};
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+        return {1, 1, 16};
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        return {4, 4, 8};
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        return {4, 4, 16};
+    default:
+        return {};
+    }
+}
+
+bool drakon::parseKtx2(const std::byte* data, size_t size, Ktx2Image& image, std::string& error) {
+    image = Ktx2Image();
+    if (size < KTX2_HEADER_SIZE || std::memcmp(data, KTX2_IDENTIFIER.data(), KTX2_IDENTIFIER.size()) != 0) {
+        error = "not a KTX2 file";
+        return false;
+    }
+
+    const std::byte* header   = data + KTX2_IDENTIFIER.size();
+    const auto       vkFormat = readLittleEndian<uint32_t>(header);
+    image.width               = readLittleEndian<uint32_t>(header + 8);
+    // Zero height or depth marks a 1D or 2D texture
+    image.height                 = std::max(readLittleEndian<uint32_t>(header + 12), 1u);
+    image.depth                  = std::max(readLittleEndian<uint32_t>(header + 16), 1u);
+    image.layerCount             = std::max(readLittleEndian<uint32_t>(header + 20), 1u);
+    image.faceCount              = readLittleEndian<uint32_t>(header + 24);
+    const auto levelCount        = readLittleEndian<uint32_t>(header + 28);
+    const auto supercompression  = readLittleEndian<uint32_t>(header + 32);
+    image.format                 = static_cast<VkFormat>(vkFormat);
+    image.generateMips           = levelCount == 0;
+
+    if (supercompression != 0) {
+        error = "supercompressed KTX2 files are not supported";
+        return false;
+    }
+    if (image.format == VK_FORMAT_UNDEFINED) {
+        error = "Basis Universal KTX2 files are not supported";
+        return false;
+    }
+    if (getTextureFormatInfo(image.format).blockBytes == 0) {
+        error = "unsupported format " + std::to_string(vkFormat);
+        return false;
+    }
+    if (image.width == 0 || (image.faceCount != 1 && image.faceCount != 6) ||
+        (image.faceCount == 6 && (image.width != image.height || image.depth != 1))) {
+        error = "invalid dimensions";
+        return false;
+    }
+    if (std::max({image.width, image.height, image.depth}) > MAX_EXTENT || image.layerCount > MAX_LAYERS) {
+        error = "dimensions too large";
+        return false;
+    }
+    const uint32_t fullChain = std::bit_width(std::max({image.width, image.height, image.depth}));
+    if (levelCount > fullChain) {
+        error = "more mip levels than the dimensions allow";
+        return false;
+    }
+
+    const uint32_t storedLevels = std::max(levelCount, 1u);
+    if (size < KTX2_HEADER_SIZE + storedLevels * KTX2_LEVEL_SIZE) {
+        error = "truncated level index";
+        return false;
+    }
+    image.levels.resize(storedLevels);
+    for (uint32_t level = 0; level < storedLevels; ++level) {
+        const std::byte* entry = data + KTX2_HEADER_SIZE + level * KTX2_LEVEL_SIZE;
+        image.levels[level]    = {readLittleEndian<uint64_t>(entry), readLittleEndian<uint64_t>(entry + 8)};
+        if (image.levels[level].offset > size || image.levels[level].size > size - image.levels[level].offset) {
+            error = "level " + std::to_string(level) + " runs past the end of the file";
+            return false;
+        }
+        if (image.levels[level].size < levelSize(image, image.format, level)) {
+            error = "level " + std::to_string(level) + " is smaller than its dimensions need";
+            return false;
+        }
+    }
+    return true;
+}
+
+VkFormat drakon::getDecodedFormat(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        return VK_FORMAT_R8G8B8A8_UNORM;
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        return VK_FORMAT_R8G8B8A8_SRGB;
+    default:
+        return VK_FORMAT_UNDEFINED;
+    }
+}
+
+bool drakon::decodeBlockCompressed(
+    VkFormat format, uint32_t width, uint32_t height, const std::byte* blocks, uint8_t* rgba) {
+    if (getDecodedFormat(format) == VK_FORMAT_UNDEFINED) {
+        return false;
+    }
+
+    const uint32_t blockBytes = getTextureFormatInfo(format).blockBytes;
+    const uint32_t columns    = blockCount(width, 4);
+    const uint32_t rows       = blockCount(height, 4);
+    const auto*    block      = reinterpret_cast<const uint8_t*>(blocks);
+    uint8_t        texels[16][4];
+    for (uint32_t row = 0; row < rows; ++row) {
+        for (uint32_t column = 0; column < columns; ++column, block += blockBytes) {
+            decodeBlock(format, block, texels);
+            // Blocks on the right and bottom edges overhang images that are not a multiple of four
+            for (uint32_t y = 0; y < 4 && row * 4 + y < height; ++y) {
+                for (uint32_t x = 0; x < 4 && column * 4 + x < width; ++x) {
+                    std::memcpy(rgba + (size_t(row * 4 + y) * width + column * 4 + x) * 4, texels[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+const std::filesystem::path& drakon::Texture::getPath() const { return this->path; }
+
+drakon::TextureState drakon::Texture::getState() const { return this->state; }
+
+bool drakon::Texture::isReady() const { return this->state == TextureState::Ready; }
+
+const drakon::ImageHandle& drakon::Texture::getImage() const { return this->image; }
+
+bool drakon::TextureCache::init(VkPhysicalDevice                physicalDevice,
+                                VkDevice                        device,
+                                GpuAllocator&                   allocator,
+                                const VkPhysicalDeviceFeatures& enabledFeatures) {
+    this->physicalDevice = physicalDevice;
+    this->device         = device;
+    this->allocator      = &allocator;
+    this->features       = enabledFeatures;
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType               = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter           = VK_FILTER_LINEAR;
+    samplerInfo.minFilter           = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode          = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW        = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.maxLod              = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &this->sampler) != VK_SUCCESS) {
+        std::cerr << "Failed to create texture sampler." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void drakon::TextureCache::cleanup() {
+    for (auto& [path, weak] : this->entries) {
+        if (std::shared_ptr<Entry> entry = weak.lock()) {
+            entry->fail();
+        }
+    }
+    this->entries.clear();
+    this->pending.clear();
+    this->transfers.clear();
+    this->transferQueue = nullptr;
+    if (this->sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(this->device, this->sampler, nullptr);
+        this->sampler = VK_NULL_HANDLE;
+    }
+    this->device    = VK_NULL_HANDLE;
+    this->allocator = nullptr;
+}
+
+void drakon::TextureCache::setAssetLoader(AssetLoader* loader) { this->assetLoader = loader; }
+
+drakon::TextureHandle drakon::TextureCache::load(const std::filesystem::path& path, AssetPriority priority) {
+    std::weak_ptr<Entry>&  slot  = this->entries[path.lexically_normal().string()];
+    std::shared_ptr<Entry> entry = slot.lock();
+    if (entry != nullptr && entry->getState() != TextureState::Failed) {
+        return entry;
+    }
+
+    entry = std::make_shared<Entry>(path);
+    slot  = entry;
+    if (this->assetLoader == nullptr) {
+        this->fail(*entry, "no asset loader to read it with");
+        return entry;
+    }
+    entry->source = this->assetLoader->load(path, priority);
+    this->pending.push_back(entry);
+    return entry;
+}
+
+void drakon::TextureCache::setTransferQueue(TransferQueue* queue) { this->transferQueue = queue; }
+
+void drakon::TextureCache::setUploadBudget(VkDeviceSize bytesPerFrame) { this->uploadBudget = bytesPerFrame; }
+
+bool drakon::TextureCache::isFormatSupported(VkFormat format) const {
+    if (this->physicalDevice == VK_NULL_HANDLE) {
+        return false;
+    }
+    // Compressed families can only be sampled with their device feature enabled, whatever the format reports
+    if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK &&
+        !this->features.textureCompressionBC) {
+        return false;
+    }
+    if (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK &&
+        !this->features.textureCompressionETC2) {
+        return false;
+    }
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK &&
+        !this->features.textureCompressionASTC_LDR) {
+        return false;
+    }
+
+    VkFormatProperties properties = {};
+    vkGetPhysicalDeviceFormatProperties(this->physicalDevice, format, &properties);
+    return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+VkSampler drakon::TextureCache::getSampler() const { return this->sampler; }
+
+drakon::TextureCacheStats drakon::TextureCache::getStats() const { return this->stats; }
+
+void drakon::TextureCache::fail(Entry& entry, const std::string& message) {
+    std::cerr << "Failed to load texture " << entry.getPath() << ": " << message << std::endl;
+    entry.fail();
+    ++this->stats.failed;
+}
+
+bool drakon::TextureCache::prepare(Entry& entry) {
+    entry.prepared = true;
+    if (entry.source->getState() != AssetState::Loaded) {
+        this->fail(entry, entry.source->getError());
+        return false;
+    }
+    std::string error;
+    if (!parseKtx2(entry.source->data(), entry.source->size(), entry.header, error)) {
+        this->fail(entry, error);
+        return false;
+    }
+
+    const Ktx2Image& header = entry.header;
+    const auto       levels = static_cast<uint32_t>(header.levels.size());
+    entry.format            = header.format;
+    if (!this->isFormatSupported(header.format)) {
+        const VkFormat decodedFormat = getDecodedFormat(header.format);
+        if (decodedFormat == VK_FORMAT_UNDEFINED || !this->isFormatSupported(decodedFormat)) {
+            this->fail(entry, "the device cannot sample format " + std::to_string(header.format));
+            return false;
+        }
+
+        entry.format = decodedFormat;
+        entry.decodedOffsets.resize(levels);
+        size_t decodedSize = 0;
+        for (uint32_t level = 0; level < levels; ++level) {
+            entry.decodedOffsets[level] = decodedSize;
+            decodedSize += levelSize(header, decodedFormat, level);
+        }
+        entry.decoded.resize(decodedSize);
+
+        const TextureFormatInfo info = getTextureFormatInfo(header.format);
+        for (uint32_t level = 0; level < levels; ++level) {
+            const uint32_t   width      = mipExtent(header.width, level);
+            const uint32_t   height     = mipExtent(header.height, level);
+            const uint32_t   slices     = mipExtent(header.depth, level) * header.layerCount * header.faceCount;
+            const size_t     sliceBytes = size_t(blockCount(width, 4)) * blockCount(height, 4) * info.blockBytes;
+            const std::byte* blocks     = entry.source->data() + header.levels[level].offset;
+            auto*            rgba       = reinterpret_cast<uint8_t*>(&entry.decoded[entry.decodedOffsets[level]]);
+            for (uint32_t slice = 0; slice < slices; ++slice) {
+                decodeBlockCompressed(header.format,
+                                      width,
+                                      height,
+                                      blocks + slice * sliceBytes,
+                                      rgba + size_t(slice) * width * height * 4);
+            }
+        }
+        ++this->stats.decoded;
+    }
+
+    entry.mipLevels = levels;
+    if (header.generateMips) {
+        // Blits cannot write compressed formats, so those keep their one level
+        VkFormatProperties properties = {};
+        vkGetPhysicalDeviceFormatProperties(this->physicalDevice, entry.format, &properties);
+        const VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                          VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if (!getTextureFormatInfo(entry.format).isCompressed() && (properties.optimalTilingFeatures & blit) == blit) {
+            entry.mipLevels = std::bit_width(std::max({header.width, header.height, header.depth}));
+        }
+    }
+
+    entry.stagingSize = 0;
+    for (uint32_t level = 0; level < levels; ++level) {
+        entry.stagingSize += alignStaging(levelSize(header, entry.format, level));
+    }
+    return true;
+}
+
+void drakon::TextureCache::recordUploads(VkCommandBuffer commandBuffer) {
+    if (this->allocator == nullptr || (this->pending.empty() && this->transfers.empty())) {
+        return;
+    }
+    DRAKON_TRACE_SCOPE("TextureCache::recordUploads");
+
+    // Copies that landed on the transfer queue become usable this frame, in submission order
+    while (!this->transfers.empty() && this->transferQueue->isComplete(this->transfers.front().transferValue)) {
+        this->finishUploads(commandBuffer, this->transfers.front(), true);
+        this->transferQueue->addGraphicsWait(this->transfers.front().transferValue);
+        this->transfers.pop_front();
+    }
+
+    Batch batch;
+    if (!this->stage(batch)) {
+        return;
+    }
+    ++this->stats.uploadBatches;
+
+    if (this->transferQueue != nullptr && this->transferQueue->isAvailable()) {
+        const VkCommandBuffer transferCommands = this->transferQueue->begin();
+        if (transferCommands != VK_NULL_HANDLE) {
+            this->recordCopies(transferCommands, batch, true);
+            batch.transferValue = this->transferQueue->submit(transferCommands);
+            if (batch.transferValue != 0) {
+                ++this->stats.transferBatches;
+                this->transfers.push_back(std::move(batch));
+                return;
+            }
+        }
+    }
+    this->recordCopies(commandBuffer, batch, false);
+    this->finishUploads(commandBuffer, batch, false);
+}
+
+bool drakon::TextureCache::stage(Batch& batch) {
+    std::vector<std::shared_ptr<Entry>> ready;
+    VkDeviceSize                        stagingSize = 0;
+    for (auto it = this->pending.begin(); it != this->pending.end();) {
+        Entry& entry = **it;
+        if (it->use_count() == 1) {
+            it = this->pending.erase(it);
+            continue;
+        }
+        if (!entry.source->isReady()) {
+            ++it;
+            continue;
+        }
+        if (!entry.prepared && !this->prepare(entry)) {
+            it = this->pending.erase(it);
+            continue;
+        }
+        if (!ready.empty() && stagingSize + entry.stagingSize > this->uploadBudget) {
+            break;
+        }
+        stagingSize += entry.stagingSize;
+        ready.push_back(std::move(*it));
+        it = this->pending.erase(it);
+    }
+    if (ready.empty()) {
+        return false;
+    }
+
+    batch.staging = this->allocator->createBuffer(
+        stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+    if (batch.staging == nullptr || batch.staging->allocation.mapped == nullptr) {
+        // Out of host memory is worth retrying next frame rather than failing every texture
+        std::cerr << "Failed to create a " << stagingSize << " byte texture staging buffer." << std::endl;
+        this->pending.insert(this->pending.begin(), ready.begin(), ready.end());
+        return false;
+    }
+
+    VkDeviceSize offset = 0;
+    for (auto& entry : ready) {
+        const Ktx2Image& header = entry->header;
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType         = header.depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
+        imageInfo.format            = entry->format;
+        imageInfo.extent            = {header.width, header.height, header.depth};
+        imageInfo.mipLevels         = entry->mipLevels;
+        imageInfo.arrayLayers       = header.layerCount * header.faceCount;
+        imageInfo.samples           = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling            = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage             = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (entry->mipLevels > header.levels.size()) {
+            imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+        // Cube arrays need a device feature to view as such, so they are viewed as plain arrays of faces
+        VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_MAX_ENUM;
+        if (header.faceCount == 6 && header.layerCount == 1) {
+            imageInfo.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+            viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+        }
+
+        ImageHandle image = this->allocator->createImage(
+            imageInfo, VK_IMAGE_ASPECT_COLOR_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, viewType);
+        if (image == nullptr) {
+            this->fail(*entry, "could not create the image");
+            continue;
+        }
+
+        Upload upload;
+        for (uint32_t level = 0; level < header.levels.size(); ++level) {
+            const VkDeviceSize size = levelSize(header, entry->format, level);
+            std::memcpy(
+                static_cast<std::byte*>(batch.staging->allocation.mapped) + offset, entry->levelData(level), size);
+
+            VkBufferImageCopy region           = {};
+            region.bufferOffset                = offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel   = level;
+            region.imageSubresource.layerCount = imageInfo.arrayLayers;
+            region.imageExtent                 = {
+                mipExtent(header.width, level), mipExtent(header.height, level), mipExtent(header.depth, level)};
+            upload.regions.push_back(region);
+            offset += alignStaging(size);
+            this->stats.bytesUploaded += size;
+        }
+        for (uint32_t level = 0; level < entry->mipLevels; ++level) {
+            this->stats.uncompressedBytes += levelSize(header, VK_FORMAT_R8G8B8A8_UNORM, level);
+        }
+        upload.entry = std::move(entry);
+        upload.image = std::move(image);
+        batch.uploads.push_back(std::move(upload));
+    }
+    this->allocator->flush(batch.staging->allocation);
+    return !batch.uploads.empty();
+}
+
+void drakon::TextureCache::recordCopies(VkCommandBuffer commandBuffer, const Batch& batch, bool release) {
+    std::vector<VkImageMemoryBarrier> barriers;
+    for (const Upload& upload : batch.uploads) {
+        imageBarrier(barriers,
+                     upload.image->handle,
+                     VK_IMAGE_LAYOUT_UNDEFINED,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     0,
+                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                     0,
+                     VK_REMAINING_MIP_LEVELS);
+    }
+    flushBarriers(commandBuffer, barriers, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    for (const Upload& upload : batch.uploads) {
+        vkCmdCopyBufferToImage(commandBuffer,
+                               batch.staging->handle,
+                               upload.image->handle,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(upload.regions.size()),
+                               upload.regions.data());
+    }
+    if (!release) {
+        return;
+    }
+
+    // Hands the images to the graphics family. Images still missing mips stay transfer destinations for the blits
+    for (const Upload& upload : batch.uploads) {
+        VkImageMemoryBarrier& barrier = imageBarrier(barriers,
+                                                     upload.image->handle,
+                                                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                     upload.getReleasedLayout(),
+                                                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                     0,
+                                                     0,
+                                                     VK_REMAINING_MIP_LEVELS);
+        barrier.srcQueueFamilyIndex   = this->transferQueue->getFamily();
+        barrier.dstQueueFamilyIndex   = this->transferQueue->getGraphicsFamily();
+    }
+    flushBarriers(commandBuffer, barriers, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+}
+
+void drakon::TextureCache::finishUploads(VkCommandBuffer commandBuffer, Batch& batch, bool acquire) {
+    constexpr VkPipelineStageFlags SHADER_STAGES = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                                   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    std::vector<VkImageMemoryBarrier> barriers;
+
+    // The acquiring half of the transfer queue's release, with the same layouts
+    if (acquire) {
+        for (const Upload& upload : batch.uploads) {
+            const VkAccessFlags access = upload.isGeneratingMips()
+                                             ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT
+                                             : VK_ACCESS_SHADER_READ_BIT;
+            VkImageMemoryBarrier& barrier = imageBarrier(barriers,
+                                                         upload.image->handle,
+                                                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                         upload.getReleasedLayout(),
+                                                         0,
+                                                         access,
+                                                         0,
+                                                         VK_REMAINING_MIP_LEVELS);
+            barrier.srcQueueFamilyIndex   = this->transferQueue->getFamily();
+            barrier.dstQueueFamilyIndex   = this->transferQueue->getGraphicsFamily();
+        }
+        // Chains with the frame submit's wait on the transfer timeline, which blocks the transfer stage
+        flushBarriers(commandBuffer,
+                      barriers,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT | SHADER_STAGES);
+    }
+
+    for (const Upload& upload : batch.uploads) {
+        if (!upload.isGeneratingMips()) {
+            continue;
+        }
+        const Image&   image      = *upload.image;
+        const uint32_t firstLevel = static_cast<uint32_t>(upload.regions.size());
+        const uint32_t layerCount = upload.regions.front().imageSubresource.layerCount;
+        for (uint32_t level = firstLevel; level < image.mipLevels; ++level) {
+            imageBarrier(barriers,
+                         image.handle,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_ACCESS_TRANSFER_READ_BIT,
+                         level - 1,
+                         1);
+            flushBarriers(commandBuffer, barriers, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+            VkImageBlit blit                   = {};
+            blit.srcSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.srcSubresource.mipLevel       = level - 1;
+            blit.srcSubresource.layerCount     = layerCount;
+            blit.srcOffsets[1]                 = {static_cast<int32_t>(mipExtent(image.extent.width, level - 1)),
+                                                  static_cast<int32_t>(mipExtent(image.extent.height, level - 1)),
+                                                  static_cast<int32_t>(mipExtent(image.extent.depth, level - 1))};
+            blit.dstSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.dstSubresource.mipLevel       = level;
+            blit.dstSubresource.layerCount     = layerCount;
+            blit.dstOffsets[1]                 = {static_cast<int32_t>(mipExtent(image.extent.width, level)),
+                                                  static_cast<int32_t>(mipExtent(image.extent.height, level)),
+                                                  static_cast<int32_t>(mipExtent(image.extent.depth, level))};
+            vkCmdBlitImage(commandBuffer,
+                           image.handle,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           image.handle,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1,
+                           &blit,
+                           VK_FILTER_LINEAR);
+        }
+        ++this->stats.mipsGenerated;
+    }
+
+    // Generated chains end with every level but the last as a transfer source. Acquired images without generated
+    // mips are already shader readable
+    for (const Upload& upload : batch.uploads) {
+        const Image&   image   = *upload.image;
+        const uint32_t sources = upload.isGeneratingMips() ? image.mipLevels - 1 : 0;
+        if (sources > 0) {
+            imageBarrier(barriers,
+                         image.handle,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_ACCESS_TRANSFER_READ_BIT,
+                         VK_ACCESS_SHADER_READ_BIT,
+                         0,
+                         sources);
+        }
+        if (!acquire || upload.isGeneratingMips()) {
+            imageBarrier(barriers,
+                         image.handle,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_ACCESS_SHADER_READ_BIT,
+                         sources,
+                         image.mipLevels - sources);
+        }
+    }
+    flushBarriers(commandBuffer, barriers, VK_PIPELINE_STAGE_TRANSFER_BIT, SHADER_STAGES);
+
+    for (Upload& upload : batch.uploads) {
+        upload.entry->finish(std::move(upload.image));
+        ++this->stats.textures;
+    }
+}
@@ -0,0 +1,233 @@
+#include <drakon/TlsfAllocator.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+// Remainders smaller than this stay attached to the allocation instead of becoming their own free block
+constexpr uint64_t MIN_SPLIT_SIZE = 16;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+} // namespace
+
+drakon::TlsfAllocator::TlsfAllocator(uint64_t size) : size(size) {
+    for (auto& lists : this->freeLists) {
+        lists.fill(NONE);
+    }
+    if (size > 0) {
+        this->insertFreeBlock(this->createBlock(0, size));
+    }
+}
+
+std::optional<uint64_t> drakon::TlsfAllocator::allocate(uint64_t size, uint64_t alignment) {
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment == 0) {
+        alignment = 1;
+    }
+    if (size > this->size || alignment > this->size) {
+        return std::nullopt;
+    }
+
+    // Searching for the worst-case padding up front means any block we find can hold the aligned allocation
+    const uint64_t searchSize = size + alignment - 1;
+    uint32_t       index      = this->findFreeBlock(searchSize);
+    if (index == NONE) {
+        return std::nullopt;
+    }
+    this->removeFreeBlock(index);
+
+    const uint64_t padding = alignUp(this->blocks[index].offset, alignment) - this->blocks[index].offset;
+    if (padding > 0) {
+        const uint32_t alignedIndex = this->splitBlock(index, padding);
+        this->insertFreeBlock(index);
+        index = alignedIndex;
+    }
+    if (this->blocks[index].size - size >= MIN_SPLIT_SIZE) {
+        this->insertFreeBlock(this->splitBlock(index, size));
+    }
+
+    Block& block = this->blocks[index];
+    block.free   = false;
+    this->allocatedBlocks.emplace(block.offset, index);
+    this->usedBytes += block.size;
+    ++this->allocationCount;
+    return block.offset;
+}
+
+bool drakon::TlsfAllocator::free(uint64_t offset) {
+    const auto found = this->allocatedBlocks.find(offset);
+    if (found == this->allocatedBlocks.end()) {
+        return false;
+    }
+    uint32_t index = found->second;
+    this->allocatedBlocks.erase(found);
+    this->usedBytes -= this->blocks[index].size;
+    --this->allocationCount;
+
+    const uint32_t previous = this->blocks[index].previousPhys;
+    if (previous != NONE && this->blocks[previous].free) {
+        this->removeFreeBlock(previous);
+        this->blocks[previous].size += this->blocks[index].size;
+        this->blocks[previous].nextPhys = this->blocks[index].nextPhys;
+        if (this->blocks[index].nextPhys != NONE) {
+            this->blocks[this->blocks[index].nextPhys].previousPhys = previous;
+        }
+        this->releaseBlock(index);
+        index = previous;
+    }
+
+    const uint32_t next = this->blocks[index].nextPhys;
+    if (next != NONE && this->blocks[next].free) {
+        this->removeFreeBlock(next);
+        this->blocks[index].size += this->blocks[next].size;
+        this->blocks[index].nextPhys = this->blocks[next].nextPhys;
+        if (this->blocks[next].nextPhys != NONE) {
+            this->blocks[this->blocks[next].nextPhys].previousPhys = index;
+        }
+        this->releaseBlock(next);
+    }
+
+    this->insertFreeBlock(index);
+    return true;
+}
+
+uint64_t drakon::TlsfAllocator::getSize() const { return this->size; }
+
+uint64_t drakon::TlsfAllocator::getUsedBytes() const { return this->usedBytes; }
+
+uint64_t drakon::TlsfAllocator::getAllocationCount() const { return this->allocationCount; }
+
+uint64_t drakon::TlsfAllocator::getLargestFreeBlock() const {
+    if (this->flBitmap == 0) {
+        return 0;
+    }
+    const uint32_t fl = 63 - static_cast<uint32_t>(std::countl_zero(this->flBitmap));
+    const uint32_t sl = 31 - static_cast<uint32_t>(std::countl_zero(this->slBitmaps[fl]));
+
+    uint64_t largest = 0;
+    for (uint32_t index = this->freeLists[fl][sl]; index != NONE; index = this->blocks[index].nextFree) {
+        largest = std::max(largest, this->blocks[index].size);
+    }
+    return largest;
+}
+
+bool drakon::TlsfAllocator::isEmpty() const { return this->allocationCount == 0; }
+
+void drakon::TlsfAllocator::mapping(uint64_t size, uint32_t& fl, uint32_t& sl) {
+    if (size < SL_COUNT) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size);
+        return;
+    }
+    const uint32_t log2 = 63 - static_cast<uint32_t>(std::countl_zero(size));
+    fl                  = log2 - SL_LOG2 + 1;
+    sl                  = static_cast<uint32_t>(size >> (log2 - SL_LOG2)) - SL_COUNT;
+}
+
+uint32_t drakon::TlsfAllocator::findFreeBlock(uint64_t size) const {
+    // Round up to the next class so every block in the list we pick is large enough
+    if (size >= SL_COUNT) {
+        const uint32_t log2  = 63 - static_cast<uint32_t>(std::countl_zero(size));
+        const uint64_t round = (uint64_t(1) << (log2 - SL_LOG2)) - 1;
+        if (size > UINT64_MAX - round) {
+            return NONE;
+        }
+        size += round;
+    }
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(size, fl, sl);
+
+    uint32_t slMap = sl < 32 ? this->slBitmaps[fl] & (~0u << sl) : 0;
+    if (slMap == 0) {
+        const uint64_t flMap = fl + 1 < 64 ? this->flBitmap & (~uint64_t(0) << (fl + 1)) : 0;
+        if (flMap == 0) {
+            return NONE;
+        }
+        fl    = static_cast<uint32_t>(std::countr_zero(flMap));
+        slMap = this->slBitmaps[fl];
+    }
+    sl = static_cast<uint32_t>(std::countr_zero(slMap));
+    return this->freeLists[fl][sl];
+}
+
+uint32_t drakon::TlsfAllocator::createBlock(uint64_t offset, uint64_t size) {
+    uint32_t index = 0;
+    if (!this->unusedBlocks.empty()) {
+        index = this->unusedBlocks.back();
+        this->unusedBlocks.pop_back();
+    } else {
+        index = static_cast<uint32_t>(this->blocks.size());
+        this->blocks.emplace_back();
+    }
+    this->blocks[index]        = {};
+    this->blocks[index].offset = offset;
+    this->blocks[index].size   = size;
+    return index;
+}
+
+void drakon::TlsfAllocator::releaseBlock(uint32_t index) { this->unusedBlocks.push_back(index); }
+
+void drakon::TlsfAllocator::insertFreeBlock(uint32_t index) {
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(this->blocks[index].size, fl, sl);
+
+    Block& block       = this->blocks[index];
+    block.free         = true;
+    block.previousFree = NONE;
+    block.nextFree     = this->freeLists[fl][sl];
+    if (block.nextFree != NONE) {
+        this->blocks[block.nextFree].previousFree = index;
+    }
+    this->freeLists[fl][sl] = index;
+    this->slBitmaps[fl] |= 1u << sl;
+    this->flBitmap |= uint64_t(1) << fl;
+}
+
+void drakon::TlsfAllocator::removeFreeBlock(uint32_t index) {
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(this->blocks[index].size, fl, sl);
+
+    Block& block = this->blocks[index];
+    if (block.previousFree != NONE) {
+        this->blocks[block.previousFree].nextFree = block.nextFree;
+    } else {
+        this->freeLists[fl][sl] = block.nextFree;
+    }
+    if (block.nextFree != NONE) {
+        this->blocks[block.nextFree].previousFree = block.previousFree;
+    }
+    block.free         = false;
+    block.previousFree = NONE;
+    block.nextFree     = NONE;
+
+    if (this->freeLists[fl][sl] == NONE) {
+        this->slBitmaps[fl] &= ~(1u << sl);
+        if (this->slBitmaps[fl] == 0) {
+            this->flBitmap &= ~(uint64_t(1) << fl);
+        }
+    }
+}
+
+uint32_t drakon::TlsfAllocator::splitBlock(uint32_t index, uint64_t size) {
+    const uint64_t remainderOffset = this->blocks[index].offset + size;
+    const uint64_t remainderSize   = this->blocks[index].size - size;
+    const uint32_t remainder       = this->createBlock(remainderOffset, remainderSize);
+
+    // createBlock may grow the vector, so only take references afterwards
+    Block& block       = this->blocks[index];
+    Block& split       = this->blocks[remainder];
+    split.previousPhys = index;
+    split.nextPhys     = block.nextPhys;
+    if (block.nextPhys != NONE) {
+        this->blocks[block.nextPhys].previousPhys = remainder;
+    }
+    block.nextPhys = remainder;
+    block.size     = size;
+    return remainder;
+}
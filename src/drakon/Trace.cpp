@@ -0,0 +1,162 @@
+#include <drakon/Trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr uint64_t EVENTS_PER_THREAD = uint64_t(1) << 16;
+
+struct ThreadBuffer {
+    std::vector<drakon::TraceEvent> events = std::vector<drakon::TraceEvent>(EVENTS_PER_THREAD);
+    // Only the owning thread writes; readers use the count to find the live window of the ring
+    std::atomic<uint64_t> written  = 0;
+    uint32_t              threadId = 0;
+    std::string           threadName;
+};
+
+struct TraceRegistry {
+    std::mutex                                 mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::chrono::steady_clock::time_point      epoch = std::chrono::steady_clock::now();
+};
+
+TraceRegistry& traceRegistry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+// Buffers outlive their threads so events from finished workers still make it into the export
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        TraceRegistry&              registry = traceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto                        created = std::make_unique<ThreadBuffer>();
+        created->threadId                   = static_cast<uint32_t>(registry.buffers.size() + 1);
+        buffer                              = created.get();
+        registry.buffers.push_back(std::move(created));
+    }
+    return *buffer;
+}
+
+void writeJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c != '\0'; ++c) {
+        switch (*c) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(*c));
+                out << escaped;
+            } else {
+                out << *c;
+            }
+        }
+    }
+    out << '"';
+}
+
+void writeMicroseconds(std::ostream& out, int64_t nanoseconds) {
+    char formatted[32];
+    std::snprintf(formatted, sizeof(formatted), "%.3f", static_cast<double>(nanoseconds) / 1000.0);
+    out << formatted;
+}
+} // namespace
+
+void drakon::Trace::enable() {
+    // Fix the epoch before the first event so timestamps start near zero
+    traceRegistry();
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void drakon::Trace::disable() { enabled.store(false, std::memory_order_relaxed); }
+
+void drakon::Trace::setThreadName(const char* name) {
+    ThreadBuffer&               buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(traceRegistry().mutex);
+    buffer.threadName = name;
+}
+
+int64_t drakon::Trace::now() {
+    const auto elapsed = std::chrono::steady_clock::now() - traceRegistry().epoch;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void drakon::Trace::record(const char* name, int64_t start, int64_t end) {
+    ThreadBuffer&  buffer  = threadBuffer();
+    const uint64_t written = buffer.written.load(std::memory_order_relaxed);
+
+    TraceEvent& event = buffer.events[written % EVENTS_PER_THREAD];
+    event.name        = name;
+    event.start       = start;
+    event.duration    = end - start;
+    buffer.written.store(written + 1, std::memory_order_release);
+}
+
+bool drakon::Trace::writeChromeJson(const std::filesystem::path& path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open trace file for writing: " << path << std::endl;
+        return false;
+    }
+
+    TraceRegistry&              registry = traceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool                    first = true;
+    std::vector<TraceEvent> events;
+    for (const auto& buffer : registry.buffers) {
+        const uint64_t end   = buffer->written.load(std::memory_order_acquire);
+        const uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+        events.clear();
+        for (uint64_t i = begin; i < end; ++i) {
+            events.push_back(buffer->events[i % EVENTS_PER_THREAD]);
+        }
+
+        // Threads keep recording while we copy; anything they lapped in the meantime may be torn, so drop it
+        const uint64_t writtenAfterCopy = buffer->written.load(std::memory_order_acquire);
+        const uint64_t firstIntact = writtenAfterCopy > EVENTS_PER_THREAD ? writtenAfterCopy - EVENTS_PER_THREAD : 0;
+        const size_t   skipped     = static_cast<size_t>(std::clamp(firstIntact, begin, end) - begin);
+
+        if (!buffer->threadName.empty()) {
+            file << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                 << buffer->threadId << ",\"args\":{\"name\":";
+            writeJsonString(file, buffer->threadName.c_str());
+            file << "}}";
+            first = false;
+        }
+
+        for (size_t i = skipped; i < events.size(); ++i) {
+            const TraceEvent& event = events[i];
+            file << (first ? "" : ",") << "\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"name\":";
+            writeJsonString(file, event.name != nullptr ? event.name : "");
+            file << ",\"ts\":";
+            writeMicroseconds(file, event.start);
+            file << ",\"dur\":";
+            writeMicroseconds(file, event.duration);
+            file << "}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+
+    if (!file.flush()) {
+        std::cerr << "Failed to write trace file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
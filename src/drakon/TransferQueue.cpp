@@ -0,0 +1,181 @@
+#include <drakon/TransferQueue.h>
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+bool drakon::TransferQueue::init(VkDevice device, uint32_t family, uint32_t graphicsFamily) {
+    this->device          = device;
+    this->family          = family;
+    this->graphicsFamily  = graphicsFamily;
+    this->getCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+        vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+    this->waitSemaphores =
+        reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+    if (this->getCounterValue == nullptr || this->waitSemaphores == nullptr) {
+        std::cerr << "Failed to load Vulkan timeline semaphore functions." << std::endl;
+        this->cleanup();
+        return false;
+    }
+    vkGetDeviceQueue(device, family, 0, &this->queue);
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex        = family;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &this->commandPool) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan transfer command pool." << std::endl;
+        this->cleanup();
+        return false;
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo = {};
+    typeInfo.sType                     = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue              = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext                 = &typeInfo;
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &this->timeline) != VK_SUCCESS) {
+        std::cerr << "Failed to create Vulkan transfer timeline semaphore." << std::endl;
+        this->cleanup();
+        return false;
+    }
+
+    this->nextValue      = 1;
+    this->completedValue = 0;
+    this->graphicsWait   = 0;
+    return true;
+}
+
+void drakon::TransferQueue::cleanup() {
+    if (this->device != VK_NULL_HANDLE) {
+        // Destroying the pool frees every command buffer allocated from it
+        if (this->commandPool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(this->device, this->commandPool, nullptr);
+        }
+        if (this->timeline != VK_NULL_HANDLE) {
+            vkDestroySemaphore(this->device, this->timeline, nullptr);
+        }
+    }
+    this->submitted.clear();
+    this->commandPool     = VK_NULL_HANDLE;
+    this->timeline        = VK_NULL_HANDLE;
+    this->queue           = VK_NULL_HANDLE;
+    this->device          = VK_NULL_HANDLE;
+    this->getCounterValue = nullptr;
+    this->waitSemaphores  = nullptr;
+}
+
+bool drakon::TransferQueue::isAvailable() const { return this->timeline != VK_NULL_HANDLE; }
+
+uint32_t drakon::TransferQueue::getFamily() const { return this->family; }
+
+uint32_t drakon::TransferQueue::getGraphicsFamily() const { return this->graphicsFamily; }
+
+VkCommandBuffer drakon::TransferQueue::begin() {
+    if (!this->isAvailable()) {
+        return VK_NULL_HANDLE;
+    }
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    if (!this->submitted.empty() && this->isComplete(this->submitted.front().value)) {
+        commandBuffer = this->submitted.front().commandBuffer;
+        this->submitted.pop_front();
+        vkResetCommandBuffer(commandBuffer, 0);
+    } else {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool                 = this->commandPool;
+        allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount          = 1;
+        if (vkAllocateCommandBuffers(this->device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            std::cerr << "Failed to allocate Vulkan transfer command buffer." << std::endl;
+            return VK_NULL_HANDLE;
+        }
+        ++this->stats.commandBuffers;
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        std::cerr << "Failed to begin Vulkan transfer command buffer." << std::endl;
+        vkFreeCommandBuffers(this->device, this->commandPool, 1, &commandBuffer);
+        --this->stats.commandBuffers;
+        return VK_NULL_HANDLE;
+    }
+    return commandBuffer;
+}
+
+uint64_t drakon::TransferQueue::submit(VkCommandBuffer commandBuffer) {
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        std::cerr << "Failed to record Vulkan transfer command buffer." << std::endl;
+        vkFreeCommandBuffers(this->device, this->commandPool, 1, &commandBuffer);
+        return 0;
+    }
+
+    const uint64_t                value        = this->nextValue;
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount     = 1;
+    timelineInfo.pSignalSemaphoreValues        = &value;
+
+    VkSubmitInfo submitInfo         = {};
+    submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext                = &timelineInfo;
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.pCommandBuffers      = &commandBuffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &this->timeline;
+    if (vkQueueSubmit(this->queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        std::cerr << "Failed to submit Vulkan transfer command buffer." << std::endl;
+        vkFreeCommandBuffers(this->device, this->commandPool, 1, &commandBuffer);
+        return 0;
+    }
+
+    ++this->nextValue;
+    ++this->stats.submits;
+    this->submitted.push_back({commandBuffer, value});
+    return value;
+}
+
+bool drakon::TransferQueue::isComplete(uint64_t value) {
+    if (value <= this->completedValue) {
+        return true;
+    }
+    uint64_t counter = 0;
+    if (!this->isAvailable() || this->getCounterValue(this->device, this->timeline, &counter) != VK_SUCCESS) {
+        return false;
+    }
+    this->completedValue = counter;
+    return value <= counter;
+}
+
+bool drakon::TransferQueue::wait(uint64_t value, uint64_t timeoutNanoseconds) {
+    if (this->isComplete(value)) {
+        return true;
+    }
+
+    VkSemaphoreWaitInfo waitInfo = {};
+    waitInfo.sType               = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount      = 1;
+    waitInfo.pSemaphores         = &this->timeline;
+    waitInfo.pValues             = &value;
+    if (this->waitSemaphores(this->device, &waitInfo, timeoutNanoseconds) != VK_SUCCESS) {
+        return false;
+    }
+    this->completedValue = value;
+    return true;
+}
+
+drakon::TransferQueueStats drakon::TransferQueue::getStats() const { return this->stats; }
+
+void drakon::TransferQueue::addGraphicsWait(uint64_t value) {
+    this->graphicsWait = std::max(this->graphicsWait, value);
+}
+
+uint64_t drakon::TransferQueue::takeGraphicsWait() { return std::exchange(this->graphicsWait, 0); }
+
+VkSemaphore drakon::TransferQueue::getTimeline() const { return this->timeline; }
@@ -0,0 +1,135 @@
+#include <drakon/UploadRing.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+// The largest offset alignment or non-coherent atom size Vulkan allows, so every region starts suitably aligned
+constexpr VkDeviceSize REGION_ALIGNMENT = 256;
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+bool drakon::UploadRing::init(VkPhysicalDevice physicalDevice,
+                              GpuAllocator&    allocator,
+                              VkDeviceSize     regionSize,
+                              uint32_t         regionCount) {
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    this->allocator        = &allocator;
+    this->regionSize       = alignUp(std::max<VkDeviceSize>(regionSize, 1), REGION_ALIGNMENT);
+    this->regionCount      = regionCount;
+    this->frameIndex       = 0;
+    this->uniformAlignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    this->storageAlignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 1);
+    this->head.store(0, std::memory_order_relaxed);
+
+    const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    // Device-local host-visible memory lets the GPU read streamed data without crossing the bus, where available
+    const VkMemoryPropertyFlags preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    this->buffer = allocator.createBuffer(
+        this->regionSize * regionCount, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, preferred);
+    if (this->buffer == nullptr || this->buffer->allocation.mapped == nullptr) {
+        std::cerr << "Failed to create Vulkan upload ring buffer." << std::endl;
+        this->buffer.reset();
+        return false;
+    }
+
+    return true;
+}
+
+void drakon::UploadRing::cleanup() {
+    this->buffer.reset();
+    this->allocator = nullptr;
+}
+
+void drakon::UploadRing::beginFrame(uint32_t frameIndex) {
+    this->frameIndex = this->regionCount > 0 ? frameIndex % this->regionCount : 0;
+    this->head.store(0, std::memory_order_relaxed);
+}
+
+bool drakon::UploadRing::endFrame() {
+    const VkDeviceSize used = this->head.load(std::memory_order_relaxed);
+    this->bytesLastFrame    = used;
+    this->peakBytes         = std::max(this->peakBytes, used);
+    if (this->buffer == nullptr || used == 0) {
+        return true;
+    }
+
+    GpuAllocation region = this->buffer->allocation;
+    region.offset += this->frameIndex * this->regionSize;
+    region.size = std::min(alignUp(used, REGION_ALIGNMENT), this->regionSize);
+    return this->allocator->flush(region);
+}
+
+drakon::UploadAllocation drakon::UploadRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    // The only writer, so a plain load and store suffice; no read-modify-write on the hot path
+    const VkDeviceSize head   = this->head.load(std::memory_order_relaxed);
+    const VkDeviceSize offset = alignUp(head, std::max<VkDeviceSize>(alignment, 1));
+    if (this->buffer == nullptr || offset + size > this->regionSize) {
+        this->failedAllocations.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+    this->head.store(offset + size, std::memory_order_relaxed);
+    return this->makeAllocation(offset, size);
+}
+
+drakon::UploadAllocation drakon::UploadRing::allocateConcurrent(VkDeviceSize size, VkDeviceSize alignment) {
+    alignment = std::max<VkDeviceSize>(alignment, 1);
+
+    VkDeviceSize head   = this->head.load(std::memory_order_relaxed);
+    VkDeviceSize offset = 0;
+    do {
+        offset = alignUp(head, alignment);
+        if (this->buffer == nullptr || offset + size > this->regionSize) {
+            this->failedAllocations.fetch_add(1, std::memory_order_relaxed);
+            return {};
+        }
+    } while (!this->head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+    return this->makeAllocation(offset, size);
+}
+
+drakon::UploadAllocation drakon::UploadRing::upload(const void* data, VkDeviceSize size, bool concurrent) {
+    const UploadAllocation allocation = concurrent ? this->allocateConcurrent(size, this->uniformAlignment)
+                                                   : this->allocate(size, this->uniformAlignment);
+    if (allocation.isValid()) {
+        std::memcpy(allocation.data, data, static_cast<size_t>(size));
+    }
+    return allocation;
+}
+
+VkBuffer drakon::UploadRing::getBuffer() const {
+    return this->buffer != nullptr ? this->buffer->handle : VK_NULL_HANDLE;
+}
+
+VkDeviceSize drakon::UploadRing::getUniformAlignment() const { return this->uniformAlignment; }
+
+VkDeviceSize drakon::UploadRing::getStorageAlignment() const { return this->storageAlignment; }
+
+drakon::UploadRingStats drakon::UploadRing::getStats() const {
+    UploadRingStats stats;
+    stats.capacityPerFrame  = this->regionSize;
+    stats.bytesLastFrame    = this->bytesLastFrame;
+    stats.peakBytes         = this->peakBytes;
+    stats.failedAllocations = this->failedAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+drakon::UploadAllocation drakon::UploadRing::makeAllocation(VkDeviceSize offset, VkDeviceSize size) const {
+    const VkDeviceSize bufferOffset = this->frameIndex * this->regionSize + offset;
+
+    UploadAllocation allocation;
+    allocation.buffer = this->buffer->handle;
+    allocation.offset = bufferOffset;
+    allocation.size   = size;
+    allocation.data   = static_cast<uint8_t*>(this->buffer->allocation.mapped) + bufferOffset;
+    return allocation;
+}
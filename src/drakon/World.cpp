@@ -0,0 +1,250 @@
+#include <drakon/World.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+constexpr size_t CHUNK_ALIGNMENT = drakon::MAX_COMPONENT_ALIGNMENT;
+
+size_t alignUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+// Lays out capacity entities followed by one array per type, returning the bytes a chunk needs
+size_t layoutChunk(const std::vector<const drakon::ComponentType*>& types,
+                   size_t                                           capacity,
+                   std::vector<size_t>&                             offsets) {
+    offsets.clear();
+    size_t offset = capacity * sizeof(drakon::Entity);
+    for (const drakon::ComponentType* type : types) {
+        offset = alignUp(offset, type->alignment);
+        offsets.push_back(offset);
+        offset += capacity * type->size;
+    }
+    return std::max<size_t>(offset, 1);
+}
+} // namespace
+
+drakon::ComponentId drakon::registerComponentType() {
+    static std::atomic<ComponentId> nextId = 0;
+    const ComponentId               id     = nextId.fetch_add(1, std::memory_order_relaxed);
+    if (id >= MAX_COMPONENT_TYPES) {
+        std::cerr << "More than " << MAX_COMPONENT_TYPES << " component types were registered." << std::endl;
+        std::abort();
+    }
+    return id;
+}
+
+void drakon::World::ChunkDeleter::operator()(std::byte* chunk) const {
+    ::operator delete[](chunk, std::align_val_t(CHUNK_ALIGNMENT));
+}
+
+drakon::Entity* drakon::World::Archetype::entities(size_t chunk) const {
+    return reinterpret_cast<Entity*>(this->chunks[chunk].get());
+}
+
+void* drakon::World::Archetype::component(size_t column, uint32_t row) const {
+    std::byte* chunk = this->chunks[row / this->chunkCapacity].get();
+    return chunk + this->offsets[column] + size_t(row % this->chunkCapacity) * this->types[column]->size;
+}
+
+drakon::World::~World() { this->clear(); }
+
+bool drakon::World::destroy(Entity entity) {
+    const EntityRecord* found = this->findRecord(entity);
+    if (found == nullptr) {
+        return false;
+    }
+
+    EntityRecord& record    = this->records[entity.index];
+    Archetype&    archetype = *record.archetype;
+    for (size_t column = 0; column < archetype.types.size(); ++column) {
+        archetype.types[column]->destroy(archetype.component(column, record.row));
+    }
+    this->removeRow(archetype, record.row);
+
+    record.archetype = nullptr;
+    ++record.generation;
+    this->freeIndices.push_back(entity.index);
+    --this->entityCount;
+    return true;
+}
+
+bool drakon::World::isAlive(Entity entity) const { return this->findRecord(entity) != nullptr; }
+
+size_t drakon::World::size() const { return this->entityCount; }
+
+void drakon::World::clear() {
+    for (const auto& archetype : this->archetypes) {
+        for (uint32_t row = 0; row < archetype->count; ++row) {
+            for (size_t column = 0; column < archetype->types.size(); ++column) {
+                archetype->types[column]->destroy(archetype->component(column, row));
+            }
+        }
+        archetype->count = 0;
+        archetype->chunks.clear();
+    }
+
+    for (uint32_t index = 0; index < this->records.size(); ++index) {
+        EntityRecord& record = this->records[index];
+        if (record.archetype != nullptr) {
+            record.archetype = nullptr;
+            ++record.generation;
+            this->freeIndices.push_back(index);
+        }
+    }
+    this->entityCount = 0;
+}
+
+drakon::World::Archetype& drakon::World::findArchetype(const ComponentType* const* types, size_t count) {
+    ComponentMask mask;
+    for (size_t i = 0; i < count; ++i) {
+        mask.set(types[i]->id);
+    }
+    if (auto found = this->archetypesByMask.find(mask); found != this->archetypesByMask.end()) {
+        return *found->second;
+    }
+
+    auto archetype  = std::make_unique<Archetype>();
+    archetype->mask = mask;
+    archetype->types.assign(types, types + count);
+    std::sort(archetype->types.begin(), archetype->types.end(), [](const auto* left, const auto* right) {
+        return left->id < right->id;
+    });
+
+    // As many entities as fit in CHUNK_BYTES, or one when a single entity is larger
+    size_t bytesPerEntity = sizeof(Entity);
+    for (const ComponentType* type : archetype->types) {
+        bytesPerEntity += type->size;
+    }
+    size_t capacity = std::max<size_t>(CHUNK_BYTES / bytesPerEntity, 1);
+    while (layoutChunk(archetype->types, capacity, archetype->offsets) > CHUNK_BYTES && capacity > 1) {
+        --capacity;
+    }
+    archetype->chunkCapacity = static_cast<uint32_t>(capacity);
+    archetype->chunkBytes    = alignUp(layoutChunk(archetype->types, capacity, archetype->offsets), CHUNK_ALIGNMENT);
+
+    archetype->columns.fill(-1);
+    for (size_t column = 0; column < archetype->types.size(); ++column) {
+        archetype->columns[archetype->types[column]->id] = static_cast<int16_t>(column);
+    }
+
+    Archetype& result            = *archetype;
+    this->archetypesByMask[mask] = &result;
+    this->archetypes.push_back(std::move(archetype));
+    return result;
+}
+
+drakon::World::Archetype& drakon::World::archetypeWith(Archetype& source, const ComponentType& type) {
+    if (auto found = source.addEdges.find(type.id); found != source.addEdges.end()) {
+        return *found->second;
+    }
+
+    std::vector<const ComponentType*> types = source.types;
+    types.push_back(&type);
+    Archetype& destination           = this->findArchetype(types.data(), types.size());
+    source.addEdges[type.id]         = &destination;
+    destination.removeEdges[type.id] = &source;
+    return destination;
+}
+
+drakon::World::Archetype& drakon::World::archetypeWithout(Archetype& source, ComponentId id) {
+    if (auto found = source.removeEdges.find(id); found != source.removeEdges.end()) {
+        return *found->second;
+    }
+
+    std::vector<const ComponentType*> types;
+    for (const ComponentType* type : source.types) {
+        if (type->id != id) {
+            types.push_back(type);
+        }
+    }
+    Archetype& destination   = this->findArchetype(types.data(), types.size());
+    source.removeEdges[id]   = &destination;
+    destination.addEdges[id] = &source;
+    return destination;
+}
+
+drakon::Entity drakon::World::allocateEntity(Archetype& archetype) {
+    uint32_t index = 0;
+    if (!this->freeIndices.empty()) {
+        index = this->freeIndices.back();
+        this->freeIndices.pop_back();
+    } else {
+        index = static_cast<uint32_t>(this->records.size());
+        this->records.emplace_back();
+    }
+
+    EntityRecord& record = this->records[index];
+    record.archetype     = &archetype;
+    record.row           = this->allocateRow(archetype);
+
+    const Entity entity = {index, record.generation};
+    archetype.entities(record.row / archetype.chunkCapacity)[record.row % archetype.chunkCapacity] = entity;
+    ++this->entityCount;
+    return entity;
+}
+
+uint32_t drakon::World::allocateRow(Archetype& archetype) {
+    const uint32_t row = archetype.count;
+    if (row / archetype.chunkCapacity == archetype.chunks.size()) {
+        void* memory = ::operator new[](archetype.chunkBytes, std::align_val_t(CHUNK_ALIGNMENT));
+        archetype.chunks.emplace_back(static_cast<std::byte*>(memory));
+    }
+    ++archetype.count;
+    return row;
+}
+
+void drakon::World::removeRow(Archetype& archetype, uint32_t row) {
+    const uint32_t last     = archetype.count - 1;
+    const uint32_t capacity = archetype.chunkCapacity;
+    if (row != last) {
+        for (size_t column = 0; column < archetype.types.size(); ++column) {
+            archetype.types[column]->relocate(archetype.component(column, row), archetype.component(column, last));
+        }
+        const Entity moved                                 = archetype.entities(last / capacity)[last % capacity];
+        archetype.entities(row / capacity)[row % capacity] = moved;
+        this->records[moved.index].row                     = row;
+    }
+    --archetype.count;
+
+    // Keep one empty chunk spare, so an entity repeatedly created and destroyed at a boundary does not reallocate
+    const size_t usedChunks = (archetype.count + capacity - 1) / capacity;
+    while (archetype.chunks.size() > usedChunks + 1) {
+        archetype.chunks.pop_back();
+    }
+}
+
+void drakon::World::moveEntity(uint32_t index, Archetype& destination) {
+    EntityRecord&  record         = this->records[index];
+    Archetype&     source         = *record.archetype;
+    const uint32_t sourceRow      = record.row;
+    const uint32_t destinationRow = this->allocateRow(destination);
+
+    for (size_t column = 0; column < source.types.size(); ++column) {
+        const ComponentType& type              = *source.types[column];
+        const int16_t        destinationColumn = destination.columns[type.id];
+        if (destinationColumn >= 0) {
+            type.relocate(destination.component(destinationColumn, destinationRow),
+                          source.component(column, sourceRow));
+        } else {
+            type.destroy(source.component(column, sourceRow));
+        }
+    }
+
+    const uint32_t capacity = destination.chunkCapacity;
+    destination.entities(destinationRow / capacity)[destinationRow % capacity] = {index, record.generation};
+    this->removeRow(source, sourceRow);
+    record.archetype = &destination;
+    record.row       = destinationRow;
+}
+
+const drakon::World::EntityRecord* drakon::World::findRecord(Entity entity) const {
+    if (entity.index >= this->records.size()) {
+        return nullptr;
+    }
+    const EntityRecord& record = this->records[entity.index];
+    if (record.archetype == nullptr || record.generation != entity.generation) {
+        return nullptr;
+    }
+    return &record;
+}
@@ -0,0 +1,148 @@
+#include <drakon/AssetLoader.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+struct AssetLoaderTest : public ::testing::Test {
+    std::filesystem::path directory;
+
+    void SetUp() override {
+        this->directory = std::filesystem::temp_directory_path() / ("drakon_asset_loader_" + std::to_string(getpid()));
+        std::filesystem::remove_all(this->directory);
+        std::filesystem::create_directories(this->directory);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(this->directory); }
+
+    std::filesystem::path write(const std::string& name, const std::string& contents) const {
+        const std::filesystem::path path = this->directory / name;
+        std::ofstream               file(path, std::ios::binary);
+        file << contents;
+        return path;
+    }
+};
+
+// Run once through io_uring, where the kernel allows it, and once through the thread pool
+struct AssetLoaderBackendTest : public AssetLoaderTest, public ::testing::WithParamInterface<bool> {};
+} // namespace
+
+TEST_P(AssetLoaderBackendTest, ReadsSmallAndMappedFiles) {
+    drakon::AssetLoader loader;
+    loader.setMapThreshold(4096);
+    ASSERT_TRUE(loader.start(2, GetParam()));
+    EXPECT_NE(loader.getBackend(), drakon::AssetBackend::None);
+
+    const std::string small = "#version 450\nvoid main() {}\n";
+    std::string       large(100000, '\0');
+    for (size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<char>(i * 31);
+    }
+
+    drakon::AssetHandle smallAsset = loader.load(this->write("small.txt", small));
+    drakon::AssetHandle largeAsset = loader.load(this->write("large.bin", large), drakon::AssetPriority::Visible);
+    drakon::AssetHandle emptyAsset = loader.load(this->write("empty.txt", ""));
+
+    ASSERT_EQ(smallAsset->wait(), drakon::AssetState::Loaded);
+    EXPECT_EQ(smallAsset->text(), small);
+    EXPECT_FALSE(smallAsset->isMapped());
+
+    ASSERT_EQ(largeAsset->wait(), drakon::AssetState::Loaded);
+    EXPECT_EQ(largeAsset->text(), large);
+    EXPECT_TRUE(largeAsset->isMapped());
+
+    ASSERT_EQ(emptyAsset->wait(), drakon::AssetState::Loaded);
+    EXPECT_EQ(emptyAsset->size(), 0u);
+
+    const drakon::AssetLoaderStats stats = loader.getStats();
+    EXPECT_EQ(stats.loaded, 3u);
+    EXPECT_EQ(stats.mapped, 1u);
+    EXPECT_EQ(stats.bytesRead, small.size() + large.size());
+}
+
+TEST_P(AssetLoaderBackendTest, MissingFilesFail) {
+    drakon::AssetLoader loader;
+    ASSERT_TRUE(loader.start(1, GetParam()));
+
+    drakon::AssetHandle asset = loader.load(this->directory / "missing.txt");
+    EXPECT_EQ(asset->wait(), drakon::AssetState::Failed);
+    EXPECT_TRUE(asset->isReady());
+    EXPECT_FALSE(asset->getError().empty());
+    EXPECT_EQ(asset->data(), nullptr);
+    EXPECT_EQ(loader.getStats().failed, 1u);
+}
+
+TEST_P(AssetLoaderBackendTest, RequestsForTheSamePathShareOneLoad) {
+    drakon::AssetLoader         loader;
+    const std::filesystem::path path = this->write("shared.txt", "shared");
+
+    // Queued before starting, so every request finds the first still loading
+    std::vector<drakon::AssetHandle> handles;
+    for (int i = 0; i < 10; ++i) {
+        handles.push_back(loader.load(i % 2 == 0 ? path : this->directory / "." / "shared.txt"));
+    }
+    ASSERT_TRUE(loader.start(2, GetParam()));
+    for (const auto& handle : handles) {
+        EXPECT_EQ(handle, handles[0]);
+    }
+    ASSERT_EQ(handles[0]->wait(), drakon::AssetState::Loaded);
+    EXPECT_EQ(handles[0]->text(), "shared");
+
+    // Held handles keep answering without another read
+    EXPECT_EQ(loader.load(path), handles[0]);
+    const drakon::AssetLoaderStats stats = loader.getStats();
+    EXPECT_EQ(stats.requests, 11u);
+    EXPECT_EQ(stats.deduplicated, 10u);
+    EXPECT_EQ(stats.loaded, 1u);
+}
+
+TEST_F(AssetLoaderTest, MoreUrgentRequestsLoadFirst) {
+    drakon::AssetLoader loader;
+
+    std::vector<drakon::AssetHandle> background;
+    for (int i = 0; i < 8; ++i) {
+        background.push_back(loader.load(this->write("background" + std::to_string(i), "b")));
+    }
+    drakon::AssetHandle promoted = loader.load(this->write("promoted", "p"));
+    drakon::AssetHandle visible  = loader.load(this->write("visible", "v"), drakon::AssetPriority::Visible);
+    // Asking again at a higher priority moves the request ahead of the background loads
+    EXPECT_EQ(loader.load(promoted->getPath(), drakon::AssetPriority::Nearby), promoted);
+    // Dropped before its turn, so it is never read
+    loader.load(this->write("dropped", "d"));
+
+    // One reader thread takes requests strictly in queue order
+    ASSERT_TRUE(loader.start(1, false));
+    ASSERT_EQ(background.front()->wait(), drakon::AssetState::Loaded);
+    EXPECT_EQ(visible->getState(), drakon::AssetState::Loaded);
+    EXPECT_EQ(promoted->getState(), drakon::AssetState::Loaded);
+    ASSERT_EQ(background.back()->wait(), drakon::AssetState::Loaded);
+    loader.stop();
+    EXPECT_EQ(loader.getStats().abandoned, 1u);
+    EXPECT_EQ(loader.getStats().loaded, 10u);
+}
+
+TEST_P(AssetLoaderBackendTest, StoppingFailsQueuedLoads) {
+    drakon::AssetLoader loader;
+    drakon::AssetHandle asset = loader.load(this->write("never.txt", "never"));
+    loader.stop();
+    EXPECT_EQ(asset->getState(), drakon::AssetState::Failed);
+
+    // A failed asset is not handed out again, even while still held
+    ASSERT_TRUE(loader.start(1, GetParam()));
+    drakon::AssetHandle again = loader.load(asset->getPath());
+    EXPECT_NE(again, asset);
+    EXPECT_EQ(again->wait(), drakon::AssetState::Loaded);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends,
+                         AssetLoaderBackendTest,
+                         ::testing::Bool(),
+                         [](const ::testing::TestParamInfo<bool>& info) {
+                             return info.param ? "IoUring" : "ThreadPool";
+                         });
@@ -0,0 +1,77 @@
+#include <drakon/DynamicResolution.h>
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+namespace {
+// A frame with a fixed cost plus a cost proportional to the pixels rendered
+double simulateFrame(float scale) { return 2.0 + 20.0 * static_cast<double>(scale) * static_cast<double>(scale); }
+} // namespace
+
+TEST(DynamicResolution, DropsAtOnceWhenOverBudget) {
+    drakon::DynamicResolution resolution;
+    resolution.setBudget(10.0);
+    resolution.setScaleLimits(0.1f, 1.0f);
+
+    EXPECT_NEAR(resolution.update(20.0, 1.0f), std::sqrt(0.45f), 1e-4f);
+}
+
+TEST(DynamicResolution, RecoversGradually) {
+    drakon::DynamicResolution resolution;
+    resolution.setBudget(10.0);
+    resolution.setScaleLimits(0.1f, 1.0f);
+    resolution.update(40.0, 1.0f);
+    const float dropped = resolution.getScale();
+    ASSERT_LT(dropped, 0.5f);
+
+    float previous = dropped;
+    for (int i = 0; i < 100; ++i) {
+        const float scale = resolution.update(1.0, previous);
+        EXPECT_LE(scale - previous, 0.02f + 1e-6f);
+        EXPECT_GE(scale, previous);
+        previous = scale;
+    }
+    EXPECT_FLOAT_EQ(previous, 1.0f);
+}
+
+TEST(DynamicResolution, ConvergesWithinBudget) {
+    drakon::DynamicResolution resolution;
+    resolution.setBudget(16.0);
+    resolution.setScaleLimits(0.25f, 1.0f);
+
+    float scale = resolution.getScale();
+    for (int i = 0; i < 200; ++i) {
+        scale = resolution.update(simulateFrame(scale), scale);
+    }
+    EXPECT_LE(simulateFrame(scale), 16.0);
+    EXPECT_GT(scale, 0.75f);
+}
+
+TEST(DynamicResolution, StaysWithinLimits) {
+    drakon::DynamicResolution resolution;
+    resolution.setBudget(10.0);
+    resolution.setScaleLimits(0.5f, 0.8f);
+    EXPECT_FLOAT_EQ(resolution.getScale(), 0.8f);
+
+    EXPECT_FLOAT_EQ(resolution.update(1000.0, 0.8f), 0.5f);
+    for (int i = 0; i < 100; ++i) {
+        resolution.update(0.1, resolution.getScale());
+    }
+    EXPECT_FLOAT_EQ(resolution.getScale(), 0.8f);
+
+    resolution.setScaleLimits(0.0f, 2.0f);
+    EXPECT_FLOAT_EQ(resolution.getMinimumScale(), 0.1f);
+    EXPECT_FLOAT_EQ(resolution.getMaximumScale(), 1.0f);
+}
+
+TEST(DynamicResolution, IgnoresInvalidFrames) {
+    drakon::DynamicResolution resolution;
+    resolution.setBudget(10.0);
+    EXPECT_FLOAT_EQ(resolution.update(0.0, 1.0f), 1.0f);
+    EXPECT_FLOAT_EQ(resolution.update(100.0, 0.0f), 1.0f);
+
+    resolution.update(100.0, 1.0f);
+    resolution.reset();
+    EXPECT_FLOAT_EQ(resolution.getScale(), 1.0f);
+}
@@ -0,0 +1,32 @@
+#include <drakon/FixedTimestep.h>
+
+#include <gtest/gtest.h>
+
+TEST(FixedTimestep, AccumulatesPartialFrames) {
+    drakon::FixedTimestep timestep(0.01, 5);
+    EXPECT_EQ(timestep.advance(0.004), 0u);
+    EXPECT_EQ(timestep.advance(0.004), 0u);
+    EXPECT_EQ(timestep.advance(0.004), 1u);
+    EXPECT_NEAR(timestep.getAlpha(), 0.2f, 1e-4f);
+}
+
+TEST(FixedTimestep, RunsSeveralStepsForLongFrames) {
+    drakon::FixedTimestep timestep(0.01, 5);
+    EXPECT_EQ(timestep.advance(0.035), 3u);
+    EXPECT_NEAR(timestep.getAlpha(), 0.5f, 1e-4f);
+    EXPECT_EQ(timestep.getDroppedSteps(), 0u);
+}
+
+TEST(FixedTimestep, DropsBacklogBeyondCatchUpLimit) {
+    drakon::FixedTimestep timestep(0.01, 4);
+    EXPECT_EQ(timestep.advance(1.0), 4u);
+    EXPECT_EQ(timestep.getDroppedSteps(), 96u);
+    EXPECT_LT(timestep.getAlpha(), 1.0f);
+    EXPECT_EQ(timestep.advance(0.0), 0u);
+}
+
+TEST(FixedTimestep, IgnoresNegativeFrameTime) {
+    drakon::FixedTimestep timestep(0.01, 4);
+    EXPECT_EQ(timestep.advance(-1.0), 0u);
+    EXPECT_FLOAT_EQ(timestep.getAlpha(), 0.0f);
+}
@@ -0,0 +1,68 @@
+#include <drakon/GpuCulling.h>
+
+#include <array>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+namespace {
+const std::array<float, 16> IDENTITY = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+} // namespace
+
+TEST(GpuCulling, IdentityFrustumIsTheClipVolume) {
+    const drakon::FrustumPlanes planes = drakon::GpuCulling::extractFrustumPlanes(IDENTITY);
+
+    // Left, right, bottom, top, near, far; x and y span [-1, 1] and depth [0, 1]
+    const std::array<std::array<float, 4>, 6> expected = {{
+        {1, 0, 0, 1},
+        {-1, 0, 0, 1},
+        {0, 1, 0, 1},
+        {0, -1, 0, 1},
+        {0, 0, 1, 0},
+        {0, 0, -1, 1},
+    }};
+    for (size_t plane = 0; plane < planes.size(); ++plane) {
+        for (size_t i = 0; i < 4; ++i) {
+            EXPECT_FLOAT_EQ(planes[plane][i], expected[plane][i]) << "plane " << plane << " component " << i;
+        }
+    }
+}
+
+TEST(GpuCulling, PlanesAreNormalized) {
+    // A uniform scale of clip space must not change the planes' distances
+    std::array<float, 16> scaled = IDENTITY;
+    scaled[0]                    = 4.0f;
+    scaled[5]                    = 4.0f;
+
+    const drakon::FrustumPlanes planes = drakon::GpuCulling::extractFrustumPlanes(scaled);
+    for (const auto& plane : planes) {
+        EXPECT_NEAR(std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]), 1.0f, 1e-5f);
+    }
+
+    // The scale narrows the visible x range to [-0.25, 0.25]
+    const float inside[3]  = {0.2f, 0.0f, 0.5f};
+    const float outside[3] = {0.3f, 0.0f, 0.5f};
+    EXPECT_TRUE(drakon::GpuCulling::isSphereVisible(planes, inside, 0.0f));
+    EXPECT_FALSE(drakon::GpuCulling::isSphereVisible(planes, outside, 0.0f));
+}
+
+TEST(GpuCulling, SpheresStraddlingAPlaneAreVisible) {
+    const drakon::FrustumPlanes planes = drakon::GpuCulling::extractFrustumPlanes(IDENTITY);
+
+    const float center[3]    = {0.0f, 0.0f, 0.5f};
+    const float right[3]     = {1.5f, 0.0f, 0.5f};
+    const float behind[3]    = {0.0f, 0.0f, -0.2f};
+    const float farCorner[3] = {1.2f, 1.2f, 0.5f};
+    EXPECT_TRUE(drakon::GpuCulling::isSphereVisible(planes, center, 0.1f));
+    EXPECT_FALSE(drakon::GpuCulling::isSphereVisible(planes, right, 0.4f));
+    EXPECT_TRUE(drakon::GpuCulling::isSphereVisible(planes, right, 0.6f));
+    EXPECT_FALSE(drakon::GpuCulling::isSphereVisible(planes, behind, 0.1f));
+    EXPECT_TRUE(drakon::GpuCulling::isSphereVisible(planes, behind, 0.3f));
+    // Plane tests are conservative near corners, so this is kept even though it misses the volume
+    EXPECT_TRUE(drakon::GpuCulling::isSphereVisible(planes, farCorner, 0.25f));
+}
+
+TEST(GpuCulling, ObjectMatchesTheShaderLayout) {
+    EXPECT_EQ(sizeof(drakon::GpuCullingObject), 32u);
+    EXPECT_EQ(sizeof(VkDrawIndexedIndirectCommand), 20u);
+}
@@ -0,0 +1,161 @@
+#include <drakon/JobSystem.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(WorkStealingDeque, OwnerPopsNewestFirstAndGrows) {
+    drakon::WorkStealingDeque<int> deque(2);
+    std::vector<int>               values(100);
+    for (int& value : values) {
+        deque.push(&value);
+    }
+    for (int i = 99; i >= 0; --i) {
+        EXPECT_EQ(deque.pop(), &values[i]);
+    }
+    EXPECT_EQ(deque.pop(), nullptr);
+    EXPECT_EQ(deque.steal(), nullptr);
+}
+
+TEST(WorkStealingDeque, EveryItemIsTakenExactlyOnceUnderContention) {
+    constexpr int                  count = 100000;
+    drakon::WorkStealingDeque<int> deque(16);
+    std::vector<int>               values(count);
+    std::vector<std::atomic<int>>  taken(count);
+    std::atomic<bool>              done = false;
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&]() {
+            while (!done.load()) {
+                if (int* value = deque.steal()) {
+                    taken[value - values.data()].fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < count; ++i) {
+        deque.push(&values[i]);
+        if (i % 3 == 0) {
+            if (int* value = deque.pop()) {
+                taken[value - values.data()].fetch_add(1);
+            }
+        }
+    }
+    while (int* value = deque.pop()) {
+        taken[value - values.data()].fetch_add(1);
+    }
+    done.store(true);
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(taken[i].load(), 1) << "item " << i;
+    }
+}
+
+TEST(JobSystem, WaitReturnsOnceEveryJobHasRun) {
+    drakon::JobSystem jobs;
+    jobs.start(4);
+    ASSERT_EQ(jobs.getWorkerCount(), 4u);
+
+    std::atomic<int>   runs = 0;
+    drakon::JobCounter counter;
+    for (int i = 0; i < 10000; ++i) {
+        jobs.run([&runs]() { runs.fetch_add(1); }, &counter);
+    }
+    jobs.wait(counter);
+    EXPECT_EQ(runs.load(), 10000);
+}
+
+TEST(JobSystem, JobsCanWaitOnJobsTheyQueue) {
+    drakon::JobSystem jobs;
+    jobs.start(3);
+
+    std::atomic<int>   leaves = 0;
+    drakon::JobCounter outer;
+    for (int i = 0; i < 64; ++i) {
+        jobs.run(
+            [&jobs, &leaves]() {
+                drakon::JobCounter inner;
+                for (int j = 0; j < 64; ++j) {
+                    jobs.run([&leaves]() { leaves.fetch_add(1); }, &inner);
+                }
+                jobs.wait(inner);
+            },
+            &outer);
+    }
+    jobs.wait(outer);
+    EXPECT_EQ(leaves.load(), 64 * 64);
+}
+
+TEST(JobSystem, ParallelForCoversEveryIndexOnce) {
+    drakon::JobSystem jobs;
+    jobs.start(4);
+
+    std::vector<std::atomic<int>> visits(10007);
+    jobs.parallelFor(visits.size(), 100, [&visits](size_t begin, size_t end) {
+        EXPECT_LE(end - begin, 100u);
+        for (size_t i = begin; i < end; ++i) {
+            visits[i].fetch_add(1);
+        }
+    });
+    for (size_t i = 0; i < visits.size(); ++i) {
+        EXPECT_EQ(visits[i].load(), 1) << "index " << i;
+    }
+}
+
+TEST(JobSystem, GraphRunsJobsAfterTheirPredecessors) {
+    drakon::JobSystem jobs;
+    jobs.start(4);
+
+    for (int round = 0; round < 100; ++round) {
+        std::atomic<int> clock = 0;
+        std::vector<int> finished(4, -1);
+
+        drakon::JobGraph graph;
+        for (int i = 0; i < 4; ++i) {
+            graph.add([&clock, &finished, i]() { finished[i] = clock.fetch_add(1); });
+        }
+        // A diamond: 0 before 1 and 2, both before 3
+        graph.precede(0, 1);
+        graph.precede(0, 2);
+        graph.precede(1, 3);
+        graph.precede(2, 3);
+
+        drakon::JobCounter counter;
+        graph.run(jobs, counter);
+        jobs.wait(counter);
+
+        EXPECT_EQ(finished[0], 0);
+        EXPECT_LT(finished[0], finished[1]);
+        EXPECT_LT(finished[0], finished[2]);
+        EXPECT_EQ(finished[3], 3);
+    }
+}
+
+TEST(JobSystem, RunsInlineWithoutWorkers) {
+    drakon::JobSystem jobs;
+    int               runs = 0;
+    jobs.run([&runs]() { ++runs; });
+    EXPECT_EQ(runs, 1);
+
+    jobs.parallelFor(10, 3, [&runs](size_t begin, size_t end) { runs += static_cast<int>(end - begin); });
+    EXPECT_EQ(runs, 11);
+}
+
+TEST(JobSystem, StopRunsJobsStillQueued) {
+    std::atomic<int> runs = 0;
+    {
+        drakon::JobSystem jobs;
+        jobs.start(2);
+        for (int i = 0; i < 1000; ++i) {
+            jobs.run([&runs]() { runs.fetch_add(1); });
+        }
+    }
+    EXPECT_EQ(runs.load(), 1000);
+}
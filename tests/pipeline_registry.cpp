@@ -0,0 +1,51 @@
+#include <drakon/PipelineRegistry.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+drakon::GraphicsPipelineDescription makeDescription() {
+    drakon::GraphicsPipelineDescription description;
+    description.stages.resize(2);
+    description.stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    description.stages[0].spirv = {0x07230203, 1, 2, 3};
+    description.stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    description.stages[1].spirv = {0x07230203, 4, 5, 6};
+    description.vertexBindings.push_back({0, 16, VK_VERTEX_INPUT_RATE_VERTEX});
+    description.dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    return description;
+}
+} // namespace
+
+TEST(GraphicsPipelineDescription, EqualDescriptionsHashEqually) {
+    const drakon::GraphicsPipelineDescription a = makeDescription();
+    const drakon::GraphicsPipelineDescription b = makeDescription();
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(a.hash(), b.hash());
+}
+
+TEST(GraphicsPipelineDescription, ShaderCodeIsPartOfTheKey) {
+    const drakon::GraphicsPipelineDescription a = makeDescription();
+    drakon::GraphicsPipelineDescription       b = makeDescription();
+    b.stages[1].spirv.back() = 7;
+    EXPECT_FALSE(a == b);
+    EXPECT_NE(a.hash(), b.hash());
+}
+
+TEST(GraphicsPipelineDescription, FixedFunctionStateIsPartOfTheKey) {
+    const drakon::GraphicsPipelineDescription a = makeDescription();
+
+    drakon::GraphicsPipelineDescription blended = makeDescription();
+    blended.colorBlend.blendEnable              = VK_TRUE;
+    EXPECT_FALSE(a == blended);
+    EXPECT_NE(a.hash(), blended.hash());
+
+    drakon::GraphicsPipelineDescription culled = makeDescription();
+    culled.cullMode                            = VK_CULL_MODE_NONE;
+    EXPECT_FALSE(a == culled);
+    EXPECT_NE(a.hash(), culled.hash());
+
+    drakon::GraphicsPipelineDescription attributes = makeDescription();
+    attributes.vertexAttributes.push_back({0, 0, VK_FORMAT_R32G32_SFLOAT, 0});
+    EXPECT_FALSE(a == attributes);
+    EXPECT_NE(a.hash(), attributes.hash());
+}
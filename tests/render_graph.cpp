@@ -0,0 +1,221 @@
+#include <drakon/RenderGraph.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+constexpr VkExtent2D EXTENT = {640, 360};
+
+drakon::RenderGraphAliasRequest makeRequest(VkDeviceSize size, uint32_t firstPass, uint32_t lastPass) {
+    drakon::RenderGraphAliasRequest request;
+    request.requirements.size           = size;
+    request.requirements.alignment      = 256;
+    request.requirements.memoryTypeBits = 0x3;
+    request.firstPass                   = firstPass;
+    request.lastPass                    = lastPass;
+    return request;
+}
+
+uint32_t importBackbuffer(drakon::RenderGraph& graph) {
+    return graph.importImage(
+        "backbuffer", VK_FORMAT_B8G8R8A8_SRGB, {}, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}
+
+const drakon::RenderGraphBarrier* findBarrier(const std::vector<drakon::RenderGraphBarrier>& barriers,
+                                              uint32_t                                      resource) {
+    for (const auto& barrier : barriers) {
+        if (barrier.resource == resource) {
+            return &barrier;
+        }
+    }
+    return nullptr;
+}
+} // namespace
+
+TEST(RenderGraph, CullsPassesNothingConsumes) {
+    drakon::RenderGraph graph;
+    const uint32_t      backbuffer = importBackbuffer(graph);
+    const uint32_t      shadows    = graph.createImage("shadows", {VK_FORMAT_D32_SFLOAT, 1024, 1024});
+    const uint32_t      debug      = graph.createImage("debug", {VK_FORMAT_R8G8B8A8_UNORM});
+
+    const uint32_t shadowPass = graph.addPass("shadows", nullptr);
+    ASSERT_TRUE(
+        graph.use(shadowPass, shadows, drakon::RenderGraphAccess::DepthAttachment, drakon::RenderGraphLoad::Clear));
+    const uint32_t debugPass = graph.addPass("debug", nullptr);
+    ASSERT_TRUE(
+        graph.use(debugPass, debug, drakon::RenderGraphAccess::ColorAttachment, drakon::RenderGraphLoad::Clear));
+    // Overwritten by the scene pass without being read first
+    const uint32_t splashPass = graph.addPass("splash", nullptr);
+    ASSERT_TRUE(
+        graph.use(splashPass, backbuffer, drakon::RenderGraphAccess::ColorAttachment, drakon::RenderGraphLoad::Clear));
+    const uint32_t scenePass = graph.addPass("scene", nullptr);
+    ASSERT_TRUE(graph.use(scenePass, shadows, drakon::RenderGraphAccess::Sampled));
+    ASSERT_TRUE(
+        graph.use(scenePass, backbuffer, drakon::RenderGraphAccess::ColorAttachment, drakon::RenderGraphLoad::Clear));
+    const uint32_t readbackPass = graph.addPass("readback", nullptr);
+    graph.setSideEffects(readbackPass);
+
+    ASSERT_TRUE(graph.compile(EXTENT));
+    EXPECT_FALSE(graph.isPassCulled(shadowPass));
+    EXPECT_TRUE(graph.isPassCulled(debugPass));
+    EXPECT_TRUE(graph.isPassCulled(splashPass));
+    EXPECT_FALSE(graph.isPassCulled(scenePass));
+    EXPECT_FALSE(graph.isPassCulled(readbackPass));
+    EXPECT_EQ(graph.getStats().passes, 3u);
+    EXPECT_EQ(graph.getStats().culledPasses, 2u);
+    EXPECT_EQ(graph.getAliasGroup(debug), drakon::RenderGraph::INVALID_GROUP);
+    EXPECT_EQ(graph.getExtent(backbuffer).width, EXTENT.width);
+    EXPECT_EQ(graph.getExtent(shadows).width, 1024u);
+}
+
+TEST(RenderGraph, BarriersFollowEachAccess) {
+    drakon::RenderGraph graph;
+    const uint32_t      backbuffer = importBackbuffer(graph);
+    const uint32_t      shadows    = graph.createImage("shadows", {VK_FORMAT_D32_SFLOAT, 1024, 1024});
+
+    const uint32_t shadowPass = graph.addPass("shadows", nullptr);
+    ASSERT_TRUE(
+        graph.use(shadowPass, shadows, drakon::RenderGraphAccess::DepthAttachment, drakon::RenderGraphLoad::Clear));
+    const uint32_t scenePass = graph.addPass("scene", nullptr);
+    ASSERT_TRUE(graph.use(scenePass, shadows, drakon::RenderGraphAccess::Sampled));
+    ASSERT_TRUE(
+        graph.use(scenePass, backbuffer, drakon::RenderGraphAccess::ColorAttachment, drakon::RenderGraphLoad::Clear));
+    ASSERT_TRUE(graph.compile(EXTENT));
+
+    // The shadow map's first barrier waits for its own sampling in the previous frame
+    const drakon::RenderGraphBarrier* first = findBarrier(graph.getPassBarriers(shadowPass), shadows);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+    EXPECT_EQ(first->newLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+    EXPECT_EQ(first->srcStage, VkPipelineStageFlags(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT));
+
+    ASSERT_EQ(graph.getPassBarriers(scenePass).size(), 2u);
+    const drakon::RenderGraphBarrier* sampled = findBarrier(graph.getPassBarriers(scenePass), shadows);
+    ASSERT_NE(sampled, nullptr);
+    EXPECT_EQ(sampled->oldLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+    EXPECT_EQ(sampled->newLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    EXPECT_EQ(sampled->srcAccess, VkAccessFlags(VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT));
+    EXPECT_EQ(sampled->dstAccess, VkAccessFlags(VK_ACCESS_SHADER_READ_BIT));
+
+    const drakon::RenderGraphBarrier* color = findBarrier(graph.getPassBarriers(scenePass), backbuffer);
+    ASSERT_NE(color, nullptr);
+    EXPECT_EQ(color->newLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    EXPECT_EQ(color->srcStage, VkPipelineStageFlags(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT));
+
+    ASSERT_EQ(graph.getFinalBarriers().size(), 1u);
+    EXPECT_EQ(graph.getFinalBarriers()[0].resource, backbuffer);
+    EXPECT_EQ(graph.getFinalBarriers()[0].oldLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    EXPECT_EQ(graph.getFinalBarriers()[0].newLayout, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    EXPECT_EQ(graph.getStats().barriers, 4u);
+}
+
+TEST(RenderGraph, RepeatedReadsShareOneBarrier) {
+    drakon::RenderGraph graph;
+    const uint32_t      lighting = graph.createImage("lighting", {VK_FORMAT_R16G16B16A16_SFLOAT});
+    const uint32_t      bloom    = graph.createImage("bloom", {VK_FORMAT_R16G16B16A16_SFLOAT, 0, 0, 0.5f});
+    const uint32_t      output   = graph.createImage("output", {VK_FORMAT_R8G8B8A8_UNORM});
+    graph.markOutput(output);
+
+    const uint32_t lightingPass = graph.addPass("lighting", nullptr);
+    ASSERT_TRUE(
+        graph.use(lightingPass, lighting, drakon::RenderGraphAccess::ColorAttachment, drakon::RenderGraphLoad::Clear));
+    const uint32_t bloomPass = graph.addPass("bloom", nullptr);
+    ASSERT_TRUE(graph.use(bloomPass, lighting, drakon::RenderGraphAccess::Sampled));
+    ASSERT_TRUE(graph.use(bloomPass, bloom, drakon::RenderGraphAccess::ColorAttachment));
+    const uint32_t compositePass = graph.addPass("composite", nullptr);
+    ASSERT_TRUE(graph.use(compositePass, lighting, drakon::RenderGraphAccess::Sampled));
+    ASSERT_TRUE(graph.use(compositePass, bloom, drakon::RenderGraphAccess::Sampled));
+    ASSERT_TRUE(graph.use(compositePass, output, drakon::RenderGraphAccess::ColorAttachment));
+    ASSERT_TRUE(graph.compile(EXTENT));
+
+    EXPECT_EQ(graph.getExtent(bloom).width, EXTENT.width / 2);
+    // The lighting image is already readable from the bloom pass
+    EXPECT_EQ(findBarrier(graph.getPassBarriers(compositePass), lighting), nullptr);
+    EXPECT_NE(findBarrier(graph.getPassBarriers(compositePass), bloom), nullptr);
+
+    ASSERT_EQ(graph.getFinalBarriers().size(), 1u);
+    EXPECT_EQ(graph.getFinalBarriers()[0].newLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+TEST(RenderGraph, AliasesImagesWithDisjointLifetimes) {
+    drakon::RenderGraph graph;
+    const uint32_t      first  = graph.createImage("first", {VK_FORMAT_R8G8B8A8_UNORM});
+    const uint32_t      middle = graph.createImage("middle", {VK_FORMAT_R8G8B8A8_UNORM});
+    const uint32_t      last   = graph.createImage("last", {VK_FORMAT_R8G8B8A8_UNORM});
+    const uint32_t      output = graph.createImage("output", {VK_FORMAT_R8G8B8A8_UNORM});
+    graph.markOutput(output);
+
+    // first lives over passes 0-1, middle over 1-2 and last over 2-3
+    const uint32_t pass0 = graph.addPass("pass0", nullptr);
+    ASSERT_TRUE(graph.use(pass0, first, drakon::RenderGraphAccess::ColorAttachment));
+    const uint32_t pass1 = graph.addPass("pass1", nullptr);
+    ASSERT_TRUE(graph.use(pass1, first, drakon::RenderGraphAccess::Sampled));
+    ASSERT_TRUE(graph.use(pass1, middle, drakon::RenderGraphAccess::ColorAttachment));
+    const uint32_t pass2 = graph.addPass("pass2", nullptr);
+    ASSERT_TRUE(graph.use(pass2, middle, drakon::RenderGraphAccess::Sampled));
+    ASSERT_TRUE(graph.use(pass2, last, drakon::RenderGraphAccess::ColorAttachment));
+    const uint32_t pass3 = graph.addPass("pass3", nullptr);
+    ASSERT_TRUE(graph.use(pass3, last, drakon::RenderGraphAccess::Sampled));
+    ASSERT_TRUE(graph.use(pass3, output, drakon::RenderGraphAccess::ColorAttachment));
+    ASSERT_TRUE(graph.compile(EXTENT));
+
+    EXPECT_EQ(graph.getAliasGroup(first), graph.getAliasGroup(last));
+    EXPECT_NE(graph.getAliasGroup(first), graph.getAliasGroup(middle));
+    EXPECT_NE(graph.getAliasGroup(output), graph.getAliasGroup(first));
+    EXPECT_NE(graph.getAliasGroup(output), graph.getAliasGroup(middle));
+
+    const drakon::RenderGraphStats stats = graph.getStats();
+    EXPECT_EQ(stats.transientImages, 4u);
+    EXPECT_EQ(stats.aliasGroups, 3u);
+    EXPECT_EQ(stats.transientBytes * 4, stats.unaliasedBytes * 3);
+
+    // Taking over the memory waits for the image that used it before
+    const drakon::RenderGraphBarrier* takeover = findBarrier(graph.getPassBarriers(pass2), last);
+    ASSERT_NE(takeover, nullptr);
+    EXPECT_EQ(takeover->oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+    EXPECT_EQ(takeover->srcStage, VkPipelineStageFlags(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT));
+}
+
+TEST(RenderGraph, AliasRequestsNeedCompatibleMemory) {
+    std::vector<drakon::RenderGraphAliasRequest> requests = {
+        makeRequest(1024, 0, 1), makeRequest(4096, 2, 3), makeRequest(2048, 4, 5), makeRequest(512, 1, 2)};
+    requests[2].requirements.memoryTypeBits = 0x4;
+
+    const std::vector<uint32_t> groups = drakon::assignRenderGraphAliases(requests);
+    ASSERT_EQ(groups.size(), 4u);
+    EXPECT_EQ(groups[0], groups[1]);
+    EXPECT_NE(groups[2], groups[1]);
+    // Overlaps the first two, so starts a group of its own
+    EXPECT_NE(groups[3], groups[0]);
+    EXPECT_NE(groups[3], groups[2]);
+}
+
+TEST(RenderGraph, RejectsInvalidUses) {
+    drakon::RenderGraph graph;
+    const uint32_t      color = graph.createImage("color", {VK_FORMAT_R8G8B8A8_UNORM});
+    const uint32_t      depth = graph.createImage("depth", {VK_FORMAT_D32_SFLOAT});
+    const uint32_t      small = graph.createImage("small", {VK_FORMAT_R8G8B8A8_UNORM, 16, 16});
+    graph.markOutput(color);
+
+    const uint32_t pass = graph.addPass("pass", nullptr);
+    EXPECT_FALSE(graph.use(pass, color, drakon::RenderGraphAccess::Sampled, drakon::RenderGraphLoad::Clear));
+    EXPECT_FALSE(graph.use(pass, depth, drakon::RenderGraphAccess::ColorAttachment));
+    EXPECT_FALSE(graph.use(pass, color, drakon::RenderGraphAccess::DepthAttachment));
+    EXPECT_TRUE(graph.use(pass, color, drakon::RenderGraphAccess::ColorAttachment));
+    EXPECT_FALSE(graph.use(pass, color, drakon::RenderGraphAccess::Sampled));
+
+    // Attachments of different sizes
+    EXPECT_TRUE(graph.use(pass, small, drakon::RenderGraphAccess::ColorAttachment));
+    EXPECT_FALSE(graph.compile(EXTENT));
+
+    // Sampling an image nothing wrote
+    drakon::RenderGraph reader;
+    const uint32_t      image  = reader.createImage("image", {VK_FORMAT_R8G8B8A8_UNORM});
+    const uint32_t      target = reader.createImage("target", {VK_FORMAT_R8G8B8A8_UNORM});
+    reader.markOutput(target);
+    const uint32_t readPass = reader.addPass("read", nullptr);
+    EXPECT_TRUE(reader.use(readPass, image, drakon::RenderGraphAccess::Sampled));
+    EXPECT_TRUE(reader.use(readPass, target, drakon::RenderGraphAccess::ColorAttachment));
+    EXPECT_FALSE(reader.compile(EXTENT));
+}
@@ -0,0 +1,109 @@
+#include <drakon/RenderQueue.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+drakon::DrawPacket packetWithKey(uint64_t sortKey, uint32_t first) {
+    drakon::DrawPacket packet;
+    packet.sortKey = sortKey;
+    packet.first   = first;
+    return packet;
+}
+} // namespace
+
+TEST(RenderQueue, SortKeyOrdersByPassThenPipelineThenMaterialThenDepth) {
+    using drakon::RenderQueue;
+
+    EXPECT_LT(RenderQueue::makeSortKey(0, 0xFFFF, 0xFFFF, 0xFFFFFF), RenderQueue::makeSortKey(1, 0, 0, 0));
+    EXPECT_LT(RenderQueue::makeSortKey(0, 1, 0xFFFF, 0xFFFFFF), RenderQueue::makeSortKey(0, 2, 0, 0));
+    EXPECT_LT(RenderQueue::makeSortKey(0, 1, 1, 0xFFFFFF), RenderQueue::makeSortKey(0, 1, 2, 0));
+    EXPECT_LT(RenderQueue::makeSortKey(0, 1, 1, 1), RenderQueue::makeSortKey(0, 1, 1, 2));
+
+    // Out-of-range fields are truncated rather than spilling into their neighbours
+    EXPECT_EQ(RenderQueue::makeSortKey(0, 0x10001, 0, 0), RenderQueue::makeSortKey(0, 1, 0, 0));
+}
+
+TEST(RenderQueue, OpaqueKeysSortRoughlyFrontToBack) {
+    using drakon::RenderQueue;
+
+    const uint32_t near = RenderQueue::quantizeDepth(0.1f);
+    const uint32_t far  = RenderQueue::quantizeDepth(0.9f);
+
+    // A nearer band comes first whatever its state, and state groups draws within a band
+    EXPECT_LT(RenderQueue::makeOpaqueSortKey(0xFFFF, 0xFFFF, near), RenderQueue::makeOpaqueSortKey(0, 0, far));
+    EXPECT_LT(RenderQueue::makeOpaqueSortKey(1, 0, near + 1), RenderQueue::makeOpaqueSortKey(2, 0, near));
+    EXPECT_LT(RenderQueue::makeOpaqueSortKey(1, 1, near), RenderQueue::makeOpaqueSortKey(1, 1, near + 1));
+}
+
+TEST(RenderQueue, TransparentKeysSortBackToFrontAfterOpaque) {
+    using drakon::RenderQueue;
+
+    const uint32_t near = RenderQueue::quantizeDepth(0.1f);
+    const uint32_t far  = RenderQueue::quantizeDepth(0.9f);
+
+    EXPECT_LT(RenderQueue::makeTransparentSortKey(0xFFFF, 0xFFFF, far),
+              RenderQueue::makeTransparentSortKey(0, 0, near));
+    EXPECT_LT(RenderQueue::makeTransparentSortKey(0, 0, far), RenderQueue::makeTransparentSortKey(1, 0, far));
+    EXPECT_LT(RenderQueue::makeOpaqueSortKey(0xFFFF, 0xFFFF, 0xFFFFFF), RenderQueue::makeTransparentSortKey(0, 0, 0));
+}
+
+TEST(RenderQueue, QuantizeDepthClampsAndPreservesOrder) {
+    using drakon::RenderQueue;
+
+    EXPECT_EQ(RenderQueue::quantizeDepth(-1.0f), 0u);
+    EXPECT_EQ(RenderQueue::quantizeDepth(2.0f), RenderQueue::quantizeDepth(1.0f));
+    EXPECT_LT(RenderQueue::quantizeDepth(0.25f), RenderQueue::quantizeDepth(0.5f));
+}
+
+TEST(RenderQueue, SortMatchesStableSort) {
+    drakon::RenderQueue queue;
+    std::mt19937_64     random(42);
+
+    std::vector<drakon::DrawPacket> expected;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        // Few distinct keys, so stability is actually exercised
+        const uint64_t key = drakon::RenderQueue::makeSortKey(
+            static_cast<uint32_t>(random() % 3), static_cast<uint32_t>(random() % 7), 0, 0);
+        expected.push_back(packetWithKey(key, i));
+        queue.submit(expected.back());
+    }
+    queue.sort();
+
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) {
+        return a.sortKey < b.sortKey;
+    });
+    ASSERT_EQ(queue.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(queue.getPacket(i).sortKey, expected[i].sortKey);
+        EXPECT_EQ(queue.getPacket(i).first, expected[i].first);
+    }
+}
+
+TEST(RenderQueue, SortHandlesFullWidthKeys) {
+    drakon::RenderQueue queue;
+    std::mt19937_64     random(7);
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        queue.submit(packetWithKey(random(), i));
+    }
+    queue.sort();
+
+    for (size_t i = 1; i < queue.size(); ++i) {
+        EXPECT_LE(queue.getPacket(i - 1).sortKey, queue.getPacket(i).sortKey);
+    }
+}
+
+TEST(RenderQueue, ClearEmptiesTheQueue) {
+    drakon::RenderQueue queue;
+    queue.submit(packetWithKey(3, 0));
+    queue.sort();
+    queue.clear();
+
+    EXPECT_TRUE(queue.empty());
+    queue.sort();
+    EXPECT_EQ(queue.size(), 0u);
+}
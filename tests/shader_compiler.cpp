@@ -0,0 +1,90 @@
+#include <drakon/JobSystem.h>
+#include <drakon/ShaderCompiler.h>
+
+#include <filesystem>
+#include <string>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+constexpr const char* SOURCE = "#version 450\n"
+                               "layout(location = 0) out vec4 color;\n"
+                               "void main() { color = vec4(SHADE); }\n";
+
+struct ShaderCacheTest : public ::testing::Test {
+    drakon::ShaderCompiler       compiler;
+    drakon::ShaderCompileOptions options;
+
+    void SetUp() override {
+        this->compiler.setCacheDirectory(std::filesystem::temp_directory_path() /
+                                         ("drakon_shader_cache_" + std::to_string(getpid())));
+        std::filesystem::remove_all(this->compiler.getCacheDirectory());
+        this->options.defines = {{"SHADE", "1.0"}};
+    }
+
+    void TearDown() override { std::filesystem::remove_all(this->compiler.getCacheDirectory()); }
+};
+} // namespace
+
+TEST(ShaderCompiler, RejectsSourcesWithoutAStage) {
+    drakon::ShaderCompiler compiler;
+    compiler.setCacheDirectory({});
+
+    const drakon::ShaderCompileResult result = compiler.compileSource("void main() {}", "shader.glsl");
+    EXPECT_FALSE(result.success);
+    EXPECT_FALSE(result.fromCache);
+    EXPECT_NE(result.log.find("shader.glsl"), std::string::npos);
+}
+
+TEST(ShaderCompiler, ReportsMissingFiles) {
+    drakon::ShaderCompiler compiler;
+    compiler.setCacheDirectory({});
+
+    const drakon::ShaderCompileResult result = compiler.compile("does/not/exist.vert");
+    EXPECT_FALSE(result.success);
+    EXPECT_NE(result.log.find("exist.vert"), std::string::npos);
+}
+
+TEST(ShaderCompiler, CompileAllKeepsRequestOrder) {
+    drakon::ShaderCompiler compiler;
+    compiler.setCacheDirectory({});
+
+    std::vector<drakon::ShaderCompileRequest> requests(8);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        requests[i].path = "missing_" + std::to_string(i) + ".frag";
+    }
+
+    drakon::JobSystem jobs;
+    jobs.start(2);
+    const std::vector<drakon::ShaderCompileResult> results = compiler.compileAll(requests, jobs);
+    ASSERT_EQ(results.size(), requests.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_FALSE(results[i].success);
+        EXPECT_NE(results[i].log.find("missing_" + std::to_string(i) + ".frag"), std::string::npos);
+    }
+}
+
+TEST_F(ShaderCacheTest, SecondCompileComesFromTheCache) {
+    const drakon::ShaderCompileResult first = this->compiler.compileSource(SOURCE, "shader.frag", this->options);
+    ASSERT_TRUE(first.success) << first.log;
+    EXPECT_FALSE(first.fromCache);
+
+    const drakon::ShaderCompileResult second = this->compiler.compileSource(SOURCE, "shader.frag", this->options);
+    ASSERT_TRUE(second.success) << second.log;
+    EXPECT_TRUE(second.fromCache);
+    EXPECT_EQ(second.spirv, first.spirv);
+}
+
+TEST_F(ShaderCacheTest, EditsAndDefinesMissTheCache) {
+    ASSERT_TRUE(this->compiler.compileSource(SOURCE, "shader.frag", this->options).success);
+
+    const std::string edited = std::string(SOURCE) + "// edited\n";
+    EXPECT_FALSE(this->compiler.compileSource(edited, "shader.frag", this->options).fromCache);
+
+    this->options.defines = {{"SHADE", "0.5"}};
+    const drakon::ShaderCompileResult redefined = this->compiler.compileSource(SOURCE, "shader.frag", this->options);
+    ASSERT_TRUE(redefined.success) << redefined.log;
+    EXPECT_FALSE(redefined.fromCache);
+}
@@ -0,0 +1,103 @@
+#include <drakon/SpriteBatch.h>
+
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(SpriteBatch, ExpandsAxisAlignedQuadsClockwiseFromTopLeft) {
+    drakon::Sprite sprite;
+    sprite.position[0] = 10.0f;
+    sprite.position[1] = 20.0f;
+    sprite.size[0]     = 4.0f;
+    sprite.size[1]     = 2.0f;
+    sprite.uv[0]       = 0.25f;
+    sprite.uv[1]       = 0.5f;
+    sprite.uv[2]       = 0.75f;
+    sprite.uv[3]       = 1.0f;
+    sprite.color       = 0x80402010;
+    sprite.layer       = 3;
+
+    std::vector<drakon::SpriteVertex> vertices(4);
+    drakon::SpriteBatch::expandQuads(&sprite, 1, vertices.data());
+
+    const float expected[4][4] = {
+        {10.0f, 20.0f, 0.25f, 0.5f},
+        {14.0f, 20.0f, 0.75f, 0.5f},
+        {14.0f, 22.0f, 0.75f, 1.0f},
+        {10.0f, 22.0f, 0.25f, 1.0f},
+    };
+    for (size_t i = 0; i < 4; ++i) {
+        EXPECT_FLOAT_EQ(vertices[i].position[0], expected[i][0]) << "corner " << i;
+        EXPECT_FLOAT_EQ(vertices[i].position[1], expected[i][1]) << "corner " << i;
+        EXPECT_FLOAT_EQ(vertices[i].uv[0], expected[i][2]) << "corner " << i;
+        EXPECT_FLOAT_EQ(vertices[i].uv[1], expected[i][3]) << "corner " << i;
+        EXPECT_EQ(vertices[i].color, 0x80402010u);
+        EXPECT_EQ(vertices[i].layer, 3u);
+    }
+}
+
+TEST(SpriteBatch, RotatesAboutTheOrigin) {
+    drakon::Sprite sprite;
+    sprite.position[0] = 100.0f;
+    sprite.position[1] = 100.0f;
+    sprite.size[0]     = 2.0f;
+    sprite.size[1]     = 2.0f;
+    sprite.origin[0]   = 0.5f;
+    sprite.origin[1]   = 0.5f;
+    sprite.rotation    = std::numbers::pi_v<float> / 2.0f;
+
+    std::vector<drakon::SpriteVertex> vertices(4);
+    drakon::SpriteBatch::expandQuads(&sprite, 1, vertices.data());
+
+    // A quarter turn clockwise on screen moves the top left corner to the top right
+    EXPECT_NEAR(vertices[0].position[0], 101.0f, 1e-4f);
+    EXPECT_NEAR(vertices[0].position[1], 99.0f, 1e-4f);
+    EXPECT_NEAR(vertices[1].position[0], 101.0f, 1e-4f);
+    EXPECT_NEAR(vertices[1].position[1], 101.0f, 1e-4f);
+    EXPECT_NEAR(vertices[2].position[0], 99.0f, 1e-4f);
+    EXPECT_NEAR(vertices[2].position[1], 101.0f, 1e-4f);
+    EXPECT_NEAR(vertices[3].position[0], 99.0f, 1e-4f);
+    EXPECT_NEAR(vertices[3].position[1], 99.0f, 1e-4f);
+}
+
+TEST(SpriteBatch, MatchesAScalarReferenceForRandomSprites) {
+    std::mt19937                          random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<drakon::Sprite> sprites(257);
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        drakon::Sprite& sprite = sprites[i];
+        sprite.position[0]     = unit(random) * 1000.0f;
+        sprite.position[1]     = unit(random) * 1000.0f;
+        sprite.size[0]         = unit(random) * 64.0f - 8.0f;
+        sprite.size[1]         = unit(random) * 64.0f - 8.0f;
+        sprite.origin[0]       = unit(random);
+        sprite.origin[1]       = unit(random);
+        sprite.rotation        = i % 2 == 0 ? 0.0f : unit(random) * 6.0f;
+        sprite.layer           = static_cast<uint32_t>(i);
+        sprite.color           = static_cast<uint32_t>(i * 2654435761u);
+    }
+
+    std::vector<drakon::SpriteVertex> vertices(sprites.size() * 4);
+    drakon::SpriteBatch::expandQuads(sprites.data(), sprites.size(), vertices.data());
+
+    const float cornerX[4] = {0.0f, 1.0f, 1.0f, 0.0f};
+    const float cornerY[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        const drakon::Sprite& sprite = sprites[i];
+        const float           cosine = std::cos(sprite.rotation);
+        const float           sine   = std::sin(sprite.rotation);
+        for (size_t corner = 0; corner < 4; ++corner) {
+            const float                 localX = (cornerX[corner] - sprite.origin[0]) * sprite.size[0];
+            const float                 localY = (cornerY[corner] - sprite.origin[1]) * sprite.size[1];
+            const drakon::SpriteVertex& vertex = vertices[i * 4 + corner];
+            EXPECT_NEAR(vertex.position[0], sprite.position[0] + localX * cosine - localY * sine, 1e-3f);
+            EXPECT_NEAR(vertex.position[1], sprite.position[1] + localX * sine + localY * cosine, 1e-3f);
+            EXPECT_EQ(vertex.color, sprite.color);
+            EXPECT_EQ(vertex.layer, sprite.layer);
+        }
+    }
+}
@@ -0,0 +1,184 @@
+#include <drakon/TextureCache.h>
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+struct Ktx2Writer {
+    std::vector<std::byte> bytes;
+
+    template <class T>
+    void put(size_t offset, T value) {
+        std::memcpy(this->bytes.data() + offset, &value, sizeof(T));
+    }
+
+    // A file with levelCount stored levels, or one when levelCount is 0, each filled with its level index
+    static std::vector<std::byte> make(VkFormat format, uint32_t width, uint32_t height, uint32_t levelCount) {
+        constexpr std::array<uint8_t, 12> IDENTIFIER = {
+            0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+        const drakon::TextureFormatInfo info   = drakon::getTextureFormatInfo(format);
+        const uint32_t                  stored = std::max(levelCount, 1u);
+
+        Ktx2Writer writer;
+        writer.bytes.resize(80 + stored * 24);
+        std::memcpy(writer.bytes.data(), IDENTIFIER.data(), IDENTIFIER.size());
+        writer.put<uint32_t>(12, format);
+        writer.put<uint32_t>(16, 1);
+        writer.put<uint32_t>(20, width);
+        writer.put<uint32_t>(24, height);
+        writer.put<uint32_t>(36, 1);
+        writer.put<uint32_t>(40, levelCount);
+        for (uint32_t level = 0; level < stored; ++level) {
+            const uint32_t levelWidth  = std::max(width >> level, 1u);
+            const uint32_t levelHeight = std::max(height >> level, 1u);
+            const uint64_t size        = uint64_t((levelWidth + info.blockWidth - 1) / info.blockWidth) *
+                                         ((levelHeight + info.blockHeight - 1) / info.blockHeight) * info.blockBytes;
+            const uint64_t offset = writer.bytes.size();
+            writer.put<uint64_t>(80 + level * 24, offset);
+            writer.put<uint64_t>(80 + level * 24 + 8, size);
+            writer.bytes.resize(offset + size, std::byte(level));
+        }
+        return writer.bytes;
+    }
+};
+
+std::vector<std::byte> toBytes(std::initializer_list<uint8_t> values) {
+    std::vector<std::byte> bytes;
+    for (uint8_t value : values) {
+        bytes.push_back(std::byte(value));
+    }
+    return bytes;
+}
+} // namespace
+
+TEST(TextureCache, FormatInfoCoversBlockFormats) {
+    EXPECT_EQ(drakon::getTextureFormatInfo(VK_FORMAT_R8G8B8A8_UNORM).blockBytes, 4u);
+    EXPECT_FALSE(drakon::getTextureFormatInfo(VK_FORMAT_R8G8B8A8_UNORM).isCompressed());
+    EXPECT_EQ(drakon::getTextureFormatInfo(VK_FORMAT_BC1_RGBA_SRGB_BLOCK).blockBytes, 8u);
+    EXPECT_EQ(drakon::getTextureFormatInfo(VK_FORMAT_BC7_UNORM_BLOCK).blockBytes, 16u);
+
+    const drakon::TextureFormatInfo astc = drakon::getTextureFormatInfo(VK_FORMAT_ASTC_4x4_SRGB_BLOCK);
+    EXPECT_EQ(astc.blockWidth, 4u);
+    EXPECT_EQ(astc.blockBytes, 16u);
+    const drakon::TextureFormatInfo largest = drakon::getTextureFormatInfo(VK_FORMAT_ASTC_12x12_SRGB_BLOCK);
+    EXPECT_EQ(largest.blockWidth, 12u);
+    EXPECT_EQ(largest.blockHeight, 12u);
+    EXPECT_TRUE(largest.isCompressed());
+
+    EXPECT_EQ(drakon::getTextureFormatInfo(VK_FORMAT_D32_SFLOAT).blockBytes, 0u);
+}
+
+TEST(TextureCache, ParsesKtx2Levels) {
+    const std::vector<std::byte> file = Ktx2Writer::make(VK_FORMAT_BC3_UNORM_BLOCK, 64, 32, 7);
+
+    drakon::Ktx2Image image;
+    std::string       error;
+    ASSERT_TRUE(drakon::parseKtx2(file.data(), file.size(), image, error)) << error;
+    EXPECT_EQ(image.format, VK_FORMAT_BC3_UNORM_BLOCK);
+    EXPECT_EQ(image.width, 64u);
+    EXPECT_EQ(image.height, 32u);
+    EXPECT_EQ(image.depth, 1u);
+    EXPECT_EQ(image.faceCount, 1u);
+    EXPECT_FALSE(image.generateMips);
+    ASSERT_EQ(image.levels.size(), 7u);
+    EXPECT_EQ(image.levels[0].size, 16u * 8 * 16);
+    // Levels smaller than a block still take a whole one
+    EXPECT_EQ(image.levels[6].size, 16u);
+    EXPECT_EQ(file[image.levels[3].offset], std::byte(3));
+}
+
+TEST(TextureCache, ZeroLevelsAsksForGeneratedMips) {
+    const std::vector<std::byte> file = Ktx2Writer::make(VK_FORMAT_R8G8B8A8_SRGB, 16, 16, 0);
+
+    drakon::Ktx2Image image;
+    std::string       error;
+    ASSERT_TRUE(drakon::parseKtx2(file.data(), file.size(), image, error)) << error;
+    EXPECT_TRUE(image.generateMips);
+    ASSERT_EQ(image.levels.size(), 1u);
+    EXPECT_EQ(image.levels[0].size, 16u * 16 * 4);
+}
+
+TEST(TextureCache, RejectsBrokenKtx2Files) {
+    drakon::Ktx2Image image;
+    std::string       error;
+
+    std::vector<std::byte> file = Ktx2Writer::make(VK_FORMAT_R8G8B8A8_UNORM, 8, 8, 1);
+    file[1]                     = std::byte('X');
+    EXPECT_FALSE(drakon::parseKtx2(file.data(), file.size(), image, error));
+    EXPECT_FALSE(error.empty());
+
+    file = Ktx2Writer::make(VK_FORMAT_R8G8B8A8_UNORM, 8, 8, 1);
+    file.pop_back();
+    EXPECT_FALSE(drakon::parseKtx2(file.data(), file.size(), image, error));
+
+    // Supercompressed
+    file = Ktx2Writer::make(VK_FORMAT_R8G8B8A8_UNORM, 8, 8, 1);
+    file[44] = std::byte(2);
+    EXPECT_FALSE(drakon::parseKtx2(file.data(), file.size(), image, error));
+
+    // Basis Universal leaves the format undefined
+    file = Ktx2Writer::make(VK_FORMAT_R8G8B8A8_UNORM, 8, 8, 1);
+    file[12] = std::byte(0);
+    EXPECT_FALSE(drakon::parseKtx2(file.data(), file.size(), image, error));
+
+    // More levels than an 8x8 image has
+    file = Ktx2Writer::make(VK_FORMAT_R8G8B8A8_UNORM, 8, 8, 5);
+    EXPECT_FALSE(drakon::parseKtx2(file.data(), file.size(), image, error));
+
+    EXPECT_FALSE(drakon::parseKtx2(file.data(), 40, image, error));
+
+    // Dimensions whose level size would wrap to zero
+    file                = Ktx2Writer::make(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 1);
+    const uint32_t huge = 1u << 31;
+    const uint32_t many = 8;
+    std::memcpy(file.data() + 20, &huge, sizeof(huge));
+    std::memcpy(file.data() + 24, &huge, sizeof(huge));
+    std::memcpy(file.data() + 32, &many, sizeof(many));
+    EXPECT_FALSE(drakon::parseKtx2(file.data(), file.size(), image, error));
+}
+
+TEST(TextureCache, DecodesBc1) {
+    // Pure red and pure blue endpoints, with the first row running from red to blue
+    const std::vector<std::byte> block = toBytes({0x00, 0xF8, 0x1F, 0x00, 0x78, 0x00, 0x00, 0x00});
+
+    std::array<uint8_t, 4 * 4 * 4> rgba = {};
+    ASSERT_TRUE(drakon::decodeBlockCompressed(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, block.data(), rgba.data()));
+    const std::array<uint8_t, 16> firstRow = {255, 0, 0, 255, 170, 0, 85, 255, 85, 0, 170, 255, 0, 0, 255, 255};
+    EXPECT_EQ(std::memcmp(rgba.data(), firstRow.data(), firstRow.size()), 0);
+    EXPECT_EQ(rgba[4 * 4 + 0], 255);
+    EXPECT_EQ(rgba[4 * 4 + 2], 0);
+
+    // Swapped endpoints switch to three colors and a transparent black
+    const std::vector<std::byte>   punchThrough = toBytes({0x1F, 0x00, 0x00, 0xF8, 0xFF, 0x00, 0x00, 0x00});
+    std::array<uint8_t, 2 * 2 * 4> small        = {};
+    ASSERT_TRUE(
+        drakon::decodeBlockCompressed(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 2, 2, punchThrough.data(), small.data()));
+    EXPECT_EQ(small[3], 0);
+    EXPECT_EQ(small[8 + 3], 255);
+    EXPECT_EQ(small[8 + 2], 255);
+
+    ASSERT_TRUE(drakon::decodeBlockCompressed(VK_FORMAT_BC1_RGB_UNORM_BLOCK, 2, 2, punchThrough.data(), small.data()));
+    EXPECT_EQ(small[3], 255);
+
+    EXPECT_EQ(drakon::getDecodedFormat(VK_FORMAT_BC1_RGB_SRGB_BLOCK), VK_FORMAT_R8G8B8A8_SRGB);
+    EXPECT_EQ(drakon::getDecodedFormat(VK_FORMAT_BC7_UNORM_BLOCK), VK_FORMAT_UNDEFINED);
+    EXPECT_FALSE(drakon::decodeBlockCompressed(VK_FORMAT_BC7_UNORM_BLOCK, 4, 4, block.data(), rgba.data()));
+}
+
+TEST(TextureCache, DecodesBc3Alpha) {
+    // Alpha from 255 to 0 with the first texels at each end, over a white color block
+    const std::vector<std::byte> block = toBytes(
+        {0xFF, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00});
+
+    std::array<uint8_t, 4 * 4 * 4> rgba = {};
+    ASSERT_TRUE(drakon::decodeBlockCompressed(VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, block.data(), rgba.data()));
+    EXPECT_EQ(rgba[0], 255);
+    EXPECT_EQ(rgba[3], 255);
+    EXPECT_EQ(rgba[4 + 3], 0);
+    EXPECT_EQ(rgba[8 + 3], 255);
+}
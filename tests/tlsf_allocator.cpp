@@ -0,0 +1,93 @@
+#include <drakon/TlsfAllocator.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(TlsfAllocator, AllocatesAlignedNonOverlappingRanges) {
+    drakon::TlsfAllocator allocator(1 << 20);
+
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (uint64_t i = 1; i <= 64; ++i) {
+        const uint64_t alignment = uint64_t(1) << (i % 9);
+        const auto     offset    = allocator.allocate(i * 37, alignment);
+        ASSERT_TRUE(offset.has_value());
+        EXPECT_EQ(*offset % alignment, 0u);
+        ranges.emplace_back(*offset, *offset + i * 37);
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        EXPECT_LE(ranges[i - 1].second, ranges[i].first);
+    }
+    EXPECT_EQ(allocator.getAllocationCount(), 64u);
+}
+
+TEST(TlsfAllocator, FreeCoalescesBackToOneBlock) {
+    drakon::TlsfAllocator allocator(4096);
+
+    const auto a = allocator.allocate(1024, 16);
+    const auto b = allocator.allocate(1024, 16);
+    const auto c = allocator.allocate(1024, 16);
+    ASSERT_TRUE(a && b && c);
+    EXPECT_EQ(allocator.getUsedBytes(), 3072u);
+
+    EXPECT_TRUE(allocator.free(*b));
+    EXPECT_TRUE(allocator.free(*a));
+    EXPECT_TRUE(allocator.free(*c));
+    EXPECT_TRUE(allocator.isEmpty());
+    EXPECT_EQ(allocator.getUsedBytes(), 0u);
+    EXPECT_EQ(allocator.getLargestFreeBlock(), 4096u);
+
+    // The whole range is usable again once every neighbour has merged
+    EXPECT_EQ(allocator.allocate(4096, 1), 0u);
+}
+
+TEST(TlsfAllocator, RejectsUnknownAndDoubleFree) {
+    drakon::TlsfAllocator allocator(1024);
+
+    const auto offset = allocator.allocate(100, 4);
+    ASSERT_TRUE(offset.has_value());
+    EXPECT_FALSE(allocator.free(*offset + 4));
+    EXPECT_TRUE(allocator.free(*offset));
+    EXPECT_FALSE(allocator.free(*offset));
+}
+
+TEST(TlsfAllocator, FailsWhenExhausted) {
+    drakon::TlsfAllocator allocator(1024);
+
+    EXPECT_FALSE(allocator.allocate(2048, 1).has_value());
+    ASSERT_TRUE(allocator.allocate(1024, 1).has_value());
+    EXPECT_FALSE(allocator.allocate(1, 1).has_value());
+}
+
+TEST(TlsfAllocator, SurvivesRandomChurn) {
+    drakon::TlsfAllocator allocator(1 << 24);
+    std::mt19937_64       random(1234);
+
+    std::vector<uint64_t> live;
+    for (int step = 0; step < 20000; ++step) {
+        if (!live.empty() && random() % 2 == 0) {
+            const size_t pick = random() % live.size();
+            ASSERT_TRUE(allocator.free(live[pick]));
+            live[pick] = live.back();
+            live.pop_back();
+        } else {
+            const uint64_t alignment = uint64_t(1) << (random() % 12);
+            const auto     offset    = allocator.allocate(1 + random() % 65536, alignment);
+            if (offset) {
+                EXPECT_EQ(*offset % alignment, 0u);
+                live.push_back(*offset);
+            }
+        }
+    }
+
+    for (uint64_t offset : live) {
+        ASSERT_TRUE(allocator.free(offset));
+    }
+    EXPECT_TRUE(allocator.isEmpty());
+    EXPECT_EQ(allocator.getLargestFreeBlock(), uint64_t(1) << 24);
+}
@@ -0,0 +1,69 @@
+#include <drakon/Trace.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace {
+std::string readTrace(const std::filesystem::path& path) {
+    std::ifstream     file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+} // namespace
+
+TEST(Trace, DisabledScopesRecordNothing) {
+    drakon::Trace::disable();
+    { DRAKON_TRACE_SCOPE("trace.disabled"); }
+
+    const auto path = std::filesystem::temp_directory_path() / "drakon_trace_disabled.json";
+    ASSERT_TRUE(drakon::Trace::writeChromeJson(path));
+    EXPECT_EQ(readTrace(path).find("trace.disabled"), std::string::npos);
+    std::filesystem::remove(path);
+}
+
+TEST(Trace, ExportsScopesFromEveryThread) {
+    drakon::Trace::enable();
+    drakon::Trace::setThreadName("trace-test-main");
+    { DRAKON_TRACE_SCOPE("trace.main"); }
+    std::thread worker([] {
+        drakon::Trace::setThreadName("trace-test-worker");
+        DRAKON_TRACE_SCOPE("trace.\"worker\"");
+    });
+    worker.join();
+    drakon::Trace::disable();
+
+    const auto path = std::filesystem::temp_directory_path() / "drakon_trace_threads.json";
+    ASSERT_TRUE(drakon::Trace::writeChromeJson(path));
+    const std::string trace = readTrace(path);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(trace.find("\"name\":\"trace.main\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"trace.\\\"worker\\\"\""), std::string::npos);
+    EXPECT_NE(trace.find("\"args\":{\"name\":\"trace-test-worker\"}"), std::string::npos);
+}
+
+TEST(Trace, KeepsMostRecentEventsWhenRingWraps) {
+    drakon::Trace::enable();
+    std::thread worker([] {
+        for (int i = 0; i < 70000; ++i) {
+            drakon::Trace::record(i < 1000 ? "trace.old" : "trace.new", i, i + 1);
+        }
+    });
+    worker.join();
+    drakon::Trace::disable();
+
+    const auto path = std::filesystem::temp_directory_path() / "drakon_trace_wrap.json";
+    ASSERT_TRUE(drakon::Trace::writeChromeJson(path));
+    const std::string trace = readTrace(path);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(trace.find("trace.old"), std::string::npos);
+    EXPECT_NE(trace.find("trace.new"), std::string::npos);
+}
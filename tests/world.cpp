@@ -0,0 +1,137 @@
+#include <drakon/World.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+struct Position {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Velocity {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Tag {
+    int value = 0;
+};
+} // namespace
+
+TEST(World, ReusesIndicesWithANewGeneration) {
+    drakon::World        world;
+    const drakon::Entity first = world.create(Position{1.0f, 2.0f});
+    EXPECT_TRUE(world.isAlive(first));
+    EXPECT_EQ(world.size(), 1u);
+
+    EXPECT_TRUE(world.destroy(first));
+    EXPECT_FALSE(world.isAlive(first));
+    EXPECT_FALSE(world.destroy(first));
+    EXPECT_EQ(world.get<Position>(first), nullptr);
+
+    const drakon::Entity second = world.create(Position{3.0f, 4.0f});
+    EXPECT_EQ(second.index, first.index);
+    EXPECT_NE(second.generation, first.generation);
+    EXPECT_FALSE(world.isAlive(first));
+    ASSERT_NE(world.get<Position>(second), nullptr);
+    EXPECT_FLOAT_EQ(world.get<Position>(second)->x, 3.0f);
+}
+
+TEST(World, AddingAndRemovingComponentsKeepsTheRest) {
+    drakon::World        world;
+    const drakon::Entity entity = world.create(Position{1.0f, 2.0f});
+    EXPECT_FALSE(world.has<Velocity>(entity));
+
+    ASSERT_NE(world.add(entity, Velocity{5.0f, 6.0f}), nullptr);
+    EXPECT_TRUE(world.has<Position>(entity));
+    EXPECT_TRUE(world.has<Velocity>(entity));
+    EXPECT_FLOAT_EQ(world.get<Position>(entity)->y, 2.0f);
+    EXPECT_FLOAT_EQ(world.get<Velocity>(entity)->x, 5.0f);
+
+    // Adding a component the entity already has assigns in place
+    world.add(entity, Velocity{7.0f, 8.0f});
+    EXPECT_FLOAT_EQ(world.get<Velocity>(entity)->x, 7.0f);
+
+    EXPECT_TRUE(world.remove<Position>(entity));
+    EXPECT_FALSE(world.remove<Position>(entity));
+    EXPECT_FALSE(world.has<Position>(entity));
+    EXPECT_FLOAT_EQ(world.get<Velocity>(entity)->y, 8.0f);
+    EXPECT_EQ(world.size(), 1u);
+}
+
+TEST(World, QueriesVisitEveryMatchingEntityAcrossChunks) {
+    drakon::World world;
+    // Enough entities to span several chunks in each archetype
+    const int                   count = 10000;
+    std::vector<drakon::Entity> moving;
+    for (int i = 0; i < count; ++i) {
+        if (i % 3 == 0) {
+            world.create(Position{static_cast<float>(i), 0.0f});
+        } else {
+            moving.push_back(world.create(Position{static_cast<float>(i), 0.0f}, Velocity{1.0f, 2.0f}));
+        }
+    }
+
+    size_t chunks = 0;
+    world.eachChunk<Position, const Velocity>(
+        [&chunks](size_t chunkCount, const drakon::Entity*, Position* positions, const Velocity* velocities) {
+            ++chunks;
+            for (size_t i = 0; i < chunkCount; ++i) {
+                positions[i].y += velocities[i].y;
+            }
+        });
+    EXPECT_GT(chunks, 1u);
+
+    std::set<uint32_t> visited;
+    world.each<Position>([&visited](drakon::Entity entity, Position& position) {
+        EXPECT_TRUE(visited.insert(entity.index).second);
+        EXPECT_FLOAT_EQ(position.y, static_cast<int>(position.x) % 3 == 0 ? 0.0f : 2.0f);
+    });
+    EXPECT_EQ(visited.size(), static_cast<size_t>(count));
+
+    size_t withVelocity = 0;
+    world.each<Velocity>([&withVelocity](Velocity&) { ++withVelocity; });
+    EXPECT_EQ(withVelocity, moving.size());
+}
+
+TEST(World, DestroyingFillsTheGapWithTheLastEntity) {
+    drakon::World               world;
+    std::vector<drakon::Entity> entities;
+    for (int i = 0; i < 100; ++i) {
+        entities.push_back(world.create(Tag{i}));
+    }
+    for (int i = 0; i < 100; i += 2) {
+        EXPECT_TRUE(world.destroy(entities[i]));
+    }
+
+    EXPECT_EQ(world.size(), 50u);
+    for (int i = 1; i < 100; i += 2) {
+        ASSERT_TRUE(world.isAlive(entities[i]));
+        EXPECT_EQ(world.get<Tag>(entities[i])->value, i);
+    }
+}
+
+TEST(World, DestroysComponentsExactlyOnce) {
+    auto resource = std::make_shared<int>(42);
+    {
+        drakon::World        world;
+        const drakon::Entity kept    = world.create(resource, Tag{1});
+        const drakon::Entity dropped = world.create(resource);
+        const drakon::Entity moved   = world.create(resource);
+        EXPECT_EQ(resource.use_count(), 4);
+
+        world.destroy(dropped);
+        EXPECT_EQ(resource.use_count(), 3);
+        // Moving between archetypes relocates without copying
+        world.add(moved, Tag{2});
+        EXPECT_EQ(resource.use_count(), 3);
+        world.remove<std::shared_ptr<int>>(moved);
+        EXPECT_EQ(resource.use_count(), 2);
+        EXPECT_TRUE(world.isAlive(kept));
+    }
+    EXPECT_EQ(resource.use_count(), 1);
+}